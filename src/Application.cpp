@@ -1,4 +1,6 @@
 #include "Application.h"
+#include "Processing/FramePool.h"
+#include "Utils/AllocationCounter.h"
 #include "Utils/Logger.h"
 #include <Windows.h>
 #include <imgui.h>
@@ -7,6 +9,29 @@
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
+// Display names in UpscaleMethod order
+static const char* s_upscaleMethodNames[] = { "Bilinear", "FSR (Edge-Adaptive)", "Edge-Directed (Text/UI, CPU)", "Temporal (Accumulated, CPU)", "Neural (int8 CNN, CPU)" };
+
+// Display names in SharpenMode order
+static const char* s_sharpenModeNames[] = { "Off", "GPU (CAS shader)", "CPU (CAS, SIMD)" };
+
+// Frames after the last window message (input, resize, display change) before a frame counts as
+// steady state for the allocation check; UI reacting to input may allocate until then
+static const uint32_t s_settleFrames = 30;
+
+static std::string ToUtf8(const std::wstring& text)
+{
+    int len = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, nullptr, 0, nullptr, nullptr);
+    if (len <= 1)
+    {
+        return std::string();
+    }
+    std::string utf8(len, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), -1, &utf8[0], len, nullptr, nullptr);
+    utf8.resize(len - 1);
+    return utf8;
+}
+
 Application::Application()
     : m_windowWidth(1280), m_windowHeight(720)
 {
@@ -132,6 +157,8 @@ void Application::Shutdown()
 void Application::ProcessFrame()
 {
     try {
+        const uint64_t allocationsBefore = GetHeapAllocationCount();
+        
         // If overlay mode is active, process overlay frames
         if (m_overlayMode && m_overlay && m_overlay->IsActive())
         {
@@ -164,12 +191,35 @@ void Application::ProcessFrame()
     float deltaTime = m_timer.GetDeltaTime();
     m_fps = 1.0f / deltaTime;
     
+    // Steady-state frames shouldn't touch the heap; frames reacting to input (a list opened, a
+    // resize) may, until the window has been left alone for s_settleFrames
+    uint64_t allocations = GetHeapAllocationCount() - allocationsBefore;
+    m_windowAllocations += allocations;
+    if (allocations && m_settledFrames >= s_settleFrames)
+    {
+        m_windowSteadyAllocations += allocations;
+        m_windowSteadyAllocatingFrames++;
+    }
+    m_settledFrames++;
+    m_windowFrames++;
+    
     // Update smoothed FPS every 0.5 seconds for readability
     m_fpsUpdateTimer += deltaTime;
     if (m_fpsUpdateTimer >= 0.5f)
     {
         m_fpsSmoothed = m_fps;
         m_fpsUpdateTimer = 0.0f;
+        
+        m_allocationsPerFrame = static_cast<float>(m_windowAllocations) / m_windowFrames;
+        if (m_windowSteadyAllocatingFrames > 0 && IsHeapAllocationCountEnabled())
+        {
+            Logger::Warning("%u steady-state frames of the last %u allocated (%llu heap allocations)",
+                m_windowSteadyAllocatingFrames, m_windowFrames, static_cast<unsigned long long>(m_windowSteadyAllocations));
+        }
+        m_windowAllocations = 0;
+        m_windowSteadyAllocations = 0;
+        m_windowSteadyAllocatingFrames = 0;
+        m_windowFrames = 0;
     }
     
     m_timer.Tick();
@@ -190,28 +240,26 @@ void Application::RenderUI()
 
     ImGui::Text("FPS (PotatoPatch): %.0f", m_fpsSmoothed);
     ImGui::Text("Captured Frames: %u", m_capturedFrames);
+    if (IsHeapAllocationCountEnabled())
+    {
+        ImGui::Text("Heap allocations per frame: %.2f", m_allocationsPerFrame);
+    }
     ImGui::Separator();
 
     // Monitor selection
     ImGui::Text("Monitor Selection:");
-    auto monitors = m_capture->GetMonitors();
+    UpdateMonitorLabels();
     
-    if (monitors.empty())
+    if (m_monitorLabels.empty())
     {
         ImGui::TextColored(ImVec4(1, 0, 0, 1), "No monitors available for capture!");
     }
     else
     {
-        for (size_t i = 0; i < monitors.size(); i++)
+        for (size_t i = 0; i < m_monitorLabels.size(); i++)
         {
-            const auto& mon = monitors[i];
-            char label[256];
-            int width = mon.bounds.right - mon.bounds.left;
-            int height = mon.bounds.bottom - mon.bounds.top;
-            snprintf(label, sizeof(label), "Monitor %d: %dx%d", (int)i, width, height);
-            
             bool isSelected = (m_selectedMonitor == (int)i);
-            if (ImGui::RadioButton(label, isSelected))
+            if (ImGui::RadioButton(m_monitorLabels[i].c_str(), isSelected))
             {
                 if (m_capture->SelectMonitor((int)i))
                 {
@@ -220,6 +268,18 @@ void Application::RenderUI()
                 }
             }
         }
+        
+        // The duplication format is fixed when it's created, so re-select the monitor
+        ImGui::BeginDisabled(m_overlayMode);
+        if (ImGui::Checkbox("HDR Capture (10-bit / FP16)", &m_hdrCapture))
+        {
+            m_capture->SetHdrCaptureEnabled(m_hdrCapture);
+            if (m_selectedMonitor >= 0)
+            {
+                m_capture->SelectMonitor(m_selectedMonitor);
+            }
+        }
+        ImGui::EndDisabled();
     }
     
     ImGui::Separator();
@@ -245,17 +305,14 @@ void Application::RenderUI()
         
         for (const auto& window : m_availableWindows)
         {
-            char titleUtf8[256];
-            WideCharToMultiByte(CP_UTF8, 0, window.title.c_str(), -1, titleUtf8, sizeof(titleUtf8), nullptr, nullptr);
-            
-            if (ImGui::Selectable(titleUtf8))
+            if (ImGui::Selectable(window.label.c_str()))
             {
                 m_targetWindow = window.hwnd;
-                m_targetWindowTitle = window.title;
+                SetTargetTitle(window.title);
                 
                 RECT rect;
                 GetClientRect(m_targetWindow, &rect);
-                Logger::Info("Selected window '%s' (%dx%d)", titleUtf8, rect.right - rect.left, rect.bottom - rect.top);
+                Logger::Info("Selected window '%s' (%dx%d)", window.label.c_str(), rect.right - rect.left, rect.bottom - rect.top);
                 
                 // Auto-select the monitor containing this window
                 int monitorIndex = m_capture->GetMonitorForWindow(m_targetWindow);
@@ -284,8 +341,10 @@ void Application::RenderUI()
     {
         // Convert to wide string and find window
         int len = MultiByteToWideChar(CP_UTF8, 0, windowTitleBuffer, -1, nullptr, 0);
-        m_targetWindowTitle.resize(len);
-        MultiByteToWideChar(CP_UTF8, 0, windowTitleBuffer, -1, &m_targetWindowTitle[0], len);
+        std::wstring title(len, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, windowTitleBuffer, -1, &title[0], len);
+        title.resize(len > 0 ? len - 1 : 0);
+        SetTargetTitle(title);
         
         m_targetWindow = FindWindowW(nullptr, m_targetWindowTitle.c_str());
         if (m_targetWindow)
@@ -336,9 +395,8 @@ void Application::RenderUI()
                 ImGui::Indent();
                 
                 // Upscale method selection
-                const char* methodNames[] = { "Bilinear", "FSR (Edge-Adaptive)" };
                 int currentMethod = static_cast<int>(m_overlayUpscaleMethod);
-                if (ImGui::Combo("Upscale Method", &currentMethod, methodNames, 2))
+                if (ImGui::Combo("Upscale Method", &currentMethod, s_upscaleMethodNames, IM_ARRAYSIZE(s_upscaleMethodNames)))
                 {
                     m_overlayUpscaleMethod = static_cast<UpscaleMethod>(currentMethod);
                     if (m_overlay) m_overlay->SetUpscaleMethod(m_overlayUpscaleMethod);
@@ -362,6 +420,27 @@ void Application::RenderUI()
                 ImGui::Unindent();
             }
             
+            // Sharpening for frames shown without upscaling
+            int sharpenMode = static_cast<int>(m_overlaySharpenMode);
+            if (ImGui::Combo("Native Sharpening", &sharpenMode, s_sharpenModeNames, IM_ARRAYSIZE(s_sharpenModeNames)))
+            {
+                m_overlaySharpenMode = static_cast<SharpenMode>(sharpenMode);
+            }
+            
+            bool fsrSliderShown = m_overlayUpscaleEnabled && m_overlayUpscaleMethod == UpscaleMethod::FSR;
+            if (m_overlaySharpenMode != SharpenMode::Off && !fsrSliderShown)
+            {
+                ImGui::Indent();
+                ImGui::SliderFloat("Sharpness", &m_overlaySharpness, 0.0f, 1.0f, "%.2f");
+                ImGui::Unindent();
+            }
+            
+            ImGui::Checkbox("Linear-Light Filtering", &m_overlayLinearLight);
+            
+            ImGui::Checkbox("Crop Black Bars (Letterbox/Pillarbox)", &m_overlayLetterboxCrop);
+            
+            ImGui::Checkbox("Frame Analysis (Luma Pyramid)", &m_overlayFrameAnalysis);
+            
             ImGui::BeginDisabled(!canStart);
             if (ImGui::Button("START OVERLAY", ImVec2(200, 40)))
             {
@@ -381,6 +460,7 @@ void Application::RenderUI()
             ImGui::PopStyleColor();
             
             ImGui::Text("Overlay FPS: %.0f", m_overlay ? m_overlay->GetOverlayFPS() : 0.0f);
+            ImGui::Text("GPU resource creations: %.1f/s", m_overlay ? m_overlay->GetResourceCreationRate() : 0.0f);
             ImGui::Text("Frames Rendered: %u", m_capturedFrames);
             
             // Live upscaling controls while overlay is active
@@ -396,9 +476,8 @@ void Application::RenderUI()
             
             if (upscaleEnabled)
             {
-                const char* methodNames[] = { "Bilinear", "FSR (Edge-Adaptive)" };
                 int currentMethod = static_cast<int>(m_overlayUpscaleMethod);
-                if (ImGui::Combo("Method", &currentMethod, methodNames, 2))
+                if (ImGui::Combo("Method", &currentMethod, s_upscaleMethodNames, IM_ARRAYSIZE(s_upscaleMethodNames)))
                 {
                     m_overlayUpscaleMethod = static_cast<UpscaleMethod>(currentMethod);
                     if (m_overlay) m_overlay->SetUpscaleMethod(m_overlayUpscaleMethod);
@@ -418,6 +497,79 @@ void Application::RenderUI()
                 }
             }
             
+            int sharpenMode = static_cast<int>(m_overlaySharpenMode);
+            if (ImGui::Combo("Native Sharpening", &sharpenMode, s_sharpenModeNames, IM_ARRAYSIZE(s_sharpenModeNames)))
+            {
+                m_overlaySharpenMode = static_cast<SharpenMode>(sharpenMode);
+                if (m_overlay) m_overlay->SetSharpenMode(m_overlaySharpenMode);
+            }
+            
+            bool fsrSliderShown = upscaleEnabled && m_overlayUpscaleMethod == UpscaleMethod::FSR;
+            if (m_overlaySharpenMode != SharpenMode::Off && !fsrSliderShown)
+            {
+                if (ImGui::SliderFloat("Sharpness", &m_overlaySharpness, 0.0f, 1.0f, "%.2f"))
+                {
+                    if (m_overlay) m_overlay->SetSharpness(m_overlaySharpness);
+                }
+            }
+            
+            if (ImGui::Checkbox("Linear-Light Filtering", &m_overlayLinearLight))
+            {
+                if (m_overlay) m_overlay->SetLinearLightEnabled(m_overlayLinearLight);
+            }
+            
+            if (ImGui::Checkbox("Crop Black Bars", &m_overlayLetterboxCrop))
+            {
+                if (m_overlay) m_overlay->SetLetterboxCropEnabled(m_overlayLetterboxCrop);
+            }
+            
+            if (m_overlayLetterboxCrop && m_overlay)
+            {
+                LetterboxStats letterbox = m_overlay->GetLetterboxStats();
+                if (letterbox.barsFound)
+                {
+                    ImGui::Text("Bars: top %u, bottom %u, left %u, right %u",
+                        letterbox.barTop, letterbox.barBottom, letterbox.barLeft, letterbox.barRight);
+                }
+                else
+                {
+                    ImGui::Text("Bars: none found");
+                }
+                ImGui::Text("Detection: %.3f ms (avg %.3f ms, %u scans)",
+                    letterbox.detectMs, letterbox.detectMsAverage, letterbox.scans);
+            }
+            
+            if (ImGui::Checkbox("Frame Analysis", &m_overlayFrameAnalysis))
+            {
+                if (m_overlay) m_overlay->SetFrameAnalysisEnabled(m_overlayFrameAnalysis);
+            }
+            
+            if (m_overlayFrameAnalysis && m_overlay)
+            {
+                FrameAnalysisStats analysis = m_overlay->GetFrameAnalysisStats();
+                ImGui::Text("Pyramid: %u levels, %.3f ms (avg %.3f ms, %llu frames)",
+                    analysis.levels, analysis.buildMs, analysis.buildMsAverage,
+                    static_cast<unsigned long long>(analysis.frames));
+                ImGui::Text("Duplicates dropped: %llu, game frame time %.1f ms (check %.3f ms)",
+                    static_cast<unsigned long long>(analysis.duplicates), analysis.frameIntervalMs, analysis.duplicateCheckMs);
+            }
+            
+            // CPU methods take their intermediate frames from the shared pool
+            FramePoolStats framePool = FramePool::Shared().GetStats();
+            ImGui::Text("Frame pool: %llu hits, %llu misses, %.1f MB resident (%.1f MB large pages)",
+                static_cast<unsigned long long>(framePool.hits), static_cast<unsigned long long>(framePool.misses),
+                framePool.residentBytes / (1024.0 * 1024.0), framePool.largePageBytes / (1024.0 * 1024.0));
+            
+            // Capture a short replay for offline quality/cost runs (--benchmark --replay file)
+            if (m_overlay && m_overlay->IsRecordingReplay())
+            {
+                ImGui::TextColored(ImVec4(1, 0.4f, 0.4f, 1), "Recording replay...");
+            }
+            else if (ImGui::Button("Record Replay (300 frames)"))
+            {
+                if (m_overlay) m_overlay->StartReplayRecording("potatopatch_replay.ppr", 300);
+            }
+            
             ImGui::Separator();
             ImGui::TextColored(ImVec4(0, 1, 0, 1), "Overlay is ACTIVE!");
             ImGui::TextWrapped("Press ESC or click 'STOP OVERLAY' to stop.");
@@ -457,9 +609,7 @@ void Application::RenderUI()
     
     if (m_targetWindow && IsWindow(m_targetWindow))
     {
-        char title[256];
-        WideCharToMultiByte(CP_UTF8, 0, m_targetWindowTitle.c_str(), -1, title, sizeof(title), nullptr, nullptr);
-        ImGui::Text("Target Window: %s", title);
+        ImGui::Text("Target Window: %s", m_targetWindowLabel.c_str());
     }
 
     ImGui::End();
@@ -500,6 +650,10 @@ void Application::StartOverlayMode()
     m_overlay->SetUpscaleMethod(m_overlayUpscaleMethod);
     m_overlay->SetUpscaleFactor(m_overlayUpscaleFactor);
     m_overlay->SetSharpness(m_overlaySharpness);
+    m_overlay->SetSharpenMode(m_overlaySharpenMode);
+    m_overlay->SetLinearLightEnabled(m_overlayLinearLight);
+    m_overlay->SetLetterboxCropEnabled(m_overlayLetterboxCrop);
+    m_overlay->SetFrameAnalysisEnabled(m_overlayFrameAnalysis);
     
     // Set target window for overlay
     m_overlay->SetTargetWindow(m_targetWindow);
@@ -537,6 +691,7 @@ void Application::HandleWindowMessages()
     {
         TranslateMessage(&msg);
         DispatchMessage(&msg);
+        m_settledFrames = 0;
 
         if (msg.message == WM_QUIT)
         {
@@ -559,6 +714,7 @@ BOOL CALLBACK Application::EnumWindowsCallback(HWND hwnd, LPARAM lParam)
     {
         WindowInfo info;
         info.title = title;
+        info.label = ToUtf8(info.title);
         info.hwnd = hwnd;
         app->m_availableWindows.push_back(info);
     }
@@ -572,6 +728,34 @@ void Application::EnumerateAllWindows()
     EnumWindows(EnumWindowsCallback, reinterpret_cast<LPARAM>(this));
 }
 
+void Application::UpdateMonitorLabels()
+{
+    // Labels only change with the monitor list, not per frame
+    if (m_monitorLabelsVersion == m_capture->GetMonitorsVersion())
+    {
+        return;
+    }
+    m_monitorLabelsVersion = m_capture->GetMonitorsVersion();
+    
+    const std::vector<MonitorInfo>& monitors = m_capture->GetMonitors();
+    m_monitorLabels.clear();
+    for (size_t i = 0; i < monitors.size(); i++)
+    {
+        const MonitorInfo& mon = monitors[i];
+        char label[256];
+        int width = mon.bounds.right - mon.bounds.left;
+        int height = mon.bounds.bottom - mon.bounds.top;
+        snprintf(label, sizeof(label), "Monitor %d: %dx%d", (int)i, width, height);
+        m_monitorLabels.push_back(label);
+    }
+}
+
+void Application::SetTargetTitle(const std::wstring& title)
+{
+    m_targetWindowTitle = title;
+    m_targetWindowLabel = ToUtf8(title);
+}
+
 LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
     if (ImGui_ImplWin32_WndProcHandler(hwnd, uMsg, wParam, lParam))
@@ -596,6 +780,14 @@ LRESULT CALLBACK Application::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LP
         PostQuitMessage(0);
         return 0;
 
+    case WM_DISPLAYCHANGE:
+        // Monitors were added, removed or changed resolution
+        if (app && app->m_capture)
+        {
+            app->m_capture->RefreshMonitors();
+        }
+        return 0;
+
     case WM_SIZE:
         if (app && app->m_context)
         {
@@ -3,6 +3,7 @@
 #include <Windows.h>
 #include <memory>
 #include <string>
+#include <vector>
 #include "Core/D3D12Context.h"
 #include "Capture/CaptureEngine.h"
 #include "Processing/Upscaler.h"
@@ -27,6 +28,8 @@ private:
     void RenderUI();
     void HandleWindowMessages();
     void EnumerateAllWindows();
+    void UpdateMonitorLabels();
+    void SetTargetTitle(const std::wstring& title);
     void StartOverlayMode();
     void StopOverlayMode();
 
@@ -55,12 +58,17 @@ private:
     float m_upscaleFactor = 2.0f;
     HWND m_targetWindow = nullptr;
     int m_selectedMonitor = -1;
+    bool m_hdrCapture = false;
     
     // Overlay upscaling settings
     bool m_overlayUpscaleEnabled = false;  // Disabled by default for performance
     UpscaleMethod m_overlayUpscaleMethod = UpscaleMethod::Bilinear;  // Bilinear is faster
     float m_overlayUpscaleFactor = 1.0f;  // 1.0 = no upscaling
     float m_overlaySharpness = 0.5f;
+    SharpenMode m_overlaySharpenMode = SharpenMode::Off;
+    bool m_overlayLinearLight = false;
+    bool m_overlayLetterboxCrop = false;
+    bool m_overlayFrameAnalysis = false;
     
     // Performance tracking
     Timer m_timer;
@@ -68,13 +76,27 @@ private:
     float m_fpsSmoothed = 0.0f;
     float m_fpsUpdateTimer = 0.0f;
     std::wstring m_targetWindowTitle;
+    std::string m_targetWindowLabel;  // UTF-8 copy of the title for the UI
+    
+    // Heap allocations per frame (only counted with POTATO_SCRATCH_CHECKS)
+    uint64_t m_windowAllocations = 0;
+    uint32_t m_windowFrames = 0;
+    uint64_t m_windowSteadyAllocations = 0;       // Of frames after s_settleFrames without window messages
+    uint32_t m_windowSteadyAllocatingFrames = 0;
+    uint32_t m_settledFrames = 0;                 // Since the last window message
+    float m_allocationsPerFrame = 0.0f;
     
     // Frame counter for captured frames
     uint32_t m_capturedFrames = 0;
     
-    // Window enumeration
+    // Monitor radio button labels, rebuilt when the capture engine's monitor list changes
+    std::vector<std::string> m_monitorLabels;
+    uint32_t m_monitorLabelsVersion = 0;
+    
+    // Window enumeration (a snapshot taken when the list is opened)
     struct WindowInfo {
         std::wstring title;
+        std::string label;  // UTF-8, converted once when enumerated
         HWND hwnd;
     };
     std::vector<WindowInfo> m_availableWindows;
@@ -0,0 +1,27 @@
+#pragma once
+#include "../Processing/ImageView.h"
+#include <cstdint>
+#include <vector>
+
+// Tightly packed BGRA8 image owned by the benchmark code
+class BenchmarkImage
+{
+public:
+    void Allocate(uint32_t width, uint32_t height)
+    {
+        m_width = width;
+        m_height = height;
+        m_pixels.resize(static_cast<size_t>(width) * height * 4);
+    }
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+
+    MutableImageView View() { return MutableImageView{ m_pixels.data(), m_width, m_height, static_cast<size_t>(m_width) * 4 }; }
+    ImageView View() const { return ImageView{ m_pixels.data(), m_width, m_height, static_cast<size_t>(m_width) * 4 }; }
+
+private:
+    std::vector<uint8_t> m_pixels;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+};
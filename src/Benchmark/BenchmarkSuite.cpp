@@ -0,0 +1,2082 @@
+#include "BenchmarkSuite.h"
+#include "ImageMetrics.h"
+#include "ReplayFile.h"
+#include "SyntheticScene.h"
+#include "../Processing/AnalysisPyramid.h"
+#include "../Processing/BlockSad.h"
+#include "../Processing/CasSharpener.h"
+#include "../Processing/CnnUpscaler.h"
+#include "../Processing/CpuUpscaler.h"
+#include "../Processing/DuplicateFrameDetector.h"
+#include "../Processing/FrameBlend.h"
+#include "../Processing/FrameBuffer.h"
+#include "../Processing/FrameGenerator.h"
+#include "../Processing/FramePool.h"
+#include "../Processing/PixelConvert.h"
+#include "../Processing/PixelSimd.h"
+#include "../Processing/ScratchArena.h"
+#include "../Processing/SceneCutDetector.h"
+#include "../Processing/TemporalUpscaler.h"
+#include "../Utils/AllocationCounter.h"
+#include "../Utils/CpuFeatures.h"
+#include "../Utils/Logger.h"
+#include "../Utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Synthetic quality run: 640x360 -> 1280x720, 4 lattice pixels per input pixel
+    const uint32_t QUALITY_WIDTH = 640;
+    const uint32_t QUALITY_HEIGHT = 360;
+    const uint32_t LATTICE_PER_PIXEL = 4;
+    const uint32_t SEQUENCE_FRAMES = 24;
+
+    // Frames before this are excluded from the steady-state average
+    const uint32_t WARMUP_FRAMES = 8;
+
+    // Cost run: 1280x720 -> 2560x1440
+    const uint32_t COST_WIDTH = 1280;
+    const uint32_t COST_HEIGHT = 720;
+    const uint32_t COST_FRAMES = 20;
+
+    // Pixel conversion run at 4K
+    const uint32_t CONVERT_WIDTH = 3840;
+    const uint32_t CONVERT_HEIGHT = 2160;
+    const uint32_t CONVERT_FRAMES = 10;
+
+    // Frame generation run: a pan of PAN_X, PAN_Y pixels between the two input frames
+    const int32_t PAN_X = 6;
+    const int32_t PAN_Y = 4;
+    const uint32_t GENERATION_RUNS = 3;
+
+    // Multi-frame run: a diagonal pan of MULTI_PAN pixels, so every t = k / N for 2x, 3x and 4x
+    // output falls on a whole pixel
+    const uint32_t MULTI_PAN = 12;
+
+    // Motion search run: pans up to MAX_PAN pixels between frames at the cost resolution
+    const int32_t MAX_PAN = 32;
+
+    // Optical flow run at 1080p; the window scene drags a WINDOW_WIDTH x WINDOW_HEIGHT window
+    // over a pan
+    const uint32_t FLOW_WIDTH = 1920;
+    const uint32_t FLOW_HEIGHT = 1080;
+    const uint32_t WINDOW_WIDTH = 640;
+    const uint32_t WINDOW_HEIGHT = 400;
+
+    // Extrapolation run: the window scene at 1080p, background panning EXTRAPOLATION_PAN and the
+    // window moving EXTRAPOLATION_MOVE pixels per source frame, shown at SOURCE_FPS. A pixel with
+    // a channel off by more than ARTIFACT_ERROR counts as an artifact
+    const int32_t EXTRAPOLATION_PAN[2] = { 8, 4 };
+    const int32_t EXTRAPOLATION_MOVE[2] = { 12, -8 };
+    const float SOURCE_FPS = 60.0f;
+    const int32_t ARTIFACT_ERROR = 32;
+
+    // Static region run: the window scene again, with a still background for menus and HUDs
+    const int32_t STATIC_RUN_MOVE[2] = { 12, -8 };
+
+    // Scene cut run: the night shot is the scene CUT_JUMP lattice pixels away at half brightness,
+    // and the loading screen is the window on LOADING_LEVEL grey
+    const uint32_t CUT_JUMP = 600;
+    const uint8_t LOADING_LEVEL = 12;
+
+    // Duplicate frame run: a GAME_FPS game captured at CAPTURE_HZ, each game frame presented on the
+    // refresh nearest its own time and panned CADENCE_PAN pixels per refresh since the first. A
+    // CARET_SIZE caret outside the game appears in capture CARET_CAPTURE, a repeat. Then
+    // SPRITE_FRAMES game frames that only move a CARET_SIZE sprite SPRITE_STEP pixels over a
+    // still scene
+    const uint32_t CAPTURE_HZ = 144;
+    const uint32_t GAME_FPS = 40;
+    const uint32_t CADENCE_CAPTURES = 72;
+    const uint32_t CADENCE_PAN = 5;
+    const uint32_t CARET_SIZE = 16;
+    const uint32_t CARET_CAPTURE = 37;
+    const uint32_t SPRITE_FRAMES = 8;
+    const uint32_t SPRITE_STEP = 4;
+
+    // Steady-state allocation check: STEADY_FRAMES frames of the CPU frame path at the quality
+    // size after the arena's warm-up; with POTATO_SCRATCH_CHECKS any heap allocation fails the run
+    const uint32_t STEADY_FRAMES = 16;
+
+    // Default sharpness of the GPU FSR path
+    const float FSR_SHARPNESS = 0.5f;
+
+    const char* MODEL_PATH = "models/espcn_x2.bin";
+
+    double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+    {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    template <typename Fn>
+    double BestOfMs(uint32_t runs, Fn&& fn)
+    {
+        double bestMs = 1e9;
+        for (uint32_t i = 0; i < runs; i++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            fn();
+            bestMs = std::min(bestMs, ElapsedMs(start));
+        }
+        return bestMs;
+    }
+
+    // White width x height rectangle at (x, y)
+    void FillRect(const MutableImageView& dst, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        for (uint32_t row = 0; row < height; row++)
+        {
+            memset(dst.Row(y + row) + x * 4, 0xFF, width * 4);
+        }
+    }
+
+    // Scene at lattice offset (backgroundX, backgroundY) with the window image pasted at
+    // (windowX, windowY), for runs that need two motions in one frame
+    void RenderWindowScene(const SyntheticScene& scene, const ImageView& window, uint32_t backgroundX, uint32_t backgroundY,
+                           uint32_t windowX, uint32_t windowY, const MutableImageView& dst)
+    {
+        scene.Render(backgroundX, backgroundY, 1, dst);
+        for (uint32_t row = 0; row < window.height; row++)
+        {
+            memcpy(dst.Row(windowY + row) + windowX * 4, window.Row(row), static_cast<size_t>(window.width) * 4);
+        }
+    }
+
+    // Per-pixel references for the conversion run, the way they'd be written without SIMD
+    uint8_t HalfToByteScalar(uint16_t half)
+    {
+        float value = HalfToFloat(half);
+        value = (value > 0.0f) ? std::min(value, 1.0f) : 0.0f;
+        return static_cast<uint8_t>(std::nearbyint(value * 255.0f));
+    }
+
+    void VideoScalar(const ImageView& src, uint8_t* luma, uint8_t* chroma)
+    {
+        const uint32_t chromaWidth = (src.width + 1) / 2;
+        for (uint32_t y = 0; y < src.height; y++)
+        {
+            for (uint32_t x = 0; x < src.width; x++)
+            {
+                const uint8_t* p = src.Row(y) + x * 4;
+                luma[y * src.width + x] = static_cast<uint8_t>(((p[0] * 25 + p[1] * 129 + p[2] * 66 + 128) >> 8) + 16);
+            }
+        }
+        for (uint32_t cy = 0; cy < (src.height + 1) / 2; cy++)
+        {
+            for (uint32_t cx = 0; cx < chromaWidth; cx++)
+            {
+                int sum[3] = {};
+                for (uint32_t i = 0; i < 4; i++)
+                {
+                    uint32_t x = std::min(cx * 2 + (i & 1), src.width - 1);
+                    uint32_t y = std::min(cy * 2 + (i >> 1), src.height - 1);
+                    const uint8_t* p = src.Row(y) + x * 4;
+                    for (int c = 0; c < 3; c++) sum[c] += p[c];
+                }
+                uint8_t* uv = chroma + (cy * chromaWidth + cx) * 2;
+                uv[0] = static_cast<uint8_t>(((sum[0] * 112 - sum[1] * 74 - sum[2] * 38 + 512) >> 10) + 128);
+                uv[1] = static_cast<uint8_t>(((sum[2] * 112 - sum[1] * 94 - sum[0] * 18 + 512) >> 10) + 128);
+            }
+        }
+    }
+
+    // Frame layout run: the FSR port and block matching written once against FrameBuffer
+    // and instantiated for each layout
+    const uint32_t MATCH_BLOCK = 8;
+    const int MATCH_RANGE = 4;
+
+    template <typename Layout>
+    using BgraFrame = FrameBuffer<Bgra8Pixel, Layout>;
+
+    template <typename Layout>
+    inline __m128 LoadFramePixel(const BgraFrame<Layout>& frame, uint32_t x, uint32_t y)
+    {
+        const uint8_t* pixel = frame.PixelAt(x, y);
+        if constexpr (BgraFrame<Layout>::Geometry::INTERLEAVED)
+        {
+            return LoadPixel(pixel);
+        }
+        else
+        {
+            const size_t plane = frame.ChannelStride();
+            return _mm_setr_ps(pixel[0], pixel[plane], pixel[plane * 2], pixel[plane * 3]);
+        }
+    }
+
+    template <typename Layout>
+    inline void StoreFramePixel(BgraFrame<Layout>& frame, uint32_t x, uint32_t y, __m128 value)
+    {
+        uint8_t* pixel = frame.PixelAt(x, y);
+        if constexpr (BgraFrame<Layout>::Geometry::INTERLEAVED)
+        {
+            StorePixel(pixel, value);
+        }
+        else
+        {
+            uint8_t packed[4];
+            StorePixel(packed, value);
+            const size_t plane = frame.ChannelStride();
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                pixel[c * plane] = packed[c];
+            }
+        }
+    }
+
+    struct LayoutTap
+    {
+        uint32_t p0;
+        uint32_t p1;
+        float weight;
+    };
+
+    // Previous/center/next taps of each output column or row, the same as SetFsrColumns()
+    std::vector<LayoutTap> BuildFsrTaps(uint32_t srcSize, uint32_t dstSize)
+    {
+        const float scale = static_cast<float>(srcSize) / dstSize;
+        const float maxPosition = static_cast<float>(srcSize - 1);
+        std::vector<LayoutTap> taps(static_cast<size_t>(dstSize) * 3);
+        for (uint32_t i = 0; i < dstSize; i++)
+        {
+            float center = (i + 0.5f) * scale - 0.5f;
+            for (int k = 0; k < 3; k++)
+            {
+                float position = std::min(std::max(center + k - 1, 0.0f), maxPosition);
+                uint32_t p0 = static_cast<uint32_t>(position);
+                taps[i * 3 + k] = LayoutTap{ p0, std::min(p0 + 1, srcSize - 1), position - p0 };
+            }
+        }
+        return taps;
+    }
+
+    template <typename Layout>
+    inline __m128 SampleFrame(const BgraFrame<Layout>& frame, const LayoutTap& tapX, const LayoutTap& tapY)
+    {
+        __m128 fx = _mm_set1_ps(tapX.weight);
+        __m128 fy = _mm_set1_ps(tapY.weight);
+        __m128 p00 = LoadFramePixel(frame, tapX.p0, tapY.p0);
+        __m128 p01 = LoadFramePixel(frame, tapX.p1, tapY.p0);
+        __m128 p10 = LoadFramePixel(frame, tapX.p0, tapY.p1);
+        __m128 p11 = LoadFramePixel(frame, tapX.p1, tapY.p1);
+        __m128 top = _mm_add_ps(p00, _mm_mul_ps(_mm_sub_ps(p01, p00), fx));
+        __m128 bottom = _mm_add_ps(p10, _mm_mul_ps(_mm_sub_ps(p11, p10), fx));
+        return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy));
+    }
+
+    inline float FrameLuminance(__m128 pixel)
+    {
+        __m128 v = _mm_mul_ps(pixel, _mm_setr_ps(0.114f, 0.587f, 0.299f, 0.0f));
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    // CpuUpscaler::FsrRows() for one row of the output's blocks, walking them in storage order
+    template <typename Layout>
+    void FsrFrameBlocks(const BgraFrame<Layout>& src, BgraFrame<Layout>& dst, const LayoutTap* columns, const LayoutTap* rows,
+                        float sharpness, uint32_t blockRow)
+    {
+        dst.ForEachBlock(blockRow, [&](uint32_t blockX, uint32_t blockY, uint32_t blockWidth, uint32_t blockHeight)
+        {
+            for (uint32_t y = blockY; y < blockY + blockHeight; y++)
+            {
+                const LayoutTap* tapY = rows + y * 3;
+                for (uint32_t x = blockX; x < blockX + blockWidth; x++)
+                {
+                    const LayoutTap* tapX = columns + x * 3;
+                    __m128 center = SampleFrame(src, tapX[1], tapY[1]);
+                    __m128 north = SampleFrame(src, tapX[1], tapY[0]);
+                    __m128 south = SampleFrame(src, tapX[1], tapY[2]);
+                    __m128 west = SampleFrame(src, tapX[0], tapY[1]);
+                    __m128 east = SampleFrame(src, tapX[2], tapY[1]);
+
+                    float lumCenter = FrameLuminance(center);
+                    float lumNorth = FrameLuminance(north);
+                    float lumSouth = FrameLuminance(south);
+                    float lumEast = FrameLuminance(east);
+                    float lumWest = FrameLuminance(west);
+                    float lumMin = std::min(lumCenter, std::min(std::min(lumNorth, lumSouth), std::min(lumEast, lumWest)));
+                    float lumMax = std::max(lumCenter, std::max(std::max(lumNorth, lumSouth), std::max(lumEast, lumWest)));
+
+                    float edgeStrength = std::min((lumMax - lumMin) * (4.0f / 255.0f), 1.0f);
+                    __m128 amount = _mm_set1_ps(sharpness * edgeStrength);
+
+                    __m128 neighbours = _mm_mul_ps(_mm_add_ps(_mm_add_ps(north, south), _mm_add_ps(east, west)), _mm_set1_ps(0.25f));
+                    __m128 sharpened = _mm_add_ps(center, _mm_mul_ps(_mm_sub_ps(center, neighbours), amount));
+
+                    __m128 minColor = _mm_min_ps(center, _mm_min_ps(_mm_min_ps(north, south), _mm_min_ps(east, west)));
+                    __m128 maxColor = _mm_max_ps(center, _mm_max_ps(_mm_max_ps(north, south), _mm_max_ps(east, west)));
+                    StoreFramePixel(dst, x, y, _mm_min_ps(_mm_max_ps(sharpened, minColor), maxColor));
+                }
+            }
+        });
+    }
+
+    // Sum of absolute RGB differences between the MATCH_BLOCK block of current at (x, y) and
+    // the one of previous at (px, py), psadbw on 8 pixels of a row at a time
+    // Rows of previous that straddle two tiles are gathered pixel by pixel
+    template <typename Layout>
+    uint32_t BlockSad(const BgraFrame<Layout>& current, const BgraFrame<Layout>& previous, uint32_t x, uint32_t y, uint32_t px, uint32_t py)
+    {
+        __m128i sum = _mm_setzero_si128();
+        for (uint32_t row = 0; row < MATCH_BLOCK; row++)
+        {
+            const uint8_t* a = current.PixelAt(x, y + row);
+            const uint8_t* b = previous.PixelAt(px, py + row);
+            if constexpr (BgraFrame<Layout>::Geometry::INTERLEAVED)
+            {
+                __m128i vb[2];
+                uint32_t run = previous.GetGeometry().RunLength(px);
+                if (run >= MATCH_BLOCK)
+                {
+                    vb[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+                    vb[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16));
+                }
+                else
+                {
+                    const uint8_t* next = previous.PixelAt(px + run, py + row) - run * 4;
+                    int32_t pixels[MATCH_BLOCK];
+                    for (uint32_t i = 0; i < MATCH_BLOCK; i++)
+                    {
+                        memcpy(&pixels[i], (i < run ? b : next) + i * 4, 4);
+                    }
+                    vb[0] = _mm_setr_epi32(pixels[0], pixels[1], pixels[2], pixels[3]);
+                    vb[1] = _mm_setr_epi32(pixels[4], pixels[5], pixels[6], pixels[7]);
+                }
+
+                const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+                for (int i = 0; i < 2; i++)
+                {
+                    __m128i va = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * 16)), colorMask);
+                    sum = _mm_add_epi64(sum, _mm_sad_epu8(va, _mm_and_si128(vb[i], colorMask)));
+                }
+            }
+            else
+            {
+                const size_t plane = current.ChannelStride();
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    __m128i va = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + c * plane));
+                    __m128i vb = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + c * plane));
+                    sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+                }
+            }
+        }
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+    }
+
+    // Best match within +-MATCH_RANGE for a row of blocks of current, like the full search of
+    // MotionEstimation.hlsl; candidates outside previous are skipped and ties keep the first
+    template <typename Layout>
+    void MatchBlockRow(const BgraFrame<Layout>& current, const BgraFrame<Layout>& previous, uint32_t blockRow, int8_t* vectors)
+    {
+        const uint32_t blocksX = current.GetWidth() / MATCH_BLOCK;
+        const int maxX = static_cast<int>(current.GetWidth() - MATCH_BLOCK);
+        const int maxY = static_cast<int>(current.GetHeight() - MATCH_BLOCK);
+        const int y = static_cast<int>(blockRow * MATCH_BLOCK);
+        for (uint32_t block = 0; block < blocksX; block++)
+        {
+            const int x = static_cast<int>(block * MATCH_BLOCK);
+            uint32_t best = UINT32_MAX;
+            int8_t bestX = 0;
+            int8_t bestY = 0;
+            for (int dy = -MATCH_RANGE; dy <= MATCH_RANGE; dy++)
+            {
+                for (int dx = -MATCH_RANGE; dx <= MATCH_RANGE; dx++)
+                {
+                    if (x + dx < 0 || y + dy < 0 || x + dx > maxX || y + dy > maxY)
+                    {
+                        continue;
+                    }
+                    uint32_t sad = BlockSad(current, previous, x, y, x + dx, y + dy);
+                    if (sad < best)
+                    {
+                        best = sad;
+                        bestX = static_cast<int8_t>(dx);
+                        bestY = static_cast<int8_t>(dy);
+                    }
+                }
+            }
+            vectors[(blockRow * blocksX + block) * 2] = bestX;
+            vectors[(blockRow * blocksX + block) * 2 + 1] = bestY;
+        }
+    }
+
+    struct LayoutResult
+    {
+        double loadMs = 0.0;
+        double fsrMs = 0.0;
+        double matchMs = 0.0;
+        bool fsrExact = false;
+        std::vector<int8_t> vectors;
+    };
+
+    // Conversion from the interleaved input, the FSR port against reference and block matching
+    // between two frames, all on Layout
+    template <typename Layout>
+    LayoutResult RunLayout(const ImageView& input, const ImageView& reference, const ImageView& current, const ImageView& previous,
+                           const MutableImageView& output, uint32_t runs)
+    {
+        ThreadPool& pool = ThreadPool::Shared();
+        LayoutResult result;
+
+        BgraFrame<Layout> source;
+        result.loadMs = BestOfMs(runs, [&]()
+        {
+            source.Load(input);
+        });
+
+        BgraFrame<Layout> upscaled;
+        upscaled.Allocate(reference.width, reference.height);
+        std::vector<LayoutTap> columns = BuildFsrTaps(input.width, reference.width);
+        std::vector<LayoutTap> rows = BuildFsrTaps(input.height, reference.height);
+        const uint32_t blockRows = upscaled.GetBlockRows();
+        result.fsrMs = BestOfMs(runs, [&]()
+        {
+            pool.ParallelFor(blockRows, pool.SuggestGrain(blockRows), [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t row = begin; row < end; row++)
+                {
+                    FsrFrameBlocks(source, upscaled, columns.data(), rows.data(), FSR_SHARPNESS, row);
+                }
+            });
+        });
+
+        upscaled.Store(output);
+        result.fsrExact = true;
+        for (uint32_t y = 0; y < reference.height; y++)
+        {
+            if (memcmp(output.Row(y), reference.Row(y), static_cast<size_t>(reference.width) * 4) != 0)
+            {
+                result.fsrExact = false;
+                break;
+            }
+        }
+
+        BgraFrame<Layout> frames[2];
+        frames[0].Load(current);
+        frames[1].Load(previous);
+        const uint32_t matchRows = current.height / MATCH_BLOCK;
+        result.vectors.resize(static_cast<size_t>(current.width / MATCH_BLOCK) * matchRows * 2);
+        result.matchMs = BestOfMs(runs, [&]()
+        {
+            pool.ParallelFor(matchRows, pool.SuggestGrain(matchRows), [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t row = begin; row < end; row++)
+                {
+                    MatchBlockRow(frames[0], frames[1], row, result.vectors.data());
+                }
+            });
+        });
+        return result;
+    }
+}
+
+BenchmarkSuite::BenchmarkSuite(const BenchmarkOptions& options)
+    : m_options(options)
+    , m_cpuUpscaler(std::make_unique<CpuUpscaler>())
+    , m_temporalUpscaler(std::make_unique<TemporalUpscaler>())
+    , m_cnnUpscaler(std::make_unique<CnnUpscaler>())
+    , m_casSharpener(std::make_unique<CasSharpener>())
+{
+}
+
+BenchmarkSuite::~BenchmarkSuite()
+{
+}
+
+const char* BenchmarkSuite::GetMethodName(Method method)
+{
+    switch (method)
+    {
+    case Method::Bilinear: return "Bilinear";
+    case Method::Fsr: return "FSR (CPU port)";
+    case Method::EdgeDirected: return "Edge-Directed";
+    case Method::Temporal: return "Temporal";
+    case Method::Neural: return "Neural";
+    default: return "Unknown";
+    }
+}
+
+void BenchmarkSuite::Upscale(Method method, const ImageView& src, const MutableImageView& dst)
+{
+    switch (method)
+    {
+    case Method::Fsr:
+        m_cpuUpscaler->Fsr(src, dst, FSR_SHARPNESS);
+        break;
+    case Method::EdgeDirected:
+        m_cpuUpscaler->EdgeDirected(src, dst);
+        break;
+    case Method::Temporal:
+        m_temporalUpscaler->Upscale(src, dst);
+        break;
+    case Method::Neural:
+        m_cnnUpscaler->Upscale(src, dst);
+        break;
+    case Method::Bilinear:
+    default:
+        m_cpuUpscaler->Bilinear(src, dst);
+        break;
+    }
+}
+
+void BenchmarkSuite::ResetHistory()
+{
+    m_temporalUpscaler->Reset();
+}
+
+int BenchmarkSuite::Run()
+{
+    const CpuFeatures& cpu = GetCpuFeatures();
+    Logger::Info("=== PotatoPatch benchmark ===");
+    Logger::Info("Threads: %u, SSE4.1: %s, AVX2: %s, F16C: %s, AVX-VNNI: %s",
+        ThreadPool::Shared().GetThreadCount(),
+        cpu.sse41 ? "yes" : "no", cpu.avx2 ? "yes" : "no", cpu.f16c ? "yes" : "no", cpu.avxVnni ? "yes" : "no");
+
+    // Without the model the neural rows show the bilinear fallback
+    m_cnnUpscaler->LoadModel(MODEL_PATH);
+
+    RunSyntheticQuality();
+
+    if (!m_options.replayPath.empty())
+    {
+        RunReplayQuality();
+    }
+
+    RunUpscaleCost();
+    RunLinearLight();
+    RunPixelConvert();
+    RunFixedPoint();
+    RunFrameLayouts();
+    RunFramePool();
+    RunAnalysisPyramid();
+    RunFrameGeneration();
+    RunMotionSearch();
+    RunBlockSad();
+    RunOpticalFlow();
+    RunExtrapolation();
+    RunStaticRegions();
+    RunSceneCuts();
+    RunDuplicateFrames();
+    const bool allocationFree = RunSteadyAllocations();
+
+    Logger::Info("Benchmark complete");
+    return allocationFree ? 0 : 1;
+}
+
+void BenchmarkSuite::PrintResult(const char* name, const Result& result)
+{
+    Logger::Info("  %-16s first %6.2f dB  steady %6.2f dB  %8.2f ms", name, result.firstPsnr, result.steadyPsnr, result.averageMs);
+}
+
+void BenchmarkSuite::RunSyntheticQuality()
+{
+    static const Sequence sequences[] =
+    {
+        { "Static", 0, 0 },
+        { "Slow pan", 1, 1 },      // 0.25 input pixel per frame
+        { "Scroll", 0, 6 },        // 1.5 input pixels per frame
+        { "Fast pan", 12, 5 },     // 3 x 1.25 input pixels per frame
+    };
+
+    const uint32_t outputWidth = QUALITY_WIDTH * 2;
+    const uint32_t outputHeight = QUALITY_HEIGHT * 2;
+    const uint32_t margin = 12 * SEQUENCE_FRAMES;
+
+    SyntheticScene scene;
+    scene.Initialize(QUALITY_WIDTH * LATTICE_PER_PIXEL + margin, QUALITY_HEIGHT * LATTICE_PER_PIXEL + margin);
+
+    m_input.Allocate(QUALITY_WIDTH, QUALITY_HEIGHT);
+    m_output.Allocate(outputWidth, outputHeight);
+    m_reference.Allocate(outputWidth, outputHeight);
+
+    Logger::Info("Synthetic sequences: %ux%u -> %ux%u, %u frames", QUALITY_WIDTH, QUALITY_HEIGHT, outputWidth, outputHeight, SEQUENCE_FRAMES);
+
+    for (const Sequence& sequence : sequences)
+    {
+        Logger::Info("%s:", sequence.name);
+        for (int m = 0; m < static_cast<int>(Method::Count); m++)
+        {
+            Method method = static_cast<Method>(m);
+            ResetHistory();
+
+            Result result;
+            double steadySum = 0.0;
+            for (uint32_t frame = 0; frame < SEQUENCE_FRAMES; frame++)
+            {
+                uint32_t offsetX = sequence.stepX * frame;
+                uint32_t offsetY = sequence.stepY * frame;
+                scene.Render(offsetX, offsetY, LATTICE_PER_PIXEL, m_input.View());
+                scene.Render(offsetX, offsetY, LATTICE_PER_PIXEL / 2, m_reference.View());
+
+                auto start = std::chrono::high_resolution_clock::now();
+                Upscale(method, m_input.View(), m_output.View());
+                result.averageMs += ElapsedMs(start);
+
+                double psnr = ComputePsnr(m_output.View(), m_reference.View());
+                if (frame == 0) result.firstPsnr = psnr;
+                if (frame >= WARMUP_FRAMES) steadySum += psnr;
+            }
+
+            result.averageMs /= SEQUENCE_FRAMES;
+            result.steadyPsnr = steadySum / (SEQUENCE_FRAMES - WARMUP_FRAMES);
+            PrintResult(GetMethodName(method), result);
+        }
+    }
+}
+
+void BenchmarkSuite::RunReplayQuality()
+{
+    ReplayReader reader;
+    if (!reader.Open(m_options.replayPath))
+    {
+        return;
+    }
+
+    // Even size so the 2x box downscale is exact
+    const uint32_t outputWidth = reader.GetWidth() & ~1u;
+    const uint32_t outputHeight = reader.GetHeight() & ~1u;
+    m_input.Allocate(outputWidth / 2, outputHeight / 2);
+    m_output.Allocate(outputWidth, outputHeight);
+
+    Logger::Info("Replay: %ux%u -> %ux%u, %u frames", outputWidth / 2, outputHeight / 2, outputWidth, outputHeight, reader.GetFrameCount());
+
+    for (int m = 0; m < static_cast<int>(Method::Count); m++)
+    {
+        Method method = static_cast<Method>(m);
+        ResetHistory();
+        reader.Rewind();
+
+        Result result;
+        double steadySum = 0.0;
+        uint32_t frames = 0;
+        ImageView frame;
+        uint64_t timestamp = 0;
+        while (reader.ReadFrame(frame, timestamp))
+        {
+            ImageView reference = frame.Crop(0, 0, outputWidth, outputHeight);
+            BoxDownsample(reference, m_input.View(), 2);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            Upscale(method, m_input.View(), m_output.View());
+            result.averageMs += ElapsedMs(start);
+
+            double psnr = ComputePsnr(m_output.View(), reference);
+            if (frames == 0) result.firstPsnr = psnr;
+            if (frames >= WARMUP_FRAMES) steadySum += psnr;
+            frames++;
+        }
+
+        if (frames == 0)
+        {
+            Logger::Warning("Replay contains no frames");
+            return;
+        }
+
+        result.averageMs /= frames;
+        result.steadyPsnr = frames > WARMUP_FRAMES ? steadySum / (frames - WARMUP_FRAMES) : result.firstPsnr;
+        PrintResult(GetMethodName(method), result);
+    }
+}
+
+void BenchmarkSuite::RunUpscaleCost()
+{
+    // Content only needs to be realistic here, 2 lattice pixels per input pixel keeps it small
+    SyntheticScene scene;
+    scene.Initialize(COST_WIDTH * 2 + COST_FRAMES, COST_HEIGHT * 2 + COST_FRAMES);
+
+    m_input.Allocate(COST_WIDTH, COST_HEIGHT);
+    m_output.Allocate(COST_WIDTH * 2, COST_HEIGHT * 2);
+
+    Logger::Info("Cost: %ux%u -> %ux%u, %u frames", COST_WIDTH, COST_HEIGHT, COST_WIDTH * 2, COST_HEIGHT * 2, COST_FRAMES);
+
+    for (int m = 0; m < static_cast<int>(Method::Count); m++)
+    {
+        Method method = static_cast<Method>(m);
+        ResetHistory();
+
+        double totalMs = 0.0;
+        double bestMs = 1e9;
+        for (uint32_t frame = 0; frame < COST_FRAMES; frame++)
+        {
+            scene.Render(frame, frame, 2, m_input.View());
+
+            auto start = std::chrono::high_resolution_clock::now();
+            Upscale(method, m_input.View(), m_output.View());
+            double ms = ElapsedMs(start);
+            totalMs += ms;
+            bestMs = std::min(bestMs, ms);
+        }
+
+        double averageMs = totalMs / COST_FRAMES;
+        double megapixelsPerSecond = COST_WIDTH * 2.0 * COST_HEIGHT * 2.0 / (averageMs * 1000.0);
+        Logger::Info("  %-16s avg %8.2f ms  best %8.2f ms  %7.1f Mpix/s", GetMethodName(method), averageMs, bestMs, megapixelsPerSecond);
+    }
+
+    // Sharpen-only mode at native output resolution, in place
+    double totalMs = 0.0;
+    double bestMs = 1e9;
+    for (uint32_t frame = 0; frame < COST_FRAMES; frame++)
+    {
+        scene.Render(frame, frame, 1, m_output.View());
+
+        auto start = std::chrono::high_resolution_clock::now();
+        m_casSharpener->Sharpen(m_output.View(), FSR_SHARPNESS);
+        double ms = ElapsedMs(start);
+        totalMs += ms;
+        bestMs = std::min(bestMs, ms);
+    }
+
+    double averageMs = totalMs / COST_FRAMES;
+    double megapixelsPerSecond = COST_WIDTH * 2.0 * COST_HEIGHT * 2.0 / (averageMs * 1000.0);
+    Logger::Info("  %-16s avg %8.2f ms  best %8.2f ms  %7.1f Mpix/s", "CAS (native)", averageMs, bestMs, megapixelsPerSecond);
+}
+
+void BenchmarkSuite::RunLinearLight()
+{
+    // The kernels with a linear-light mode
+    static const Method methods[] = { Method::Bilinear, Method::Fsr, Method::EdgeDirected };
+    const int methodCount = 3;
+
+    // Input and references are box filtered in linear light, like a real render, so filtering
+    // the encoded values shows up as darkened edges. A 2x bilinear downscale is exactly that
+    // box filter, so it isolates the colour space from the upscalers' own errors.
+    const uint32_t outputWidth = QUALITY_WIDTH * 2;
+    const uint32_t outputHeight = QUALITY_HEIGHT * 2;
+
+    SyntheticScene scene;
+    scene.Initialize(COST_WIDTH * 2 + COST_FRAMES, COST_HEIGHT * 2 + COST_FRAMES);
+
+    m_input.Allocate(QUALITY_WIDTH, QUALITY_HEIGHT);
+    m_output.Allocate(outputWidth, outputHeight);
+    m_reference.Allocate(outputWidth, outputHeight);
+    scene.Render(0, 0, LATTICE_PER_PIXEL, m_input.View(), true);
+    scene.Render(0, 0, LATTICE_PER_PIXEL / 2, m_reference.View(), true);
+
+    BenchmarkImage downscaled;
+    downscaled.Allocate(QUALITY_WIDTH, QUALITY_HEIGHT);
+
+    double upscalePsnr[2][methodCount];
+    double downscalePsnr[2];
+    for (int linear = 0; linear < 2; linear++)
+    {
+        m_cpuUpscaler->SetLinearLight(linear != 0);
+        for (int m = 0; m < methodCount; m++)
+        {
+            Upscale(methods[m], m_input.View(), m_output.View());
+            upscalePsnr[linear][m] = ComputePsnr(m_output.View(), m_reference.View());
+        }
+        m_cpuUpscaler->Bilinear(m_reference.View(), downscaled.View());
+        downscalePsnr[linear] = ComputePsnr(downscaled.View(), m_input.View());
+    }
+
+    // Cost on the RunUpscaleCost frames, both modes on each frame, best of COST_FRAMES
+    m_input.Allocate(COST_WIDTH, COST_HEIGHT);
+    m_output.Allocate(COST_WIDTH * 2, COST_HEIGHT * 2);
+
+    double bestMs[2][methodCount];
+    std::fill(&bestMs[0][0], &bestMs[0][0] + 2 * methodCount, 1e9);
+    for (uint32_t frame = 0; frame < COST_FRAMES; frame++)
+    {
+        scene.Render(frame, frame, 2, m_input.View());
+        for (int m = 0; m < methodCount; m++)
+        {
+            for (int linear = 0; linear < 2; linear++)
+            {
+                m_cpuUpscaler->SetLinearLight(linear != 0);
+                auto start = std::chrono::high_resolution_clock::now();
+                Upscale(methods[m], m_input.View(), m_output.View());
+                bestMs[linear][m] = std::min(bestMs[linear][m], ElapsedMs(start));
+            }
+        }
+    }
+    m_cpuUpscaler->SetLinearLight(false);
+
+    Logger::Info("Linear light: %ux%u -> %ux%u PSNR against linear-light references, best time at %ux%u -> %ux%u",
+        QUALITY_WIDTH, QUALITY_HEIGHT, outputWidth, outputHeight, COST_WIDTH, COST_HEIGHT, COST_WIDTH * 2, COST_HEIGHT * 2);
+    Logger::Info("  %-16s gamma %6.2f dB  linear %6.2f dB", "2x downscale", downscalePsnr[0], downscalePsnr[1]);
+    for (int m = 0; m < methodCount; m++)
+    {
+        Logger::Info("  %-16s gamma %6.2f dB %8.2f ms  linear %6.2f dB %8.2f ms  (%+.1f%% time)",
+            GetMethodName(methods[m]), upscalePsnr[0][m], bestMs[0][m], upscalePsnr[1][m], bestMs[1][m],
+            (bestMs[1][m] / bestMs[0][m] - 1.0) * 100.0);
+    }
+}
+
+void BenchmarkSuite::RunPixelConvert()
+{
+    const uint32_t width = CONVERT_WIDTH;
+    const uint32_t height = CONVERT_HEIGHT;
+    const size_t pixels = static_cast<size_t>(width) * height;
+    const uint32_t chromaWidth = (width + 1) / 2;
+    const size_t chromaSize = static_cast<size_t>(chromaWidth) * ((height + 1) / 2);
+
+    SyntheticScene scene;
+    scene.Initialize(width, height);
+    BenchmarkImage frame;
+    frame.Allocate(width, height);
+    scene.Render(0, 0, 1, frame.View());
+    const ImageView src = static_cast<const BenchmarkImage&>(frame).View();
+
+    // Sources for the unpack direction: the same frame as 10:10:10:2 and FP16
+    std::vector<uint32_t> packed10(pixels);
+    std::vector<uint16_t> halfPixels(pixels * 4);
+    for (size_t i = 0; i < pixels; i++)
+    {
+        const uint8_t* p = src.data + i * 4;
+        uint32_t r = (p[2] * 1023 + 127) / 255;
+        uint32_t g = (p[1] * 1023 + 127) / 255;
+        uint32_t b = (p[0] * 1023 + 127) / 255;
+        packed10[i] = r | (g << 10) | (b << 20) | (3u << 30);
+    }
+
+    std::vector<uint8_t> expected(pixels * 4);
+    std::vector<uint8_t> actual(pixels * 4);
+    std::vector<uint16_t> expectedHalf(pixels * 4);
+    std::vector<uint8_t> expectedVideo(pixels + chromaSize * 2);
+    std::vector<uint8_t> actualVideo(pixels + chromaSize * 2);
+    std::vector<uint8_t> planarVideo(pixels + chromaSize * 2);
+    const size_t rowBytes = static_cast<size_t>(width) * 4;
+    const MutableImageView actualView{ actual.data(), width, height, rowBytes };
+
+    Logger::Info("Pixel conversion: %ux%u, best of %u, %u threads (scalar reference on one thread)",
+        width, height, CONVERT_FRAMES, ThreadPool::Shared().GetThreadCount());
+
+    auto report = [&](const char* name, double scalarMs, double simdMs, bool exact)
+    {
+        Logger::Info("  %-16s scalar %8.2f ms  simd %7.2f ms  %5.1fx  %7.1f Mpix/s  %s", name, scalarMs, simdMs,
+            scalarMs / simdMs, pixels / (simdMs * 1000.0), exact ? "exact" : "MISMATCH");
+    };
+
+    // BGRA8 -> RGBA8 (the upload swizzle)
+    double scalarMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        for (size_t i = 0; i < pixels; i++)
+        {
+            expected[i * 4] = src.data[i * 4 + 2];
+            expected[i * 4 + 1] = src.data[i * 4 + 1];
+            expected[i * 4 + 2] = src.data[i * 4];
+            expected[i * 4 + 3] = src.data[i * 4 + 3];
+        }
+    });
+    double simdMs = BestOfMs(CONVERT_FRAMES, [&]() { BgraToRgba(src, MutablePlaneView{ actual.data(), rowBytes }); });
+    report("BGRA -> RGBA", scalarMs, simdMs, expected == actual);
+
+    // BGRA8 -> luma
+    scalarMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        for (size_t i = 0; i < pixels; i++)
+        {
+            expected[i] = PixelLuma(src.data + i * 4);
+        }
+    });
+    simdMs = BestOfMs(CONVERT_FRAMES, [&]() { BgraToLuma(src, MutablePlaneView{ actual.data(), width }); });
+    report("BGRA -> luma", scalarMs, simdMs, memcmp(expected.data(), actual.data(), pixels) == 0);
+
+    // BGRA8 -> NV12 and I420 (I420 is checked against the NV12 reference deinterleaved)
+    scalarMs = BestOfMs(CONVERT_FRAMES, [&]() { VideoScalar(src, expectedVideo.data(), expectedVideo.data() + pixels); });
+    simdMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        BgraToNv12(src, MutablePlaneView{ actualVideo.data(), width }, MutablePlaneView{ actualVideo.data() + pixels, chromaWidth * 2 });
+    });
+    report("BGRA -> NV12", scalarMs, simdMs, expectedVideo == actualVideo);
+
+    simdMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        uint8_t* u = planarVideo.data() + pixels;
+        BgraToI420(src, MutablePlaneView{ planarVideo.data(), width }, MutablePlaneView{ u, chromaWidth },
+            MutablePlaneView{ u + chromaSize, chromaWidth });
+    });
+    bool exact = memcmp(expectedVideo.data(), planarVideo.data(), pixels) == 0;
+    for (size_t i = 0; i < chromaSize && exact; i++)
+    {
+        exact = planarVideo[pixels + i] == expectedVideo[pixels + i * 2] &&
+                planarVideo[pixels + chromaSize + i] == expectedVideo[pixels + i * 2 + 1];
+    }
+    report("BGRA -> I420", scalarMs, simdMs, exact);
+
+    // BGRA8 -> FP16 and back
+    scalarMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        for (size_t i = 0; i < pixels; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                expectedHalf[i * 4 + c] = FloatToHalf(src.data[i * 4 + 2 - c] / 255.0f);
+            }
+            expectedHalf[i * 4 + 3] = FloatToHalf(src.data[i * 4 + 3] / 255.0f);
+        }
+    });
+    simdMs = BestOfMs(CONVERT_FRAMES, [&]() { BgraToHalf(src, MutablePlaneView{ reinterpret_cast<uint8_t*>(halfPixels.data()), rowBytes * 2 }); });
+    report("BGRA -> FP16", scalarMs, simdMs, expectedHalf == halfPixels);
+
+    scalarMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        for (size_t i = 0; i < pixels; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                expected[i * 4 + 2 - c] = HalfToByteScalar(halfPixels[i * 4 + c]);
+            }
+            expected[i * 4 + 3] = HalfToByteScalar(halfPixels[i * 4 + 3]);
+        }
+    });
+    simdMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        ConvertToBgra(PixelFormat::Rgba16F, PlaneView{ reinterpret_cast<const uint8_t*>(halfPixels.data()), rowBytes * 2 }, actualView);
+    });
+    report("FP16 -> BGRA", scalarMs, simdMs, expected == actual);
+
+    // 10:10:10:2 -> BGRA8
+    scalarMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        for (size_t i = 0; i < pixels; i++)
+        {
+            uint32_t v = packed10[i];
+            expected[i * 4] = static_cast<uint8_t>((((v >> 20) & 0x3FF) * 255 + 511) / 1023);
+            expected[i * 4 + 1] = static_cast<uint8_t>((((v >> 10) & 0x3FF) * 255 + 511) / 1023);
+            expected[i * 4 + 2] = static_cast<uint8_t>(((v & 0x3FF) * 255 + 511) / 1023);
+            expected[i * 4 + 3] = static_cast<uint8_t>((v >> 30) * 85);
+        }
+    });
+    simdMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        ConvertToBgra(PixelFormat::Rgb10A2, PlaneView{ reinterpret_cast<const uint8_t*>(packed10.data()), rowBytes }, actualView);
+    });
+    report("RGB10A2 -> BGRA", scalarMs, simdMs, expected == actual);
+}
+
+void BenchmarkSuite::RunFixedPoint()
+{
+    const uint32_t outputWidth = COST_WIDTH * 2;
+    const uint32_t outputHeight = COST_HEIGHT * 2;
+    const size_t channels = static_cast<size_t>(outputWidth) * outputHeight * 4;
+
+    SyntheticScene scene;
+    scene.Initialize(outputWidth + 2, outputHeight + 2);
+    m_input.Allocate(COST_WIDTH, COST_HEIGHT);
+    scene.Render(0, 0, 2, m_input.View());
+
+    // Two frames a pixel apart for the blend, the first one doubles as the CAS input
+    BenchmarkImage frames[2];
+    for (int i = 0; i < 2; i++)
+    {
+        frames[i].Allocate(outputWidth, outputHeight);
+        scene.Render(i, i, 1, frames[i].View());
+    }
+    const BenchmarkImage& first = frames[0];
+    const BenchmarkImage& second = frames[1];
+
+    // Output of each precision, compared channel by channel once both have run
+    BenchmarkImage results[2];
+    results[0].Allocate(outputWidth, outputHeight);
+    results[1].Allocate(outputWidth, outputHeight);
+
+    Logger::Info("Fixed point: float vs Fixed16 kernels, best of %u, |fixed - float| over all channels", COST_FRAMES);
+
+    auto report = [&](const char* name, const double (&ms)[2])
+    {
+        const uint8_t* a = static_cast<const BenchmarkImage&>(results[0]).View().data;
+        const uint8_t* b = static_cast<const BenchmarkImage&>(results[1]).View().data;
+        size_t histogram[3] = {};
+        for (size_t i = 0; i < channels; i++)
+        {
+            int difference = std::abs(a[i] - b[i]);
+            histogram[std::min(difference, 2)]++;
+        }
+        Logger::Info("  %-16s float %7.2f ms  fixed %7.2f ms  %4.2fx  |d|=0 %6.2f%%  1 %6.2f%%  >1 %zu", name, ms[0], ms[1],
+            ms[0] / ms[1], histogram[0] * 100.0 / channels, histogram[1] * 100.0 / channels, histogram[2]);
+    };
+
+    double ms[2];
+    for (int fixed = 0; fixed < 2; fixed++)
+    {
+        KernelPrecision precision = fixed ? KernelPrecision::Fixed16 : KernelPrecision::Float;
+        m_cpuUpscaler->SetBilinearPrecision(precision);
+        ms[fixed] = BestOfMs(COST_FRAMES, [&]()
+        {
+            m_cpuUpscaler->Bilinear(m_input.View(), results[fixed].View());
+        });
+    }
+    m_cpuUpscaler->SetBilinearPrecision(KernelPrecision::Float);
+    report("Bilinear 2x", ms);
+
+    // In place, so the copy of the input is timed too; it's the same for both
+    for (int fixed = 0; fixed < 2; fixed++)
+    {
+        m_casSharpener->SetPrecision(fixed ? KernelPrecision::Fixed16 : KernelPrecision::Float);
+        ms[fixed] = BestOfMs(COST_FRAMES, [&]()
+        {
+            memcpy(results[fixed].View().data, first.View().data, channels);
+            m_casSharpener->Sharpen(results[fixed].View(), FSR_SHARPNESS);
+        });
+    }
+    m_casSharpener->SetPrecision(KernelPrecision::Float);
+    report("CAS (native)", ms);
+
+    for (int fixed = 0; fixed < 2; fixed++)
+    {
+        ms[fixed] = BestOfMs(COST_FRAMES, [&]()
+        {
+            BlendFrames(first.View(), second.View(), 0.5f, results[fixed].View(),
+                fixed ? KernelPrecision::Fixed16 : KernelPrecision::Float);
+        });
+    }
+    report("Frame blend", ms);
+}
+
+void BenchmarkSuite::RunFrameLayouts()
+{
+    const uint32_t outputWidth = COST_WIDTH * 2;
+    const uint32_t outputHeight = COST_HEIGHT * 2;
+
+    SyntheticScene scene;
+    scene.Initialize(outputWidth + MATCH_RANGE, outputHeight + MATCH_RANGE);
+    m_input.Allocate(COST_WIDTH, COST_HEIGHT);
+    scene.Render(0, 0, 2, m_input.View());
+
+    m_reference.Allocate(outputWidth, outputHeight);
+    m_cpuUpscaler->Fsr(m_input.View(), m_reference.View(), FSR_SHARPNESS);
+    m_output.Allocate(outputWidth, outputHeight);
+
+    // The current frame is the previous one panned by (3, 2), found at that offset in previous
+    const int panX = 3;
+    const int panY = 2;
+    BenchmarkImage frames[2];
+    frames[0].Allocate(COST_WIDTH, COST_HEIGHT);
+    frames[1].Allocate(COST_WIDTH, COST_HEIGHT);
+    scene.Render(panX, panY, 1, frames[0].View());
+    scene.Render(0, 0, 1, frames[1].View());
+    const BenchmarkImage& current = frames[0];
+    const BenchmarkImage& previous = frames[1];
+
+    Logger::Info("Frame layouts: load %ux%u, FSR port %ux%u -> %ux%u, %ux%u block matching +-%d at %ux%u, best of %u",
+        COST_WIDTH, COST_HEIGHT, COST_WIDTH, COST_HEIGHT, outputWidth, outputHeight, MATCH_BLOCK, MATCH_BLOCK, MATCH_RANGE,
+        COST_WIDTH, COST_HEIGHT, COST_FRAMES);
+
+    const ImageView input = static_cast<const BenchmarkImage&>(m_input).View();
+    const ImageView reference = static_cast<const BenchmarkImage&>(m_reference).View();
+    LayoutResult results[4] =
+    {
+        RunLayout<InterleavedLayout>(input, reference, current.View(), previous.View(), m_output.View(), COST_FRAMES),
+        RunLayout<PlanarLayout>(input, reference, current.View(), previous.View(), m_output.View(), COST_FRAMES),
+        RunLayout<TiledLayout<8>>(input, reference, current.View(), previous.View(), m_output.View(), COST_FRAMES),
+        RunLayout<TiledLayout<32>>(input, reference, current.View(), previous.View(), m_output.View(), COST_FRAMES)
+    };
+    const char* names[4] = { InterleavedLayout::Name(), PlanarLayout::Name(), TiledLayout<8>::Name(), TiledLayout<32>::Name() };
+
+    for (int i = 0; i < 4; i++)
+    {
+        const std::vector<int8_t>& vectors = results[i].vectors;
+        size_t found = 0;
+        for (size_t v = 0; v < vectors.size(); v += 2)
+        {
+            found += (vectors[v] == panX && vectors[v + 1] == panY) ? 1 : 0;
+        }
+        Logger::Info("  %-16s load %6.2f ms  FSR %7.2f ms %-7s  match %7.2f ms  %5.1f%% at (%d, %d)%s", names[i],
+            results[i].loadMs, results[i].fsrMs, results[i].fsrExact ? "exact" : "differs", results[i].matchMs,
+            found * 200.0 / vectors.size(), panX, panY, vectors == results[0].vectors ? "" : "  vectors differ");
+    }
+}
+
+void BenchmarkSuite::RunFramePool()
+{
+    // A 4K BGRA8 frame per iteration, written once like a conversion or upscale output would be
+    const size_t frameBytes = static_cast<size_t>(CONVERT_WIDTH) * CONVERT_HEIGHT * 4;
+    const uint32_t iterations = CONVERT_FRAMES * 2;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        std::vector<uint8_t> frame(frameBytes);
+        memset(frame.data(), static_cast<int>(i), frameBytes);
+    }
+    double heapMs = ElapsedMs(start) / iterations;
+
+    // Own pool so the counters only cover this run
+    FramePool pool;
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        FrameHandle frame = pool.Acquire(CONVERT_WIDTH, CONVERT_HEIGHT, PixelFormat::Bgra8);
+        memset(frame.Data(), static_cast<int>(i), frame.GetPitch() * CONVERT_HEIGHT);
+    }
+    double poolMs = ElapsedMs(start) / iterations;
+    FramePoolStats stats = pool.GetStats();
+
+    Logger::Info("Frame pool: %ux%u BGRA8 allocate + fill, average of %u", CONVERT_WIDTH, CONVERT_HEIGHT, iterations);
+    Logger::Info("  %-16s %7.2f ms", "heap", heapMs);
+    Logger::Info("  %-16s %7.2f ms  %llu hits  %llu misses  %.1f MB resident  %.1f MB large pages", "pool", poolMs,
+        static_cast<unsigned long long>(stats.hits), static_cast<unsigned long long>(stats.misses),
+        stats.residentBytes / (1024.0 * 1024.0), stats.largePageBytes / (1024.0 * 1024.0));
+}
+
+void BenchmarkSuite::RunAnalysisPyramid()
+{
+    const uint32_t width = CONVERT_WIDTH;
+    const uint32_t height = CONVERT_HEIGHT;
+
+    SyntheticScene scene;
+    scene.Initialize(width, height);
+    BenchmarkImage frame;
+    frame.Allocate(width, height);
+    scene.Render(0, 0, 1, frame.View());
+    const ImageView src = static_cast<const BenchmarkImage&>(frame).View();
+
+    // Scalar reference: per-pixel luma, then each level from the one before
+    std::vector<std::vector<uint8_t>> expected;
+    double scalarMs = BestOfMs(CONVERT_FRAMES, [&]()
+    {
+        expected.assign(1, std::vector<uint8_t>(static_cast<size_t>(width) * height));
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                expected[0][static_cast<size_t>(y) * width + x] = PixelLuma(src.Row(y) + x * 4);
+            }
+        }
+
+        uint32_t levelWidth = width;
+        uint32_t levelHeight = height;
+        while (expected.size() < LumaPyramid::MAX_LEVELS &&
+               levelWidth / 2 >= LumaPyramid::MIN_LEVEL_SIZE && levelHeight / 2 >= LumaPyramid::MIN_LEVEL_SIZE)
+        {
+            const uint32_t nextWidth = levelWidth / 2;
+            const uint32_t nextHeight = levelHeight / 2;
+            std::vector<uint8_t> next(static_cast<size_t>(nextWidth) * nextHeight);
+            const std::vector<uint8_t>& prev = expected.back();
+            for (uint32_t y = 0; y < nextHeight; y++)
+            {
+                const uint8_t* row0 = &prev[static_cast<size_t>(y * 2) * levelWidth];
+                const uint8_t* row1 = row0 + levelWidth;
+                for (uint32_t x = 0; x < nextWidth; x++)
+                {
+                    next[static_cast<size_t>(y) * nextWidth + x] =
+                        static_cast<uint8_t>((row0[x * 2] + row0[x * 2 + 1] + row1[x * 2] + row1[x * 2 + 1] + 2) >> 2);
+                }
+            }
+            expected.push_back(std::move(next));
+            levelWidth = nextWidth;
+            levelHeight = nextHeight;
+        }
+    });
+
+    // Level 0 alone, then the full pyramid (consecutive frames through FrameAnalysis)
+    LumaPyramid lumaOnly;
+    double lumaMs = BestOfMs(CONVERT_FRAMES, [&]() { lumaOnly.Build(src, 1); });
+    // The same frame every time, so the duplicate check is off
+    FrameAnalysis analysis;
+    analysis.SetDropDuplicates(false);
+    double pyramidMs = BestOfMs(CONVERT_FRAMES, [&]() { analysis.Update(src); });
+
+    const LumaPyramid& pyramid = analysis.GetCurrent();
+    bool exact = pyramid.GetLevelCount() == expected.size();
+    for (uint32_t level = 0; exact && level < pyramid.GetLevelCount(); level++)
+    {
+        const LumaView& view = pyramid.GetLevel(level);
+        for (uint32_t y = 0; exact && y < view.height; y++)
+        {
+            exact = memcmp(view.Row(y), &expected[level][static_cast<size_t>(y) * view.width], view.width) == 0;
+        }
+    }
+
+    Logger::Info("Analysis pyramid: %ux%u, %u levels, best of %u, %u threads (scalar reference on one thread)",
+        width, height, pyramid.GetLevelCount(), CONVERT_FRAMES, ThreadPool::Shared().GetThreadCount());
+    Logger::Info("  %-16s %7.2f ms", "scalar", scalarMs);
+    Logger::Info("  %-16s %7.2f ms", "luma only", lumaMs);
+    Logger::Info("  %-16s %7.2f ms  %5.1fx  %s", "pyramid", pyramidMs, scalarMs / pyramidMs, exact ? "exact" : "MISMATCH");
+}
+
+void BenchmarkSuite::RunFrameGeneration()
+{
+    static const struct { uint32_t width; uint32_t height; } sizes[] = { { 1920, 1080 }, { 2560, 1440 } };
+
+    FrameGenerator generator;
+    Logger::Info("Frame generation: middle frame of a %d,%d pixel pan, block %u, range +-%u, best of %u, %u threads",
+        PAN_X, PAN_Y, generator.GetBlockSize(), generator.GetSearchRange(), GENERATION_RUNS, ThreadPool::Shared().GetThreadCount());
+
+    for (const auto& size : sizes)
+    {
+        // The true middle frame is rendered half way along the pan
+        SyntheticScene scene;
+        scene.Initialize(size.width + PAN_X, size.height + PAN_Y);
+        BenchmarkImage previous;
+        BenchmarkImage current;
+        BenchmarkImage middle;
+        BenchmarkImage generated;
+        previous.Allocate(size.width, size.height);
+        current.Allocate(size.width, size.height);
+        middle.Allocate(size.width, size.height);
+        generated.Allocate(size.width, size.height);
+        scene.Render(PAN_X, PAN_Y, 1, previous.View());
+        scene.Render(0, 0, 1, current.View());
+        scene.Render(PAN_X / 2, PAN_Y / 2, 1, middle.View());
+
+        const ImageView previousView = static_cast<const BenchmarkImage&>(previous).View();
+        const ImageView currentView = static_cast<const BenchmarkImage&>(current).View();
+        const ImageView middleView = static_cast<const BenchmarkImage&>(middle).View();
+        const ImageView generatedView = static_cast<const BenchmarkImage&>(generated).View();
+
+        float estimateMs = 1e9f;
+        float interpolateMs = 1e9f;
+        double totalMs = BestOfMs(GENERATION_RUNS, [&]()
+        {
+            generator.Generate(previousView, currentView, generated.View());
+            estimateMs = std::min(estimateMs, generator.GetStats().estimateMs);
+            interpolateMs = std::min(interpolateMs, generator.GetStats().interpolateMs);
+        });
+        double generatedPsnr = ComputePsnr(generatedView, middleView);
+
+        // Share of blocks that found the pan (flat blocks match anywhere); the previous frame
+        // is the scene shifted by the pan, so its content sits at -pan from the current one
+        const MotionField& field = generator.GetMotionField();
+        size_t exact = 0;
+        for (const MotionVector& vector : field.vectors)
+        {
+            exact += (vector.x == -PAN_X && vector.y == -PAN_Y) ? 1 : 0;
+        }
+
+        // Plain cross-fade for comparison
+        BlendFrames(previousView, currentView, 0.5f, generated.View());
+        double blendPsnr = ComputePsnr(generatedView, middleView);
+
+        Logger::Info("  %ux%u  %8.1f ms (motion %.1f, blend %.2f)  %6.2f dB  cross-fade %6.2f dB  %4.1f%% vectors exact",
+            size.width, size.height, totalMs, estimateMs, interpolateMs, generatedPsnr, blendPsnr,
+            100.0 * exact / field.vectors.size());
+    }
+
+    // 2x, 3x and 4x output at 1080p: all intermediates from one estimate in one pass, against
+    // one Generate() per intermediate
+    const uint32_t width = 1920;
+    const uint32_t height = 1080;
+    Logger::Info("Multi-frame generation: %ux%u, %u,%u pixel pan, predictive search, best of %u, %u threads",
+        width, height, MULTI_PAN, MULTI_PAN, GENERATION_RUNS, ThreadPool::Shared().GetThreadCount());
+
+    SyntheticScene scene;
+    scene.Initialize(width + MULTI_PAN, height + MULTI_PAN);
+    BenchmarkImage previous;
+    BenchmarkImage current;
+    BenchmarkImage truth;
+    BenchmarkImage generated[FrameGenerator::MAX_GENERATED_FRAMES];
+    previous.Allocate(width, height);
+    current.Allocate(width, height);
+    truth.Allocate(width, height);
+    MutableImageView views[FrameGenerator::MAX_GENERATED_FRAMES];
+    for (uint32_t k = 0; k < FrameGenerator::MAX_GENERATED_FRAMES; k++)
+    {
+        generated[k].Allocate(width, height);
+        views[k] = generated[k].View();
+    }
+    scene.Render(MULTI_PAN, MULTI_PAN, 1, previous.View());
+    scene.Render(0, 0, 1, current.View());
+    const ImageView previousView = static_cast<const BenchmarkImage&>(previous).View();
+    const ImageView currentView = static_cast<const BenchmarkImage&>(current).View();
+
+    FrameGenerator multi;
+    multi.SetMotionSearch(MotionSearch::Predictive);
+    multi.SetSearchRange(MULTI_PAN * 2);
+    for (uint32_t factor = 2; factor <= FrameGenerator::MAX_GENERATED_FRAMES + 1; factor++)
+    {
+        const uint32_t count = factor - 1;
+        double separateMs = BestOfMs(GENERATION_RUNS, [&]()
+        {
+            for (uint32_t k = 0; k < count; k++)
+            {
+                multi.Generate(previousView, currentView, views[k], static_cast<float>(k + 1) / factor);
+            }
+        });
+
+        // Blend time of the same run as the best total, so it's a part of it
+        double batchedMs = 1e9;
+        float batchedBlendMs = 0.0f;
+        for (uint32_t run = 0; run < GENERATION_RUNS; run++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            multi.Generate(previousView, currentView, views, count);
+            const double runMs = ElapsedMs(start);
+            if (runMs < batchedMs)
+            {
+                batchedMs = runMs;
+                batchedBlendMs = multi.GetStats().interpolateMs;
+            }
+        }
+
+        // The frame at t = k / N is the scene MULTI_PAN * (N - k) / N pixels along
+        double worstPsnr = 1e9;
+        for (uint32_t k = 0; k < count; k++)
+        {
+            const uint32_t offset = MULTI_PAN * (factor - k - 1) / factor;
+            scene.Render(offset, offset, 1, truth.View());
+            worstPsnr = std::min(worstPsnr, ComputePsnr(static_cast<const BenchmarkImage&>(generated[k]).View(),
+                                                        static_cast<const BenchmarkImage&>(truth).View()));
+        }
+        Logger::Info("  %ux: %u frames  %7.1f ms batched (blend %.2f)  %7.1f ms separately  worst %6.2f dB",
+            factor, count, batchedMs, batchedBlendMs, separateMs, worstPsnr);
+    }
+}
+
+void BenchmarkSuite::RunMotionSearch()
+{
+    static const struct { int32_t x; int32_t y; } pans[] = { { 4, 2 }, { 8, -6 }, { 16, 10 }, { 30, -20 } };
+    static const struct { const char* name; MotionSearch search; uint32_t range; } searches[] = {
+        { "exhaustive +-8", MotionSearch::Exhaustive, 8 },
+        { "exhaustive +-32", MotionSearch::Exhaustive, MAX_PAN },
+        { "hierarchical +-32", MotionSearch::Hierarchical, MAX_PAN },
+        { "predictive +-32", MotionSearch::Predictive, MAX_PAN },
+        { "dense flow +-32", MotionSearch::DenseFlow, MAX_PAN },
+    };
+
+    Logger::Info("Motion search: %ux%u, 8x8 blocks, middle frame of a pan (after one frame of the same pan), %u threads",
+        COST_WIDTH, COST_HEIGHT, ThreadPool::Shared().GetThreadCount());
+
+    // The view starts 2 * MAX_PAN into the lattice so pans can go either way for two frames
+    SyntheticScene scene;
+    scene.Initialize(COST_WIDTH + 4 * MAX_PAN, COST_HEIGHT + 4 * MAX_PAN);
+    BenchmarkImage older;
+    BenchmarkImage previous;
+    BenchmarkImage current;
+    BenchmarkImage middle;
+    BenchmarkImage generated;
+    older.Allocate(COST_WIDTH, COST_HEIGHT);
+    previous.Allocate(COST_WIDTH, COST_HEIGHT);
+    current.Allocate(COST_WIDTH, COST_HEIGHT);
+    middle.Allocate(COST_WIDTH, COST_HEIGHT);
+    generated.Allocate(COST_WIDTH, COST_HEIGHT);
+    scene.Render(2 * MAX_PAN, 2 * MAX_PAN, 1, current.View());
+
+    const ImageView olderView = static_cast<const BenchmarkImage&>(older).View();
+    const ImageView previousView = static_cast<const BenchmarkImage&>(previous).View();
+    const ImageView currentView = static_cast<const BenchmarkImage&>(current).View();
+    const ImageView middleView = static_cast<const BenchmarkImage&>(middle).View();
+    const ImageView generatedView = static_cast<const BenchmarkImage&>(generated).View();
+
+    for (const auto& pan : pans)
+    {
+        scene.Render(2 * MAX_PAN + 2 * pan.x, 2 * MAX_PAN + 2 * pan.y, 1, older.View());
+        scene.Render(2 * MAX_PAN + pan.x, 2 * MAX_PAN + pan.y, 1, previous.View());
+        scene.Render(2 * MAX_PAN + pan.x / 2, 2 * MAX_PAN + pan.y / 2, 1, middle.View());
+        Logger::Info("  pan %d,%d", pan.x, pan.y);
+
+        for (const auto& search : searches)
+        {
+            // A fresh generator sees the frame before first, as it would in a stream
+            FrameGenerator generator;
+            generator.SetMotionSearch(search.search);
+            generator.SetSearchRange(search.range);
+            generator.EstimateMotion(olderView, previousView);
+            double motionMs = BestOfMs(1, [&]() { generator.EstimateMotion(previousView, currentView); });
+            generator.Interpolate(previousView, currentView, generated.View(), 0.5f);
+
+            const MotionField& field = generator.GetMotionField();
+            size_t exact = 0;
+            for (const MotionVector& vector : field.vectors)
+            {
+                exact += (vector.x == -pan.x && vector.y == -pan.y) ? 1 : 0;
+            }
+            Logger::Info("    %-18s %8.1f ms  %7.1f candidates/block  %5.1f%% vectors exact  %6.2f dB", search.name, motionMs,
+                generator.GetStats().candidatesPerBlock, 100.0 * exact / field.vectors.size(), ComputePsnr(generatedView, middleView));
+        }
+    }
+}
+
+void BenchmarkSuite::RunBlockSad()
+{
+    // Every block of a 720p luma frame against the 8x8 offsets -4..3, one thread
+    const int32_t OFFSET = 4;
+    const uint32_t CANDIDATES = 2 * OFFSET * 2 * OFFSET;
+
+    SyntheticScene scene;
+    scene.Initialize(COST_WIDTH, COST_HEIGHT);
+    BenchmarkImage frame;
+    frame.Allocate(COST_WIDTH, COST_HEIGHT);
+    scene.Render(0, 0, 1, frame.View());
+    LumaPyramid luma;
+    luma.Build(static_cast<const BenchmarkImage&>(frame).View(), 1);
+    const LumaView& plane = luma.GetLevel(0);
+
+    const CpuFeatures& cpu = GetCpuFeatures();
+    Logger::Info("Block SAD: %ux%u luma, %u candidates per block, best of %u, one thread (%s)",
+        COST_WIDTH, COST_HEIGHT, CANDIDATES, COST_FRAMES, cpu.avx2 ? "AVX2" : (cpu.sse41 ? "SSE4.1" : "SSE2"));
+
+    for (uint32_t size : { 8u, 16u })
+    {
+        // Blocks whose offsets, plus BlockSadX8()'s overread, stay inside the frame
+        const uint32_t margin = size + 2 * OFFSET;
+        const uint32_t blocksX = (COST_WIDTH - 2 * margin) / size;
+        const uint32_t blocksY = (COST_HEIGHT - 2 * margin) / size;
+        const double candidates = static_cast<double>(blocksX) * blocksY * CANDIDATES;
+
+        auto search = [&](auto&& blockSads)
+        {
+            uint64_t checksum = 0;
+            for (uint32_t by = 0; by < blocksY; by++)
+            {
+                for (uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    const uint32_t x = margin + bx * size;
+                    const uint32_t y = margin + by * size;
+                    for (int32_t dy = -OFFSET; dy < OFFSET; dy++)
+                    {
+                        uint32_t sads[8];
+                        blockSads(plane.Row(y) + x, plane.Row(y + dy) + x - OFFSET, sads);
+                        for (uint32_t sad : sads)
+                        {
+                            checksum += sad;
+                        }
+                    }
+                }
+            }
+            return checksum;
+        };
+
+        uint64_t scalarSum = 0;
+        uint64_t singleSum = 0;
+        uint64_t batchSum = 0;
+        double scalarMs = BestOfMs(COST_FRAMES, [&]()
+        {
+            scalarSum = search([&](const uint8_t* cur, const uint8_t* ref, uint32_t* sads)
+            {
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    sads[i] = BlockSadScalar(cur, plane.pitch, ref + i, plane.pitch, size, size);
+                }
+            });
+        });
+        double singleMs = BestOfMs(COST_FRAMES, [&]()
+        {
+            singleSum = search([&](const uint8_t* cur, const uint8_t* ref, uint32_t* sads)
+            {
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    sads[i] = BlockSad(cur, plane.pitch, ref + i, plane.pitch, size);
+                }
+            });
+        });
+        double batchMs = BestOfMs(COST_FRAMES, [&]()
+        {
+            batchSum = search([&](const uint8_t* cur, const uint8_t* ref, uint32_t* sads)
+            {
+                BlockSadX8(cur, plane.pitch, ref, plane.pitch, size, sads);
+            });
+        });
+
+        const char* match = (singleSum == scalarSum && batchSum == scalarSum) ? "exact" : "MISMATCH";
+        Logger::Info("  %ux%u scalar        %7.2f ms  %7.1f M candidates/s", size, size, scalarMs, candidates / scalarMs / 1000.0);
+        Logger::Info("  %ux%u one per call  %7.2f ms  %7.1f M candidates/s  %5.1fx", size, size, singleMs, candidates / singleMs / 1000.0, scalarMs / singleMs);
+        Logger::Info("  %ux%u eight per call%7.2f ms  %7.1f M candidates/s  %5.1fx  %s", size, size, batchMs, candidates / batchMs / 1000.0, scalarMs / batchMs, match);
+    }
+}
+
+void BenchmarkSuite::RunOpticalFlow()
+{
+    // Pans, and a window moving over a pan with its content, whose edges the blocks straddle
+    static const struct { const char* name; int32_t panX; int32_t panY; int32_t moveX; int32_t moveY; } scenes[] = {
+        { "pan 8,4", 8, 4, 0, 0 },
+        { "pan 24,-16", 24, -16, 0, 0 },
+        { "window 12,-8 over pan 4,2", 4, 2, 12, -8 },
+    };
+    static const struct { const char* name; MotionSearch search; } searches[] = {
+        { "hierarchical 8x8", MotionSearch::Hierarchical },
+        { "predictive 8x8", MotionSearch::Predictive },
+        { "dense flow", MotionSearch::DenseFlow },
+    };
+
+    Logger::Info("Optical flow: %ux%u, range +-%d, end point error against the rendered motion, best of %u, %u threads",
+        FLOW_WIDTH, FLOW_HEIGHT, MAX_PAN, GENERATION_RUNS, ThreadPool::Shared().GetThreadCount());
+
+    SyntheticScene scene;
+    scene.Initialize(FLOW_WIDTH + 4 * MAX_PAN, FLOW_HEIGHT + 4 * MAX_PAN);
+    BenchmarkImage window;
+    BenchmarkImage previous;
+    BenchmarkImage current;
+    BenchmarkImage middle;
+    BenchmarkImage generated;
+    window.Allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    previous.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    current.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    middle.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    generated.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    scene.Render(0, 0, 1, window.View());
+
+    const ImageView windowView = static_cast<const BenchmarkImage&>(window).View();
+    const ImageView previousView = static_cast<const BenchmarkImage&>(previous).View();
+    const ImageView currentView = static_cast<const BenchmarkImage&>(current).View();
+    const ImageView middleView = static_cast<const BenchmarkImage&>(middle).View();
+    const ImageView generatedView = static_cast<const BenchmarkImage&>(generated).View();
+
+    // The window sits centred in the current frame; frames before it are rendered back along
+    // both motions (step 2 = previous, 1 = middle)
+    const uint32_t windowX = (FLOW_WIDTH - WINDOW_WIDTH) / 2;
+    const uint32_t windowY = (FLOW_HEIGHT - WINDOW_HEIGHT) / 2;
+    auto compose = [&](BenchmarkImage& dst, const auto& motion, int32_t step)
+    {
+        const uint32_t backgroundX = 2 * MAX_PAN + motion.panX * step / 2;
+        const uint32_t backgroundY = 2 * MAX_PAN + motion.panY * step / 2;
+        if (motion.moveX == 0 && motion.moveY == 0)
+        {
+            scene.Render(backgroundX, backgroundY, 1, dst.View());
+            return;
+        }
+        RenderWindowScene(scene, windowView, backgroundX, backgroundY, windowX - motion.moveX * step / 2,
+                          windowY - motion.moveY * step / 2, dst.View());
+    };
+
+    for (const auto& motion : scenes)
+    {
+        compose(previous, motion, 2);
+        compose(middle, motion, 1);
+        compose(current, motion, 0);
+        Logger::Info("  %s", motion.name);
+
+        // Content at p in the current frame was at p + truth in the previous one
+        const bool hasWindow = motion.moveX != 0 || motion.moveY != 0;
+        auto truth = [&](uint32_t x, uint32_t y, float& tx, float& ty)
+        {
+            const bool inWindow = hasWindow && x - windowX < WINDOW_WIDTH && y - windowY < WINDOW_HEIGHT;
+            tx = static_cast<float>(inWindow ? -motion.moveX : -motion.panX);
+            ty = static_cast<float>(inWindow ? -motion.moveY : -motion.panY);
+        };
+
+        for (const auto& search : searches)
+        {
+            FrameGenerator generator;
+            generator.SetMotionSearch(search.search);
+            generator.SetSearchRange(MAX_PAN);
+            generator.EstimateMotion(previousView, currentView);
+            double motionMs = BestOfMs(GENERATION_RUNS, [&]() { generator.EstimateMotion(previousView, currentView); });
+            generator.Interpolate(previousView, currentView, generated.View(), 0.5f);
+
+            // Per-pixel end point error: the block's vector, or the flow sampled at the pixel
+            const MotionField& field = generator.GetMotionField();
+            const FlowField& flow = generator.GetOpticalFlow().GetFlow();
+            double errorSum = 0.0;
+            size_t outliers = 0;
+            for (uint32_t y = 0; y < FLOW_HEIGHT; y++)
+            {
+                for (uint32_t x = 0; x < FLOW_WIDTH; x++)
+                {
+                    float dx;
+                    float dy;
+                    if (search.search == MotionSearch::DenseFlow)
+                    {
+                        flow.Sample(static_cast<float>(x), static_cast<float>(y), dx, dy);
+                    }
+                    else
+                    {
+                        const MotionVector& vector = field.At(x / field.blockSize, y / field.blockSize);
+                        dx = vector.x;
+                        dy = vector.y;
+                    }
+                    float tx;
+                    float ty;
+                    truth(x, y, tx, ty);
+                    const double error = std::sqrt((dx - tx) * (dx - tx) + (dy - ty) * (dy - ty));
+                    errorSum += error;
+                    outliers += error > 1.0 ? 1 : 0;
+                }
+            }
+            const double pixels = static_cast<double>(FLOW_WIDTH) * FLOW_HEIGHT;
+            Logger::Info("    %-18s %7.1f ms  EPE %5.2f px  %5.1f%% over 1 px  %6.2f dB", search.name, motionMs,
+                errorSum / pixels, 100.0 * outliers / pixels, ComputePsnr(generatedView, middleView));
+
+            if (search.search == MotionSearch::DenseFlow)
+            {
+                const OpticalFlowStats& stats = generator.GetOpticalFlow().GetStats();
+                Logger::Info("      pyramids %.1f ms, smoothing %.1f ms, patch search %.1f ms, densify %.1f ms, refine %.1f ms, %u patches (%u reset)",
+                    generator.GetStats().pyramidMs, stats.smoothMs, stats.searchMs, stats.densifyMs, stats.refineMs, stats.patches, stats.revertedPatches);
+            }
+        }
+    }
+}
+
+void BenchmarkSuite::RunExtrapolation()
+{
+    const float frameMs = 1000.0f / SOURCE_FPS;
+    Logger::Info("Frame extrapolation: %ux%u, %d,%d pan with a window moving %d,%d, predictive 8x8, best of %u, %u threads",
+        FLOW_WIDTH, FLOW_HEIGHT, EXTRAPOLATION_PAN[0], EXTRAPOLATION_PAN[1], EXTRAPOLATION_MOVE[0], EXTRAPOLATION_MOVE[1],
+        GENERATION_RUNS, ThreadPool::Shared().GetThreadCount());
+    Logger::Info("  added latency at %.0f fps: interpolation holds the newest capture back one frame (%.1f ms) plus generation",
+        SOURCE_FPS, frameMs);
+
+    SyntheticScene scene;
+    scene.Initialize(FLOW_WIDTH + 4 * MAX_PAN, FLOW_HEIGHT + 4 * MAX_PAN);
+    BenchmarkImage window;
+    BenchmarkImage previous;
+    BenchmarkImage current;
+    BenchmarkImage truth;
+    BenchmarkImage generated;
+    window.Allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    previous.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    current.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    truth.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    generated.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    scene.Render(0, 0, 1, window.View());
+
+    // Scene at source time `time` (current = 0, previous = -1), in half frames
+    auto render = [&](BenchmarkImage& dst, int32_t halfFrames)
+    {
+        const int32_t windowX = static_cast<int32_t>(FLOW_WIDTH - WINDOW_WIDTH) / 2 + EXTRAPOLATION_MOVE[0] * halfFrames / 2;
+        const int32_t windowY = static_cast<int32_t>(FLOW_HEIGHT - WINDOW_HEIGHT) / 2 + EXTRAPOLATION_MOVE[1] * halfFrames / 2;
+        RenderWindowScene(scene, static_cast<const BenchmarkImage&>(window).View(), 2 * MAX_PAN - EXTRAPOLATION_PAN[0] * halfFrames / 2,
+                          2 * MAX_PAN - EXTRAPOLATION_PAN[1] * halfFrames / 2, windowX, windowY, dst.View());
+    };
+    render(previous, -2);
+    render(current, 0);
+
+    const ImageView previousView = static_cast<const BenchmarkImage&>(previous).View();
+    const ImageView currentView = static_cast<const BenchmarkImage&>(current).View();
+    const ImageView truthView = static_cast<const BenchmarkImage&>(truth).View();
+    const ImageView generatedView = static_cast<const BenchmarkImage&>(generated).View();
+
+    auto artifactRate = [&]()
+    {
+        size_t artifacts = 0;
+        for (uint32_t y = 0; y < FLOW_HEIGHT; y++)
+        {
+            const uint8_t* a = generatedView.Row(y);
+            const uint8_t* b = truthView.Row(y);
+            for (uint32_t x = 0; x < FLOW_WIDTH; x++)
+            {
+                int32_t error = 0;
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    error = std::max(error, std::abs(a[x * 4 + c] - b[x * 4 + c]));
+                }
+                artifacts += error > ARTIFACT_ERROR ? 1 : 0;
+            }
+        }
+        return 100.0 * artifacts / (static_cast<double>(FLOW_WIDTH) * FLOW_HEIGHT);
+    };
+
+    FrameGenerator generator;
+    generator.SetMotionSearch(MotionSearch::Predictive);
+    generator.SetSearchRange(MAX_PAN);
+    auto report = [&](const char* name, double ms, float latencyMs, float holeRatio)
+    {
+        Logger::Info("  %-20s %7.1f ms  +%5.1f ms latency  %6.2f dB  %5.1f%% artifacts  %5.1f%% holes", name, ms, latencyMs,
+            ComputePsnr(generatedView, truthView), artifactRate(), 100.0f * holeRatio);
+    };
+
+    // Interpolation shows the frame half way between the two captures
+    render(truth, -1);
+    generator.Generate(previousView, currentView, generated.View(), 0.5f);
+    double ms = BestOfMs(GENERATION_RUNS, [&]() { generator.Generate(previousView, currentView, generated.View(), 0.5f); });
+    report("interpolate t=0.5", ms, frameMs + static_cast<float>(ms), 0.0f);
+
+    // Extrapolation shows a frame past the current capture before the next one arrives
+    for (int32_t halfFrames : { 1, 2 })
+    {
+        render(truth, halfFrames);
+        generator.SetPredictionDistance(0.5f * halfFrames);
+        ms = BestOfMs(GENERATION_RUNS, [&]() { generator.Extrapolate(previousView, currentView, generated.View()); });
+        report(halfFrames == 1 ? "extrapolate +0.5" : "extrapolate +1", ms, static_cast<float>(ms), generator.GetStats().holeRatio);
+    }
+
+    // Baseline: repeating the current frame in the +0.5 slot
+    render(truth, 1);
+    for (uint32_t y = 0; y < FLOW_HEIGHT; y++)
+    {
+        memcpy(generated.View().Row(y), currentView.Row(y), static_cast<size_t>(FLOW_WIDTH) * 4);
+    }
+    report("repeat current", 0.0, 0.0f, 0.0f);
+}
+
+void BenchmarkSuite::RunStaticRegions()
+{
+    Logger::Info("Static region bypass: %ux%u middle frame, predictive 8x8, best of %u, %u threads",
+        FLOW_WIDTH, FLOW_HEIGHT, GENERATION_RUNS, ThreadPool::Shared().GetThreadCount());
+
+    SyntheticScene scene;
+    scene.Initialize(FLOW_WIDTH + 4 * MAX_PAN, FLOW_HEIGHT + 4 * MAX_PAN);
+    BenchmarkImage window;
+    BenchmarkImage previous;
+    BenchmarkImage current;
+    BenchmarkImage middle;
+    BenchmarkImage generated;
+    window.Allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    previous.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    current.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    middle.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    generated.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    scene.Render(0, 0, 1, window.View());
+
+    const ImageView windowView = static_cast<const BenchmarkImage&>(window).View();
+    const ImageView previousView = static_cast<const BenchmarkImage&>(previous).View();
+    const ImageView currentView = static_cast<const BenchmarkImage&>(current).View();
+    const ImageView middleView = static_cast<const BenchmarkImage&>(middle).View();
+    const ImageView generatedView = static_cast<const BenchmarkImage&>(generated).View();
+
+    // A still frame, a window dragged over a still background, and the same over a pan (nothing
+    // to bypass, the cost of the mask)
+    static const struct { const char* name; int32_t panX; int32_t panY; int32_t moveX; int32_t moveY; } scenes[] = {
+        { "still", 0, 0, 0, 0 },
+        { "window over still", 0, 0, STATIC_RUN_MOVE[0], STATIC_RUN_MOVE[1] },
+        { "window over pan", 8, 4, STATIC_RUN_MOVE[0], STATIC_RUN_MOVE[1] }
+    };
+
+    FrameGenerator generator;
+    generator.SetMotionSearch(MotionSearch::Predictive);
+    generator.SetSearchRange(MAX_PAN);
+    for (const auto& motion : scenes)
+    {
+        // step is in half frames back from the current one
+        auto compose = [&](BenchmarkImage& dst, int32_t step)
+        {
+            const uint32_t windowX = (FLOW_WIDTH - WINDOW_WIDTH) / 2;
+            const uint32_t windowY = (FLOW_HEIGHT - WINDOW_HEIGHT) / 2;
+            RenderWindowScene(scene, windowView, 2 * MAX_PAN + motion.panX * step / 2, 2 * MAX_PAN + motion.panY * step / 2,
+                              windowX - motion.moveX * step / 2, windowY - motion.moveY * step / 2, dst.View());
+        };
+        compose(previous, 2);
+        compose(middle, 1);
+        compose(current, 0);
+
+        float blendMs[2] = { 0.0f, 0.0f };
+        double psnr[2] = { 0.0, 0.0 };
+        float staticRatio = 0.0f;
+        for (uint32_t bypass = 0; bypass < 2; bypass++)
+        {
+            generator.SetStaticBypass(bypass != 0);
+            generator.EstimateMotion(previousView, currentView);
+            double ms = BestOfMs(GENERATION_RUNS, [&]() { generator.Interpolate(previousView, currentView, generated.View(), 0.5f); });
+            blendMs[bypass] = static_cast<float>(ms);
+            psnr[bypass] = ComputePsnr(generatedView, middleView);
+            staticRatio = generator.GetStats().staticRatio;
+        }
+        Logger::Info("  %-18s %5.1f%% static  blend %6.2f ms (%6.2f dB), bypassed %6.2f ms (%6.2f dB)",
+            motion.name, 100.0f * staticRatio, blendMs[0], psnr[0], blendMs[1], psnr[1]);
+    }
+}
+
+void BenchmarkSuite::RunSceneCuts()
+{
+    Logger::Info("Scene cut detection: %ux%u, every %u-th row, %u bins, predictive 8x8, best of %u, %u threads",
+        FLOW_WIDTH, FLOW_HEIGHT, SceneCutDetector::ROW_STEP, SceneCutDetector::HISTOGRAM_BINS, GENERATION_RUNS,
+        ThreadPool::Shared().GetThreadCount());
+
+    SyntheticScene scene;
+    scene.Initialize(FLOW_WIDTH + CUT_JUMP + 4 * MAX_PAN, FLOW_HEIGHT + CUT_JUMP + 4 * MAX_PAN);
+    BenchmarkImage window;
+    BenchmarkImage frames[2];
+    BenchmarkImage generated;
+    window.Allocate(WINDOW_WIDTH, WINDOW_HEIGHT);
+    frames[0].Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    frames[1].Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    generated.Allocate(FLOW_WIDTH, FLOW_HEIGHT);
+    scene.Render(0, 0, 1, window.View());
+    const ImageView windowView = static_cast<const BenchmarkImage&>(window).View();
+    const uint32_t windowX = (FLOW_WIDTH - WINDOW_WIDTH) / 2;
+    const uint32_t windowY = (FLOW_HEIGHT - WINDOW_HEIGHT) / 2;
+
+    // A frame of the given kind, the scene under it panned by panX, panY
+    enum Shot { Game, WindowOverGame, Faded, NightShot, Loading };
+    auto render = [&](BenchmarkImage& dst, Shot shot, int32_t panX, int32_t panY)
+    {
+        const uint32_t base = 2 * MAX_PAN;
+        const uint32_t jump = shot == NightShot ? CUT_JUMP : 0;
+        scene.Render(base + jump + panX, base + jump + panY, 1, dst.View());
+        MutableImageView view = dst.View();
+        if (shot == Faded || shot == NightShot || shot == Loading)
+        {
+            const uint32_t scale = shot == Faded ? 3 : 2;
+            for (uint32_t y = 0; y < view.height; y++)
+            {
+                uint8_t* row = view.Row(y);
+                for (uint32_t x = 0; x < view.width * 4; x++)
+                {
+                    row[x] = shot == Loading ? LOADING_LEVEL : static_cast<uint8_t>(row[x] * scale / 4);
+                }
+            }
+        }
+        if (shot == WindowOverGame || shot == Loading)
+        {
+            for (uint32_t row = 0; row < WINDOW_HEIGHT; row++)
+            {
+                memcpy(view.Row(windowY + row) + windowX * 4, windowView.Row(row), static_cast<size_t>(WINDOW_WIDTH) * 4);
+            }
+        }
+    };
+
+    // Pairs that must not count as cuts, then cuts
+    static const struct { const char* name; Shot from; Shot to; int32_t panX; int32_t panY; bool cut; } pairs[] = {
+        { "still", Game, Game, 0, 0, false },
+        { "pan 6,4", Game, Game, 6, 4, false },
+        { "pan 32,-20", Game, Game, MAX_PAN, -20, false },
+        { "window opens", Game, WindowOverGame, 0, 0, false },
+        { "fade step 3/4", Game, Faded, 0, 0, false },
+        { "cut to night shot", Game, NightShot, 0, 0, true },
+        { "cut to loading", Game, Loading, 0, 0, true },
+        { "cut from loading", Loading, Game, 0, 0, true }
+    };
+
+    const ImageView previousView = static_cast<const BenchmarkImage&>(frames[0]).View();
+    const ImageView currentView = static_cast<const BenchmarkImage&>(frames[1]).View();
+    SceneCutDetector detector;
+    FrameGenerator generator;
+    generator.SetMotionSearch(MotionSearch::Predictive);
+    generator.SetSearchRange(MAX_PAN);
+    uint32_t wrong = 0;
+    for (const auto& pair : pairs)
+    {
+        render(frames[0], pair.from, pair.panX, pair.panY);
+        render(frames[1], pair.to, 0, 0);
+
+        SceneCutResult result;
+        double detectMs = BestOfMs(GENERATION_RUNS, [&]() { result = detector.Compare(previousView, currentView); });
+        wrong += result.cut != pair.cut ? 1 : 0;
+
+        // Full generation with and without the check
+        generator.SetSceneCutDetection(false);
+        double fullMs = BestOfMs(GENERATION_RUNS, [&]() { generator.Generate(previousView, currentView, generated.View()); });
+        generator.SetSceneCutDetection(true);
+        double checkedMs = BestOfMs(GENERATION_RUNS, [&]() { generator.Generate(previousView, currentView, generated.View()); });
+
+        Logger::Info("  %-18s histogram %.3f  correlation %5.2f  %-3s %-5s  check %.2f ms  generate %6.1f ms -> %6.1f ms",
+            pair.name, result.histogramDistance, result.correlation, result.cut ? "cut" : "-", result.cut == pair.cut ? "ok" : "WRONG",
+            detectMs, fullMs, checkedMs);
+    }
+
+    const FrameGeneratorStats& stats = generator.GetStats();
+    Logger::Info("  %u of %u pairs misjudged; %llu cuts repeated, %.1f ms of estimation and blending skipped", wrong,
+        static_cast<uint32_t>(sizeof(pairs) / sizeof(pairs[0])), static_cast<unsigned long long>(stats.cuts), stats.cutSavedMs);
+}
+
+void BenchmarkSuite::RunDuplicateFrames()
+{
+    const uint32_t width = COST_WIDTH;
+    const uint32_t height = COST_HEIGHT;
+    const double refresh = 1.0 / CAPTURE_HZ;
+    Logger::Info("Duplicate frames: %u fps game captured at %u Hz, %ux%u, %u captures, %ux%u tiles, predictive 8x8, %u threads",
+        GAME_FPS, CAPTURE_HZ, width, height, CADENCE_CAPTURES, DuplicateFrameDetector::TILE_WIDTH,
+        DuplicateFrameDetector::TILE_HEIGHT, ThreadPool::Shared().GetThreadCount());
+
+    SyntheticScene scene;
+    scene.Initialize(width + CADENCE_PAN * CADENCE_CAPTURES + CARET_SIZE, height + CADENCE_PAN * CADENCE_CAPTURES + CARET_SIZE);
+    std::vector<BenchmarkImage> captures(CADENCE_CAPTURES);
+    std::vector<bool> truthNew(CADENCE_CAPTURES);
+    std::vector<uint32_t> shown(CADENCE_CAPTURES);  // Refresh whose game time each capture shows
+    BenchmarkImage truth;
+    BenchmarkImage generated;
+    truth.Allocate(width, height);
+    generated.Allocate(width, height);
+
+    // Game frame g is presented at refresh round(g * CAPTURE_HZ / GAME_FPS) and shows the scene as
+    // of that refresh; the content moves right and down, so the scene offset shrinks
+    const uint32_t origin = CADENCE_PAN * CADENCE_CAPTURES;
+    auto render = [&](const MutableImageView& dst, uint32_t refreshIndex)
+    {
+        scene.Render(origin - CADENCE_PAN * refreshIndex, origin - CADENCE_PAN * refreshIndex, 1, dst);
+    };
+    uint32_t presented = 0;
+    for (uint32_t i = 0; i < CADENCE_CAPTURES; i++)
+    {
+        uint32_t nextGameFrame = 0;
+        while ((nextGameFrame * CAPTURE_HZ * 2 + GAME_FPS) / (GAME_FPS * 2) <= i)
+        {
+            nextGameFrame++;
+        }
+        const uint32_t present = ((nextGameFrame - 1) * CAPTURE_HZ * 2 + GAME_FPS) / (GAME_FPS * 2);
+        truthNew[i] = i == 0 || present != presented;
+        presented = present;
+        shown[i] = present;
+
+        captures[i].Allocate(width, height);
+        render(captures[i].View(), present);
+        if (i >= CARET_CAPTURE)
+        {
+            FillRect(captures[i].View(), DuplicateFrameDetector::TILE_WIDTH, 6 * DuplicateFrameDetector::TILE_HEIGHT, CARET_SIZE, CARET_SIZE);
+        }
+    }
+
+    // The sprite frames: the first pan frame, with the sprite moved each frame
+    std::vector<BenchmarkImage> spriteFrames(SPRITE_FRAMES);
+    for (uint32_t i = 0; i < SPRITE_FRAMES; i++)
+    {
+        spriteFrames[i].Allocate(width, height);
+        render(spriteFrames[i].View(), 0);
+        FillRect(spriteFrames[i].View(), width / 2 + i * SPRITE_STEP, height / 2, CARET_SIZE, CARET_SIZE);
+    }
+
+    // Tagging: every capture through the detector at its present time (the refresh it was captured
+    // on), at the default limit and at one that lets the caret through
+    std::vector<bool> tagged(CADENCE_CAPTURES);
+    for (uint32_t limit : { 0u, 2u })
+    {
+        DuplicateFrameDetector detector;
+        detector.SetChangedTileLimit(limit);
+        uint32_t missed = 0;
+        uint32_t falseNew = 0;
+        uint32_t gameFrames = 0;
+        float checkMs = 0.0f;
+        for (uint32_t i = 0; i < CADENCE_CAPTURES; i++)
+        {
+            const bool isNew = detector.Update(static_cast<const BenchmarkImage&>(captures[i]).View(), i * refresh);
+            checkMs += detector.GetStats().checkMs;
+            gameFrames += truthNew[i] ? 1 : 0;
+            missed += truthNew[i] && !isNew ? 1 : 0;
+            falseNew += !truthNew[i] && isNew ? 1 : 0;
+            // The default limit's tags drive the generation below
+            if (limit == 0)
+            {
+                tagged[i] = isNew;
+            }
+        }
+        const double frameInterval = detector.GetStats().frameInterval;
+
+        detector.Reset();
+        uint32_t spriteFound = 0;
+        for (uint32_t i = 0; i < SPRITE_FRAMES; i++)
+        {
+            spriteFound += detector.Update(static_cast<const BenchmarkImage&>(spriteFrames[i]).View(), i * refresh) ? 1 : 0;
+        }
+
+        Logger::Info("  limit %u: %u game frames in %u captures: %u missed, %u extra (caret); check %.3f ms per capture; "
+                     "game frame time %.1f ms (capture %.1f ms); sprite over a still scene %u of %u found",
+            limit, gameFrames, CADENCE_CAPTURES, missed, falseNew, checkMs / CADENCE_CAPTURES, frameInterval * 1000.0,
+            refresh * 1000.0, spriteFound, SPRITE_FRAMES);
+    }
+
+    // Every refresh gets a generated frame. Untagged: one generation per pair of captures, half
+    // way. Tagged at the default limit: duplicates dropped, the last two new frames interpolated
+    // at the refresh time one game frame back (their own spacing, from the tags), one estimate per
+    // new frame
+    FrameGenerator naive;
+    naive.SetMotionSearch(MotionSearch::Predictive);
+    naive.SetSearchRange(MAX_PAN);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 1; i < CADENCE_CAPTURES; i++)
+    {
+        naive.Generate(static_cast<const BenchmarkImage&>(captures[i - 1]).View(), static_cast<const BenchmarkImage&>(captures[i]).View(),
+                       generated.View());
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const double naiveMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    FrameGenerator cadence[2];
+    double cadenceMs[2] = { 0.0, 0.0 };
+    double psnr[2] = { 0.0, 0.0 };
+    uint32_t scored = 0;
+    for (uint32_t mode = 0; mode < 2; mode++)
+    {
+        // mode 0 takes t from the timestamps, mode 1 always generates the middle frame
+        cadence[mode].SetMotionSearch(MotionSearch::Predictive);
+        cadence[mode].SetSearchRange(MAX_PAN);
+        int32_t frames[2] = { -1, -1 };  // Capture index of the previous and current new frame
+        scored = 0;
+        for (uint32_t i = 0; i < CADENCE_CAPTURES; i++)
+        {
+            if (tagged[i])
+            {
+                frames[0] = frames[1];
+                frames[1] = static_cast<int32_t>(i);
+            }
+            if (frames[0] < 0)
+            {
+                continue;
+            }
+
+            const double previousTime = frames[0] * refresh;
+            const double currentTime = frames[1] * refresh;
+            const double outputTime = mode == 0 ? i * refresh - (currentTime - previousTime) : (previousTime + currentTime) * 0.5;
+            start = std::chrono::high_resolution_clock::now();
+            cadence[mode].GenerateAt(static_cast<const BenchmarkImage&>(captures[frames[0]]).View(), previousTime,
+                                     static_cast<const BenchmarkImage&>(captures[frames[1]]).View(), currentTime, outputTime,
+                                     generated.View());
+            end = std::chrono::high_resolution_clock::now();
+            cadenceMs[mode] += std::chrono::duration<double, std::milli>(end - start).count();
+
+            // The refresh shows the game one game frame back, held at the newest frame
+            const uint32_t back = i - static_cast<uint32_t>(frames[1]);
+            const uint32_t span = shown[frames[1]] - shown[frames[0]];
+            render(truth.View(), shown[frames[0]] + std::min(back, span));
+            psnr[mode] += ComputePsnr(static_cast<const BenchmarkImage&>(generated).View(), static_cast<const BenchmarkImage&>(truth).View());
+            scored++;
+        }
+    }
+
+    Logger::Info("  every capture pair:    %7.1f ms  %u estimates", naiveMs, CADENCE_CAPTURES - 1);
+    Logger::Info("  new frames, timed:     %7.1f ms  %llu estimates, %llu reused  %6.2f dB against the game's motion",
+        cadenceMs[0], static_cast<unsigned long long>(cadence[0].GetStats().frames - cadence[0].GetStats().reusedEstimates),
+        static_cast<unsigned long long>(cadence[0].GetStats().reusedEstimates), psnr[0] / std::max(scored, 1u));
+    Logger::Info("  new frames, midpoint:  %7.1f ms  %llu estimates, %llu reused  %6.2f dB",
+        cadenceMs[1], static_cast<unsigned long long>(cadence[1].GetStats().frames - cadence[1].GetStats().reusedEstimates),
+        static_cast<unsigned long long>(cadence[1].GetStats().reusedEstimates), psnr[1] / std::max(scored, 1u));
+}
+
+bool BenchmarkSuite::RunSteadyAllocations()
+{
+    const uint32_t outputWidth = QUALITY_WIDTH * 2;
+    const uint32_t outputHeight = QUALITY_HEIGHT * 2;
+    if (!IsHeapAllocationCountEnabled())
+    {
+        Logger::Info("Steady-state allocations: not counted (configure with -DPOTATO_SCRATCH_CHECKS=ON)");
+        return true;
+    }
+    Logger::Info("Steady-state allocations: %ux%u -> %ux%u, upscale, CAS, analysis, generation, %u frames after %u warm-up",
+        QUALITY_WIDTH, QUALITY_HEIGHT, outputWidth, outputHeight, STEADY_FRAMES, ScratchArena::WARMUP_FRAMES);
+
+    SyntheticScene scene;
+    scene.Initialize(QUALITY_WIDTH + STEADY_FRAMES * 2 + 8, QUALITY_HEIGHT + STEADY_FRAMES * 2 + 8);
+    BenchmarkImage inputs[2];
+    BenchmarkImage outputs[2];
+    BenchmarkImage generated;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        inputs[i].Allocate(QUALITY_WIDTH, QUALITY_HEIGHT);
+        outputs[i].Allocate(outputWidth, outputHeight);
+    }
+    generated.Allocate(outputWidth, outputHeight);
+
+    // One arena of its own, so the shape warm-up doesn't depend on earlier sections
+    ScratchArena arena;
+    FrameAnalysis analysis;
+    FrameGenerator generator;
+    generator.SetMotionSearch(MotionSearch::Predictive);
+    ResetHistory();
+
+    const uint32_t frames = ScratchArena::WARMUP_FRAMES + STEADY_FRAMES;
+    uint64_t steadyAllocations = 0;
+    uint32_t allocatingFrames = 0;
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        // Rendering the test scene isn't part of the frame path
+        const uint32_t slot = frame % 2;
+        scene.Render(frame * 2, frame, 1, inputs[slot].View());
+
+        const uint64_t allocationsBefore = GetHeapAllocationCount();
+        arena.BeginFrame(frame);
+        const ImageView input = static_cast<const BenchmarkImage&>(inputs[slot]).View();
+        m_temporalUpscaler->Upscale(input, outputs[slot].View());
+        m_casSharpener->Sharpen(outputs[slot].View(), FSR_SHARPNESS);
+        analysis.Update(input, frame / 60.0);
+        if (frame > 0)
+        {
+            generator.Generate(static_cast<const BenchmarkImage&>(outputs[slot ^ 1]).View(),
+                               static_cast<const BenchmarkImage&>(outputs[slot]).View(), generated.View());
+        }
+        arena.EndFrame();
+
+        const uint64_t allocations = GetHeapAllocationCount() - allocationsBefore;
+        // Generation starts a frame late, so its warm-up ends a frame later
+        if (frame >= ScratchArena::WARMUP_FRAMES + 1 && allocations > 0)
+        {
+            steadyAllocations += allocations;
+            allocatingFrames++;
+        }
+    }
+
+    if (steadyAllocations > 0)
+    {
+        Logger::Error("  %u of %u steady-state frames allocated (%llu heap allocations)", allocatingFrames, STEADY_FRAMES - 1,
+            static_cast<unsigned long long>(steadyAllocations));
+        return false;
+    }
+    Logger::Info("  0 heap allocations in %u steady-state frames", STEADY_FRAMES - 1);
+    return true;
+}
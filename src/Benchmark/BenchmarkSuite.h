@@ -0,0 +1,89 @@
+#pragma once
+#include "BenchmarkImage.h"
+#include <memory>
+#include <string>
+
+class CpuUpscaler;
+class TemporalUpscaler;
+class CnnUpscaler;
+class CasSharpener;
+class ReplayReader;
+
+struct BenchmarkOptions
+{
+    std::string replayPath;  // Optional capture recorded from the overlay
+};
+
+// Headless quality/cost report for the CPU processing paths
+// Run with --benchmark [--replay file.ppr]; no window or D3D device is created.
+// Synthetic sequences provide an exact high resolution reference; replay frames are
+// downscaled 2x and the original frame serves as the reference.
+class BenchmarkSuite
+{
+public:
+    explicit BenchmarkSuite(const BenchmarkOptions& options);
+    ~BenchmarkSuite();
+
+    // Returns the process exit code
+    int Run();
+
+private:
+    enum class Method
+    {
+        Bilinear,
+        Fsr,
+        EdgeDirected,
+        Temporal,
+        Neural,
+        Count
+    };
+
+    struct Sequence
+    {
+        const char* name;
+        int stepX;  // Pan per frame in lattice pixels (1/4 input pixel)
+        int stepY;
+    };
+
+    struct Result
+    {
+        double firstPsnr = 0.0;   // Quality of the first frame
+        double steadyPsnr = 0.0;  // Average once temporal methods have converged
+        double averageMs = 0.0;
+    };
+
+    static const char* GetMethodName(Method method);
+    void Upscale(Method method, const ImageView& src, const MutableImageView& dst);
+    void ResetHistory();
+
+    void RunSyntheticQuality();
+    void RunReplayQuality();
+    void RunUpscaleCost();
+    void RunLinearLight();
+    void RunPixelConvert();
+    void RunFixedPoint();
+    void RunFrameLayouts();
+    void RunFramePool();
+    void RunAnalysisPyramid();
+    void RunFrameGeneration();
+    void RunMotionSearch();
+    void RunBlockSad();
+    void RunOpticalFlow();
+    void RunExtrapolation();
+    void RunStaticRegions();
+    void RunSceneCuts();
+    void RunDuplicateFrames();
+    bool RunSteadyAllocations();  // False if a steady-state frame allocated
+    void PrintResult(const char* name, const Result& result);
+
+private:
+    BenchmarkOptions m_options;
+    std::unique_ptr<CpuUpscaler> m_cpuUpscaler;
+    std::unique_ptr<TemporalUpscaler> m_temporalUpscaler;
+    std::unique_ptr<CnnUpscaler> m_cnnUpscaler;
+    std::unique_ptr<CasSharpener> m_casSharpener;
+
+    BenchmarkImage m_input;
+    BenchmarkImage m_output;
+    BenchmarkImage m_reference;
+};
@@ -0,0 +1,63 @@
+#include "ImageMetrics.h"
+#include <algorithm>
+#include <cmath>
+
+double ComputePsnr(const ImageView& image, const ImageView& reference)
+{
+    const uint32_t width = std::min(image.width, reference.width);
+    const uint32_t height = std::min(image.height, reference.height);
+    if (width == 0 || height == 0)
+    {
+        return 0.0;
+    }
+
+    uint64_t sumSquares = 0;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* a = image.Row(y);
+        const uint8_t* b = reference.Row(y);
+        uint32_t rowSum = 0;  // At most 3 * 65025 per pixel, fits for rows up to ~22000 pixels
+        for (uint32_t x = 0; x < width * 4; x += 4)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                int d = a[x + c] - b[x + c];
+                rowSum += d * d;
+            }
+        }
+        sumSquares += rowSum;
+    }
+
+    if (sumSquares == 0)
+    {
+        return 99.0;
+    }
+
+    double mse = static_cast<double>(sumSquares) / (static_cast<double>(width) * height * 3);
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+void BoxDownsample(const ImageView& src, const MutableImageView& dst, uint32_t factor)
+{
+    const uint32_t area = factor * factor;
+    for (uint32_t y = 0; y < dst.height; y++)
+    {
+        uint8_t* out = dst.Row(y);
+        for (uint32_t x = 0; x < dst.width; x++)
+        {
+            uint32_t sum[4] = {};
+            for (uint32_t sy = 0; sy < factor; sy++)
+            {
+                const uint8_t* in = src.Row(y * factor + sy) + x * factor * 4;
+                for (uint32_t sx = 0; sx < factor * 4; sx++)
+                {
+                    sum[sx & 3] += in[sx];
+                }
+            }
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                out[x * 4 + c] = static_cast<uint8_t>((sum[c] + area / 2) / area);
+            }
+        }
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "../Processing/ImageView.h"
+
+// Quality metrics for comparing a processed frame against a reference
+
+// PSNR over the B, G and R channels in dB (alpha ignored), 99 for identical images
+double ComputePsnr(const ImageView& image, const ImageView& reference);
+
+// Average each factor x factor block of src into one pixel of dst
+// dst must be exactly src / factor in both dimensions
+void BoxDownsample(const ImageView& src, const MutableImageView& dst, uint32_t factor);
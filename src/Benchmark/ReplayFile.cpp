@@ -0,0 +1,112 @@
+#include "ReplayFile.h"
+#include "../Utils/Logger.h"
+#include <cstring>
+
+ReplayWriter::~ReplayWriter()
+{
+    Close();
+}
+
+bool ReplayWriter::Open(const std::string& path, uint32_t width, uint32_t height)
+{
+    Close();
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open())
+    {
+        Logger::Error("Failed to create replay file: %s", path.c_str());
+        return false;
+    }
+
+    m_header = ReplayHeader();
+    m_header.width = width;
+    m_header.height = height;
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    return m_file.good();
+}
+
+bool ReplayWriter::WriteFrame(const ImageView& frame, uint64_t timestampUs)
+{
+    if (!m_file.is_open() || frame.width != m_header.width || frame.height != m_header.height)
+    {
+        return false;
+    }
+
+    m_file.write(reinterpret_cast<const char*>(&timestampUs), sizeof(timestampUs));
+    for (uint32_t y = 0; y < frame.height; y++)
+    {
+        m_file.write(reinterpret_cast<const char*>(frame.Row(y)), static_cast<std::streamsize>(frame.width) * 4);
+    }
+
+    if (!m_file.good())
+    {
+        Logger::Error("Failed to write replay frame %u", m_header.frameCount);
+        return false;
+    }
+
+    m_header.frameCount++;
+    return true;
+}
+
+void ReplayWriter::Close()
+{
+    if (!m_file.is_open())
+    {
+        return;
+    }
+
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_file.close();
+    Logger::Info("Replay saved: %u frames at %ux%u", m_header.frameCount, m_header.width, m_header.height);
+}
+
+bool ReplayReader::Open(const std::string& path)
+{
+    m_file.open(path, std::ios::binary);
+    if (!m_file.is_open())
+    {
+        Logger::Error("Failed to open replay file: %s", path.c_str());
+        return false;
+    }
+
+    m_file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header));
+    if (!m_file.good() || memcmp(m_header.magic, "PPRP", 4) != 0 || m_header.version != 1 ||
+        m_header.width == 0 || m_header.height == 0)
+    {
+        Logger::Error("Not a valid replay file: %s", path.c_str());
+        m_file.close();
+        return false;
+    }
+
+    m_frame.resize(static_cast<size_t>(m_header.width) * m_header.height * 4);
+    m_framesRead = 0;
+    Logger::Info("Replay loaded: %u frames at %ux%u", m_header.frameCount, m_header.width, m_header.height);
+    return true;
+}
+
+bool ReplayReader::ReadFrame(ImageView& frame, uint64_t& timestampUs)
+{
+    if (!m_file.is_open() || m_framesRead >= m_header.frameCount)
+    {
+        return false;
+    }
+
+    m_file.read(reinterpret_cast<char*>(&timestampUs), sizeof(timestampUs));
+    m_file.read(reinterpret_cast<char*>(m_frame.data()), static_cast<std::streamsize>(m_frame.size()));
+    if (!m_file.good())
+    {
+        return false;
+    }
+
+    m_framesRead++;
+    frame = ImageView{ m_frame.data(), m_header.width, m_header.height, static_cast<size_t>(m_header.width) * 4 };
+    return true;
+}
+
+void ReplayReader::Rewind()
+{
+    m_file.clear();
+    m_file.seekg(sizeof(ReplayHeader));
+    m_framesRead = 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "../Processing/ImageView.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Captured frame sequences for offline benchmarking
+// File layout: ReplayHeader, then per frame a uint64 timestamp (microseconds since the
+// first frame) followed by width * height * 4 bytes of tightly packed BGRA8 pixels
+struct ReplayHeader
+{
+    char magic[4] = { 'P', 'P', 'R', 'P' };
+    uint32_t version = 1;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t frameCount = 0;
+    uint32_t reserved = 0;
+};
+
+class ReplayWriter
+{
+public:
+    ~ReplayWriter();
+
+    bool Open(const std::string& path, uint32_t width, uint32_t height);
+    bool WriteFrame(const ImageView& frame, uint64_t timestampUs);
+    void Close();  // Patches the frame count into the header
+
+    bool IsOpen() const { return m_file.is_open(); }
+    uint32_t GetFrameCount() const { return m_header.frameCount; }
+
+private:
+    std::ofstream m_file;
+    ReplayHeader m_header;
+};
+
+class ReplayReader
+{
+public:
+    bool Open(const std::string& path);
+
+    // Reads the next frame into an internal buffer, false at the end of the file
+    bool ReadFrame(ImageView& frame, uint64_t& timestampUs);
+    void Rewind();
+
+    uint32_t GetWidth() const { return m_header.width; }
+    uint32_t GetHeight() const { return m_header.height; }
+    uint32_t GetFrameCount() const { return m_header.frameCount; }
+
+private:
+    std::ifstream m_file;
+    ReplayHeader m_header;
+    std::vector<uint8_t> m_frame;
+    uint32_t m_framesRead = 0;
+};
@@ -0,0 +1,200 @@
+#include "SyntheticScene.h"
+#include "../Processing/ColorSpace.h"
+#include <cmath>
+
+namespace
+{
+    // Scene is a patchwork of tiles, each holding one kind of content
+    const uint32_t TILE_SIZE = 384;
+
+    // Glyph cell in lattice pixels (6x8 input pixels at 4 lattice pixels per input pixel)
+    const uint32_t GLYPH_WIDTH = 24;
+    const uint32_t GLYPH_HEIGHT = 32;
+
+    inline uint32_t Hash(uint32_t a, uint32_t b)
+    {
+        uint32_t h = a * 0x9E3779B1u ^ (b + 0x7F4A7C15u) * 0x85EBCA77u;
+        h ^= h >> 15;
+        h *= 0x2C1B3C6Du;
+        h ^= h >> 12;
+        return h;
+    }
+
+    inline void SetPixel(uint8_t* pixel, uint8_t r, uint8_t g, uint8_t b)
+    {
+        pixel[0] = b;
+        pixel[1] = g;
+        pixel[2] = r;
+        pixel[3] = 255;
+    }
+
+    inline bool InRange(uint32_t value, uint32_t begin, uint32_t end)
+    {
+        return value >= begin && value < end;
+    }
+
+    // Seven-segment style glyph strokes, 3 lattice pixels wide
+    bool GlyphCovers(uint32_t mask, uint32_t lx, uint32_t ly)
+    {
+        if ((mask & 1) && InRange(ly, 4, 7) && InRange(lx, 4, 18)) return true;
+        if ((mask & 2) && InRange(ly, 14, 17) && InRange(lx, 4, 18)) return true;
+        if ((mask & 4) && InRange(ly, 25, 28) && InRange(lx, 4, 18)) return true;
+        if ((mask & 8) && InRange(lx, 4, 7) && InRange(ly, 4, 17)) return true;
+        if ((mask & 16) && InRange(lx, 15, 18) && InRange(ly, 4, 17)) return true;
+        if ((mask & 32) && InRange(lx, 4, 7) && InRange(ly, 14, 28)) return true;
+        if ((mask & 64) && InRange(lx, 15, 18) && InRange(ly, 14, 28)) return true;
+        return false;
+    }
+}
+
+void SyntheticScene::Initialize(uint32_t latticeWidth, uint32_t latticeHeight)
+{
+    m_width = latticeWidth;
+    m_height = latticeHeight;
+    m_lattice.resize(static_cast<size_t>(latticeWidth) * latticeHeight * 4);
+
+    for (uint32_t y = 0; y < m_height; y++)
+    {
+        uint8_t* row = &m_lattice[static_cast<size_t>(y) * m_width * 4];
+        for (uint32_t x = 0; x < m_width; x++)
+        {
+            Evaluate(x, y, row + x * 4);
+        }
+    }
+}
+
+void SyntheticScene::Evaluate(uint32_t x, uint32_t y, uint8_t* pixel) const
+{
+    const uint32_t tileX = x / TILE_SIZE;
+    const uint32_t tileY = y / TILE_SIZE;
+    const uint32_t kind = Hash(tileX, tileY) % 3;
+    const float localX = static_cast<float>(x % TILE_SIZE);
+    const float localY = static_cast<float>(y % TILE_SIZE);
+
+    if (kind == 0)
+    {
+        // Small dark text on a light background, every fourth line left empty
+        uint32_t cellX = x / GLYPH_WIDTH;
+        uint32_t cellY = y / GLYPH_HEIGHT;
+        uint32_t hash = Hash(cellX, cellY + 0x1000);
+        bool blank = (cellY % 4) == 3 || (hash >> 24) < 40;
+        if (!blank && GlyphCovers((hash & 0x7F) | 1, x % GLYPH_WIDTH, y % GLYPH_HEIGHT))
+        {
+            SetPixel(pixel, 28, 30, 38);
+        }
+        else
+        {
+            SetPixel(pixel, 232, 232, 226);
+        }
+    }
+    else if (kind == 1)
+    {
+        // Thin diagonal lines, a vertical grid and concentric rings on a dark background
+        float diagonal = (localX * 0.6f + localY * 0.8f) / 17.0f;
+        float dx = localX - TILE_SIZE * 0.5f;
+        float dy = localY - TILE_SIZE * 0.5f;
+        float ring = std::sqrt(dx * dx + dy * dy) / 11.0f;
+
+        if (ring - std::floor(ring) < 0.18f && ring < 14.0f)
+        {
+            SetPixel(pixel, 90, 200, 240);
+        }
+        else if (diagonal - std::floor(diagonal) < 0.12f)
+        {
+            SetPixel(pixel, 220, 200, 90);
+        }
+        else if (x % 29 < 2)
+        {
+            SetPixel(pixel, 120, 120, 130);
+        }
+        else
+        {
+            SetPixel(pixel, 40, 44, 52);
+        }
+    }
+    else
+    {
+        // Smooth gradient with a soft highlight and a bordered UI panel
+        float u = localX / TILE_SIZE;
+        float v = localY / TILE_SIZE;
+        float dx = u - 0.35f;
+        float dy = v - 0.4f;
+        float glow = std::exp(-(dx * dx + dy * dy) * 12.0f);
+        float r = 40.0f + 150.0f * u + 60.0f * glow;
+        float g = 70.0f + 90.0f * v + 60.0f * glow;
+        float b = 160.0f - 80.0f * u + 60.0f * glow;
+
+        bool inPanel = localX >= 200 && localX < 360 && localY >= 220 && localY < 340;
+        bool onBorder = inPanel && (localX < 202 || localX >= 358 || localY < 222 || localY >= 338);
+        if (onBorder)
+        {
+            SetPixel(pixel, 250, 250, 250);
+        }
+        else if (inPanel)
+        {
+            SetPixel(pixel, 36, 36, 40);
+        }
+        else
+        {
+            SetPixel(pixel, static_cast<uint8_t>(std::fmin(r, 255.0f)), static_cast<uint8_t>(std::fmin(g, 255.0f)),
+                     static_cast<uint8_t>(std::fmin(b, 255.0f)));
+        }
+    }
+}
+
+bool SyntheticScene::Render(uint32_t offsetX, uint32_t offsetY, uint32_t cellSize, const MutableImageView& dst, bool linearLight) const
+{
+    if (cellSize == 0 ||
+        offsetX + static_cast<uint64_t>(dst.width) * cellSize > m_width ||
+        offsetY + static_cast<uint64_t>(dst.height) * cellSize > m_height)
+    {
+        return false;
+    }
+
+    const uint32_t area = cellSize * cellSize;
+    const size_t latticePitch = static_cast<size_t>(m_width) * 4;
+    const SrgbTables& tables = GetSrgbTables();
+
+    for (uint32_t y = 0; y < dst.height; y++)
+    {
+        const uint8_t* cellRow = &m_lattice[(offsetY + static_cast<size_t>(y) * cellSize) * latticePitch + offsetX * 4];
+        uint8_t* out = dst.Row(y);
+        for (uint32_t x = 0; x < dst.width; x++)
+        {
+            if (linearLight)
+            {
+                float sum[4] = {};
+                for (uint32_t sy = 0; sy < cellSize; sy++)
+                {
+                    const uint8_t* in = cellRow + sy * latticePitch + x * cellSize * 4;
+                    for (uint32_t sx = 0; sx < cellSize * 4; sx++)
+                    {
+                        sum[sx & 3] += (sx & 3) == 3 ? in[sx] : tables.toLinear[in[sx]];
+                    }
+                }
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    float encoded = LinearToSrgb(sum[c] / (area * 255.0f));
+                    out[x * 4 + c] = static_cast<uint8_t>(std::lround(encoded * 255.0f));
+                }
+                out[x * 4 + 3] = static_cast<uint8_t>(std::lround(sum[3] / area));
+                continue;
+            }
+
+            uint32_t sum[4] = {};
+            for (uint32_t sy = 0; sy < cellSize; sy++)
+            {
+                const uint8_t* in = cellRow + sy * latticePitch + x * cellSize * 4;
+                for (uint32_t sx = 0; sx < cellSize * 4; sx++)
+                {
+                    sum[sx & 3] += in[sx];
+                }
+            }
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                out[x * 4 + c] = static_cast<uint8_t>((sum[c] + area / 2) / area);
+            }
+        }
+    }
+    return true;
+}
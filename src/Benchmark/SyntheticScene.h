@@ -0,0 +1,32 @@
+#pragma once
+#include "../Processing/ImageView.h"
+#include <cstdint>
+#include <vector>
+
+// Procedural desktop-like test content: small text, thin lines, UI boxes, gradients
+// The scene is rendered once onto a fine lattice; frames are box-filtered from it, so a
+// low resolution input and a high resolution reference of the same moment (and of the
+// same pan offset) are exactly consistent with each other.
+class SyntheticScene
+{
+public:
+    // Lattice size in lattice pixels, large enough for the view plus the furthest pan
+    void Initialize(uint32_t latticeWidth, uint32_t latticeHeight);
+
+    // Render a frame whose pixels each cover cellSize x cellSize lattice pixels,
+    // starting at lattice position (offsetX, offsetY)
+    // linearLight averages the cells in linear light, like a camera or a supersampled renderer
+    // Returns false if the frame would read outside the lattice
+    bool Render(uint32_t offsetX, uint32_t offsetY, uint32_t cellSize, const MutableImageView& dst, bool linearLight = false) const;
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+
+private:
+    void Evaluate(uint32_t x, uint32_t y, uint8_t* pixel) const;
+
+private:
+    std::vector<uint8_t> m_lattice;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+};
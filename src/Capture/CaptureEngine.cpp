@@ -21,6 +21,7 @@ bool CaptureEngine::Initialize(D3D12Context* context)
         return false;
     }
     
+    m_monitorsVersion++;
     Logger::Info("Capture engine initialized with desktop duplication");
     return true;
 }
@@ -34,23 +35,20 @@ void CaptureEngine::Shutdown()
     }
 }
 
-std::vector<MonitorInfo> CaptureEngine::GetMonitors()
+const std::vector<MonitorInfo>& CaptureEngine::GetMonitors() const
+{
+    // Enumerated once by the duplication, the UI reads this every frame
+    static const std::vector<MonitorInfo> noMonitors;
+    return m_desktopDuplication ? m_desktopDuplication->GetMonitors() : noMonitors;
+}
+
+void CaptureEngine::RefreshMonitors()
 {
-    // Return cached monitors from initialization
     if (m_desktopDuplication)
     {
-        // Cache the monitors on first call to avoid re-enumeration
-        static std::vector<MonitorInfo> cachedMonitors;
-        static bool cached = false;
-        
-        if (!cached)
-        {
-            cachedMonitors = m_desktopDuplication->EnumerateMonitors();
-            cached = true;
-        }
-        return cachedMonitors;
+        m_desktopDuplication->RefreshMonitors();
+        m_monitorsVersion++;
     }
-    return {};
 }
 
 bool CaptureEngine::SelectMonitor(int monitorIndex)
@@ -68,6 +66,14 @@ bool CaptureEngine::SelectMonitor(int monitorIndex)
     return false;
 }
 
+void CaptureEngine::SetHdrCaptureEnabled(bool enabled)
+{
+    if (m_desktopDuplication)
+    {
+        m_desktopDuplication->SetHdrCaptureEnabled(enabled);
+    }
+}
+
 int CaptureEngine::GetMonitorForWindow(HWND hwnd)
 {
     if (!hwnd || !IsWindow(hwnd))
@@ -81,7 +87,7 @@ int CaptureEngine::GetMonitorForWindow(HWND hwnd)
         return -1;
     }
     
-    auto monitors = GetMonitors();
+    const std::vector<MonitorInfo>& monitors = GetMonitors();
     for (size_t i = 0; i < monitors.size(); i++)
     {
         if (monitors[i].hMonitor == hMonitor)
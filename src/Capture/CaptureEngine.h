@@ -14,12 +14,21 @@ public:
     bool Initialize(D3D12Context* context);
     void Shutdown();
 
-    // Get available monitors for capture
-    std::vector<MonitorInfo> GetMonitors();
+    // Get available monitors for capture (valid until the next RefreshMonitors())
+    const std::vector<MonitorInfo>& GetMonitors() const;
+    
+    // Changes whenever the monitor list does, so callers can cache what they derive from it
+    uint32_t GetMonitorsVersion() const { return m_monitorsVersion; }
+    
+    // Enumerate the monitors again (e.g. after a display change)
+    void RefreshMonitors();
     
     // Select which monitor to capture (call before enabling capture)
     bool SelectMonitor(int monitorIndex);
     
+    // Capture in the desktop's HDR format when it has one (takes effect on the next SelectMonitor)
+    void SetHdrCaptureEnabled(bool enabled);
+    
     // Get monitor that contains a window
     int GetMonitorForWindow(HWND hwnd);
     
@@ -48,4 +57,5 @@ private:
     D3D12Context* m_context = nullptr;
     std::unique_ptr<DesktopDuplication> m_desktopDuplication;
     int m_selectedMonitor = -1;
+    uint32_t m_monitorsVersion = 0;
 };
\ No newline at end of file
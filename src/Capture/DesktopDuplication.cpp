@@ -18,6 +18,10 @@ bool DesktopDuplication::Initialize(D3D12Context* d3d12Context)
 {
     m_d3d12Context = d3d12Context;
     
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_ticksPerSecond = static_cast<double>(frequency.QuadPart);
+    
     if (!CreateD3D11Device())
     {
         Logger::Error("Failed to create D3D11 device for desktop duplication");
@@ -132,6 +136,12 @@ std::vector<MonitorInfo> DesktopDuplication::EnumerateMonitors()
     return monitors;
 }
 
+void DesktopDuplication::RefreshMonitors()
+{
+    // The current duplication keeps its output, only later selections see the new list
+    m_monitors = EnumerateMonitors();
+}
+
 bool DesktopDuplication::SelectMonitor(int monitorIndex)
 {
     if (monitorIndex < 0 || monitorIndex >= (int)m_monitors.size())
@@ -199,8 +209,36 @@ bool DesktopDuplication::CreateDuplicationOutput(int adapterIndex, int outputInd
         return false;
     }
     
+    // HDR capture needs DuplicateOutput1, which hands out the desktop in whichever of the
+    // listed formats is closest to its own (FP16 on an HDR display, 10-bit on a deep colour one)
+    hr = E_NOINTERFACE;
+    ComPtr<IDXGIOutput5> output5;
+    if (m_hdrCapture && SUCCEEDED(output.As(&output5)))
+    {
+        const DXGI_FORMAT formats[] = {
+            DXGI_FORMAT_R16G16B16A16_FLOAT,
+            DXGI_FORMAT_R10G10B10A2_UNORM,
+            DXGI_FORMAT_B8G8R8A8_UNORM,
+        };
+
+        // DuplicateOutput1 requires a per-monitor aware thread
+        DPI_AWARENESS_CONTEXT previous = SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+        hr = output5->DuplicateOutput1(m_d3d11Device.Get(), 0, _countof(formats), formats, &m_duplication);
+        if (previous)
+        {
+            SetThreadDpiAwarenessContext(previous);
+        }
+        if (FAILED(hr))
+        {
+            Logger::Warning("HDR desktop duplication unavailable (0x%08X), capturing BGRA8", hr);
+        }
+    }
+
     // DuplicateOutput - we'll disable the mouse pointer capture later via frame info
-    hr = output1->DuplicateOutput(m_d3d11Device.Get(), &m_duplication);
+    if (FAILED(hr))
+    {
+        hr = output1->DuplicateOutput(m_d3d11Device.Get(), &m_duplication);
+    }
     if (FAILED(hr))
     {
         if (hr == DXGI_ERROR_NOT_CURRENTLY_AVAILABLE)
@@ -219,6 +257,16 @@ bool DesktopDuplication::CreateDuplicationOutput(int adapterIndex, int outputInd
     }
     
     Logger::Info("Desktop duplication output created (cursor will be excluded from capture)");
+
+    DXGI_OUTDUPL_DESC duplicationDesc;
+    m_duplication->GetDesc(&duplicationDesc);
+    m_format = duplicationDesc.ModeDesc.Format;
+    if (m_format != DXGI_FORMAT_R16G16B16A16_FLOAT && m_format != DXGI_FORMAT_R10G10B10A2_UNORM)
+    {
+        m_format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    }
+    Logger::Info("Capture format: %s", m_format == DXGI_FORMAT_R16G16B16A16_FLOAT ? "RGBA16F" :
+                 m_format == DXGI_FORMAT_R10G10B10A2_UNORM ? "RGB10A2" : "BGRA8");
     
     DXGI_OUTPUT_DESC desc;
     output->GetDesc(&desc);
@@ -229,7 +277,7 @@ bool DesktopDuplication::CreateDuplicationOutput(int adapterIndex, int outputInd
     texDesc.Height = desc.DesktopCoordinates.bottom - desc.DesktopCoordinates.top;
     texDesc.MipLevels = 1;
     texDesc.ArraySize = 1;
-    texDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    texDesc.Format = m_format;
     texDesc.SampleDesc.Count = 1;
     texDesc.Usage = D3D11_USAGE_DEFAULT;
     texDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
@@ -293,6 +341,12 @@ bool DesktopDuplication::CaptureFrame(int timeoutMs)
     // Copy to our texture
     m_d3d11Context->CopyResource(m_capturedTexture.Get(), desktopTexture.Get());
     
+    // 0 when only the pointer moved; the desktop image is then the last presented one
+    if (frameInfo.LastPresentTime.QuadPart != 0)
+    {
+        m_presentTime = frameInfo.LastPresentTime.QuadPart / m_ticksPerSecond;
+    }
+    
     m_duplication->ReleaseFrame();
     return true;
 }
@@ -1,7 +1,7 @@
 #pragma once
 #include "../Core/D3D12Context.h"
 #include <d3d11.h>
-#include <dxgi1_2.h>
+#include <dxgi1_5.h>
 #include <wrl/client.h>
 #include <vector>
 #include <string>
@@ -29,6 +29,10 @@ public:
     // Get list of available monitors
     std::vector<MonitorInfo> EnumerateMonitors();
     
+    // Monitors found at initialization or by the last RefreshMonitors(), in SelectMonitor() order
+    const std::vector<MonitorInfo>& GetMonitors() const { return m_monitors; }
+    void RefreshMonitors();
+    
     // Select which monitor to capture
     bool SelectMonitor(int monitorIndex);
     
@@ -39,6 +43,10 @@ public:
     // Get the captured frame as D3D11 texture
     ID3D11Texture2D* GetCapturedTexture() { return m_capturedTexture.Get(); }
     
+    // When the captured desktop image was presented, in seconds on the performance counter
+    // (DXGI_OUTDUPL_FRAME_INFO::LastPresentTime); 0 until a frame was captured
+    double GetPresentTime() const { return m_presentTime; }
+    
     // Get D3D11 device (for creating shared resources)
     ID3D11Device* GetD3D11Device() { return m_d3d11Device.Get(); }
     ID3D11DeviceContext* GetD3D11Context() { return m_d3d11Context.Get(); }
@@ -50,6 +58,14 @@ public:
     // Check if initialized and ready
     bool IsReady() const { return m_initialized; }
 
+    // Ask for the desktop's native HDR format (FP16 or 10-bit) instead of BGRA8
+    // Takes effect on the next SelectMonitor()
+    void SetHdrCaptureEnabled(bool enabled) { m_hdrCapture = enabled; }
+    bool IsHdrCaptureEnabled() const { return m_hdrCapture; }
+
+    // Format of the captured texture
+    DXGI_FORMAT GetFormat() const { return m_format; }
+
 private:
     bool CreateD3D11Device();
     bool CreateDuplicationOutput(int adapterIndex, int outputIndex);
@@ -68,6 +84,10 @@ private:
     uint32_t m_width = 0;
     uint32_t m_height = 0;
     int m_currentMonitor = -1;
+    bool m_hdrCapture = false;
+    DXGI_FORMAT m_format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    double m_ticksPerSecond = 1.0;
+    double m_presentTime = 0.0;
     
     std::vector<MonitorInfo> m_monitors;
 };
@@ -0,0 +1,138 @@
+#include "FrameReadback.h"
+#include "../Utils/Logger.h"
+
+FrameReadback::FrameReadback()
+{
+}
+
+FrameReadback::~FrameReadback()
+{
+    Shutdown();
+}
+
+bool FrameReadback::Initialize(ID3D11Device* device, ID3D11DeviceContext* context)
+{
+    if (!device || !context)
+    {
+        Logger::Error("FrameReadback: Invalid device or context");
+        return false;
+    }
+
+    m_device = device;
+    m_context = context;
+    return true;
+}
+
+void FrameReadback::Shutdown()
+{
+    Unmap();
+    m_stagingTexture.Reset();
+    m_device = nullptr;
+    m_context = nullptr;
+    m_width = 0;
+    m_height = 0;
+    m_format = DXGI_FORMAT_UNKNOWN;
+}
+
+bool FrameReadback::EnsureStagingTexture(uint32_t width, uint32_t height, DXGI_FORMAT format)
+{
+    if (m_stagingTexture && m_width == width && m_height == height && m_format == format)
+    {
+        return true;
+    }
+
+    m_stagingTexture.Reset();
+
+    D3D11_TEXTURE2D_DESC texDesc = {};
+    texDesc.Width = width;
+    texDesc.Height = height;
+    texDesc.MipLevels = 1;
+    texDesc.ArraySize = 1;
+    texDesc.Format = format;
+    texDesc.SampleDesc.Count = 1;
+    texDesc.Usage = D3D11_USAGE_STAGING;
+    texDesc.BindFlags = 0;
+    texDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ | D3D11_CPU_ACCESS_WRITE;
+
+    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_stagingTexture);
+    if (FAILED(hr))
+    {
+        Logger::Error("FrameReadback: Failed to create staging texture: 0x%08X", hr);
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_format = format;
+    return true;
+}
+
+bool FrameReadback::CopyAndMap(ID3D11Texture2D* source, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped, D3D11_TEXTURE2D_DESC& desc)
+{
+    if (!source || !m_device || !m_context)
+    {
+        return false;
+    }
+
+    Unmap();
+
+    source->GetDesc(&desc);
+
+    if (!EnsureStagingTexture(desc.Width, desc.Height, desc.Format))
+    {
+        return false;
+    }
+
+    m_context->CopyResource(m_stagingTexture.Get(), source);
+
+    HRESULT hr = m_context->Map(m_stagingTexture.Get(), 0, mapType, 0, &mapped);
+    if (FAILED(hr))
+    {
+        Logger::Error("FrameReadback: Failed to map staging texture: 0x%08X", hr);
+        return false;
+    }
+
+    m_mapped = true;
+    return true;
+}
+
+bool FrameReadback::Map(ID3D11Texture2D* source, ImageView& view)
+{
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    D3D11_TEXTURE2D_DESC desc;
+    if (!CopyAndMap(source, D3D11_MAP_READ, mapped, desc))
+    {
+        return false;
+    }
+
+    view.data = static_cast<const uint8_t*>(mapped.pData);
+    view.width = desc.Width;
+    view.height = desc.Height;
+    view.pitch = mapped.RowPitch;
+    return true;
+}
+
+bool FrameReadback::MapWritable(ID3D11Texture2D* source, MutableImageView& view)
+{
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    D3D11_TEXTURE2D_DESC desc;
+    if (!CopyAndMap(source, D3D11_MAP_READ_WRITE, mapped, desc))
+    {
+        return false;
+    }
+
+    view.data = static_cast<uint8_t*>(mapped.pData);
+    view.width = desc.Width;
+    view.height = desc.Height;
+    view.pitch = mapped.RowPitch;
+    return true;
+}
+
+void FrameReadback::Unmap()
+{
+    if (m_mapped)
+    {
+        m_context->Unmap(m_stagingTexture.Get(), 0);
+        m_mapped = false;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include "../Processing/ImageView.h"
+
+using Microsoft::WRL::ComPtr;
+
+// Copies a GPU texture into a CPU-readable staging texture and maps it
+// Used by the CPU-side analysis stages (letterbox detection etc.)
+class FrameReadback
+{
+public:
+    FrameReadback();
+    ~FrameReadback();
+
+    bool Initialize(ID3D11Device* device, ID3D11DeviceContext* context);
+    void Shutdown();
+
+    // Copy the source texture and map the copy for reading
+    // The view stays valid until Unmap() is called
+    bool Map(ID3D11Texture2D* source, ImageView& view);
+
+    // Same, but the copy may be modified in place and copied back to the GPU afterwards
+    bool MapWritable(ID3D11Texture2D* source, MutableImageView& view);
+    void Unmap();
+
+    // Staging copy of the last mapped texture (usable as a copy source once unmapped)
+    ID3D11Texture2D* GetStagingTexture() const { return m_stagingTexture.Get(); }
+
+private:
+    bool EnsureStagingTexture(uint32_t width, uint32_t height, DXGI_FORMAT format);
+    bool CopyAndMap(ID3D11Texture2D* source, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped, D3D11_TEXTURE2D_DESC& desc);
+
+private:
+    ID3D11Device* m_device = nullptr;
+    ID3D11DeviceContext* m_context = nullptr;
+
+    ComPtr<ID3D11Texture2D> m_stagingTexture;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+    bool m_mapped = false;
+};
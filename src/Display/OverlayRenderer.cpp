@@ -1,7 +1,11 @@
 #include "OverlayRenderer.h"
+#include "../Processing/ScratchArena.h"
 #include "../Utils/Logger.h"
 #include <dxgi1_5.h>  // For IDXGIFactory5 and DXGI_FEATURE_PRESENT_ALLOW_TEARING
 
+// Captured frames between letterbox scans - bars change rarely and each scan is a GPU readback
+static const uint32_t LETTERBOX_SCAN_INTERVAL = 8;
+
 OverlayRenderer::OverlayRenderer()
 {
 }
@@ -35,6 +39,19 @@ bool OverlayRenderer::Initialize(HWND overlayWindow, ID3D11Device* captureDevice
         Logger::Warning("Failed to initialize D3D11 upscaler - upscaling will be disabled");
         m_upscaler.reset();
     }
+    else
+    {
+        m_upscaler->SetMaxOutputSize(m_width, m_height);
+    }
+    
+    m_readback = std::make_unique<FrameReadback>();
+    if (!m_readback->Initialize(m_device, m_context))
+    {
+        Logger::Warning("Failed to initialize frame readback - letterbox detection will be disabled");
+        m_readback.reset();
+    }
+    m_letterboxDetector = std::make_unique<LetterboxDetector>();
+    m_frameAnalysis = std::make_unique<FrameAnalysis>();
     
     Logger::Info("Overlay renderer initialized");
     return true;
@@ -42,11 +59,19 @@ bool OverlayRenderer::Initialize(HWND overlayWindow, ID3D11Device* captureDevice
 
 void OverlayRenderer::Shutdown()
 {
+    StopReplayRecording();
     if (m_upscaler)
     {
         m_upscaler->Shutdown();
         m_upscaler.reset();
     }
+    if (m_readback)
+    {
+        m_readback->Shutdown();
+        m_readback.reset();
+    }
+    m_letterboxDetector.reset();
+    m_frameAnalysis.reset();
     ReleaseRenderTarget();
     m_swapChain.Reset();
     m_device = nullptr;
@@ -86,7 +111,8 @@ bool OverlayRenderer::CreateSwapChain(HWND hwnd)
     swapChainDesc.Height = m_height;
     swapChainDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
     swapChainDesc.SampleDesc.Count = 1;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    // Unordered access lets the CAS shader write straight into the back buffer
+    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT | DXGI_USAGE_UNORDERED_ACCESS;
     swapChainDesc.BufferCount = 2;
     swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
     swapChainDesc.Flags = m_tearingSupported ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
@@ -115,6 +141,20 @@ bool OverlayRenderer::CreateSwapChain(HWND hwnd)
         );
     }
     
+    if (FAILED(hr))
+    {
+        // Try without unordered access (GPU sharpening then falls back to the CPU)
+        swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        hr = factory->CreateSwapChainForHwnd(
+            m_device,
+            hwnd,
+            &swapChainDesc,
+            nullptr,
+            nullptr,
+            &m_swapChain
+        );
+    }
+    
     if (FAILED(hr))
     {
         Logger::Error("CreateSwapChainForHwnd failed: 0x%08X", hr);
@@ -135,6 +175,16 @@ bool OverlayRenderer::CreateRenderTarget()
     
     hr = m_device->CreateRenderTargetView(m_backBuffer.Get(), nullptr, &m_renderTargetView);
     if (FAILED(hr)) return false;
+    m_resourceCreations++;
+    
+    // Optional - only the GPU sharpen path needs it
+    D3D11_TEXTURE2D_DESC desc;
+    m_backBuffer->GetDesc(&desc);
+    if (desc.BindFlags & D3D11_BIND_UNORDERED_ACCESS)
+    {
+        m_device->CreateUnorderedAccessView(m_backBuffer.Get(), nullptr, &m_backBufferUAV);
+        m_resourceCreations++;
+    }
     
     return true;
 }
@@ -146,10 +196,96 @@ void OverlayRenderer::ReleaseRenderTarget()
         m_context->OMSetRenderTargets(0, nullptr, nullptr);
     }
     m_renderTargetView.Reset();
+    m_backBufferUAV.Reset();
     m_backBuffer.Reset();
 }
 
-void OverlayRenderer::RenderFrame(ID3D11Texture2D* capturedFrame)
+bool OverlayRenderer::EnsureBackBufferFormat(DXGI_FORMAT captureFormat)
+{
+    // Copies need matching formats, so HDR captures get an HDR back buffer
+    DXGI_FORMAT format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    if (captureFormat == DXGI_FORMAT_R16G16B16A16_FLOAT || captureFormat == DXGI_FORMAT_R10G10B10A2_UNORM)
+    {
+        format = captureFormat;
+    }
+    if (format == m_backBufferFormat)
+    {
+        return true;
+    }
+    
+    ReleaseRenderTarget();
+    
+    UINT flags = m_tearingSupported ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+    HRESULT hr = m_swapChain->ResizeBuffers(0, m_width, m_height, format, flags);
+    if (FAILED(hr))
+    {
+        Logger::Warning("Overlay swap chain can't switch format (0x%08X)", hr);
+        m_swapChain->ResizeBuffers(0, m_width, m_height, m_backBufferFormat, flags);
+        CreateRenderTarget();
+        return false;
+    }
+    m_backBufferFormat = format;
+    CreateRenderTarget();
+    
+    // FP16 desktops are scRGB (linear, values above 1.0 are HDR), 10-bit ones stay sRGB
+    ComPtr<IDXGISwapChain3> swapChain3;
+    if (SUCCEEDED(m_swapChain.As(&swapChain3)))
+    {
+        DXGI_COLOR_SPACE_TYPE colorSpace = format == DXGI_FORMAT_R16G16B16A16_FLOAT
+            ? DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709
+            : DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709;
+        swapChain3->SetColorSpace1(colorSpace);
+    }
+    
+    Logger::Info("Overlay back buffer format changed to %s", format == DXGI_FORMAT_R16G16B16A16_FLOAT ? "RGBA16F" :
+                 format == DXGI_FORMAT_R10G10B10A2_UNORM ? "RGB10A2" : "BGRA8");
+    return true;
+}
+
+void OverlayRenderer::RenderFrame(ID3D11Texture2D* capturedFrame, bool newFrame, double presentTime)
+{
+    // CPU stages take their per-frame temporaries from the scratch arena
+    ScratchArena& scratch = ScratchArena::Shared();
+    scratch.BeginFrame(m_frameIndex++, GetProcessingShape(capturedFrame));
+    RenderCapturedFrame(capturedFrame, newFrame, presentTime);
+    scratch.EndFrame();
+}
+
+uint64_t OverlayRenderer::GetProcessingShape(ID3D11Texture2D* capturedFrame) const
+{
+    // FNV-1a over everything that changes frame sizes or which stages run
+    uint64_t shape = 0xCBF29CE484222325ull;
+    auto mix = [&shape](uint64_t value)
+    {
+        shape = (shape ^ value) * 0x100000001B3ull;
+    };
+
+    if (capturedFrame)
+    {
+        D3D11_TEXTURE2D_DESC desc;
+        capturedFrame->GetDesc(&desc);
+        mix(desc.Width);
+        mix(desc.Height);
+        mix(desc.Format);
+    }
+    mix(m_width);
+    mix(m_height);
+    mix(m_upscaleEnabled);
+    mix(static_cast<uint64_t>(m_upscaleMethod));
+    mix(static_cast<uint64_t>(m_upscaleFactor * 1000.0f));
+    mix(static_cast<uint64_t>(m_sharpenMode));
+    mix(m_letterboxEnabled);
+    mix(m_frameAnalysisEnabled);
+    if (m_letterboxEnabled && m_letterboxDetector)
+    {
+        const ActiveRect& active = m_letterboxDetector->GetActiveRect();
+        mix((static_cast<uint64_t>(active.left) << 32) | active.top);
+        mix((static_cast<uint64_t>(active.right) << 32) | active.bottom);
+    }
+    return shape;
+}
+
+void OverlayRenderer::RenderCapturedFrame(ID3D11Texture2D* capturedFrame, bool newFrame, double presentTime)
 {
     if (!m_backBuffer) return;
     
@@ -164,16 +300,59 @@ void OverlayRenderer::RenderFrame(ID3D11Texture2D* capturedFrame)
         return;
     }
     
+    if (newFrame && m_replayFramesLeft > 0)
+    {
+        RecordReplayFrame(capturedFrame);
+    }
+    
     // Get captured frame dimensions
     D3D11_TEXTURE2D_DESC srcDesc;
     capturedFrame->GetDesc(&srcDesc);
     
+    if (!EnsureBackBufferFormat(srcDesc.Format) || !m_backBuffer)
+    {
+        return;
+    }
+    
     // Get back buffer dimensions  
     D3D11_TEXTURE2D_DESC dstDesc;
     m_backBuffer->GetDesc(&dstDesc);
     
+    // CPU analysis of new frames; the letterbox scan and the luma pyramid share one readback.
+    // Both work on BGRA8, HDR captures keep the last rect and pyramid
+    if (newFrame && m_readback && srcDesc.Format == DXGI_FORMAT_B8G8R8A8_UNORM)
+    {
+        bool scanLetterbox = m_letterboxEnabled && m_letterboxDetector &&
+                             ++m_framesSinceLetterboxScan >= LETTERBOX_SCAN_INTERVAL;
+        bool buildPyramid = m_frameAnalysisEnabled && m_frameAnalysis;
+        if (scanLetterbox)
+        {
+            m_framesSinceLetterboxScan = 0;
+        }
+        if (scanLetterbox || buildPyramid)
+        {
+            AnalyzeFrame(capturedFrame, scanLetterbox, buildPyramid, presentTime);
+        }
+    }
+    
+    // Letterbox cropping: only the active picture area is scaled and centered
+    if (m_letterboxEnabled && m_letterboxDetector && m_readback)
+    {
+        D3D11_RECT contentRect = { 0, 0, (LONG)srcDesc.Width, (LONG)srcDesc.Height };
+        const ActiveRect& active = m_letterboxDetector->GetActiveRect();
+        if (active.Width() > 0 && active.Height() > 0 && active.right <= srcDesc.Width && active.bottom <= srcDesc.Height)
+        {
+            contentRect = { (LONG)active.left, (LONG)active.top, (LONG)active.right, (LONG)active.bottom };
+        }
+        
+        RenderContentRect(capturedFrame, contentRect, dstDesc);
+        return;
+    }
+    
     // Determine the source texture to copy (either upscaled or original)
     ID3D11Texture2D* sourceTexture = capturedFrame;
+    uint32_t copyWidth = srcDesc.Width;
+    uint32_t copyHeight = srcDesc.Height;
     
     // Apply upscaling only if enabled AND factor > 1
     if (m_upscaleEnabled && m_upscaler && m_upscaleFactor > 1.01f)
@@ -196,16 +375,30 @@ void OverlayRenderer::RenderFrame(ID3D11Texture2D* capturedFrame)
                 m_upscaleMethod
             );
             
-            if (upscaledTexture)
+            if (upscaledTexture && upscaledTexture != capturedFrame)
             {
+                // The output texture is allocated at the back buffer size, only part may be used
                 sourceTexture = upscaledTexture;
                 sourceTexture->GetDesc(&srcDesc);
+                copyWidth = upscaledWidth;
+                copyHeight = upscaledHeight;
             }
         }
     }
     
+    // Native resolution: sharpen while copying into the back buffer
+    if (sourceTexture == capturedFrame && m_sharpenMode != SharpenMode::Off && m_upscaler)
+    {
+        D3D11_RECT sharpenRect = { 0, 0, (LONG)min(srcDesc.Width, dstDesc.Width), (LONG)min(srcDesc.Height, dstDesc.Height) };
+        if (m_upscaler->Sharpen(capturedFrame, sharpenRect, m_backBuffer.Get(), m_backBufferUAV.Get(), 0, 0, m_sharpenMode))
+        {
+            return;
+        }
+    }
+    
     // Copy the source texture to back buffer
-    if (srcDesc.Width == dstDesc.Width && srcDesc.Height == dstDesc.Height)
+    if (srcDesc.Width == dstDesc.Width && srcDesc.Height == dstDesc.Height &&
+        copyWidth == dstDesc.Width && copyHeight == dstDesc.Height)
     {
         // Sizes match - direct copy (fastest path)
         m_context->CopyResource(m_backBuffer.Get(), sourceTexture);
@@ -217,8 +410,8 @@ void OverlayRenderer::RenderFrame(ID3D11Texture2D* capturedFrame)
         srcBox.left = 0;
         srcBox.top = 0;
         srcBox.front = 0;
-        srcBox.right = min(srcDesc.Width, dstDesc.Width);
-        srcBox.bottom = min(srcDesc.Height, dstDesc.Height);
+        srcBox.right = min(copyWidth, dstDesc.Width);
+        srcBox.bottom = min(copyHeight, dstDesc.Height);
         srcBox.back = 1;
         
         m_context->CopySubresourceRegion(
@@ -231,6 +424,148 @@ void OverlayRenderer::RenderFrame(ID3D11Texture2D* capturedFrame)
     // Note: No Flush() here - Present() will synchronize
 }
 
+void OverlayRenderer::AnalyzeFrame(ID3D11Texture2D* capturedFrame, bool scanLetterbox, bool buildPyramid, double presentTime)
+{
+    ImageView frame;
+    if (!m_readback->Map(capturedFrame, frame))
+    {
+        return;
+    }
+    
+    if (scanLetterbox && m_letterboxDetector->Update(frame))
+    {
+        const ActiveRect& active = m_letterboxDetector->GetActiveRect();
+        Logger::Info("Letterbox: active picture %ux%u at (%u,%u)",
+            active.Width(), active.Height(), active.left, active.top);
+    }
+    
+    if (buildPyramid)
+    {
+        // Repeated captures of the same game frame are dropped here; new frames keep the time
+        // their image was presented, not when the readback finished
+        m_frameAnalysis->Update(frame, presentTime);
+    }
+    
+    m_readback->Unmap();
+}
+
+void OverlayRenderer::RecordReplayFrame(ID3D11Texture2D* capturedFrame)
+{
+    if (!m_readback)
+    {
+        StopReplayRecording();
+        return;
+    }
+    
+    // Replays are stored as BGRA8
+    D3D11_TEXTURE2D_DESC desc;
+    capturedFrame->GetDesc(&desc);
+    if (desc.Format != DXGI_FORMAT_B8G8R8A8_UNORM)
+    {
+        Logger::Warning("Replay recording needs a BGRA8 capture, turn off HDR capture");
+        StopReplayRecording();
+        return;
+    }
+    
+    ImageView frame;
+    if (!m_readback->Map(capturedFrame, frame))
+    {
+        StopReplayRecording();
+        return;
+    }
+    
+    if (!m_replayWriter)
+    {
+        m_replayWriter = std::make_unique<ReplayWriter>();
+        if (!m_replayWriter->Open(m_replayPath, frame.width, frame.height))
+        {
+            m_readback->Unmap();
+            StopReplayRecording();
+            return;
+        }
+        m_replayStart = std::chrono::steady_clock::now();
+    }
+    
+    uint64_t timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - m_replayStart).count();
+    bool written = m_replayWriter->WriteFrame(frame, timestampUs);
+    m_readback->Unmap();
+    
+    // A resolution change mid-recording ends the replay
+    if (!written || --m_replayFramesLeft == 0)
+    {
+        StopReplayRecording();
+    }
+}
+
+void OverlayRenderer::RenderContentRect(ID3D11Texture2D* capturedFrame, const D3D11_RECT& contentRect, const D3D11_TEXTURE2D_DESC& dstDesc)
+{
+    uint32_t contentWidth = contentRect.right - contentRect.left;
+    uint32_t contentHeight = contentRect.bottom - contentRect.top;
+    
+    // Scale by the upscale factor, but never past what fits in the back buffer (keeps aspect ratio)
+    float scale = 1.0f;
+    if (m_upscaleEnabled && m_upscaler && m_upscaleFactor > 1.01f)
+    {
+        float fit = min((float)dstDesc.Width / contentWidth, (float)dstDesc.Height / contentHeight);
+        scale = min(m_upscaleFactor, fit);
+    }
+    
+    ID3D11Texture2D* sourceTexture = capturedFrame;
+    D3D11_BOX srcBox = { (UINT)contentRect.left, (UINT)contentRect.top, 0, (UINT)contentRect.right, (UINT)contentRect.bottom, 1 };
+    
+    if (scale > 1.01f)
+    {
+        uint32_t scaledWidth = static_cast<uint32_t>(contentWidth * scale);
+        uint32_t scaledHeight = static_cast<uint32_t>(contentHeight * scale);
+        
+        ID3D11Texture2D* upscaledTexture = m_upscaler->Upscale(
+            capturedFrame,
+            scaledWidth,
+            scaledHeight,
+            m_upscaleMethod,
+            &contentRect
+        );
+        
+        if (upscaledTexture && upscaledTexture != capturedFrame)
+        {
+            sourceTexture = upscaledTexture;
+            srcBox = { 0, 0, 0, scaledWidth, scaledHeight, 1 };
+        }
+    }
+    
+    // Center in the back buffer, cropping if the picture is still larger
+    uint32_t copyWidth = min(srcBox.right - srcBox.left, dstDesc.Width);
+    uint32_t copyHeight = min(srcBox.bottom - srcBox.top, dstDesc.Height);
+    srcBox.right = srcBox.left + copyWidth;
+    srcBox.bottom = srcBox.top + copyHeight;
+    uint32_t dstX = (dstDesc.Width - copyWidth) / 2;
+    uint32_t dstY = (dstDesc.Height - copyHeight) / 2;
+    
+    // Flip-model back buffers are undefined after present, so the bars need a clear
+    if ((copyWidth < dstDesc.Width || copyHeight < dstDesc.Height) && m_renderTargetView)
+    {
+        float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        m_context->ClearRenderTargetView(m_renderTargetView.Get(), clearColor);
+    }
+    
+    if (sourceTexture == capturedFrame && m_sharpenMode != SharpenMode::Off && m_upscaler)
+    {
+        D3D11_RECT sharpenRect = { (LONG)srcBox.left, (LONG)srcBox.top, (LONG)srcBox.right, (LONG)srcBox.bottom };
+        if (m_upscaler->Sharpen(capturedFrame, sharpenRect, m_backBuffer.Get(), m_backBufferUAV.Get(), dstX, dstY, m_sharpenMode))
+        {
+            return;
+        }
+    }
+    
+    m_context->CopySubresourceRegion(
+        m_backBuffer.Get(), 0,
+        dstX, dstY, 0,
+        sourceTexture, 0,
+        &srcBox
+    );
+}
+
 void OverlayRenderer::Present(bool vsync)
 {
     if (m_swapChain)
@@ -254,6 +589,10 @@ void OverlayRenderer::Resize(uint32_t width, uint32_t height)
     
     m_width = width;
     m_height = height;
+    if (m_upscaler)
+    {
+        m_upscaler->SetMaxOutputSize(width, height);
+    }
     
     ReleaseRenderTarget();
     
@@ -270,6 +609,11 @@ void OverlayRenderer::Resize(uint32_t width, uint32_t height)
     }
 }
 
+uint64_t OverlayRenderer::GetResourceCreations() const
+{
+    return m_resourceCreations + (m_upscaler ? m_upscaler->GetResourceCreations() : 0);
+}
+
 void OverlayRenderer::SetSharpness(float sharpness)
 {
     if (m_upscaler)
@@ -286,3 +630,73 @@ float OverlayRenderer::GetSharpness() const
     }
     return 0.5f;
 }
+
+void OverlayRenderer::SetLinearLightEnabled(bool enabled)
+{
+    if (m_upscaler)
+    {
+        m_upscaler->SetLinearLight(enabled);
+    }
+}
+
+bool OverlayRenderer::IsLinearLightEnabled() const
+{
+    return m_upscaler && m_upscaler->IsLinearLight();
+}
+
+void OverlayRenderer::SetLetterboxCropEnabled(bool enabled)
+{
+    if (enabled && !m_letterboxEnabled && m_letterboxDetector)
+    {
+        // Start from the full frame and scan on the next captured frame
+        m_letterboxDetector->Reset();
+        m_framesSinceLetterboxScan = LETTERBOX_SCAN_INTERVAL;
+    }
+    m_letterboxEnabled = enabled;
+}
+
+void OverlayRenderer::SetFrameAnalysisEnabled(bool enabled)
+{
+    if (!enabled && m_frameAnalysis)
+    {
+        // A later restart mustn't compare against a stale previous frame
+        m_frameAnalysis->Reset();
+    }
+    m_frameAnalysisEnabled = enabled;
+}
+
+FrameAnalysisStats OverlayRenderer::GetFrameAnalysisStats() const
+{
+    if (m_frameAnalysis)
+    {
+        return m_frameAnalysis->GetStats();
+    }
+    return FrameAnalysisStats{};
+}
+
+void OverlayRenderer::StartReplayRecording(const std::string& path, uint32_t frameCount)
+{
+    StopReplayRecording();
+    m_replayPath = path;
+    m_replayFramesLeft = frameCount;
+    Logger::Info("Recording %u frames to %s", frameCount, path.c_str());
+}
+
+void OverlayRenderer::StopReplayRecording()
+{
+    m_replayFramesLeft = 0;
+    if (m_replayWriter)
+    {
+        m_replayWriter->Close();
+        m_replayWriter.reset();
+    }
+}
+
+LetterboxStats OverlayRenderer::GetLetterboxStats() const
+{
+    if (m_letterboxDetector)
+    {
+        return m_letterboxDetector->GetStats();
+    }
+    return LetterboxStats{};
+}
@@ -3,9 +3,15 @@
 #include <d3d12.h>
 #include <dxgi1_4.h>
 #include <wrl/client.h>
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include "../Processing/AnalysisPyramid.h"
 #include "../Processing/D3D11Upscaler.h"
+#include "../Processing/LetterboxDetector.h"
+#include "../Capture/FrameReadback.h"
+#include "../Benchmark/ReplayFile.h"
 
 using Microsoft::WRL::ComPtr;
 
@@ -22,7 +28,9 @@ public:
 
     // Render a captured frame to the overlay window
     // If upscaling is enabled, the frame will be upscaled to the output size
-    void RenderFrame(ID3D11Texture2D* capturedFrame);
+    // newFrame is false when the same capture is shown again (skips per-frame analysis)
+    // presentTime is when the captured image was presented (seconds, performance counter)
+    void RenderFrame(ID3D11Texture2D* capturedFrame, bool newFrame = true, double presentTime = 0.0);
     
     // Present the frame
     void Present(bool vsync = false);
@@ -43,10 +51,43 @@ public:
     void SetSharpness(float sharpness);
     float GetSharpness() const;
 
+    // CAS sharpening of frames shown at native resolution (no upscale)
+    void SetSharpenMode(SharpenMode mode) { m_sharpenMode = mode; }
+    SharpenMode GetSharpenMode() const { return m_sharpenMode; }
+
+    // Resample in linear light rather than on sRGB-encoded values
+    void SetLinearLightEnabled(bool enabled);
+    bool IsLinearLightEnabled() const;
+
+    // Letterbox/pillarbox cropping - black bars are detected and only the picture is scaled
+    void SetLetterboxCropEnabled(bool enabled);
+    bool IsLetterboxCropEnabled() const { return m_letterboxEnabled; }
+    LetterboxStats GetLetterboxStats() const;
+
+    // Luma pyramid of every new frame (and the previous one) for the analysis stages
+    void SetFrameAnalysisEnabled(bool enabled);
+    bool IsFrameAnalysisEnabled() const { return m_frameAnalysisEnabled; }
+    const FrameAnalysis* GetFrameAnalysis() const { return m_frameAnalysis.get(); }
+    FrameAnalysisStats GetFrameAnalysisStats() const;
+
+    // Record the next frameCount captured frames to a replay file for --benchmark
+    void StartReplayRecording(const std::string& path, uint32_t frameCount);
+    void StopReplayRecording();
+    bool IsRecordingReplay() const { return m_replayFramesLeft > 0; }
+
+    // GPU textures and views created since start (render targets and upscaler surfaces)
+    uint64_t GetResourceCreations() const;
+
 private:
     bool CreateSwapChain(HWND hwnd);
     bool CreateRenderTarget();
     void ReleaseRenderTarget();
+    bool EnsureBackBufferFormat(DXGI_FORMAT captureFormat);
+    void AnalyzeFrame(ID3D11Texture2D* capturedFrame, bool scanLetterbox, bool buildPyramid, double presentTime);
+    void RecordReplayFrame(ID3D11Texture2D* capturedFrame);
+    void RenderCapturedFrame(ID3D11Texture2D* capturedFrame, bool newFrame, double presentTime);
+    uint64_t GetProcessingShape(ID3D11Texture2D* capturedFrame) const;
+    void RenderContentRect(ID3D11Texture2D* capturedFrame, const D3D11_RECT& contentRect, const D3D11_TEXTURE2D_DESC& dstDesc);
 
 private:
     ID3D11Device* m_device = nullptr;  // Shared with capture
@@ -55,14 +96,37 @@ private:
     ComPtr<IDXGISwapChain1> m_swapChain;
     ComPtr<ID3D11RenderTargetView> m_renderTargetView;
     ComPtr<ID3D11Texture2D> m_backBuffer;
+    ComPtr<ID3D11UnorderedAccessView> m_backBufferUAV;  // Null if the driver refuses UAV back buffers
+    DXGI_FORMAT m_backBufferFormat = DXGI_FORMAT_B8G8R8A8_UNORM;  // Follows the capture format (HDR)
     
     // Upscaler
     std::unique_ptr<D3D11Upscaler> m_upscaler;
     bool m_upscaleEnabled = false;
     UpscaleMethod m_upscaleMethod = UpscaleMethod::FSR;
     float m_upscaleFactor = 1.5f;
+    SharpenMode m_sharpenMode = SharpenMode::Off;
+    
+    // Letterbox detection (runs on a CPU readback every few captured frames)
+    std::unique_ptr<LetterboxDetector> m_letterboxDetector;
+    std::unique_ptr<FrameReadback> m_readback;
+    bool m_letterboxEnabled = false;
+    uint32_t m_framesSinceLetterboxScan = 0;
+    
+    // Analysis pyramids, built on the same readback as the letterbox scan
+    std::unique_ptr<FrameAnalysis> m_frameAnalysis;
+    bool m_frameAnalysisEnabled = false;
+    
+    // Index of the next frame for the scratch arena
+    uint64_t m_frameIndex = 0;
+    
+    // Replay recording (the file is opened on the first frame, once the size is known)
+    std::unique_ptr<ReplayWriter> m_replayWriter;
+    std::string m_replayPath;
+    uint32_t m_replayFramesLeft = 0;
+    std::chrono::steady_clock::time_point m_replayStart;
     
     uint32_t m_width = 0;
     uint32_t m_height = 0;
     bool m_tearingSupported = false;
+    uint64_t m_resourceCreations = 0;  // Render target views
 };
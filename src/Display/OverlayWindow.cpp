@@ -171,6 +171,7 @@ bool OverlayWindow::StartOverlay(DesktopDuplication* capture)
     }
     
     m_renderer = std::make_unique<OverlayRenderer>();
+    m_lastResourceCreations = 0;
     
     if (!m_renderer->Initialize(m_overlayHwnd, captureDevice, captureContext))
     {
@@ -183,6 +184,10 @@ bool OverlayWindow::StartOverlay(DesktopDuplication* capture)
     m_renderer->SetUpscaleMethod(m_upscaleMethod);
     m_renderer->SetUpscaleFactor(m_upscaleFactor);
     m_renderer->SetSharpness(m_sharpness);
+    m_renderer->SetSharpenMode(m_sharpenMode);
+    m_renderer->SetLinearLightEnabled(m_linearLightEnabled);
+    m_renderer->SetLetterboxCropEnabled(m_letterboxCropEnabled);
+    m_renderer->SetFrameAnalysisEnabled(m_frameAnalysisEnabled);
     
     // Show the overlay window
     ShowWindow(m_overlayHwnd, SW_SHOWNOACTIVATE);
@@ -318,7 +323,7 @@ void OverlayWindow::ProcessFrame()
     }
     
     // Always render and present (even if no new frame, to avoid ghosting)
-    m_renderer->RenderFrame(capturedFrame);
+    m_renderer->RenderFrame(capturedFrame, hasNewFrame, m_capture->GetPresentTime());
     m_renderer->Present(false);  // No vsync for lowest latency
     
     // Calculate FPS
@@ -334,6 +339,12 @@ void OverlayWindow::ProcessFrame()
     if (m_fpsAccumulator >= 0.5f)
     {
         m_overlayFPS = m_fpsFrameCount / m_fpsAccumulator;
+        
+        // Should stay at zero while settings are changed live
+        uint64_t creations = m_renderer->GetResourceCreations();
+        m_resourceCreationRate = (creations - m_lastResourceCreations) / m_fpsAccumulator;
+        m_lastResourceCreations = creations;
+        
         m_fpsAccumulator = 0.0f;
         m_fpsFrameCount = 0;
     }
@@ -440,3 +451,90 @@ float OverlayWindow::GetSharpness() const
 {
     return m_sharpness;
 }
+
+void OverlayWindow::SetSharpenMode(SharpenMode mode)
+{
+    m_sharpenMode = mode;
+    if (m_renderer)
+    {
+        m_renderer->SetSharpenMode(mode);
+    }
+}
+
+SharpenMode OverlayWindow::GetSharpenMode() const
+{
+    return m_sharpenMode;
+}
+
+void OverlayWindow::SetLinearLightEnabled(bool enabled)
+{
+    m_linearLightEnabled = enabled;
+    if (m_renderer)
+    {
+        m_renderer->SetLinearLightEnabled(enabled);
+    }
+}
+
+bool OverlayWindow::IsLinearLightEnabled() const
+{
+    return m_linearLightEnabled;
+}
+
+void OverlayWindow::SetLetterboxCropEnabled(bool enabled)
+{
+    m_letterboxCropEnabled = enabled;
+    if (m_renderer)
+    {
+        m_renderer->SetLetterboxCropEnabled(enabled);
+    }
+}
+
+bool OverlayWindow::IsLetterboxCropEnabled() const
+{
+    return m_letterboxCropEnabled;
+}
+
+LetterboxStats OverlayWindow::GetLetterboxStats() const
+{
+    if (m_renderer)
+    {
+        return m_renderer->GetLetterboxStats();
+    }
+    return LetterboxStats{};
+}
+
+void OverlayWindow::SetFrameAnalysisEnabled(bool enabled)
+{
+    m_frameAnalysisEnabled = enabled;
+    if (m_renderer)
+    {
+        m_renderer->SetFrameAnalysisEnabled(enabled);
+    }
+}
+
+bool OverlayWindow::IsFrameAnalysisEnabled() const
+{
+    return m_frameAnalysisEnabled;
+}
+
+FrameAnalysisStats OverlayWindow::GetFrameAnalysisStats() const
+{
+    if (m_renderer)
+    {
+        return m_renderer->GetFrameAnalysisStats();
+    }
+    return FrameAnalysisStats{};
+}
+
+void OverlayWindow::StartReplayRecording(const std::string& path, uint32_t frameCount)
+{
+    if (m_renderer)
+    {
+        m_renderer->StartReplayRecording(path, frameCount);
+    }
+}
+
+bool OverlayWindow::IsRecordingReplay() const
+{
+    return m_renderer && m_renderer->IsRecordingReplay();
+}
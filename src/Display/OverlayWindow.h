@@ -37,6 +37,7 @@ public:
     // Get stats
     uint32_t GetFramesCaptured() const { return m_framesCaptured; }
     float GetOverlayFPS() const { return m_overlayFPS; }
+    float GetResourceCreationRate() const { return m_resourceCreationRate; }  // Per second
     
     // Upscaling controls - forwarded to OverlayRenderer
     void SetUpscalingEnabled(bool enabled);
@@ -50,6 +51,23 @@ public:
     
     void SetSharpness(float sharpness);
     float GetSharpness() const;
+    
+    void SetSharpenMode(SharpenMode mode);
+    SharpenMode GetSharpenMode() const;
+    
+    void SetLinearLightEnabled(bool enabled);
+    bool IsLinearLightEnabled() const;
+    
+    void SetLetterboxCropEnabled(bool enabled);
+    bool IsLetterboxCropEnabled() const;
+    LetterboxStats GetLetterboxStats() const;
+    
+    void SetFrameAnalysisEnabled(bool enabled);
+    bool IsFrameAnalysisEnabled() const;
+    FrameAnalysisStats GetFrameAnalysisStats() const;
+    
+    void StartReplayRecording(const std::string& path, uint32_t frameCount);
+    bool IsRecordingReplay() const;
 
 private:
     static LRESULT CALLBACK OverlayWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -71,6 +89,10 @@ private:
     UpscaleMethod m_upscaleMethod = UpscaleMethod::FSR;
     float m_upscaleFactor = 1.5f;
     float m_sharpness = 0.5f;
+    SharpenMode m_sharpenMode = SharpenMode::Off;
+    bool m_linearLightEnabled = false;
+    bool m_letterboxCropEnabled = false;
+    bool m_frameAnalysisEnabled = false;
     
     // FPS tracking
     LARGE_INTEGER m_lastFrameTime = {};
@@ -78,6 +100,8 @@ private:
     float m_overlayFPS = 0.0f;
     float m_fpsAccumulator = 0.0f;
     int m_fpsFrameCount = 0;
+    float m_resourceCreationRate = 0.0f;
+    uint64_t m_lastResourceCreations = 0;
     
     // Target window info
     RECT m_targetRect = {};
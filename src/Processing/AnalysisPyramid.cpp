@@ -0,0 +1,180 @@
+#include "AnalysisPyramid.h"
+#include "PixelConvert.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <chrono>
+
+namespace
+{
+    const size_t ROW_ALIGNMENT = 64;
+
+    size_t AlignPitch(uint32_t width)
+    {
+        return (width + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+    }
+
+    // Levels are views into the pyramid's own storage
+    uint8_t* MutableRow(const LumaView& level, uint32_t y)
+    {
+        return const_cast<uint8_t*>(level.Row(y));
+    }
+}
+
+void DownsampleLumaRow(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dstWidth)
+{
+    // Even and odd pixels of both rows summed in 16-bit lanes, 32 source pixels per step
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i two = _mm_set1_epi16(2);
+    uint32_t x = 0;
+    for (; x + 16 <= dstWidth; x += 16)
+    {
+        __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2));
+        __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 2 + 16));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 2 + 16));
+
+        __m128i sum0 = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a0, lowBytes), _mm_srli_epi16(a0, 8)),
+                                     _mm_add_epi16(_mm_and_si128(b0, lowBytes), _mm_srli_epi16(b0, 8)));
+        __m128i sum1 = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a1, lowBytes), _mm_srli_epi16(a1, 8)),
+                                     _mm_add_epi16(_mm_and_si128(b1, lowBytes), _mm_srli_epi16(b1, 8)));
+        sum0 = _mm_srli_epi16(_mm_add_epi16(sum0, two), 2);
+        sum1 = _mm_srli_epi16(_mm_add_epi16(sum1, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(sum0, sum1));
+    }
+    for (; x < dstWidth; x++)
+    {
+        dst[x] = static_cast<uint8_t>((row0[x * 2] + row0[x * 2 + 1] + row1[x * 2] + row1[x * 2 + 1] + 2) >> 2);
+    }
+}
+
+bool LumaPyramid::Matches(const LumaPyramid& other) const
+{
+    return m_levelCount == other.m_levelCount && GetWidth() == other.GetWidth() && GetHeight() == other.GetHeight();
+}
+
+void LumaPyramid::Build(const ImageView& frame, uint32_t maxLevels)
+{
+    if (frame.width == 0 || frame.height == 0 || maxLevels == 0)
+    {
+        m_levelCount = 0;
+        return;
+    }
+
+    // Level sizes and storage
+    uint32_t widths[MAX_LEVELS];
+    uint32_t heights[MAX_LEVELS];
+    size_t offsets[MAX_LEVELS];
+    size_t size = 0;
+    uint32_t count = 0;
+    uint32_t width = frame.width;
+    uint32_t height = frame.height;
+    const uint32_t levelLimit = maxLevels < MAX_LEVELS ? maxLevels : MAX_LEVELS;
+    while (count < levelLimit)
+    {
+        widths[count] = width;
+        heights[count] = height;
+        offsets[count] = size;
+        size += AlignPitch(width) * height;
+        count++;
+        width /= 2;
+        height /= 2;
+        if (width < MIN_LEVEL_SIZE || height < MIN_LEVEL_SIZE)
+        {
+            break;
+        }
+    }
+
+    if (m_storage.size() < size + ROW_ALIGNMENT)
+    {
+        m_storage.resize(size + ROW_ALIGNMENT);
+    }
+    size_t misalignment = reinterpret_cast<uintptr_t>(m_storage.data()) % ROW_ALIGNMENT;
+    uint8_t* base = m_storage.data() + (misalignment ? ROW_ALIGNMENT - misalignment : 0);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        m_levels[i] = LumaView{ base + offsets[i], widths[i], heights[i], AlignPitch(widths[i]) };
+    }
+    m_levelCount = count;
+
+    ThreadPool& pool = ThreadPool::Shared();
+    const LumaView& full = m_levels[0];
+    if (count == 1)
+    {
+        pool.ParallelFor(full.height, pool.SuggestGrain(full.height), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t y = begin; y < end; y++)
+            {
+                BgraToLumaRow(frame.Row(y), MutableRow(full, y), full.width);
+            }
+        });
+        return;
+    }
+
+    // Level 1 is made while its two source rows are still in cache
+    const LumaView& half = m_levels[1];
+    pool.ParallelFor(half.height, pool.SuggestGrain(half.height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            BgraToLumaRow(frame.Row(y * 2), MutableRow(full, y * 2), full.width);
+            BgraToLumaRow(frame.Row(y * 2 + 1), MutableRow(full, y * 2 + 1), full.width);
+            DownsampleLumaRow(full.Row(y * 2), full.Row(y * 2 + 1), MutableRow(half, y), half.width);
+        }
+    });
+    if (full.height % 2)
+    {
+        BgraToLumaRow(frame.Row(full.height - 1), MutableRow(full, full.height - 1), full.width);
+    }
+
+    for (uint32_t i = 2; i < count; i++)
+    {
+        const LumaView& src = m_levels[i - 1];
+        const LumaView& dst = m_levels[i];
+        pool.ParallelFor(dst.height, pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t y = begin; y < end; y++)
+            {
+                DownsampleLumaRow(src.Row(y * 2), src.Row(y * 2 + 1), MutableRow(dst, y), dst.width);
+            }
+        });
+    }
+}
+
+bool FrameAnalysis::Update(const ImageView& frame, double timestamp)
+{
+    if (m_dropDuplicates)
+    {
+        const bool isNew = m_duplicates.Update(frame, timestamp);
+        const DuplicateFrameStats& duplicates = m_duplicates.GetStats();
+        m_stats.duplicateCheckMs = duplicates.checkMsAverage;
+        m_stats.frameIntervalMs = static_cast<float>(duplicates.frameInterval * 1000.0);
+        if (!isNew)
+        {
+            m_stats.duplicates++;
+            return false;
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // The older pyramid is overwritten, the current one becomes the previous frame
+    m_current ^= 1;
+    m_pyramids[m_current].Build(frame);
+    m_times[m_current] = timestamp;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    float elapsedMs = std::chrono::duration<float, std::milli>(end - start).count();
+
+    m_stats.buildMs = elapsedMs;
+    m_stats.buildMsAverage = (m_stats.frames == 0) ? elapsedMs : m_stats.buildMsAverage * 0.9f + elapsedMs * 0.1f;
+    m_stats.levels = m_pyramids[m_current].GetLevelCount();
+    m_stats.frames++;
+    return true;
+}
+
+void FrameAnalysis::Reset()
+{
+    m_pyramids[0].Clear();
+    m_pyramids[1].Clear();
+    m_duplicates.Reset();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "DuplicateFrameDetector.h"
+#include "ImageView.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Grayscale versions of a captured frame for the analysis stages (motion estimation, scene
+// change and duplicate detection), built once per frame so no stage converts BGRA itself
+// Level 0 is full resolution luma (PixelLuma() weights), each further level is a 2x2 box average
+// of the one before, rounded, with an odd last column/row dropped. Levels stop before a side
+// would fall below MIN_LEVEL_SIZE. Every row starts on a 64-byte boundary.
+class LumaPyramid
+{
+public:
+    static const uint32_t MAX_LEVELS = 6;
+    static const uint32_t MIN_LEVEL_SIZE = 16;
+
+    LumaPyramid() = default;
+    LumaPyramid(const LumaPyramid&) = delete;
+    LumaPyramid& operator=(const LumaPyramid&) = delete;
+    LumaPyramid(LumaPyramid&&) = default;
+    LumaPyramid& operator=(LumaPyramid&&) = default;
+
+    // Storage is reused while the frame size stays the same
+    void Build(const ImageView& frame, uint32_t maxLevels = MAX_LEVELS);
+    void Clear() { m_levelCount = 0; }
+
+    bool IsEmpty() const { return m_levelCount == 0; }
+    uint32_t GetLevelCount() const { return m_levelCount; }
+    const LumaView& GetLevel(uint32_t level) const { return m_levels[level]; }
+    uint32_t GetWidth() const { return m_levels[0].width; }
+    uint32_t GetHeight() const { return m_levels[0].height; }
+
+    // Same frame size and level count, so levels can be compared one to one
+    bool Matches(const LumaPyramid& other) const;
+
+private:
+    std::vector<uint8_t> m_storage;  // All levels, over-allocated by a line for alignment
+    LumaView m_levels[MAX_LEVELS];
+    uint32_t m_levelCount = 0;
+};
+
+struct FrameAnalysisStats
+{
+    float buildMs = 0.0f;         // Cost of the last pyramid
+    float buildMsAverage = 0.0f;  // Smoothed
+    uint32_t levels = 0;
+    uint64_t frames = 0;
+    uint64_t duplicates = 0;      // Captures dropped as repeats of the current frame
+    float duplicateCheckMs = 0.0f;  // Smoothed cost of the duplicate check
+    float frameIntervalMs = 0.0f;   // Smoothed time between the frames kept
+};
+
+// Per-frame analysis stage: the pyramid of the newest frame and the one before it, for stages
+// that compare consecutive frames. Update() reuses the older pyramid's storage, so a steady
+// stream of frames doesn't allocate.
+// Captures that only repeat the current frame (a game below the desktop refresh rate) are
+// dropped before the pyramid is built, so the two pyramids are always two different game frames
+// and their present times give the game's own frame interval.
+class FrameAnalysis
+{
+public:
+    // timestamp is when the frame was presented, in seconds on any steady clock; returns false
+    // for a dropped duplicate, which leaves both pyramids as they were
+    bool Update(const ImageView& frame, double timestamp = 0.0);
+    void Reset();
+
+    // Drop repeated captures (on by default)
+    void SetDropDuplicates(bool enabled) { m_dropDuplicates = enabled; }
+    bool GetDropDuplicates() const { return m_dropDuplicates; }
+    const DuplicateFrameDetector& GetDuplicateDetector() const { return m_duplicates; }
+
+    const LumaPyramid& GetCurrent() const { return m_pyramids[m_current]; }
+    const LumaPyramid& GetPrevious() const { return m_pyramids[m_current ^ 1]; }
+
+    // Present times of the current and previous pyramid's frames
+    double GetCurrentTime() const { return m_times[m_current]; }
+    double GetPreviousTime() const { return m_times[m_current ^ 1]; }
+
+    // A previous frame exists and has the current frame's size
+    bool HasPrevious() const { return !GetPrevious().IsEmpty() && GetPrevious().Matches(GetCurrent()); }
+
+    const FrameAnalysisStats& GetStats() const { return m_stats; }
+
+private:
+    LumaPyramid m_pyramids[2];
+    double m_times[2] = { 0.0, 0.0 };
+    uint32_t m_current = 0;
+    DuplicateFrameDetector m_duplicates;
+    bool m_dropDuplicates = true;
+    FrameAnalysisStats m_stats;
+};
+
+// 2x2 box average of two source rows into dstWidth pixels (SSE2); exposed for the benchmark
+void DownsampleLumaRow(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dstWidth);
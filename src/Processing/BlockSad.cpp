@@ -0,0 +1,227 @@
+#include "BlockSad.h"
+#include "../Utils/CpuFeatures.h"
+#include <immintrin.h>
+#include <cstdlib>
+
+namespace
+{
+    __m128i LoadRow8(const uint8_t* row)
+    {
+        return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row));
+    }
+
+    __m128i LoadRow16(const uint8_t* row)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+    }
+
+    // psadbw leaves two 64-bit partial sums
+    uint32_t SumSad(__m128i sum)
+    {
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+    }
+
+    // --- One candidate ---
+
+    uint32_t BlockSad8Sse2(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch)
+    {
+        __m128i sum = _mm_setzero_si128();
+        for (uint32_t y = 0; y < 8; y += 2)
+        {
+            __m128i c = _mm_unpacklo_epi64(LoadRow8(cur + y * curPitch), LoadRow8(cur + (y + 1) * curPitch));
+            __m128i r = _mm_unpacklo_epi64(LoadRow8(ref + y * refPitch), LoadRow8(ref + (y + 1) * refPitch));
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(c, r));
+        }
+        return SumSad(sum);
+    }
+
+    uint32_t BlockSad16Sse2(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch)
+    {
+        __m128i sum = _mm_setzero_si128();
+        for (uint32_t y = 0; y < 16; y++)
+        {
+            sum = _mm_add_epi64(sum, _mm_sad_epu8(LoadRow16(cur + y * curPitch), LoadRow16(ref + y * refPitch)));
+        }
+        return SumSad(sum);
+    }
+
+    POTATO_TARGET_AVX2 __m256i LoadRows(__m128i low, __m128i high)
+    {
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+    }
+
+    POTATO_TARGET_AVX2 uint32_t SumSadAvx2(__m256i sum)
+    {
+        return SumSad(_mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+    }
+
+    // Four rows per vpsadbw
+    POTATO_TARGET_AVX2 uint32_t BlockSad8Avx2(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch)
+    {
+        __m256i sum = _mm256_setzero_si256();
+        for (uint32_t y = 0; y < 8; y += 4)
+        {
+            __m256i c = LoadRows(
+                _mm_unpacklo_epi64(LoadRow8(cur + y * curPitch), LoadRow8(cur + (y + 1) * curPitch)),
+                _mm_unpacklo_epi64(LoadRow8(cur + (y + 2) * curPitch), LoadRow8(cur + (y + 3) * curPitch)));
+            __m256i r = LoadRows(
+                _mm_unpacklo_epi64(LoadRow8(ref + y * refPitch), LoadRow8(ref + (y + 1) * refPitch)),
+                _mm_unpacklo_epi64(LoadRow8(ref + (y + 2) * refPitch), LoadRow8(ref + (y + 3) * refPitch)));
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(c, r));
+        }
+        return SumSadAvx2(sum);
+    }
+
+    // Two rows per vpsadbw
+    POTATO_TARGET_AVX2 uint32_t BlockSad16Avx2(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch)
+    {
+        __m256i sum = _mm256_setzero_si256();
+        for (uint32_t y = 0; y < 16; y += 2)
+        {
+            __m256i c = LoadRows(LoadRow16(cur + y * curPitch), LoadRow16(cur + (y + 1) * curPitch));
+            __m256i r = LoadRows(LoadRow16(ref + y * refPitch), LoadRow16(ref + (y + 1) * refPitch));
+            sum = _mm256_add_epi64(sum, _mm256_sad_epu8(c, r));
+        }
+        return SumSadAvx2(sum);
+    }
+
+    // --- Eight consecutive candidates ---
+    // mpsadbw(ref, cur, imm) gives, for i = 0..7, the SAD of the 4 cur bytes picked by imm[1:0]
+    // against ref bytes starting at i (+4 if imm[2] is set). Sums stay in 16-bit lanes: a 16x16
+    // block peaks at 65280.
+
+    void StoreSads(__m128i sums, uint32_t* sads)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sads), _mm_unpacklo_epi16(sums, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(sads + 4), _mm_unpackhi_epi16(sums, zero));
+    }
+
+    void BlockSadX8Sse2(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t size, uint32_t* sads)
+    {
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            sads[i] = size == 8 ? BlockSad8Sse2(cur, curPitch, ref + i, refPitch) : BlockSad16Sse2(cur, curPitch, ref + i, refPitch);
+        }
+    }
+
+    POTATO_TARGET_SSE41 void BlockSadX8Sse41(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t size, uint32_t* sads)
+    {
+        __m128i sum = _mm_setzero_si128();
+        for (uint32_t y = 0; y < size; y++)
+        {
+            const uint8_t* c = cur + y * curPitch;
+            const uint8_t* r = ref + y * refPitch;
+            __m128i current = size == 8 ? LoadRow8(c) : LoadRow16(c);
+            __m128i low = LoadRow16(r);
+            sum = _mm_add_epi16(sum, _mm_mpsadbw_epu8(low, current, 0));  // cur 0-3 against ref i..
+            sum = _mm_add_epi16(sum, _mm_mpsadbw_epu8(low, current, 5));  // cur 4-7 against ref 4 + i..
+            if (size == 16)
+            {
+                __m128i high = LoadRow16(r + 8);
+                sum = _mm_add_epi16(sum, _mm_mpsadbw_epu8(high, current, 2));  // cur 8-11 against ref 8 + i..
+                sum = _mm_add_epi16(sum, _mm_mpsadbw_epu8(high, current, 7));  // cur 12-15 against ref 12 + i..
+            }
+        }
+        StoreSads(sum, sads);
+    }
+
+    // vmpsadbw takes a separate selector per 128-bit lane (imm[2:0] low, imm[5:3] high): 8-wide
+    // blocks put two rows side by side, 16-wide blocks the two halves of one row
+    POTATO_TARGET_AVX2 void BlockSadX8Avx2(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t size, uint32_t* sads)
+    {
+        __m256i sum = _mm256_setzero_si256();
+        if (size == 8)
+        {
+            for (uint32_t y = 0; y < 8; y += 2)
+            {
+                __m256i current = LoadRows(LoadRow8(cur + y * curPitch), LoadRow8(cur + (y + 1) * curPitch));
+                __m256i reference = LoadRows(LoadRow16(ref + y * refPitch), LoadRow16(ref + (y + 1) * refPitch));
+                sum = _mm256_add_epi16(sum, _mm256_mpsadbw_epu8(reference, current, 0x00));
+                sum = _mm256_add_epi16(sum, _mm256_mpsadbw_epu8(reference, current, 0x2D));
+            }
+        }
+        else
+        {
+            for (uint32_t y = 0; y < 16; y++)
+            {
+                const uint8_t* r = ref + y * refPitch;
+                __m256i current = _mm256_broadcastsi128_si256(LoadRow16(cur + y * curPitch));
+                __m256i reference = LoadRows(LoadRow16(r), LoadRow16(r + 8));
+                sum = _mm256_add_epi16(sum, _mm256_mpsadbw_epu8(reference, current, 0x10));
+                sum = _mm256_add_epi16(sum, _mm256_mpsadbw_epu8(reference, current, 0x3D));
+            }
+        }
+        StoreSads(_mm_add_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)), sads);
+    }
+}
+
+uint32_t BlockSad(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t size)
+{
+    if (size != 8 && size != 16)
+    {
+        return BlockSadScalar(cur, curPitch, ref, refPitch, size, size);
+    }
+
+    if (GetCpuFeatures().avx2)
+    {
+        return size == 8 ? BlockSad8Avx2(cur, curPitch, ref, refPitch) : BlockSad16Avx2(cur, curPitch, ref, refPitch);
+    }
+    return size == 8 ? BlockSad8Sse2(cur, curPitch, ref, refPitch) : BlockSad16Sse2(cur, curPitch, ref, refPitch);
+}
+
+void BlockSadX8(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t size, uint32_t* sads)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    if (size != 8 && size != 16)
+    {
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            sads[i] = BlockSadScalar(cur, curPitch, ref + i, refPitch, size, size);
+        }
+    }
+    else if (features.avx2)
+    {
+        BlockSadX8Avx2(cur, curPitch, ref, refPitch, size, sads);
+    }
+    else if (features.sse41)
+    {
+        BlockSadX8Sse41(cur, curPitch, ref, refPitch, size, sads);
+    }
+    else
+    {
+        BlockSadX8Sse2(cur, curPitch, ref, refPitch, size, sads);
+    }
+}
+
+uint32_t RowSad(const uint8_t* a, const uint8_t* b, uint32_t width)
+{
+    __m128i sum = _mm_setzero_si128();
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(LoadRow16(a + x), LoadRow16(b + x)));
+    }
+    uint32_t sad = SumSad(sum);
+    for (; x < width; x++)
+    {
+        sad += static_cast<uint32_t>(std::abs(a[x] - b[x]));
+    }
+    return sad;
+}
+
+uint32_t BlockSadScalar(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t width, uint32_t height)
+{
+    uint32_t sad = 0;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* c = cur + y * curPitch;
+        const uint8_t* r = ref + y * refPitch;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            sad += static_cast<uint32_t>(std::abs(c[x] - r[x]));
+        }
+    }
+    return sad;
+}
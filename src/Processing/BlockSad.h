@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Sum of absolute differences of 8-bit luma blocks, the matching cost of the CPU motion search
+// BlockSad() scores one candidate (psadbw, vpsadbw two rows at a time); BlockSadX8() scores the
+// eight candidates ref, ref + 1, ..., ref + 7 of one row of offsets together (mpsadbw on SSE4.1,
+// vmpsadbw on AVX2), sharing the loads of the current block. Sizes other than 8 and 16 use
+// BlockSadScalar(). Pitches are in bytes.
+
+// size x size block at cur against the one at ref
+uint32_t BlockSad(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t size);
+
+// sads[i] is the SAD against ref + i; reads size + 8 bytes of each ref row
+void BlockSadX8(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t size, uint32_t* sads);
+
+// One row of any width, psadbw 16 pixels at a time
+uint32_t RowSad(const uint8_t* a, const uint8_t* b, uint32_t width);
+
+// Plain loop, any block size
+uint32_t BlockSadScalar(const uint8_t* cur, size_t curPitch, const uint8_t* ref, size_t refPitch, uint32_t width, uint32_t height);
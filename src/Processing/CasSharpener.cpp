@@ -0,0 +1,335 @@
+#include "CasSharpener.h"
+#include "ScratchArena.h"
+#include "../Utils/CpuFeatures.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const uint32_t ROWS_PER_BAND = 5;
+    const uint32_t ROW_ABOVE = 0;
+    const uint32_t ROW_BELOW = 1;
+    const uint32_t ROW_ROLLING = 2;
+
+    // Fixed16 table: 256 maxima x 128 headroom values
+    const uint32_t HEADROOM_STEPS = 128;
+
+    inline void CopyPaddedRow(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        memcpy(dst + 4, src, static_cast<size_t>(width) * 4);
+        memcpy(dst, src, 4);
+        memcpy(dst + (width + 1) * 4, src + (width - 1) * 4, 4);
+    }
+
+    inline __m128i LoadPixels(const uint8_t* p)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    // 16 bytes or 8 words to four vectors of 4 floats
+    inline void WidenBytes(__m128i v, __m128 (&out)[4])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        out[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+        out[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+        out[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+        out[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+    }
+
+    inline void WidenWords(__m128i lo, __m128i hi, __m128 (&out)[4])
+    {
+        const __m128i zero = _mm_setzero_si128();
+        out[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+        out[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+        out[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+        out[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+    }
+
+    // CAS on 4 channels: weight = sqrt(headroom / max) * peak, applied to the 4 neighbours
+    inline __m128i CasChannels(__m128 mn, __m128 mx, __m128 sum, __m128 center, __m128 peak)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 headroom = _mm_min_ps(mn, _mm_sub_ps(_mm_set1_ps(255.0f), mx));
+        __m128 amp = _mm_min_ps(_mm_mul_ps(headroom, _mm_rcp_ps(_mm_max_ps(mx, one))), one);
+        __m128 weight = _mm_mul_ps(_mm_sqrt_ps(amp), peak);
+        __m128 value = _mm_add_ps(_mm_mul_ps(weight, sum), center);
+        __m128 normalize = _mm_rcp_ps(_mm_add_ps(one, _mm_mul_ps(weight, _mm_set1_ps(4.0f))));
+        return _mm_cvtps_epi32(_mm_mul_ps(value, normalize));
+    }
+
+    // above/row/below are padded copies of the original rows, out is the image row
+    void SharpenRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, uint32_t width, float peak)
+    {
+        const __m128 peakV = _mm_set1_ps(peak);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+        for (uint32_t i = 0; i < width; i += 4)
+        {
+            // The last group is moved back to end at the row end, recomputing a few pixels
+            // is harmless since the inputs are copies
+            uint32_t x = std::min(i, width - 4);
+            size_t offset = static_cast<size_t>(x + 1) * 4;
+
+            __m128i b = LoadPixels(above + offset);
+            __m128i d = LoadPixels(row + offset - 4);
+            __m128i e = LoadPixels(row + offset);
+            __m128i f = LoadPixels(row + offset + 4);
+            __m128i h = LoadPixels(below + offset);
+
+            __m128i mn = _mm_min_epu8(_mm_min_epu8(_mm_min_epu8(b, d), _mm_min_epu8(f, h)), e);
+            __m128i mx = _mm_max_epu8(_mm_max_epu8(_mm_max_epu8(b, d), _mm_max_epu8(f, h)), e);
+            __m128i sumLo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero)),
+                                          _mm_add_epi16(_mm_unpacklo_epi8(f, zero), _mm_unpacklo_epi8(h, zero)));
+            __m128i sumHi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero)),
+                                          _mm_add_epi16(_mm_unpackhi_epi8(f, zero), _mm_unpackhi_epi8(h, zero)));
+
+            __m128 mnF[4], mxF[4], sumF[4], centerF[4];
+            WidenBytes(mn, mnF);
+            WidenBytes(mx, mxF);
+            WidenBytes(e, centerF);
+            WidenWords(sumLo, sumHi, sumF);
+
+            __m128i r0 = CasChannels(mnF[0], mxF[0], sumF[0], centerF[0], peakV);
+            __m128i r1 = CasChannels(mnF[1], mxF[1], sumF[1], centerF[1], peakV);
+            __m128i r2 = CasChannels(mnF[2], mxF[2], sumF[2], centerF[2], peakV);
+            __m128i r3 = CasChannels(mnF[3], mxF[3], sumF[3], centerF[3], peakV);
+            __m128i result = _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+
+            result = _mm_or_si128(_mm_andnot_si128(alphaMask, result), _mm_and_si128(alphaMask, e));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), result);
+        }
+    }
+
+    // Same as SharpenRow with 8 pixels per step
+    // unpack and pack both work within 128-bit lanes, so the channel order survives the round trip
+    POTATO_TARGET_AVX2
+    inline __m256i CasChannelsAVX2(__m256i mn, __m256i mx, __m256i sum, __m256i center, __m256 peak)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        __m256 mnF = _mm256_cvtepi32_ps(mn);
+        __m256 mxF = _mm256_cvtepi32_ps(mx);
+        __m256 headroom = _mm256_min_ps(mnF, _mm256_sub_ps(_mm256_set1_ps(255.0f), mxF));
+        __m256 amp = _mm256_min_ps(_mm256_mul_ps(headroom, _mm256_rcp_ps(_mm256_max_ps(mxF, one))), one);
+        __m256 weight = _mm256_mul_ps(_mm256_sqrt_ps(amp), peak);
+        __m256 value = _mm256_add_ps(_mm256_mul_ps(weight, _mm256_cvtepi32_ps(sum)), _mm256_cvtepi32_ps(center));
+        __m256 normalize = _mm256_rcp_ps(_mm256_add_ps(one, _mm256_mul_ps(weight, _mm256_set1_ps(4.0f))));
+        return _mm256_cvtps_epi32(_mm256_mul_ps(value, normalize));
+    }
+
+    POTATO_TARGET_AVX2
+    void SharpenRowAVX2(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, uint32_t width, float peak)
+    {
+        const __m256 peakV = _mm256_set1_ps(peak);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        for (uint32_t i = 0; i < width; i += 8)
+        {
+            uint32_t x = std::min(i, width - 8);
+            size_t offset = static_cast<size_t>(x + 1) * 4;
+
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(above + offset));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + offset - 4));
+            __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + offset));
+            __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + offset + 4));
+            __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(below + offset));
+
+            __m256i mn = _mm256_min_epu8(_mm256_min_epu8(_mm256_min_epu8(b, d), _mm256_min_epu8(f, h)), e);
+            __m256i mx = _mm256_max_epu8(_mm256_max_epu8(_mm256_max_epu8(b, d), _mm256_max_epu8(f, h)), e);
+
+            __m256i sumLo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi8(d, zero)),
+                                             _mm256_add_epi16(_mm256_unpacklo_epi8(f, zero), _mm256_unpacklo_epi8(h, zero)));
+            __m256i sumHi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi8(d, zero)),
+                                             _mm256_add_epi16(_mm256_unpackhi_epi8(f, zero), _mm256_unpackhi_epi8(h, zero)));
+
+            __m256i results[4];
+            for (int half = 0; half < 2; half++)
+            {
+                __m256i mn16 = half ? _mm256_unpackhi_epi8(mn, zero) : _mm256_unpacklo_epi8(mn, zero);
+                __m256i mx16 = half ? _mm256_unpackhi_epi8(mx, zero) : _mm256_unpacklo_epi8(mx, zero);
+                __m256i center16 = half ? _mm256_unpackhi_epi8(e, zero) : _mm256_unpacklo_epi8(e, zero);
+                __m256i sum16 = half ? sumHi : sumLo;
+                results[half * 2] = CasChannelsAVX2(_mm256_unpacklo_epi16(mn16, zero), _mm256_unpacklo_epi16(mx16, zero),
+                    _mm256_unpacklo_epi16(sum16, zero), _mm256_unpacklo_epi16(center16, zero), peakV);
+                results[half * 2 + 1] = CasChannelsAVX2(_mm256_unpackhi_epi16(mn16, zero), _mm256_unpackhi_epi16(mx16, zero),
+                    _mm256_unpackhi_epi16(sum16, zero), _mm256_unpackhi_epi16(center16, zero), peakV);
+            }
+            __m256i result = _mm256_packus_epi16(_mm256_packs_epi32(results[0], results[1]), _mm256_packs_epi32(results[2], results[3]));
+
+            result = _mm256_or_si256(_mm256_andnot_si256(alphaMask, result), _mm256_and_si256(alphaMask, e));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x * 4), result);
+        }
+    }
+    // Fixed16 version of SharpenRowAVX2: each channel's weight and normalisation come from
+    // the table, then value = center + weight * sum is formed at 16x scale and multiplied by
+    // the normalisation, both through pmulhrsw (worst case error ~0.25 before rounding)
+    POTATO_TARGET_AVX2
+    inline __m256i CasChannelsFixedAVX2(__m256i mx, __m256i headroom, __m256i sum, __m256i center, const int32_t* table)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i index = _mm256_or_si256(_mm256_slli_epi16(mx, 7), headroom);
+
+        // Gathered in the lane order packs puts back together
+        __m256i lo = _mm256_i32gather_epi32(table, _mm256_unpacklo_epi16(index, zero), 4);
+        __m256i hi = _mm256_i32gather_epi32(table, _mm256_unpackhi_epi16(index, zero), 4);
+        __m256i weight = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_slli_epi32(lo, 16), 16), _mm256_srai_epi32(_mm256_slli_epi32(hi, 16), 16));
+        __m256i normalize = _mm256_packs_epi32(_mm256_srai_epi32(lo, 16), _mm256_srai_epi32(hi, 16));
+
+        __m256i value = _mm256_add_epi16(_mm256_slli_epi16(center, 4), _mm256_mulhrs_epi16(_mm256_slli_epi16(sum, 4), weight));
+        return _mm256_mulhrs_epi16(value, normalize);
+    }
+
+    POTATO_TARGET_AVX2
+    void SharpenRowFixedAVX2(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint8_t* out, uint32_t width, const int32_t* table)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+        for (uint32_t i = 0; i < width; i += 8)
+        {
+            uint32_t x = std::min(i, width - 8);
+            size_t offset = static_cast<size_t>(x + 1) * 4;
+
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(above + offset));
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + offset - 4));
+            __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + offset));
+            __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + offset + 4));
+            __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(below + offset));
+
+            __m256i mn = _mm256_min_epu8(_mm256_min_epu8(_mm256_min_epu8(b, d), _mm256_min_epu8(f, h)), e);
+            __m256i mx = _mm256_max_epu8(_mm256_max_epu8(_mm256_max_epu8(b, d), _mm256_max_epu8(f, h)), e);
+            __m256i headroom = _mm256_min_epu8(mn, _mm256_sub_epi8(_mm256_set1_epi8(-1), mx));
+
+            __m256i sumLo = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi8(d, zero)),
+                                             _mm256_add_epi16(_mm256_unpacklo_epi8(f, zero), _mm256_unpacklo_epi8(h, zero)));
+            __m256i sumHi = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi8(d, zero)),
+                                             _mm256_add_epi16(_mm256_unpackhi_epi8(f, zero), _mm256_unpackhi_epi8(h, zero)));
+
+            __m256i resultLo = CasChannelsFixedAVX2(_mm256_unpacklo_epi8(mx, zero), _mm256_unpacklo_epi8(headroom, zero),
+                sumLo, _mm256_unpacklo_epi8(e, zero), table);
+            __m256i resultHi = CasChannelsFixedAVX2(_mm256_unpackhi_epi8(mx, zero), _mm256_unpackhi_epi8(headroom, zero),
+                sumHi, _mm256_unpackhi_epi8(e, zero), table);
+            __m256i result = _mm256_packus_epi16(resultLo, resultHi);
+
+            result = _mm256_or_si256(_mm256_andnot_si256(alphaMask, result), _mm256_and_si256(alphaMask, e));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x * 4), result);
+        }
+    }
+}
+
+CasSharpener::CasSharpener()
+    : m_pool(ThreadPool::Shared())
+{
+}
+
+CasSharpener::~CasSharpener()
+{
+}
+
+uint8_t* CasSharpener::GetBandRow(uint32_t band, uint32_t index)
+{
+    return &m_rows[(static_cast<size_t>(band) * ROWS_PER_BAND + index) * m_rowSize];
+}
+
+void CasSharpener::Sharpen(const MutableImageView& image, float sharpness)
+{
+    if (!image.data || image.width < 4 || image.height == 0)
+    {
+        return;
+    }
+
+    // Negative lobe of the neighbour weights, -1/8 (soft) to -1/5 (sharp)
+    const float peak = -1.0f / (8.0f - 3.0f * std::min(std::max(sharpness, 0.0f), 1.0f));
+
+    const uint32_t height = image.height;
+    const uint32_t grain = m_pool.SuggestGrain(height);
+    const uint32_t bandCount = (height + grain - 1) / grain;
+    m_rowSize = static_cast<size_t>(image.width + 2) * 4;
+    ScratchScope scratch;
+    m_rows = scratch.Allocate<uint8_t>(bandCount * ROWS_PER_BAND * m_rowSize);
+
+    // Save the rows around each band before any band starts writing
+    for (uint32_t band = 0; band < bandCount; band++)
+    {
+        uint32_t begin = band * grain;
+        uint32_t end = std::min(begin + grain, height);
+        CopyPaddedRow(image.Row(begin > 0 ? begin - 1 : 0), GetBandRow(band, ROW_ABOVE), image.width);
+        CopyPaddedRow(image.Row(std::min(end, height - 1)), GetBandRow(band, ROW_BELOW), image.width);
+    }
+
+    const bool fixed = m_precision == KernelPrecision::Fixed16 && GetCpuFeatures().avx2 && image.width >= 8;
+    if (fixed && (m_fixedTable.empty() || m_fixedPeak != peak))
+    {
+        BuildFixedTable(peak);
+    }
+
+    m_pool.ParallelFor(bandCount, 1, [&](uint32_t first, uint32_t last)
+    {
+        for (uint32_t band = first; band < last; band++)
+        {
+            uint32_t begin = band * grain;
+            SharpenBand(image, band, begin, std::min(begin + grain, height), peak, fixed);
+        }
+    });
+}
+
+void CasSharpener::BuildFixedTable(float peak)
+{
+    m_fixedTable.resize(256 * HEADROOM_STEPS);
+    for (uint32_t mx = 0; mx < 256; mx++)
+    {
+        for (uint32_t headroom = 0; headroom < HEADROOM_STEPS; headroom++)
+        {
+            float amp = std::min(static_cast<float>(headroom) / std::max(mx, 1u), 1.0f);
+            float weight = std::sqrt(amp) * peak;
+            int32_t weightQ15 = static_cast<int32_t>(std::lround(weight * 32768.0f));
+            int32_t normalizeQ11 = static_cast<int32_t>(std::lround(2048.0f / (1.0f + 4.0f * weight)));
+            m_fixedTable[mx * HEADROOM_STEPS + headroom] = (weightQ15 & 0xFFFF) | (normalizeQ11 << 16);
+        }
+    }
+    m_fixedPeak = peak;
+}
+
+void CasSharpener::SharpenBand(const MutableImageView& image, uint32_t band, uint32_t begin, uint32_t end, float peak, bool fixed)
+{
+    const bool useAvx2 = GetCpuFeatures().avx2 && image.width >= 8;
+    uint8_t* rolling[3] = { GetBandRow(band, ROW_ROLLING), GetBandRow(band, ROW_ROLLING + 1), GetBandRow(band, ROW_ROLLING + 2) };
+
+    // Each row is copied before it's written, so the one below is still the original
+    const uint8_t* above = GetBandRow(band, ROW_ABOVE);
+    CopyPaddedRow(image.Row(begin), rolling[0], image.width);
+    const uint8_t* current = rolling[0];
+    uint32_t slot = 1;
+
+    for (uint32_t y = begin; y < end; y++)
+    {
+        const uint8_t* below = GetBandRow(band, ROW_BELOW);
+        if (y + 1 < end)
+        {
+            CopyPaddedRow(image.Row(y + 1), rolling[slot], image.width);
+            below = rolling[slot];
+            slot = (slot + 1) % 3;
+        }
+
+        if (fixed)
+        {
+            SharpenRowFixedAVX2(above, current, below, image.Row(y), image.width, m_fixedTable.data());
+        }
+        else if (useAvx2)
+        {
+            SharpenRowAVX2(above, current, below, image.Row(y), image.width, peak);
+        }
+        else
+        {
+            SharpenRow(above, current, below, image.Row(y), image.width, peak);
+        }
+        above = current;
+        current = below;
+    }
+}
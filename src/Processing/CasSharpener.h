@@ -0,0 +1,47 @@
+#pragma once
+#include "ImageView.h"
+#include "PixelSimd.h"
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Contrast adaptive sharpening (CAS) of a BGRA8 image, in place
+// Each channel moves away from the average of its 4 neighbours by an amount that shrinks
+// as the local min/max approach 0 or 255, so edges sharpen without clipping or halos.
+// Matches the CAS compute shader in D3D11Upscaler.
+class CasSharpener
+{
+public:
+    CasSharpener();
+    ~CasSharpener();
+
+    // sharpness 0..1, alpha is left untouched
+    // Images narrower than 4 pixels are left as they are
+    void Sharpen(const MutableImageView& image, float sharpness);
+
+    // Fixed16 looks the per-channel weights up in a table instead of computing sqrt and
+    // reciprocals, then sharpens in 16-bit lanes; it needs AVX2 (the lookup is a gather)
+    void SetPrecision(KernelPrecision precision) { m_precision = precision; }
+    KernelPrecision GetPrecision() const { return m_precision; }
+
+private:
+    uint8_t* GetBandRow(uint32_t band, uint32_t index);
+    void SharpenBand(const MutableImageView& image, uint32_t band, uint32_t begin, uint32_t end, float peak, bool fixed);
+    void BuildFixedTable(float peak);
+
+private:
+    ThreadPool& m_pool;
+
+    // Per row band: the original rows just above and below it (neighbouring bands overwrite
+    // them) and 3 rolling copies of its own rows, each padded by one pixel on both sides
+    // Scratch of the current Sharpen() call
+    uint8_t* m_rows = nullptr;
+    size_t m_rowSize = 0;
+
+    // Fixed16: neighbour weight (Q15, low half) and 1 / (1 + 4 * weight) (Q11, high half),
+    // indexed by max * 128 + min(min, 255 - max); rebuilt when the sharpness changes
+    KernelPrecision m_precision = KernelPrecision::Float;
+    std::vector<int32_t> m_fixedTable;
+    float m_fixedPeak = 0.0f;
+};
@@ -0,0 +1,542 @@
+#include "CnnUpscaler.h"
+#include "PixelConvert.h"
+#include "../Utils/CpuFeatures.h"
+#include "../Utils/Logger.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    // Three 3x3 layers see 3 pixels in every direction, plus one column so the
+    // 4 byte loads of the first layer never read past a row
+    const uint32_t LUMA_PAD = 3;
+
+    const uint32_t CHANNELS = 16;
+    const uint32_t OUTPUTS = 4;  // 2x2 sub-pixels per input pixel
+
+    // Input pixels per tile, activations of one tile are ~75 KB
+    const uint32_t TILE_WIDTH = 64;
+    const uint32_t TILE_HEIGHT = 32;
+    const size_t ACT1_SIZE = (TILE_WIDTH + 4) * (TILE_HEIGHT + 4) * CHANNELS;
+    const size_t ACT2_SIZE = (TILE_WIDTH + 2) * (TILE_HEIGHT + 2) * CHANNELS;
+
+    const uint32_t LAYER_INPUTS[3] = { 1, CHANNELS, CHANNELS };
+    const uint32_t LAYER_OUTPUTS[3] = { CHANNELS, CHANNELS, OUTPUTS };
+
+    // maddubs adds two u8 * s8 products into a saturating int16. Luma goes up to 255 and
+    // hidden activations up to 127, so these weight limits keep every pair below 32767
+    // and the AVX2 path gives exactly the same sums as VNNI and the scalar fallback.
+    const int LAYER_WEIGHT_LIMITS[3] = { 63, 127, 127 };
+
+    const int ACTIVATION_MAX = 127;
+
+    inline int32_t LoadInt32(const uint8_t* p)
+    {
+        int32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // Rounds like _mm256_cvtps_epi32 so the scalar path matches the SIMD one
+    inline int RoundToInt(float value)
+    {
+        return _mm_cvtss_si32(_mm_set_ss(value));
+    }
+
+    // Adds a per-pixel residual (one int32 per pixel) to B, G and R of 2 or 4 pixels
+    inline void AddResidual(uint8_t* pixels, __m128i residual, uint32_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i colourMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+
+        __m128i r16 = _mm_packs_epi32(residual, residual);
+        __m128i pairs = _mm_unpacklo_epi16(r16, r16);
+        __m128i r01 = _mm_and_si128(_mm_unpacklo_epi32(pairs, pairs), colourMask);
+        __m128i r23 = _mm_and_si128(_mm_unpackhi_epi32(pairs, pairs), colourMask);
+
+        __m128i p = count == 4 ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels))
+                               : _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels));
+        __m128i p01 = _mm_add_epi16(_mm_unpacklo_epi8(p, zero), r01);
+        __m128i p23 = _mm_add_epi16(_mm_unpackhi_epi8(p, zero), r23);
+        p = _mm_packus_epi16(p01, p23);
+
+        if (count == 4)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), p);
+        }
+        else
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pixels), p);
+        }
+    }
+
+    // acc += dot products of 4 unsigned bytes of a with 4 signed bytes of w, per int32 lane
+    template <bool Vnni>
+    POTATO_TARGET_AVX2 inline __m256i DotAccumulate(__m256i acc, __m256i a, __m256i w)
+    {
+        if (Vnni)
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            return _mm256_dpbusd_avx_epi32(acc, a, w);
+#else
+            // Emitted directly so this function doesn't need an avxvnni target of its own
+            __asm__("%{vex%} vpdpbusd %2, %1, %0" : "+x"(acc) : "x"(a), "xm"(w));
+            return acc;
+#endif
+        }
+
+        __m256i pairs = _mm256_maddubs_epi16(a, w);
+        return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+    }
+
+    POTATO_TARGET_AVX2 inline __m256i Requantize(__m256i acc, const float* multiplier, const float* offset)
+    {
+        __m256 value = _mm256_mul_ps(_mm256_cvtepi32_ps(acc), _mm256_loadu_ps(multiplier));
+        return _mm256_cvtps_epi32(_mm256_add_ps(value, _mm256_loadu_ps(offset)));
+    }
+
+    // Requantises 16 accumulators to 0..127 (the ReLU is the unsigned saturation)
+    POTATO_TARGET_AVX2 inline void StoreActivations(uint8_t* out, __m256i acc0, __m256i acc1, const CnnLayer& layer)
+    {
+        __m256i q0 = Requantize(acc0, layer.multiplier, layer.offset);
+        __m256i q1 = Requantize(acc1, layer.multiplier + 8, layer.offset + 8);
+        __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(q0, q1), _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+        bytes = _mm_min_epu8(bytes, _mm_set1_epi8(ACTIVATION_MAX));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+    }
+
+    // Runs the network over one tile and adds the residual to the 2x image
+    // luma points at input pixel (-3, -3) of the tile, out at output pixel (0, 0)
+    template <bool Vnni>
+    POTATO_TARGET_AVX2 void RunTileAvx2(const CnnLayer (&layers)[3], const uint8_t* luma, size_t lumaPitch,
+        uint32_t width, uint32_t height, uint8_t* out, size_t outPitch)
+    {
+        alignas(32) uint8_t act1[ACT1_SIZE];
+        alignas(32) uint8_t act2[ACT2_SIZE + CHANNELS];  // The last pair load reads one position past the end
+
+        const uint32_t width1 = width + 4;
+        const uint32_t width2 = width + 2;
+        const __m256i zero = _mm256_setzero_si256();
+
+        // Layer 1: one int32 per kernel row (3 luma taps + a byte with zero weight)
+        const __m256i* w1 = reinterpret_cast<const __m256i*>(layers[0].packed.data());
+        for (uint32_t y = 0; y < height + 4; y++)
+        {
+            for (uint32_t x = 0; x < width1; x++)
+            {
+                __m256i acc0 = zero;
+                __m256i acc1 = zero;
+                for (int ky = 0; ky < 3; ky++)
+                {
+                    __m256i taps = _mm256_set1_epi32(LoadInt32(luma + (y + ky) * lumaPitch + x));
+                    acc0 = DotAccumulate<Vnni>(acc0, taps, _mm256_loadu_si256(w1 + ky * 2));
+                    acc1 = DotAccumulate<Vnni>(acc1, taps, _mm256_loadu_si256(w1 + ky * 2 + 1));
+                }
+                StoreActivations(act1 + (y * width1 + x) * CHANNELS, acc0, acc1, layers[0]);
+            }
+        }
+
+        // Layer 2: 9 taps x 4 groups of 4 input channels
+        const __m256i* w2 = reinterpret_cast<const __m256i*>(layers[1].packed.data());
+        for (uint32_t y = 0; y < height + 2; y++)
+        {
+            for (uint32_t x = 0; x < width2; x++)
+            {
+                __m256i acc0 = zero;
+                __m256i acc1 = zero;
+                for (int ky = 0; ky < 3; ky++)
+                {
+                    for (int kx = 0; kx < 3; kx++)
+                    {
+                        const uint8_t* in = act1 + ((y + ky) * width1 + x + kx) * CHANNELS;
+                        const __m256i* w = w2 + (ky * 3 + kx) * 8;
+                        for (int g = 0; g < 4; g++)
+                        {
+                            __m256i taps = _mm256_set1_epi32(LoadInt32(in + g * 4));
+                            acc0 = DotAccumulate<Vnni>(acc0, taps, _mm256_loadu_si256(w + g * 2));
+                            acc1 = DotAccumulate<Vnni>(acc1, taps, _mm256_loadu_si256(w + g * 2 + 1));
+                        }
+                    }
+                }
+                StoreActivations(act2 + (y * width2 + x) * CHANNELS, acc0, acc1, layers[1]);
+            }
+        }
+
+        // Layer 3: two neighbouring pixels per vector (4 outputs each), the groups are
+        // broadcast within each 128-bit half
+        const __m256i* w3 = reinterpret_cast<const __m256i*>(layers[2].packed.data());
+        const __m256i groups[4] =
+        {
+            _mm256_setr_epi32(0, 0, 0, 0, 4, 4, 4, 4),
+            _mm256_setr_epi32(1, 1, 1, 1, 5, 5, 5, 5),
+            _mm256_setr_epi32(2, 2, 2, 2, 6, 6, 6, 6),
+            _mm256_setr_epi32(3, 3, 3, 3, 7, 7, 7, 7),
+        };
+        // Outputs are (0,0) (1,0) (0,1) (1,1) per pixel, regroup them into the two output rows
+        const __m256i rowOrder = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t* row0 = out + 2 * y * outPitch;
+            uint8_t* row1 = row0 + outPitch;
+            for (uint32_t x = 0; x < width; x += 2)
+            {
+                __m256i acc = zero;
+                for (int ky = 0; ky < 3; ky++)
+                {
+                    for (int kx = 0; kx < 3; kx++)
+                    {
+                        __m256i pair = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(act2 + ((y + ky) * width2 + x + kx) * CHANNELS));
+                        const __m256i* w = w3 + (ky * 3 + kx) * 4;
+                        for (int g = 0; g < 4; g++)
+                        {
+                            acc = DotAccumulate<Vnni>(acc, _mm256_permutevar8x32_epi32(pair, groups[g]), _mm256_loadu_si256(w + g));
+                        }
+                    }
+                }
+
+                __m256i residual = _mm256_permutevar8x32_epi32(Requantize(acc, layers[2].multiplier, layers[2].offset), rowOrder);
+                uint32_t count = std::min(2u, width - x) * 2;
+                AddResidual(row0 + x * 8, _mm256_castsi256_si128(residual), count);
+                AddResidual(row1 + x * 8, _mm256_extracti128_si256(residual, 1), count);
+            }
+        }
+    }
+
+    // Reference implementation for CPUs without AVX2, same arithmetic as the SIMD path
+    void RunTileScalar(const CnnLayer (&layers)[3], const uint8_t* luma, size_t lumaPitch,
+        uint32_t width, uint32_t height, uint8_t* out, size_t outPitch)
+    {
+        uint8_t act1[ACT1_SIZE];
+        uint8_t act2[ACT2_SIZE];
+
+        const uint32_t width1 = width + 4;
+        const uint32_t width2 = width + 2;
+
+        auto quantize = [](int32_t acc, const CnnLayer& layer, uint32_t o)
+        {
+            int q = RoundToInt(static_cast<float>(acc) * layer.multiplier[o] + layer.offset[o]);
+            return static_cast<uint8_t>(std::min(std::max(q, 0), ACTIVATION_MAX));
+        };
+
+        const int8_t* w1 = layers[0].weights.data();
+        for (uint32_t y = 0; y < height + 4; y++)
+        {
+            for (uint32_t x = 0; x < width1; x++)
+            {
+                for (uint32_t o = 0; o < CHANNELS; o++)
+                {
+                    int32_t acc = 0;
+                    for (int k = 0; k < 9; k++)
+                    {
+                        acc += luma[(y + k / 3) * lumaPitch + x + k % 3] * w1[o * 9 + k];
+                    }
+                    act1[(y * width1 + x) * CHANNELS + o] = quantize(acc, layers[0], o);
+                }
+            }
+        }
+
+        const int8_t* w2 = layers[1].weights.data();
+        for (uint32_t y = 0; y < height + 2; y++)
+        {
+            for (uint32_t x = 0; x < width2; x++)
+            {
+                for (uint32_t o = 0; o < CHANNELS; o++)
+                {
+                    int32_t acc = 0;
+                    for (int k = 0; k < 9; k++)
+                    {
+                        const uint8_t* in = &act1[((y + k / 3) * width1 + x + k % 3) * CHANNELS];
+                        const int8_t* w = w2 + (o * 9 + k) * CHANNELS;
+                        for (uint32_t c = 0; c < CHANNELS; c++)
+                        {
+                            acc += in[c] * w[c];
+                        }
+                    }
+                    act2[(y * width2 + x) * CHANNELS + o] = quantize(acc, layers[1], o);
+                }
+            }
+        }
+
+        const int8_t* w3 = layers[2].weights.data();
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                for (uint32_t o = 0; o < OUTPUTS; o++)
+                {
+                    int32_t acc = 0;
+                    for (int k = 0; k < 9; k++)
+                    {
+                        const uint8_t* in = &act2[((y + k / 3) * width2 + x + k % 3) * CHANNELS];
+                        const int8_t* w = w3 + (o * 9 + k) * CHANNELS;
+                        for (uint32_t c = 0; c < CHANNELS; c++)
+                        {
+                            acc += in[c] * w[c];
+                        }
+                    }
+
+                    int residual = RoundToInt(static_cast<float>(acc) * layers[2].multiplier[o] + layers[2].offset[o]);
+                    uint8_t* pixel = out + (2 * y + o / 2) * outPitch + (2 * x + o % 2) * 4;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        pixel[c] = static_cast<uint8_t>(std::min(std::max(pixel[c] + residual, 0), 255));
+                    }
+                }
+            }
+        }
+    }
+}
+
+CnnUpscaler::CnnUpscaler()
+    : m_pool(ThreadPool::Shared())
+{
+    const CpuFeatures& cpu = GetCpuFeatures();
+    m_useAvx2 = cpu.avx2;
+    m_useVnni = cpu.avxVnni;
+}
+
+CnnUpscaler::~CnnUpscaler()
+{
+}
+
+bool CnnUpscaler::LoadModel(const std::string& path)
+{
+    m_loaded = false;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        Logger::Warning("Neural upscaler model not found: %s", path.c_str());
+        return false;
+    }
+
+    CnnModelHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file.good() || memcmp(header.magic, "PPNN", 4) != 0 || header.version != 1 ||
+        header.scale != 2 || header.layerCount != 3)
+    {
+        Logger::Error("Not a supported model file: %s", path.c_str());
+        return false;
+    }
+
+    float inputStep = 1.0f / 255.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        CnnLayerHeader layerHeader;
+        file.read(reinterpret_cast<char*>(&layerHeader), sizeof(layerHeader));
+        if (!file.good() || layerHeader.inputChannels != LAYER_INPUTS[i] ||
+            layerHeader.outputChannels != LAYER_OUTPUTS[i] || layerHeader.kernelSize != 3 ||
+            !(layerHeader.outputStep > 0.0f))
+        {
+            Logger::Error("Model layer %d has an unsupported shape: %s", i, path.c_str());
+            return false;
+        }
+
+        const uint32_t outputs = layerHeader.outputChannels;
+        float weightScale[CHANNELS];
+        float bias[CHANNELS];
+        CnnLayer& layer = m_layers[i];
+        layer.inputChannels = layerHeader.inputChannels;
+        layer.outputChannels = outputs;
+        layer.weights.resize(static_cast<size_t>(outputs) * 9 * layer.inputChannels);
+
+        file.read(reinterpret_cast<char*>(weightScale), sizeof(float) * outputs);
+        file.read(reinterpret_cast<char*>(bias), sizeof(float) * outputs);
+        file.read(reinterpret_cast<char*>(layer.weights.data()), layer.weights.size());
+        if (!file.good())
+        {
+            Logger::Error("Model file is truncated: %s", path.c_str());
+            return false;
+        }
+
+        for (int8_t weight : layer.weights)
+        {
+            if (std::abs(weight) > LAYER_WEIGHT_LIMITS[i])
+            {
+                Logger::Error("Model layer %d has weights outside +-%d: %s", i, LAYER_WEIGHT_LIMITS[i], path.c_str());
+                return false;
+            }
+        }
+
+        for (uint32_t o = 0; o < outputs; o++)
+        {
+            layer.multiplier[o] = weightScale[o] * inputStep / layerHeader.outputStep;
+            layer.offset[o] = bias[o] / layerHeader.outputStep;
+        }
+
+        PackWeights(layer, i);
+        inputStep = layerHeader.outputStep;
+    }
+
+    m_loaded = true;
+    Logger::Info("Neural upscaler model loaded (%s)", m_useVnni ? "AVX-VNNI" : m_useAvx2 ? "AVX2" : "scalar");
+    return true;
+}
+
+void CnnUpscaler::PackWeights(CnnLayer& layer, int index)
+{
+    const uint32_t inputs = layer.inputChannels;
+    auto weight = [&](uint32_t o, uint32_t tap, uint32_t c) { return layer.weights[(o * 9 + tap) * inputs + c]; };
+
+    layer.packed.clear();
+    if (index == 0)
+    {
+        // [ky][output half][lane] = w(o, ky, 0..2), 0
+        for (uint32_t ky = 0; ky < 3; ky++)
+        {
+            for (uint32_t o = 0; o < CHANNELS; o++)
+            {
+                for (uint32_t kx = 0; kx < 4; kx++)
+                {
+                    layer.packed.push_back(kx < 3 ? weight(o, ky * 3 + kx, 0) : 0);
+                }
+            }
+        }
+    }
+    else if (index == 1)
+    {
+        // [tap][group][output half][lane] = w(o, tap, 4 * group .. 4 * group + 3)
+        for (uint32_t tap = 0; tap < 9; tap++)
+        {
+            for (uint32_t g = 0; g < 4; g++)
+            {
+                for (uint32_t o = 0; o < CHANNELS; o++)
+                {
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        layer.packed.push_back(weight(o, tap, g * 4 + c));
+                    }
+                }
+            }
+        }
+    }
+    else
+    {
+        // [tap][group][lane], the 4 outputs repeat in both 128-bit halves
+        for (uint32_t tap = 0; tap < 9; tap++)
+        {
+            for (uint32_t g = 0; g < 4; g++)
+            {
+                for (uint32_t lane = 0; lane < 8; lane++)
+                {
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        layer.packed.push_back(weight(lane % OUTPUTS, tap, g * 4 + c));
+                    }
+                }
+            }
+        }
+
+        for (uint32_t o = 0; o < OUTPUTS; o++)
+        {
+            layer.multiplier[o + OUTPUTS] = layer.multiplier[o];
+            layer.offset[o + OUTPUTS] = layer.offset[o];
+        }
+    }
+}
+
+void CnnUpscaler::Upscale(const ImageView& src, const MutableImageView& dst)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0)
+    {
+        return;
+    }
+
+    if (!m_loaded)
+    {
+        m_bilinear.Bilinear(src, dst);
+        return;
+    }
+
+    if (dst.width == src.width * 2 && dst.height == src.height * 2)
+    {
+        Upscale2x(src, dst);
+        return;
+    }
+
+    // The 2x grid is center aligned like the bilinear resample, so no offset is needed
+    size_t pitch = static_cast<size_t>(src.width) * 2 * 4;
+    m_stage.resize(pitch * src.height * 2);
+    MutableImageView stage{ m_stage.data(), src.width * 2, src.height * 2, pitch };
+    Upscale2x(src, stage);
+    m_bilinear.Bilinear(stage, dst);
+}
+
+void CnnUpscaler::Upscale2x(const ImageView& src, const MutableImageView& dst)
+{
+    m_width = src.width;
+    m_height = src.height;
+
+    // The network only predicts the detail missing from a bilinear upscale
+    m_bilinear.Bilinear(src, dst);
+    BuildPaddedLuma(src);
+
+    const uint32_t tilesX = (m_width + TILE_WIDTH - 1) / TILE_WIDTH;
+    const uint32_t tilesY = (m_height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    m_pool.ParallelFor(tilesX * tilesY, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t tile = begin; tile < end; tile++)
+        {
+            ProcessTile(dst, tile % tilesX, tile / tilesX);
+        }
+    });
+}
+
+void CnnUpscaler::BuildPaddedLuma(const ImageView& src)
+{
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+    m_lumaPitch = width + 2 * LUMA_PAD + 1;
+    m_luma.resize(m_lumaPitch * (height + 2 * LUMA_PAD));
+
+    m_pool.ParallelFor(height, m_pool.SuggestGrain(height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint8_t* in = src.Row(y);
+            uint8_t* out = &m_luma[(y + LUMA_PAD) * m_lumaPitch];
+            BgraToLumaRow(in, out + LUMA_PAD, width);
+            std::fill(out, out + LUMA_PAD, out[LUMA_PAD]);
+            std::fill(out + LUMA_PAD + width, out + m_lumaPitch, out[LUMA_PAD + width - 1]);
+        }
+    });
+
+    const uint8_t* first = &m_luma[LUMA_PAD * m_lumaPitch];
+    const uint8_t* last = &m_luma[(height + LUMA_PAD - 1) * m_lumaPitch];
+    for (uint32_t i = 1; i <= LUMA_PAD; i++)
+    {
+        std::copy(first, first + m_lumaPitch, &m_luma[(LUMA_PAD - i) * m_lumaPitch]);
+        std::copy(last, last + m_lumaPitch, &m_luma[(height + LUMA_PAD - 1 + i) * m_lumaPitch]);
+    }
+}
+
+void CnnUpscaler::ProcessTile(const MutableImageView& dst, uint32_t tileX, uint32_t tileY)
+{
+    const uint32_t x0 = tileX * TILE_WIDTH;
+    const uint32_t y0 = tileY * TILE_HEIGHT;
+    const uint32_t width = std::min(TILE_WIDTH, m_width - x0);
+    const uint32_t height = std::min(TILE_HEIGHT, m_height - y0);
+
+    // Padded luma coordinates are shifted by LUMA_PAD, so this is input pixel (x0 - 3, y0 - 3)
+    const uint8_t* luma = &m_luma[y0 * m_lumaPitch + x0];
+    uint8_t* out = dst.Row(y0 * 2) + x0 * 8;
+
+    if (m_useVnni)
+    {
+        RunTileAvx2<true>(m_layers, luma, m_lumaPitch, width, height, out, dst.pitch);
+    }
+    else if (m_useAvx2)
+    {
+        RunTileAvx2<false>(m_layers, luma, m_lumaPitch, width, height, out, dst.pitch);
+    }
+    else
+    {
+        RunTileScalar(m_layers, luma, m_lumaPitch, width, height, out, dst.pitch);
+    }
+}
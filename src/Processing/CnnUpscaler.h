@@ -0,0 +1,83 @@
+#pragma once
+#include "ImageView.h"
+#include "CpuUpscaler.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Model file layout (little endian):
+//   CnnModelHeader
+//   per layer: CnnLayerHeader, float weightScale[outputChannels], float bias[outputChannels],
+//              int8 weights[outputChannels][kernelSize][kernelSize][inputChannels]
+// A layer's real output is sum(weights * inputs) * weightScale * inputStep + bias, where
+// inputStep is the previous layer's outputStep (1/255 for the luma input). Hidden layers are
+// ReLU and stored as 0..127 steps, the last layer is the luma residual in 1/255 steps.
+struct CnnModelHeader
+{
+    char magic[4] = { 'P', 'P', 'N', 'N' };
+    uint32_t version = 1;
+    uint32_t scale = 2;
+    uint32_t layerCount = 0;
+};
+
+struct CnnLayerHeader
+{
+    uint32_t inputChannels = 0;
+    uint32_t outputChannels = 0;
+    uint32_t kernelSize = 0;
+    float outputStep = 0.0f;
+};
+
+// One quantised 3x3 layer in the layouts the kernels consume
+struct CnnLayer
+{
+    uint32_t inputChannels = 0;
+    uint32_t outputChannels = 0;
+    std::vector<int8_t> weights;  // [out][ky][kx][in], as stored in the file
+    std::vector<int8_t> packed;   // Weight vectors matching the broadcast inputs of the AVX2 kernels
+    float multiplier[16] = {};    // Output steps = accumulator * multiplier + offset
+    float offset[16] = {};
+};
+
+// Tiny ESPCN-style super-resolution network on the CPU, int8 quantised
+// Three 3x3 convolutions (1 -> 16 -> 16 -> 4) run on luma and predict a 2x2 residual per
+// input pixel (pixel shuffle) that is added on top of a bilinear 2x upscale of the colour
+// image. Dot products use AVX-VNNI when the CPU has it and AVX2 otherwise; the image is
+// processed in tiles small enough that the activations stay in L1/L2.
+class CnnUpscaler
+{
+public:
+    CnnUpscaler();
+    ~CnnUpscaler();
+
+    // Only the 1 -> 16 -> 16 -> 4 layout is supported, anything else is rejected
+    bool LoadModel(const std::string& path);
+    bool IsLoaded() const { return m_loaded; }
+
+    // Network 2x pass, then a bilinear resample covers any other factor
+    // Falls back to plain bilinear when no model is loaded
+    void Upscale(const ImageView& src, const MutableImageView& dst);
+
+private:
+    void PackWeights(CnnLayer& layer, int index);
+    void Upscale2x(const ImageView& src, const MutableImageView& dst);
+    void BuildPaddedLuma(const ImageView& src);
+    void ProcessTile(const MutableImageView& dst, uint32_t tileX, uint32_t tileY);
+
+private:
+    ThreadPool& m_pool;
+    CpuUpscaler m_bilinear;
+    bool m_loaded = false;
+    bool m_useAvx2 = false;
+    bool m_useVnni = false;
+
+    CnnLayer m_layers[3];
+
+    std::vector<uint8_t> m_luma;   // Source luma with a replicated border of LUMA_PAD pixels
+    size_t m_lumaPitch = 0;
+    uint32_t m_width = 0;          // Source size of the current 2x pass
+    uint32_t m_height = 0;
+    std::vector<uint8_t> m_stage;  // 2x result before the residual resample
+};
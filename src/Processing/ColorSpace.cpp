@@ -0,0 +1,42 @@
+#include "ColorSpace.h"
+#include <cmath>
+
+float SrgbToLinear(float encoded)
+{
+    if (encoded <= 0.04045f)
+    {
+        return encoded / 12.92f;
+    }
+    return std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float linear)
+{
+    if (linear <= 0.0031308f)
+    {
+        return linear * 12.92f;
+    }
+    return 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+}
+
+static SrgbTables BuildSrgbTables()
+{
+    SrgbTables tables;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        tables.toLinear[i] = SrgbToLinear(i / 255.0f) * 255.0f;
+        tables.toLinear16[i] = static_cast<int16_t>(std::lround(tables.toLinear[i] * LINEAR16_SCALE));
+    }
+    for (uint32_t i = 0; i < SrgbTables::LINEAR_STEPS; i++)
+    {
+        float encoded = LinearToSrgb(static_cast<float>(i) / (SrgbTables::LINEAR_STEPS - 1));
+        tables.toSrgb[i] = static_cast<uint8_t>(std::lround(encoded * 255.0f));
+    }
+    return tables;
+}
+
+const SrgbTables& GetSrgbTables()
+{
+    static const SrgbTables tables = BuildSrgbTables();
+    return tables;
+}
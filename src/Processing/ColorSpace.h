@@ -0,0 +1,67 @@
+#pragma once
+#include "PixelSimd.h"
+#include <cstdint>
+
+// sRGB <-> linear light conversion for the linear-light filtering mode
+// Linear values keep the 0..255 range of the encoded channels, so the kernels' constants
+// (contrast thresholds, clamps) work unchanged in either space
+struct SrgbTables
+{
+    static const uint32_t LINEAR_STEPS = 4096;
+    static constexpr float LINEAR_TO_INDEX = (LINEAR_STEPS - 1) / 255.0f;
+
+    float toLinear[256];             // Encoded channel -> linear light
+    int16_t toLinear16[256];         // Same in LINEAR16_SCALE steps, for decoded images
+    uint8_t toSrgb[LINEAR_STEPS];    // Linear light in 1/4095 steps -> encoded channel
+};
+
+// Fixed point scale of decoded images, 0..255 maps to 0..32640 so values fit signed 16 bits
+const float LINEAR16_SCALE = 128.0f;
+
+// A BGRA image decoded to linear light once, so resampling kernels don't pay for the
+// table lookups on every tap (pitch is in elements)
+struct LinearImageView
+{
+    const int16_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    const int16_t* Row(uint32_t y) const { return data + y * pitch; }
+};
+
+const SrgbTables& GetSrgbTables();
+
+// Exact transfer functions on 0..1 values (table construction and reference rendering)
+float SrgbToLinear(float encoded);
+float LinearToSrgb(float linear);
+
+// One pixel of a LinearImageView as floats on the 0..255 scale
+inline __m128 LoadPixelLinear16(const int16_t* pixel)
+{
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel));
+    v = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+    return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / LINEAR16_SCALE));
+}
+
+inline void StorePixelLinear16(int16_t* pixel, __m128 value)
+{
+    __m128i v = _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(LINEAR16_SCALE)));
+    v = _mm_max_epi16(_mm_packs_epi32(v, v), _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(pixel), v);
+}
+
+// StorePixel() with the colour channels encoded back to sRGB
+inline void StorePixelLinear(uint8_t* pixel, __m128 value, const SrgbTables& tables)
+{
+    const float s = SrgbTables::LINEAR_TO_INDEX;
+    __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+    __m128i index = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_setr_ps(s, s, s, 1.0f)));
+
+    alignas(16) int32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+    pixel[0] = tables.toSrgb[lanes[0]];
+    pixel[1] = tables.toSrgb[lanes[1]];
+    pixel[2] = tables.toSrgb[lanes[2]];
+    pixel[3] = static_cast<uint8_t>(lanes[3]);
+}
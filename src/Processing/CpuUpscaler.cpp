@@ -0,0 +1,1067 @@
+#include "CpuUpscaler.h"
+#include "PixelSimd.h"
+#include "ColorSpace.h"
+#include "PixelConvert.h"
+#include "ScratchArena.h"
+#include "../Utils/CpuFeatures.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace
+{
+    // Replicated border around the luma planes so gradient windows never need clamping
+    const uint32_t LUMA_PAD = 2;
+
+    // Gradient sums are evaluated in segments so the per-pixel scratch lives on the stack
+    const uint32_t SEGMENT = 256;
+
+    // One direction wins outright when its gradient is this much smaller than the other's
+    const float EDGE_THRESHOLD = 1.15f;
+
+    struct DiffTerm
+    {
+        const uint8_t* a;
+        const uint8_t* b;
+    };
+
+    // out[x] = sum over terms of |a[x] - b[x]|
+    template <int N>
+    void SumAbsDiffs(const DiffTerm (&terms)[N], uint32_t offset, uint32_t count, uint16_t* out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        uint32_t x = 0;
+        for (; x + 16 <= count; x += 16)
+        {
+            __m128i lo = _mm_setzero_si128();
+            __m128i hi = _mm_setzero_si128();
+            for (int k = 0; k < N; k++)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(terms[k].a + offset + x));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(terms[k].b + offset + x));
+                __m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+                lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(d, zero));
+                hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(d, zero));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x + 8), hi);
+        }
+        for (; x < count; x++)
+        {
+            uint32_t sum = 0;
+            for (int k = 0; k < N; k++)
+            {
+                int d = terms[k].a[offset + x] - terms[k].b[offset + x];
+                sum += d < 0 ? -d : d;
+            }
+            out[x] = static_cast<uint16_t>(sum);
+        }
+    }
+
+    // Weight of direction 0 given the gradient along each direction
+    // Interpolating along the direction with the smaller gradient follows the edge
+    inline float DirectionWeight(uint32_t gradient0, uint32_t gradient1)
+    {
+        float a = 1.0f + gradient0;
+        float b = 1.0f + gradient1;
+        if (a * EDGE_THRESHOLD < b) return 1.0f;
+        if (b * EDGE_THRESHOLD < a) return 0.0f;
+
+        float g0 = static_cast<float>(gradient0);
+        float g1 = static_cast<float>(gradient1);
+        float a5 = g0 * g0 * g0 * g0 * g0;
+        float b5 = g1 * g1 * g1 * g1 * g1;
+        return (1.0f + b5) / (2.0f + a5 + b5);
+    }
+
+    // Filtering space of the kernels: the encoded pixels of an ImageView as they are, a
+    // LinearImageView decoded up front, whose results are encoded again on store, or the
+    // floats of a decoded HDR frame, stored as floats
+    inline __m128 LoadColor(const uint8_t* pixel)
+    {
+        return LoadPixel(pixel);
+    }
+
+    inline __m128 LoadColor(const int16_t* pixel)
+    {
+        return LoadPixelLinear16(pixel);
+    }
+
+    inline __m128 LoadColor(const float* pixel)
+    {
+        return _mm_loadu_ps(pixel);
+    }
+
+    inline void StoreColor(const ImageView&, uint8_t* pixel, __m128 value, const SrgbTables&)
+    {
+        StorePixel(pixel, value);
+    }
+
+    inline void StoreColor(const LinearImageView&, uint8_t* pixel, __m128 value, const SrgbTables& tables)
+    {
+        StorePixelLinear(pixel, value, tables);
+    }
+
+    inline void StoreColor(const FloatImageView&, float* pixel, __m128 value, const SrgbTables&)
+    {
+        _mm_storeu_ps(pixel, value);
+    }
+
+    // Edge-directed pass 1 results are kept in the filtering space too when it isn't the encoded image
+    inline void StoreFiltered(const ImageView&, std::vector<int16_t>&, size_t, __m128)
+    {
+    }
+
+    inline void StoreFiltered(const LinearImageView&, std::vector<int16_t>& buffer, size_t index, __m128 value)
+    {
+        StorePixelLinear16(&buffer[index], value);
+    }
+
+    inline void StoreFiltered(const FloatImageView&, std::vector<int16_t>&, size_t, __m128)
+    {
+    }
+
+    inline void CopyPixel(float* dst, const float* src)
+    {
+        _mm_storeu_ps(dst, _mm_loadu_ps(src));
+    }
+
+    // HDR output rows are filtered into floats and converted to halves once complete, so F16C
+    // converts them in bulk instead of a per-pixel store. Two rows, the 2x pass writes pairs
+    // The rows are scratch, the HDR entry points hold a ScratchScope around their passes
+    struct HalfRowWriter
+    {
+        uint32_t width;
+        uint32_t height;
+        MutableHalfImageView image;
+        float* rows;
+
+        explicit HalfRowWriter(const MutableHalfImageView& target)
+            : width(target.width), height(target.height), image(target),
+              rows(ScratchArena::Shared().Allocate<float>(static_cast<size_t>(target.width) * 8))
+        {
+        }
+
+        float* Row(uint32_t y) const { return rows + (y & 1) * static_cast<size_t>(width) * 4; }
+    };
+
+    // Output rows of a kernel, set up once per parallel range
+    template <typename View>
+    inline View OutputRows(const View& dst)
+    {
+        return dst;
+    }
+
+    inline HalfRowWriter OutputRows(const MutableHalfImageView& dst)
+    {
+        return HalfRowWriter(dst);
+    }
+
+    template <typename View>
+    inline void FlushRow(const View&, uint32_t)
+    {
+    }
+
+    inline void FlushRow(const HalfRowWriter& output, uint32_t y)
+    {
+        FloatToHalfRow(output.Row(y), output.image.Row(y), output.width);
+    }
+
+    // 4-tap cubic (-1, 9, 9, -1) / 16 between p1 and p2, clamped to their range so
+    // thin lines and text edges don't ring
+    template <typename T>
+    inline __m128 DirectionalCubic(const T* p0, const T* p1, const T* p2, const T* p3)
+    {
+        __m128 a = LoadColor(p0);
+        __m128 b = LoadColor(p1);
+        __m128 c = LoadColor(p2);
+        __m128 d = LoadColor(p3);
+        __m128 v = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_add_ps(b, c), _mm_set1_ps(9.0f)), _mm_add_ps(a, d)), _mm_set1_ps(1.0f / 16.0f));
+        return _mm_min_ps(_mm_max_ps(v, _mm_min_ps(b, c)), _mm_max_ps(b, c));
+    }
+
+    template <typename T>
+    inline __m128 InterpolateColor(const T* const (&dir0)[4], const T* const (&dir1)[4], float weight0)
+    {
+        if (weight0 >= 1.0f)
+        {
+            return DirectionalCubic(dir0[0], dir0[1], dir0[2], dir0[3]);
+        }
+        if (weight0 <= 0.0f)
+        {
+            return DirectionalCubic(dir1[0], dir1[1], dir1[2], dir1[3]);
+        }
+        __m128 v0 = DirectionalCubic(dir0[0], dir0[1], dir0[2], dir0[3]);
+        __m128 v1 = DirectionalCubic(dir1[0], dir1[1], dir1[2], dir1[3]);
+        return _mm_add_ps(v1, _mm_mul_ps(_mm_sub_ps(v0, v1), _mm_set1_ps(weight0)));
+    }
+
+    template <typename T>
+    inline __m128 SampleBilinear(const T* row0, const T* row1, uint32_t offset0, uint32_t offset1, __m128 fx, __m128 fy)
+    {
+        __m128 p00 = LoadColor(row0 + offset0);
+        __m128 p01 = LoadColor(row0 + offset1);
+        __m128 p10 = LoadColor(row1 + offset0);
+        __m128 p11 = LoadColor(row1 + offset1);
+        __m128 top = _mm_add_ps(p00, _mm_mul_ps(_mm_sub_ps(p01, p00), fx));
+        __m128 bottom = _mm_add_ps(p10, _mm_mul_ps(_mm_sub_ps(p11, p10), fx));
+        return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy));
+    }
+
+    // GetLuminance() of the shaders on a BGRA float pixel, 0..255
+    inline float PixelLuminance(__m128 pixel)
+    {
+        __m128 v = _mm_mul_ps(pixel, _mm_setr_ps(0.114f, 0.587f, 0.299f, 0.0f));
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    // Direction detection needs gradients above SDR white too, so HDR luma is tone mapped
+    // (Reinhard, 1.0 -> 128) rather than clipped. NaN ends up 0, Inf 255
+    inline uint8_t PixelLuma(const float* pixel)
+    {
+        float luminance = PixelLuminance(_mm_loadu_ps(pixel));
+        luminance = (luminance > 0.0f) ? luminance : 0.0f;
+        return static_cast<uint8_t>(255.5f - 255.0f * 255.0f / (luminance + 255.0f));
+    }
+
+    inline void LumaRow(const uint8_t* src, uint8_t* dst, uint32_t width)
+    {
+        BgraToLumaRow(src, dst, width);
+    }
+
+    inline void LumaRow(const float* src, uint8_t* dst, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            dst[x] = PixelLuma(src + x * 4);
+        }
+    }
+
+    inline uint32_t ClampRow(int row, uint32_t height)
+    {
+        return static_cast<uint32_t>(std::min(std::max(row, 0), static_cast<int>(height) - 1));
+    }
+
+    // Fixed16 bilinear: channels are held as value * 128 in int16 lanes and lerped with Q15
+    // weights through pmulhrsw, which rounds; rows are filtered horizontally once, then each
+    // output row blends two of them
+    const int FIXED_SHIFT = 7;
+
+    inline int16_t ToFixedWeight(float weight)
+    {
+        return static_cast<int16_t>(std::min(std::lround(weight * 32768.0f), 32767L));
+    }
+
+    // Scalar pmulhrsw
+    inline int16_t MulRound(int16_t a, int16_t b)
+    {
+        return static_cast<int16_t>((a * b + 0x4000) >> 15);
+    }
+
+    inline int32_t LoadPacked(const uint8_t* pixel)
+    {
+        int32_t packed;
+        memcpy(&packed, pixel, sizeof(packed));
+        return packed;
+    }
+
+    void FilterPixelFixed(const uint8_t* row, const uint32_t* offsets, int16_t weight, int16_t* out)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            int16_t a = static_cast<int16_t>(row[offsets[0] + c] << FIXED_SHIFT);
+            int16_t b = static_cast<int16_t>(row[offsets[1] + c] << FIXED_SHIFT);
+            out[c] = static_cast<int16_t>(a + MulRound(static_cast<int16_t>(b - a), weight));
+        }
+    }
+
+    void BlendRowsFixedScalar(const int16_t* top, const int16_t* bottom, int16_t weight, uint8_t* out, uint32_t begin, uint32_t count)
+    {
+        const int round = 1 << (FIXED_SHIFT - 1);
+        for (uint32_t i = begin; i < count; i++)
+        {
+            int value = top[i] + MulRound(static_cast<int16_t>(bottom[i] - top[i]), weight);
+            out[i] = static_cast<uint8_t>(std::min(std::max((value + round) >> FIXED_SHIFT, 0), 255));
+        }
+    }
+
+    POTATO_TARGET_SSE41
+    inline __m128i LerpFixed(__m128i a, __m128i b, __m128i weight)
+    {
+        return _mm_add_epi16(a, _mm_mulhrs_epi16(_mm_sub_epi16(b, a), weight));
+    }
+
+    // 2 output pixels per step; offsets holds offset0/offset1 per column
+    POTATO_TARGET_SSE41
+    void FilterRowFixedSse41(const uint8_t* row, const uint32_t* offsets, const int16_t* weights, int16_t* out, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 2 <= width; x += 2)
+        {
+            const uint32_t* o = offsets + x * 2;
+            __m128i p0 = _mm_cvtepu8_epi16(_mm_unpacklo_epi32(_mm_cvtsi32_si128(LoadPacked(row + o[0])), _mm_cvtsi32_si128(LoadPacked(row + o[2]))));
+            __m128i p1 = _mm_cvtepu8_epi16(_mm_unpacklo_epi32(_mm_cvtsi32_si128(LoadPacked(row + o[1])), _mm_cvtsi32_si128(LoadPacked(row + o[3]))));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + x * 4));
+            __m128i v = LerpFixed(_mm_slli_epi16(p0, FIXED_SHIFT), _mm_slli_epi16(p1, FIXED_SHIFT), w);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), v);
+        }
+        for (; x < width; x++)
+        {
+            FilterPixelFixed(row, offsets + x * 2, weights[x * 4], out + x * 4);
+        }
+    }
+
+    // count is in channels
+    POTATO_TARGET_SSE41
+    void BlendRowsFixedSse41(const int16_t* top, const int16_t* bottom, int16_t weight, uint8_t* out, uint32_t count)
+    {
+        const __m128i w = _mm_set1_epi16(weight);
+        const __m128i round = _mm_set1_epi16(1 << (FIXED_SHIFT - 1));
+        uint32_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i lo = LerpFixed(_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + i)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + i)), w);
+            __m128i hi = LerpFixed(_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + i + 8)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + i + 8)), w);
+            lo = _mm_srai_epi16(_mm_add_epi16(lo, round), FIXED_SHIFT);
+            hi = _mm_srai_epi16(_mm_add_epi16(hi, round), FIXED_SHIFT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+        }
+        BlendRowsFixedScalar(top, bottom, weight, out, i, count);
+    }
+
+    POTATO_TARGET_AVX2
+    inline __m256i LerpFixedAVX2(__m256i a, __m256i b, __m256i weight)
+    {
+        return _mm256_add_epi16(a, _mm256_mulhrs_epi16(_mm256_sub_epi16(b, a), weight));
+    }
+
+    // 4 output pixels per step
+    POTATO_TARGET_AVX2
+    void FilterRowFixedAVX2(const uint8_t* row, const uint32_t* offsets, const int16_t* weights, int16_t* out, uint32_t width)
+    {
+        uint32_t x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            const uint32_t* o = offsets + x * 2;
+            __m256i p0 = _mm256_cvtepu8_epi16(_mm_setr_epi32(LoadPacked(row + o[0]), LoadPacked(row + o[2]), LoadPacked(row + o[4]), LoadPacked(row + o[6])));
+            __m256i p1 = _mm256_cvtepu8_epi16(_mm_setr_epi32(LoadPacked(row + o[1]), LoadPacked(row + o[3]), LoadPacked(row + o[5]), LoadPacked(row + o[7])));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + x * 4));
+            __m256i v = LerpFixedAVX2(_mm256_slli_epi16(p0, FIXED_SHIFT), _mm256_slli_epi16(p1, FIXED_SHIFT), w);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x * 4), v);
+        }
+        for (; x < width; x++)
+        {
+            FilterPixelFixed(row, offsets + x * 2, weights[x * 4], out + x * 4);
+        }
+    }
+
+    // packus works per 128-bit lane, so the packed halves are put back in order
+    POTATO_TARGET_AVX2
+    void BlendRowsFixedAVX2(const int16_t* top, const int16_t* bottom, int16_t weight, uint8_t* out, uint32_t count)
+    {
+        const __m256i w = _mm256_set1_epi16(weight);
+        const __m256i round = _mm256_set1_epi16(1 << (FIXED_SHIFT - 1));
+        uint32_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            __m256i lo = LerpFixedAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + i)), w);
+            __m256i hi = LerpFixedAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(top + i + 16)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bottom + i + 16)), w);
+            lo = _mm256_srai_epi16(_mm256_add_epi16(lo, round), FIXED_SHIFT);
+            hi = _mm256_srai_epi16(_mm256_add_epi16(hi, round), FIXED_SHIFT);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+        BlendRowsFixedScalar(top, bottom, weight, out, i, count);
+    }
+}
+
+CpuUpscaler::CpuUpscaler()
+    : m_pool(ThreadPool::Shared())
+{
+}
+
+CpuUpscaler::~CpuUpscaler()
+{
+}
+
+void CpuUpscaler::Bilinear(const ImageView& src, const MutableImageView& dst)
+{
+    Resample(src, dst, 0.0f);
+}
+
+void CpuUpscaler::Bilinear(const HalfImageView& src, const MutableHalfImageView& dst)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0)
+    {
+        return;
+    }
+    Resample(DecodeHalf(src), dst, 0.0f);
+}
+
+void CpuUpscaler::SetBilinearColumns(uint32_t srcWidth, uint32_t dstWidth, float offset)
+{
+    const float scaleX = static_cast<float>(srcWidth) / dstWidth;
+
+    m_bilinearColumns.resize(dstWidth);
+    for (uint32_t x = 0; x < dstWidth; x++)
+    {
+        float srcX = std::max(0.0f, (x + 0.5f) * scaleX - 0.5f + offset);
+        uint32_t x0 = std::min(static_cast<uint32_t>(srcX), srcWidth - 1);
+        uint32_t x1 = std::min(x0 + 1, srcWidth - 1);
+        m_bilinearColumns[x] = BilinearTap{ x0 * 4, x1 * 4, srcX - x0 };
+    }
+}
+
+void CpuUpscaler::Resample(const ImageView& src, const MutableImageView& dst, float offset)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0)
+    {
+        return;
+    }
+
+    SetBilinearColumns(src.width, dst.width, offset);
+
+    if (m_linearLight)
+    {
+        LinearImageView linear = DecodeLinear(src);
+        m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+        {
+            ResampleRows(linear, dst, offset, begin, end);
+        });
+        return;
+    }
+
+    if (m_bilinearPrecision == KernelPrecision::Fixed16 && GetCpuFeatures().sse41)
+    {
+        ResampleFixed(src, dst, offset);
+        return;
+    }
+
+    m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        ResampleRows(src, dst, offset, begin, end);
+    });
+}
+
+void CpuUpscaler::ResampleFixed(const ImageView& src, const MutableImageView& dst, float offset)
+{
+    m_fixedOffsets.resize(static_cast<size_t>(dst.width) * 2);
+    m_fixedWeights.resize(static_cast<size_t>(dst.width) * 4);
+    for (uint32_t x = 0; x < dst.width; x++)
+    {
+        const BilinearTap& tap = m_bilinearColumns[x];
+        m_fixedOffsets[x * 2] = tap.offset0;
+        m_fixedOffsets[x * 2 + 1] = tap.offset1;
+        std::fill_n(&m_fixedWeights[x * 4], 4, ToFixedWeight(tap.weight));
+    }
+
+    // Each band keeps its own pair of filtered rows
+    const uint32_t grain = m_pool.SuggestGrain(dst.height);
+    const uint32_t bandCount = (dst.height + grain - 1) / grain;
+    ScratchScope scratch;
+    m_fixedRows = scratch.Allocate<int16_t>(static_cast<size_t>(bandCount) * 2 * dst.width * 4);
+
+    m_pool.ParallelFor(bandCount, 1, [&](uint32_t first, uint32_t last)
+    {
+        for (uint32_t band = first; band < last; band++)
+        {
+            uint32_t begin = band * grain;
+            ResampleBandFixed(src, dst, offset, band, begin, std::min(begin + grain, dst.height));
+        }
+    });
+}
+
+void CpuUpscaler::ResampleBandFixed(const ImageView& src, const MutableImageView& dst, float offset, uint32_t band, uint32_t begin, uint32_t end)
+{
+    const bool useAvx2 = GetCpuFeatures().avx2;
+    const float scaleY = static_cast<float>(src.height) / dst.height;
+    const size_t rowSize = static_cast<size_t>(dst.width) * 4;
+    int16_t* rows[2] = { &m_fixedRows[band * 2 * rowSize], &m_fixedRows[(band * 2 + 1) * rowSize] };
+    int64_t cached[2] = { -1, -1 };
+
+    // Filtered source row, reusing the cached pair where possible (upscaling reads each
+    // source row for several output rows); keep is the other row the output row needs
+    auto fetch = [&](uint32_t row, uint32_t keep) -> const int16_t*
+    {
+        for (int slot = 0; slot < 2; slot++)
+        {
+            if (cached[slot] == row)
+            {
+                return rows[slot];
+            }
+        }
+        int slot = (cached[0] == keep) ? 1 : 0;
+        if (useAvx2)
+        {
+            FilterRowFixedAVX2(src.Row(row), m_fixedOffsets.data(), m_fixedWeights.data(), rows[slot], dst.width);
+        }
+        else
+        {
+            FilterRowFixedSse41(src.Row(row), m_fixedOffsets.data(), m_fixedWeights.data(), rows[slot], dst.width);
+        }
+        cached[slot] = row;
+        return rows[slot];
+    };
+
+    for (uint32_t y = begin; y < end; y++)
+    {
+        float srcY = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f + offset);
+        uint32_t y0 = std::min(static_cast<uint32_t>(srcY), src.height - 1);
+        uint32_t y1 = std::min(y0 + 1, src.height - 1);
+
+        const int16_t* top = fetch(y0, y1);
+        const int16_t* bottom = fetch(y1, y0);
+        if (useAvx2)
+        {
+            BlendRowsFixedAVX2(top, bottom, ToFixedWeight(srcY - y0), dst.Row(y), dst.width * 4);
+        }
+        else
+        {
+            BlendRowsFixedSse41(top, bottom, ToFixedWeight(srcY - y0), dst.Row(y), dst.width * 4);
+        }
+    }
+}
+
+void CpuUpscaler::Resample(const FloatImageView& src, const MutableHalfImageView& dst, float offset)
+{
+    ScratchScope scratch;
+    SetBilinearColumns(src.width, dst.width, offset);
+    m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        ResampleRows(src, dst, offset, begin, end);
+    });
+}
+
+template <typename Source, typename Target>
+void CpuUpscaler::ResampleRows(const Source& src, const Target& dst, float offset, uint32_t begin, uint32_t end)
+{
+    const float scaleY = static_cast<float>(src.height) / dst.height;
+    const BilinearTap* columns = m_bilinearColumns.data();
+    const SrgbTables& tables = GetSrgbTables();
+    auto output = OutputRows(dst);
+
+    for (uint32_t y = begin; y < end; y++)
+    {
+        float srcY = std::max(0.0f, (y + 0.5f) * scaleY - 0.5f + offset);
+        uint32_t y0 = std::min(static_cast<uint32_t>(srcY), src.height - 1);
+        uint32_t y1 = std::min(y0 + 1, src.height - 1);
+        __m128 fy = _mm_set1_ps(srcY - y0);
+
+        auto row0 = src.Row(y0);
+        auto row1 = src.Row(y1);
+        auto out = output.Row(y);
+
+        for (uint32_t x = 0; x < dst.width; x++)
+        {
+            const BilinearTap& tap = columns[x];
+            __m128 value = SampleBilinear(row0, row1, tap.offset0, tap.offset1, _mm_set1_ps(tap.weight), fy);
+            StoreColor(src, out + x * 4, value, tables);
+        }
+        FlushRow(output, y);
+    }
+}
+
+LinearImageView CpuUpscaler::DecodeLinear(const ImageView& src)
+{
+    const size_t pitch = static_cast<size_t>(src.width) * 4;
+    if (m_linearSource.size() < pitch * src.height)
+    {
+        m_linearSource.resize(pitch * src.height);
+    }
+
+    const int16_t* toLinear = GetSrgbTables().toLinear16;
+    int16_t* data = m_linearSource.data();
+    m_pool.ParallelFor(src.height, m_pool.SuggestGrain(src.height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint8_t* in = src.Row(y);
+            int16_t* out = data + y * pitch;
+            for (uint32_t x = 0; x < src.width * 4; x += 4)
+            {
+                out[x] = toLinear[in[x]];
+                out[x + 1] = toLinear[in[x + 1]];
+                out[x + 2] = toLinear[in[x + 2]];
+                out[x + 3] = static_cast<int16_t>(in[x + 3] * static_cast<int>(LINEAR16_SCALE));
+            }
+        }
+    });
+
+    return LinearImageView{ data, src.width, src.height, pitch };
+}
+
+FloatImageView CpuUpscaler::DecodeHalf(const HalfImageView& src)
+{
+    const size_t pitch = static_cast<size_t>(src.width) * 4;
+    if (m_floatSource.size() < pitch * src.height)
+    {
+        m_floatSource.resize(pitch * src.height);
+    }
+
+    float* data = m_floatSource.data();
+    m_pool.ParallelFor(src.height, m_pool.SuggestGrain(src.height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            HalfToFloatRow(src.Row(y), data + y * pitch, src.width);
+        }
+    });
+
+    return FloatImageView{ data, src.width, src.height, pitch };
+}
+
+void CpuUpscaler::SetFsrColumns(uint32_t srcWidth, uint32_t dstWidth)
+{
+    const float scaleX = static_cast<float>(srcWidth) / dstWidth;
+    const float maxX = static_cast<float>(srcWidth - 1);
+
+    // Neighbour taps are one source pixel away and clamped to the image like ClampToSourceRect()
+    m_fsrColumns.resize(static_cast<size_t>(dstWidth) * 3);
+    for (uint32_t x = 0; x < dstWidth; x++)
+    {
+        float centerX = (x + 0.5f) * scaleX - 0.5f;
+        for (int k = 0; k < 3; k++)
+        {
+            float srcX = std::min(std::max(centerX + k - 1, 0.0f), maxX);
+            uint32_t x0 = static_cast<uint32_t>(srcX);
+            uint32_t x1 = std::min(x0 + 1, srcWidth - 1);
+            m_fsrColumns[x * 3 + k] = BilinearTap{ x0 * 4, x1 * 4, srcX - x0 };
+        }
+    }
+}
+
+void CpuUpscaler::Fsr(const ImageView& src, const MutableImageView& dst, float sharpness)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0)
+    {
+        return;
+    }
+
+    SetFsrColumns(src.width, dst.width);
+
+    if (m_linearLight)
+    {
+        LinearImageView linear = DecodeLinear(src);
+        m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+        {
+            FsrRows(linear, dst, sharpness, begin, end);
+        });
+        return;
+    }
+
+    m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        FsrRows(src, dst, sharpness, begin, end);
+    });
+}
+
+void CpuUpscaler::Fsr(const HalfImageView& src, const MutableHalfImageView& dst, float sharpness)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0)
+    {
+        return;
+    }
+
+    SetFsrColumns(src.width, dst.width);
+
+    ScratchScope scratch;
+    FloatImageView source = DecodeHalf(src);
+    m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        FsrRows(source, dst, sharpness, begin, end);
+    });
+}
+
+template <typename Source, typename Target>
+void CpuUpscaler::FsrRows(const Source& src, const Target& dst, float sharpness, uint32_t begin, uint32_t end)
+{
+    const float scaleY = static_cast<float>(src.height) / dst.height;
+    const float maxY = static_cast<float>(src.height - 1);
+    const BilinearTap* columns = m_fsrColumns.data();
+    const SrgbTables& tables = GetSrgbTables();
+    auto output = OutputRows(dst);
+
+    for (uint32_t y = begin; y < end; y++)
+    {
+        // North, center and south rows
+        decltype(src.Row(0)) rows0[3];
+        decltype(src.Row(0)) rows1[3];
+        __m128 fy[3];
+        float centerY = (y + 0.5f) * scaleY - 0.5f;
+        for (int k = 0; k < 3; k++)
+        {
+            float srcY = std::min(std::max(centerY + k - 1, 0.0f), maxY);
+            uint32_t y0 = static_cast<uint32_t>(srcY);
+            rows0[k] = src.Row(y0);
+            rows1[k] = src.Row(std::min(y0 + 1, src.height - 1));
+            fy[k] = _mm_set1_ps(srcY - y0);
+        }
+
+        auto out = output.Row(y);
+        for (uint32_t x = 0; x < dst.width; x++)
+        {
+            const BilinearTap* tap = columns + x * 3;
+            __m128 fxCenter = _mm_set1_ps(tap[1].weight);
+            __m128 center = SampleBilinear(rows0[1], rows1[1], tap[1].offset0, tap[1].offset1, fxCenter, fy[1]);
+            __m128 north = SampleBilinear(rows0[0], rows1[0], tap[1].offset0, tap[1].offset1, fxCenter, fy[0]);
+            __m128 south = SampleBilinear(rows0[2], rows1[2], tap[1].offset0, tap[1].offset1, fxCenter, fy[2]);
+            __m128 west = SampleBilinear(rows0[1], rows1[1], tap[0].offset0, tap[0].offset1, _mm_set1_ps(tap[0].weight), fy[1]);
+            __m128 east = SampleBilinear(rows0[1], rows1[1], tap[2].offset0, tap[2].offset1, _mm_set1_ps(tap[2].weight), fy[1]);
+
+            float lumCenter = PixelLuminance(center);
+            float lumNorth = PixelLuminance(north);
+            float lumSouth = PixelLuminance(south);
+            float lumEast = PixelLuminance(east);
+            float lumWest = PixelLuminance(west);
+            float lumMin = std::min(lumCenter, std::min(std::min(lumNorth, lumSouth), std::min(lumEast, lumWest)));
+            float lumMax = std::max(lumCenter, std::max(std::max(lumNorth, lumSouth), std::max(lumEast, lumWest)));
+
+            float edgeStrength = std::min((lumMax - lumMin) * (4.0f / 255.0f), 1.0f);
+            __m128 amount = _mm_set1_ps(sharpness * edgeStrength);
+
+            __m128 neighbours = _mm_mul_ps(_mm_add_ps(_mm_add_ps(north, south), _mm_add_ps(east, west)), _mm_set1_ps(0.25f));
+            __m128 sharpened = _mm_add_ps(center, _mm_mul_ps(_mm_sub_ps(center, neighbours), amount));
+
+            __m128 minColor = _mm_min_ps(center, _mm_min_ps(_mm_min_ps(north, south), _mm_min_ps(east, west)));
+            __m128 maxColor = _mm_max_ps(center, _mm_max_ps(_mm_max_ps(north, south), _mm_max_ps(east, west)));
+            StoreColor(src, out + x * 4, _mm_min_ps(_mm_max_ps(sharpened, minColor), maxColor), tables);
+        }
+        FlushRow(output, y);
+    }
+}
+
+MutableImageView CpuUpscaler::GetStageBuffer(const ImageView&, int index, uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t>& buffer = m_stage[index];
+    size_t size = static_cast<size_t>(width) * height * 4;
+    if (buffer.size() < size)
+    {
+        buffer.resize(size);
+    }
+    return MutableImageView{ buffer.data(), width, height, static_cast<size_t>(width) * 4 };
+}
+
+MutableFloatImageView CpuUpscaler::GetStageBuffer(const FloatImageView&, int index, uint32_t width, uint32_t height)
+{
+    std::vector<float>& buffer = m_floatStage[index];
+    size_t size = static_cast<size_t>(width) * height * 4;
+    if (buffer.size() < size)
+    {
+        buffer.resize(size);
+    }
+    return MutableFloatImageView{ buffer.data(), width, height, static_cast<size_t>(width) * 4 };
+}
+
+void CpuUpscaler::EdgeDirected(const ImageView& src, const MutableImageView& dst)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0)
+    {
+        return;
+    }
+    EdgeDirectedSteps(src, dst);
+}
+
+void CpuUpscaler::EdgeDirected(const HalfImageView& src, const MutableHalfImageView& dst)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0)
+    {
+        return;
+    }
+    ScratchScope scratch;
+    EdgeDirectedSteps(DecodeHalf(src), dst);
+}
+
+template <typename Image, typename Target>
+void CpuUpscaler::EdgeDirectedSteps(const Image& src, const Target& dst)
+{
+    Image current = src;
+    int stage = 0;
+
+    // Keep doubling while the result doesn't overshoot the target by more than 25%
+    do
+    {
+        uint32_t width = current.width * 2;
+        uint32_t height = current.height * 2;
+
+        if (width == dst.width && height == dst.height)
+        {
+            EdgeDirected2x(current, dst);
+            return;
+        }
+
+        auto target = GetStageBuffer(src, stage, width, height);
+        EdgeDirected2x(current, target);
+        current = target;
+        stage ^= 1;
+    } while (current.width * 2 * 4 <= dst.width * 5 && current.height * 2 * 4 <= dst.height * 5);
+
+    // Residual non-integer factor
+    // The 2x passes keep source pixels on even output pixels (corner aligned), so pixel j of
+    // an s-times buffer sits at source position j / s rather than (j + 0.5) / s - 0.5
+    float scale = static_cast<float>(current.width) / src.width;
+    Resample(current, dst, -(scale - 1.0f) * 0.5f);
+}
+
+template <typename Image>
+void CpuUpscaler::BuildPaddedLuma(const Image& src, std::vector<uint8_t>& luma)
+{
+    const uint32_t paddedWidth = src.width + 2 * LUMA_PAD;
+    luma.resize(static_cast<size_t>(paddedWidth) * (src.height + 2 * LUMA_PAD));
+
+    m_pool.ParallelFor(src.height, m_pool.SuggestGrain(src.height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            uint8_t* out = &luma[(y + LUMA_PAD) * paddedWidth + LUMA_PAD];
+            LumaRow(src.Row(y), out, src.width);
+            out[-1] = out[-2] = out[0];
+            out[src.width] = out[src.width + 1] = out[src.width - 1];
+        }
+    });
+
+    PadLumaRows(luma, src.width, src.height);
+}
+
+void CpuUpscaler::PadLumaRows(std::vector<uint8_t>& luma, uint32_t width, uint32_t height)
+{
+    const size_t paddedWidth = width + 2 * LUMA_PAD;
+    uint8_t* first = &luma[LUMA_PAD * paddedWidth];
+    uint8_t* last = &luma[(height + LUMA_PAD - 1) * paddedWidth];
+    for (uint32_t i = 1; i <= LUMA_PAD; i++)
+    {
+        std::copy(first, first + paddedWidth, first - i * paddedWidth);
+        std::copy(last, last + paddedWidth, last + i * paddedWidth);
+    }
+}
+
+void CpuUpscaler::SetColumnOffsets(uint32_t width)
+{
+    m_columnOffsets.resize(width + 2 * LUMA_PAD);
+    for (uint32_t i = 0; i < width + 2 * LUMA_PAD; i++)
+    {
+        m_columnOffsets[i] = ClampRow(static_cast<int>(i) - static_cast<int>(LUMA_PAD), width) * 4;
+    }
+}
+
+void CpuUpscaler::EdgeDirected2x(const ImageView& src, const MutableImageView& dst)
+{
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+
+    SetColumnOffsets(width);
+    BuildPaddedLuma(src, m_luma);
+
+    m_diagonal.resize(static_cast<size_t>(width) * height * 4);
+    m_diagonalLuma.resize(m_luma.size());
+
+    // Direction detection stays on the encoded luma, only the interpolation changes space
+    if (m_linearLight)
+    {
+        m_diagonalLinear.resize(m_diagonal.size());
+        LinearImageView diagonal{ m_diagonalLinear.data(), width, height, static_cast<size_t>(width) * 4 };
+        EdgeDirectedPasses(src, DecodeLinear(src), diagonal, dst);
+    }
+    else
+    {
+        ImageView diagonal{ m_diagonal.data(), width, height, static_cast<size_t>(width) * 4 };
+        EdgeDirectedPasses(src, src, diagonal, dst);
+    }
+}
+
+template <typename Target>
+void CpuUpscaler::EdgeDirected2x(const FloatImageView& src, const Target& dst)
+{
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+
+    SetColumnOffsets(width);
+    BuildPaddedLuma(src, m_luma);
+
+    m_diagonalFloat.resize(static_cast<size_t>(width) * height * 4);
+    m_diagonalLuma.resize(m_luma.size());
+
+    FloatImageView diagonal{ m_diagonalFloat.data(), width, height, static_cast<size_t>(width) * 4 };
+    EdgeDirectedPasses(src, src, diagonal, dst);
+}
+
+template <typename Image, typename Source, typename Target>
+void CpuUpscaler::EdgeDirectedPasses(const Image& src, const Source& source, const Source& diagonal, const Target& dst)
+{
+    // Pass 1: the center of every 2x2 source quad, interpolated along the diagonals
+    m_pool.ParallelFor(src.height, m_pool.SuggestGrain(src.height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            DiagonalPass(src, source, y);
+        }
+    });
+    PadLumaRows(m_diagonalLuma, src.width, src.height);
+
+    // Pass 2: the horizontal and vertical midpoints, now surrounded by known pixels
+    m_pool.ParallelFor(src.height, m_pool.SuggestGrain(src.height), [&](uint32_t begin, uint32_t end)
+    {
+        auto output = OutputRows(dst);
+        for (uint32_t y = begin; y < end; y++)
+        {
+            MidpointPass(src, source, diagonal, output, y);
+        }
+    });
+}
+
+template <typename Image, typename Source>
+void CpuUpscaler::DiagonalPass(const Image& image, const Source& src, uint32_t y)
+{
+    const SrgbTables& tables = GetSrgbTables();
+    const uint32_t width = src.width;
+    const uint32_t paddedWidth = width + 2 * LUMA_PAD;
+    const uint32_t* cols = m_columnOffsets.data() + LUMA_PAD;
+
+    // Luma rows y-1..y+2 (pointing at column 0) and matching pixel rows
+    using Pixel = typename std::remove_pointer<decltype(src.Row(0))>::type;
+    const uint8_t* L[4];
+    Pixel* P[4];
+    for (int k = 0; k < 4; k++)
+    {
+        L[k] = &m_luma[(y + k - 1 + LUMA_PAD) * paddedWidth + LUMA_PAD];
+        P[k] = src.Row(ClampRow(static_cast<int>(y) + k - 1, src.height));
+    }
+
+    // Gradients over the 3x3 pairs around the quad, along the down-right and up-right diagonals
+    DiffTerm downRight[9];
+    DiffTerm upRight[9];
+    int term = 0;
+    for (int r = 0; r < 3; r++)
+    {
+        for (int dc = -1; dc <= 1; dc++)
+        {
+            downRight[term] = DiffTerm{ L[r] + dc, L[r + 1] + dc + 1 };
+            upRight[term] = DiffTerm{ L[r] + dc + 1, L[r + 1] + dc };
+            term++;
+        }
+    }
+
+    auto out = DiagonalPixels(image) + static_cast<size_t>(y) * width * 4;
+    uint8_t* outLuma = &m_diagonalLuma[(y + LUMA_PAD) * paddedWidth + LUMA_PAD];
+
+    uint16_t gradientDown[SEGMENT];
+    uint16_t gradientUp[SEGMENT];
+
+    for (uint32_t start = 0; start < width; start += SEGMENT)
+    {
+        uint32_t count = std::min(SEGMENT, width - start);
+        SumAbsDiffs(downRight, start, count, gradientDown);
+        SumAbsDiffs(upRight, start, count, gradientUp);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            int x = static_cast<int>(start + i);
+            Pixel* const alongDown[4] = { P[0] + cols[x - 1], P[1] + cols[x], P[2] + cols[x + 1], P[3] + cols[x + 2] };
+            Pixel* const alongUp[4] = { P[3] + cols[x - 1], P[2] + cols[x], P[1] + cols[x + 1], P[0] + cols[x + 2] };
+
+            auto pixel = out + x * 4;
+            __m128 value = InterpolateColor(alongDown, alongUp, DirectionWeight(gradientDown[i], gradientUp[i]));
+            StoreColor(src, pixel, value, tables);
+            StoreFiltered(src, m_diagonalLinear, (static_cast<size_t>(y) * width + x) * 4, value);
+            outLuma[x] = PixelLuma(pixel);
+        }
+    }
+
+    outLuma[-1] = outLuma[-2] = outLuma[0];
+    outLuma[width] = outLuma[width + 1] = outLuma[width - 1];
+}
+
+template <typename Image, typename Source, typename Target>
+void CpuUpscaler::MidpointPass(const Image& src, const Source& source, const Source& diagonal, const Target& dst, uint32_t y)
+{
+    using Pixel = typename std::remove_pointer<decltype(source.Row(0))>::type;
+    const SrgbTables& tables = GetSrgbTables();
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+    const uint32_t paddedWidth = width + 2 * LUMA_PAD;
+    const size_t diagonalPitch = static_cast<size_t>(width) * 4;
+    const uint32_t* cols = m_columnOffsets.data() + LUMA_PAD;
+
+    // Source rows y-1..y+2 and diagonal rows y-2..y+1, in the filtering space for
+    // interpolation (P, D) and encoded for the pixels copied through unchanged
+    const uint8_t* LP[4];
+    const uint8_t* LD[4];
+    Pixel* P[4];
+    Pixel* D[4];
+    for (int k = 0; k < 4; k++)
+    {
+        LP[k] = &m_luma[(y + k - 1 + LUMA_PAD) * paddedWidth + LUMA_PAD];
+        LD[k] = &m_diagonalLuma[(y + k - 2 + LUMA_PAD) * paddedWidth + LUMA_PAD];
+        P[k] = source.Row(ClampRow(static_cast<int>(y) + k - 1, height));
+        D[k] = diagonal.Row(ClampRow(static_cast<int>(y) + k - 2, height));
+    }
+    auto sourceRow = src.Row(y);
+    const auto* diagonalRow = DiagonalPixels(src) + y * diagonalPitch;
+
+    // Output row 2y: odd pixels sit between P(x,y) and P(x+1,y) horizontally
+    // and between D(x,y-1) and D(x,y) vertically
+    const DiffTerm evenRowH[7] = {
+        { LP[1] - 1, LP[1] }, { LP[1], LP[1] + 1 }, { LP[1] + 1, LP[1] + 2 },
+        { LD[1] - 1, LD[1] }, { LD[1], LD[1] + 1 }, { LD[2] - 1, LD[2] }, { LD[2], LD[2] + 1 }
+    };
+    const DiffTerm evenRowV[7] = {
+        { LD[0], LD[1] }, { LD[1], LD[2] }, { LD[2], LD[3] },
+        { LP[0], LP[1] }, { LP[1], LP[2] }, { LP[0] + 1, LP[1] + 1 }, { LP[1] + 1, LP[2] + 1 }
+    };
+
+    // Output row 2y+1: even pixels sit between P(x,y) and P(x,y+1) vertically
+    // and between D(x-1,y) and D(x,y) horizontally
+    const DiffTerm oddRowV[7] = {
+        { LP[0], LP[1] }, { LP[1], LP[2] }, { LP[2], LP[3] },
+        { LD[1] - 1, LD[2] - 1 }, { LD[2] - 1, LD[3] - 1 }, { LD[1], LD[2] }, { LD[2], LD[3] }
+    };
+    const DiffTerm oddRowH[7] = {
+        { LD[2] - 2, LD[2] - 1 }, { LD[2] - 1, LD[2] }, { LD[2], LD[2] + 1 },
+        { LP[1] - 1, LP[1] }, { LP[1], LP[1] + 1 }, { LP[2] - 1, LP[2] }, { LP[2], LP[2] + 1 }
+    };
+
+    auto evenRow = dst.Row(2 * y);
+    auto oddRow = dst.Row(2 * y + 1);
+
+    uint16_t gradientH[SEGMENT];
+    uint16_t gradientV[SEGMENT];
+
+    for (uint32_t start = 0; start < width; start += SEGMENT)
+    {
+        uint32_t count = std::min(SEGMENT, width - start);
+
+        SumAbsDiffs(evenRowH, start, count, gradientH);
+        SumAbsDiffs(evenRowV, start, count, gradientV);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            int x = static_cast<int>(start + i);
+            Pixel* const alongH[4] = { P[1] + cols[x - 1], P[1] + cols[x], P[1] + cols[x + 1], P[1] + cols[x + 2] };
+            Pixel* const alongV[4] = { D[0] + cols[x], D[1] + cols[x], D[2] + cols[x], D[3] + cols[x] };
+
+            CopyPixel(evenRow + x * 8, sourceRow + x * 4);
+            StoreColor(source, evenRow + x * 8 + 4, InterpolateColor(alongH, alongV, DirectionWeight(gradientH[i], gradientV[i])), tables);
+        }
+
+        SumAbsDiffs(oddRowH, start, count, gradientH);
+        SumAbsDiffs(oddRowV, start, count, gradientV);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            int x = static_cast<int>(start + i);
+            Pixel* const alongV[4] = { P[0] + cols[x], P[1] + cols[x], P[2] + cols[x], P[3] + cols[x] };
+            Pixel* const alongH[4] = { D[2] + cols[x - 2], D[2] + cols[x - 1], D[2] + cols[x], D[2] + cols[x + 1] };
+
+            StoreColor(source, oddRow + x * 8, InterpolateColor(alongV, alongH, DirectionWeight(gradientV[i], gradientH[i])), tables);
+            CopyPixel(oddRow + x * 8 + 4, diagonalRow + x * 4);
+        }
+    }
+
+    FlushRow(dst, 2 * y);
+    FlushRow(dst, 2 * y + 1);
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include "ImageView.h"
+#include "ColorSpace.h"
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// An RGBA16F image decoded to floats for the kernels: BGRA order like the 8-bit frames, and
+// 1.0 maps to 255 so the kernels' constants apply unchanged; HDR values above 255 are kept
+// (pitch is in elements)
+struct FloatImageView
+{
+    const float* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    const float* Row(uint32_t y) const { return data + y * pitch; }
+};
+
+struct MutableFloatImageView
+{
+    float* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    float* Row(uint32_t y) const { return data + y * pitch; }
+    operator FloatImageView() const { return FloatImageView{ data, width, height, pitch }; }
+};
+
+// CPU upscaling kernels for BGRA8 and RGBA16F frames, parallelised over rows on the shared thread pool
+// Used for the methods that don't map well to a single compute shader pass
+class CpuUpscaler
+{
+public:
+    CpuUpscaler();
+    ~CpuUpscaler();
+
+    // Plain bilinear resample to the size of dst (any ratio, up or down)
+    void Bilinear(const ImageView& src, const MutableImageView& dst);
+
+    // Edge-directed upscale for text and thin UI lines
+    // Runs one or more 2x directional interpolation passes, then a bilinear
+    // resample covers the remaining non-integer factor
+    void EdgeDirected(const ImageView& src, const MutableImageView& dst);
+
+    // Same filter as the FSR compute shader (bilinear + contrast adaptive sharpening)
+    // The benchmark uses it to compare the CPU methods against the GPU default
+    void Fsr(const ImageView& src, const MutableImageView& dst, float sharpness);
+
+    // Filter in linear light (sRGB decoded through a LUT on load, encoded on store)
+    // instead of on the gamma-encoded values, which darkens high contrast edges
+    void SetLinearLight(bool enabled) { m_linearLight = enabled; }
+    bool IsLinearLight() const { return m_linearLight; }
+
+    // Arithmetic of the 8-bit bilinear resample (also the residual step of Edge-Directed)
+    // Fixed16 needs SSE4.1; linear-light and HDR resampling always use floats
+    void SetBilinearPrecision(KernelPrecision precision) { m_bilinearPrecision = precision; }
+    KernelPrecision GetBilinearPrecision() const { return m_bilinearPrecision; }
+
+    // HDR frames: same filters on half floats, values above 1.0 are preserved
+    // Linear light doesn't apply, FP16 desktops are already linear (scRGB)
+    void Bilinear(const HalfImageView& src, const MutableHalfImageView& dst);
+    void EdgeDirected(const HalfImageView& src, const MutableHalfImageView& dst);
+    void Fsr(const HalfImageView& src, const MutableHalfImageView& dst, float sharpness);
+
+private:
+    struct BilinearTap
+    {
+        uint32_t offset0;  // Element offsets of the two source columns (4 per pixel)
+        uint32_t offset1;
+        float weight;      // Weight of offset1
+    };
+
+    // Bilinear with the source grid shifted by offset pixels
+    void Resample(const ImageView& src, const MutableImageView& dst, float offset);
+    void Resample(const FloatImageView& src, const MutableHalfImageView& dst, float offset);
+    void SetBilinearColumns(uint32_t srcWidth, uint32_t dstWidth, float offset);
+    void SetFsrColumns(uint32_t srcWidth, uint32_t dstWidth);
+    template <typename Source, typename Target>
+    void ResampleRows(const Source& src, const Target& dst, float offset, uint32_t begin, uint32_t end);
+    void ResampleFixed(const ImageView& src, const MutableImageView& dst, float offset);
+    void ResampleBandFixed(const ImageView& src, const MutableImageView& dst, float offset, uint32_t band, uint32_t begin, uint32_t end);
+    template <typename Source, typename Target>
+    void FsrRows(const Source& src, const Target& dst, float sharpness, uint32_t begin, uint32_t end);
+
+    // Decode src into m_linearSource / m_floatSource; valid until the next call
+    LinearImageView DecodeLinear(const ImageView& src);
+    FloatImageView DecodeHalf(const HalfImageView& src);
+
+    // Doubling passes followed by the residual resample
+    template <typename Image, typename Target>
+    void EdgeDirectedSteps(const Image& src, const Target& dst);
+
+    // Exact 2x pass (dst must be 2 * src in both dimensions)
+    void EdgeDirected2x(const ImageView& src, const MutableImageView& dst);
+    template <typename Target>
+    void EdgeDirected2x(const FloatImageView& src, const Target& dst);
+    template <typename Image, typename Source, typename Target>
+    void EdgeDirectedPasses(const Image& src, const Source& source, const Source& diagonal, const Target& dst);
+    template <typename Image, typename Source>
+    void DiagonalPass(const Image& src, const Source& source, uint32_t row);
+    template <typename Image, typename Source, typename Target>
+    void MidpointPass(const Image& src, const Source& source, const Source& diagonal, const Target& dst, uint32_t row);
+    void SetColumnOffsets(uint32_t width);
+    template <typename Image>
+    void BuildPaddedLuma(const Image& src, std::vector<uint8_t>& luma);
+    void PadLumaRows(std::vector<uint8_t>& luma, uint32_t width, uint32_t height);
+
+    // Pass 1 results in the format of the image being upscaled
+    uint8_t* DiagonalPixels(const ImageView&) { return m_diagonal.data(); }
+    float* DiagonalPixels(const FloatImageView&) { return m_diagonalFloat.data(); }
+
+    // Intermediate between 2x passes, in the format of the image being upscaled
+    MutableImageView GetStageBuffer(const ImageView&, int index, uint32_t width, uint32_t height);
+    MutableFloatImageView GetStageBuffer(const FloatImageView&, int index, uint32_t width, uint32_t height);
+
+private:
+    ThreadPool& m_pool;
+    bool m_linearLight = false;
+    KernelPrecision m_bilinearPrecision = KernelPrecision::Float;
+
+    // Edge-directed intermediates, reused between frames
+    std::vector<uint8_t> m_luma;          // Source luma with a 2 pixel replicated border
+    std::vector<uint8_t> m_diagonal;      // Pixels at the centers of each 2x2 source quad
+    std::vector<uint8_t> m_diagonalLuma;  // Their luma, same padding as m_luma
+    std::vector<int16_t> m_diagonalLinear;  // Same pixels in linear light (linear-light mode)
+    std::vector<float> m_diagonalFloat;     // Same pixels for HDR frames
+    std::vector<uint32_t> m_columnOffsets;  // Clamped element offsets for columns -2..width+1
+    std::vector<uint8_t> m_stage[2];      // Between 2x passes and before the residual resample
+    std::vector<float> m_floatStage[2];   // Same for HDR frames
+
+    std::vector<int16_t> m_linearSource;  // Source decoded to linear light (linear-light mode)
+    std::vector<float> m_floatSource;     // HDR source decoded from half floats
+
+    std::vector<BilinearTap> m_bilinearColumns;
+    std::vector<uint32_t> m_fixedOffsets;  // Fixed16 resample: offset0/offset1 per column
+    std::vector<int16_t> m_fixedWeights;   // Q15 weight of offset1, repeated for the 4 channels
+    int16_t* m_fixedRows = nullptr;        // Two horizontally filtered source rows per band (scratch)
+    std::vector<BilinearTap> m_fsrColumns;  // West, center and east tap per output column
+};
@@ -1,11 +1,43 @@
 #include "D3D11Upscaler.h"
+#include "ColorSpace.h"
+#include "FramePool.h"
+#include "PixelConvert.h"
 #include "../Utils/Logger.h"
 #include <d3dcompiler.h>
+#include <algorithm>
 #include <fstream>
 #include <vector>
 
 #pragma comment(lib, "d3dcompiler.lib")
 
+// Capture formats the CPU kernels can take after converting to BGRA8
+static bool GetCpuPixelFormat(DXGI_FORMAT format, PixelFormat& pixelFormat)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+        pixelFormat = PixelFormat::Bgra8;
+        return true;
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+        pixelFormat = PixelFormat::Rgba8;
+        return true;
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+        pixelFormat = PixelFormat::Rgb10A2;
+        return true;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        pixelFormat = PixelFormat::Rgba16F;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Capture formats that can carry values the 8-bit kernels would clip
+static bool IsHdrFormat(DXGI_FORMAT format)
+{
+    return format == DXGI_FORMAT_R10G10B10A2_UNORM || format == DXGI_FORMAT_R16G16B16A16_FLOAT;
+}
+
 // Embedded shader source for bilinear upscaling
 static const char* s_bilinearShaderSource = R"(
 Texture2D<float4> InputTexture : register(t0);
@@ -14,14 +46,76 @@ SamplerState LinearSampler : register(s0);
 
 cbuffer Constants : register(b0)
 {
-    float inputWidth;
+    float inputWidth;    // Size of the source rect being upscaled
     float inputHeight;
     float outputWidth;
     float outputHeight;
     float sharpness;
-    float3 padding;
+    float2 inputOffset;  // Top-left of the source rect in the input texture
+    float padding;
+    float2 textureSize;  // Full input texture size
+    float2 padding2;
 };
 
+// Map an output pixel to a UV inside the source rect of the input texture
+float2 OutputToInputUV(uint2 outputPos)
+{
+    float2 rectPos = (float2(outputPos) + 0.5f) / float2(outputWidth, outputHeight) * float2(inputWidth, inputHeight);
+    return (inputOffset + rectPos) / textureSize;
+}
+
+// Keep taps inside the source rect so cropped bars don't bleed into the edges
+float2 ClampToSourceRect(float2 uv)
+{
+    float2 minUV = (inputOffset + 0.5f) / textureSize;
+    float2 maxUV = (inputOffset + float2(inputWidth, inputHeight) - 0.5f) / textureSize;
+    return clamp(uv, minUV, maxUV);
+}
+
+// Linear-light variant (LINEAR_LIGHT=1): the taps are decoded before filtering and the
+// result encoded again, through the same tables as the CPU kernels
+#if LINEAR_LIGHT
+Buffer<float> SrgbToLinear : register(t1);  // 256 entries
+Buffer<float> LinearToSrgb : register(t2);  // 4096 entries
+
+float4 LoadLinear(int2 pos)
+{
+    float4 texel = InputTexture.Load(int3(pos, 0));
+    uint3 index = (uint3)(texel.rgb * 255.0f + 0.5f);
+    return float4(SrgbToLinear[index.r], SrgbToLinear[index.g], SrgbToLinear[index.b], texel.a);
+}
+
+// The sampler would filter the encoded values, so the bilinear taps are done by hand
+float4 SampleSource(float2 uv)
+{
+    float2 pos = uv * textureSize - 0.5f;
+    float2 f = frac(pos);
+    int2 maxPos = int2(textureSize) - 1;
+    int2 p0 = int2(floor(pos));
+    int2 p1 = clamp(p0 + 1, 0, maxPos);
+    p0 = clamp(p0, 0, maxPos);
+    float4 top = lerp(LoadLinear(p0), LoadLinear(int2(p1.x, p0.y)), f.x);
+    float4 bottom = lerp(LoadLinear(int2(p0.x, p1.y)), LoadLinear(p1), f.x);
+    return lerp(top, bottom, f.y);
+}
+
+float4 EncodeOutput(float4 color)
+{
+    uint3 index = (uint3)(saturate(color.rgb) * 4095.0f + 0.5f);
+    return float4(LinearToSrgb[index.r], LinearToSrgb[index.g], LinearToSrgb[index.b], color.a);
+}
+#else
+float4 SampleSource(float2 uv)
+{
+    return InputTexture.SampleLevel(LinearSampler, uv, 0);
+}
+
+float4 EncodeOutput(float4 color)
+{
+    return color;
+}
+#endif
+
 [numthreads(8, 8, 1)]
 void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
 {
@@ -31,12 +125,12 @@ void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
         return;
 
     // Calculate UV coordinates
-    float2 uv = (float2(outputPos) + 0.5f) / float2(outputWidth, outputHeight);
+    float2 uv = OutputToInputUV(outputPos);
 
     // Sample with bilinear filtering
-    float4 color = InputTexture.SampleLevel(LinearSampler, uv, 0);
+    float4 color = SampleSource(uv);
 
-    OutputTexture[outputPos] = color;
+    OutputTexture[outputPos] = EncodeOutput(color);
 }
 )";
 
@@ -48,14 +142,76 @@ SamplerState LinearSampler : register(s0);
 
 cbuffer Constants : register(b0)
 {
-    float inputWidth;
+    float inputWidth;    // Size of the source rect being upscaled
     float inputHeight;
     float outputWidth;
     float outputHeight;
     float sharpness;
-    float3 padding;
+    float2 inputOffset;  // Top-left of the source rect in the input texture
+    float padding;
+    float2 textureSize;  // Full input texture size
+    float2 padding2;
 };
 
+// Map an output pixel to a UV inside the source rect of the input texture
+float2 OutputToInputUV(uint2 outputPos)
+{
+    float2 rectPos = (float2(outputPos) + 0.5f) / float2(outputWidth, outputHeight) * float2(inputWidth, inputHeight);
+    return (inputOffset + rectPos) / textureSize;
+}
+
+// Keep taps inside the source rect so cropped bars don't bleed into the edges
+float2 ClampToSourceRect(float2 uv)
+{
+    float2 minUV = (inputOffset + 0.5f) / textureSize;
+    float2 maxUV = (inputOffset + float2(inputWidth, inputHeight) - 0.5f) / textureSize;
+    return clamp(uv, minUV, maxUV);
+}
+
+// Linear-light variant (LINEAR_LIGHT=1): the taps are decoded before filtering and the
+// result encoded again, through the same tables as the CPU kernels
+#if LINEAR_LIGHT
+Buffer<float> SrgbToLinear : register(t1);  // 256 entries
+Buffer<float> LinearToSrgb : register(t2);  // 4096 entries
+
+float4 LoadLinear(int2 pos)
+{
+    float4 texel = InputTexture.Load(int3(pos, 0));
+    uint3 index = (uint3)(texel.rgb * 255.0f + 0.5f);
+    return float4(SrgbToLinear[index.r], SrgbToLinear[index.g], SrgbToLinear[index.b], texel.a);
+}
+
+// The sampler would filter the encoded values, so the bilinear taps are done by hand
+float4 SampleSource(float2 uv)
+{
+    float2 pos = uv * textureSize - 0.5f;
+    float2 f = frac(pos);
+    int2 maxPos = int2(textureSize) - 1;
+    int2 p0 = int2(floor(pos));
+    int2 p1 = clamp(p0 + 1, 0, maxPos);
+    p0 = clamp(p0, 0, maxPos);
+    float4 top = lerp(LoadLinear(p0), LoadLinear(int2(p1.x, p0.y)), f.x);
+    float4 bottom = lerp(LoadLinear(int2(p0.x, p1.y)), LoadLinear(p1), f.x);
+    return lerp(top, bottom, f.y);
+}
+
+float4 EncodeOutput(float4 color)
+{
+    uint3 index = (uint3)(saturate(color.rgb) * 4095.0f + 0.5f);
+    return float4(LinearToSrgb[index.r], LinearToSrgb[index.g], LinearToSrgb[index.b], color.a);
+}
+#else
+float4 SampleSource(float2 uv)
+{
+    return InputTexture.SampleLevel(LinearSampler, uv, 0);
+}
+
+float4 EncodeOutput(float4 color)
+{
+    return color;
+}
+#endif
+
 // Calculate luminance for edge detection
 float GetLuminance(float3 color)
 {
@@ -65,17 +221,16 @@ float GetLuminance(float3 color)
 // FSR-inspired Robust Contrast Adaptive Sharpening (RCAS)
 float4 FSRUpscale(float2 uv)
 {
-    float2 inputSize = float2(inputWidth, inputHeight);
-    float2 texelSize = 1.0f / inputSize;
+    float2 texelSize = 1.0f / textureSize;
     
     // Get the center sample
-    float4 center = InputTexture.SampleLevel(LinearSampler, uv, 0);
+    float4 center = SampleSource(uv);
     
     // Sample cross neighborhood for edge detection
-    float4 north = InputTexture.SampleLevel(LinearSampler, uv + float2(0, -texelSize.y), 0);
-    float4 south = InputTexture.SampleLevel(LinearSampler, uv + float2(0, texelSize.y), 0);
-    float4 east = InputTexture.SampleLevel(LinearSampler, uv + float2(texelSize.x, 0), 0);
-    float4 west = InputTexture.SampleLevel(LinearSampler, uv + float2(-texelSize.x, 0), 0);
+    float4 north = SampleSource(ClampToSourceRect(uv + float2(0, -texelSize.y)));
+    float4 south = SampleSource(ClampToSourceRect(uv + float2(0, texelSize.y)));
+    float4 east = SampleSource(ClampToSourceRect(uv + float2(texelSize.x, 0)));
+    float4 west = SampleSource(ClampToSourceRect(uv + float2(-texelSize.x, 0)));
     
     // Calculate luminance values
     float lumCenter = GetLuminance(center.rgb);
@@ -111,7 +266,7 @@ float4 FSRUpscale(float2 uv)
 // Enhanced upscaling with edge-aware interpolation
 float4 FSREdgeAware(float2 uv)
 {
-    float2 inputSize = float2(inputWidth, inputHeight);
+    float2 inputSize = textureSize;
     float2 outputSize = float2(outputWidth, outputHeight);
     float2 texelSize = 1.0f / inputSize;
     
@@ -133,7 +288,7 @@ float4 FSREdgeAware(float2 uv)
         {
             int idx = (y + 1) * 4 + (x + 1);
             float2 samplePos = (inputPosFloor + float2(x, y) + 0.5f) / inputSize;
-            samplePos = saturate(samplePos);
+            samplePos = ClampToSourceRect(samplePos);
             samples[idx] = InputTexture.SampleLevel(LinearSampler, samplePos, 0);
             
             // Mitchell-Netravali-like filter weights
@@ -181,12 +336,58 @@ void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
     if (outputPos.x >= (uint)outputWidth || outputPos.y >= (uint)outputHeight)
         return;
 
-    float2 uv = (float2(outputPos) + 0.5f) / float2(outputWidth, outputHeight);
+    float2 uv = OutputToInputUV(outputPos);
     
     // Use edge-aware upscaling
     float4 color = FSRUpscale(uv);
     
-    OutputTexture[outputPos] = color;
+    OutputTexture[outputPos] = EncodeOutput(color);
+}
+)";
+
+// Contrast adaptive sharpening at native resolution, same math as CasSharpener on the CPU
+// Reads the captured frame and writes straight into the target, so no intermediate texture
+static const char* s_casShaderSource = R"(
+Texture2D<float4> InputTexture : register(t0);
+RWTexture2D<float4> OutputTexture : register(u0);
+
+cbuffer SharpenConstants : register(b0)
+{
+    int2 sourceOffset;  // Source rect top-left in the input
+    int2 targetOffset;  // Top-left in the output
+    int2 size;          // Rect size
+    float peak;         // -1/8 (soft) to -1/5 (sharp)
+    float padding;
+};
+
+float3 LoadClamped(int2 pos)
+{
+    return InputTexture.Load(int3(clamp(pos, sourceOffset, sourceOffset + size - 1), 0)).rgb;
+}
+
+[numthreads(8, 8, 1)]
+void CSMain(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    if (dispatchThreadID.x >= (uint)size.x || dispatchThreadID.y >= (uint)size.y)
+        return;
+
+    int2 pos = sourceOffset + int2(dispatchThreadID.xy);
+    float4 center = InputTexture.Load(int3(pos, 0));
+    float3 e = center.rgb;
+    float3 b = LoadClamped(pos + int2(0, -1));
+    float3 d = LoadClamped(pos + int2(-1, 0));
+    float3 f = LoadClamped(pos + int2(1, 0));
+    float3 h = LoadClamped(pos + int2(0, 1));
+
+    float3 mn = min(e, min(min(b, d), min(f, h)));
+    float3 mx = max(e, max(max(b, d), max(f, h)));
+
+    // Less sharpening where the neighbourhood is close to clipping
+    float3 amp = saturate(min(mn, 1.0f - mx) / max(mx, 1.0f / 255.0f));
+    float3 weight = sqrt(amp) * peak;
+    float3 result = (weight * (b + d + f + h) + e) / (1.0f + 4.0f * weight);
+
+    OutputTexture[targetOffset + int2(dispatchThreadID.xy)] = float4(saturate(result), center.a);
 }
 )";
 
@@ -241,6 +442,19 @@ bool D3D11Upscaler::Initialize(ID3D11Device* device, ID3D11DeviceContext* contex
         return false;
     }
 
+    m_readback = std::make_unique<FrameReadback>();
+    if (!m_readback->Initialize(m_device, m_context))
+    {
+        Logger::Error("D3D11Upscaler: Failed to initialize frame readback");
+        return false;
+    }
+    m_cpuUpscaler = std::make_unique<CpuUpscaler>();
+    m_cpuUpscaler->SetLinearLight(m_linearLight);
+    m_temporalUpscaler = std::make_unique<TemporalUpscaler>();
+    m_cnnUpscaler = std::make_unique<CnnUpscaler>();
+    m_cnnUpscaler->LoadModel("models/espcn_x2.bin");
+    m_casSharpener = std::make_unique<CasSharpener>();
+
     Logger::Info("D3D11Upscaler initialized successfully");
     return true;
 }
@@ -249,10 +463,28 @@ void D3D11Upscaler::Shutdown()
 {
     m_bilinearShader.Reset();
     m_fsrShader.Reset();
+    m_bilinearLinearShader.Reset();
+    m_fsrLinearShader.Reset();
+    m_srgbToLinearSRV.Reset();
+    m_linearToSrgbSRV.Reset();
+    m_casShader.Reset();
     m_outputTexture.Reset();
     m_outputUAV.Reset();
+    m_outputSurfaces.clear();
     m_constantBuffer.Reset();
+    m_sharpenConstantBuffer.Reset();
     m_linearSampler.Reset();
+    m_cachedInputSRV.Reset();
+    m_cachedInputTexture = nullptr;
+    if (m_readback)
+    {
+        m_readback->Shutdown();
+        m_readback.reset();
+    }
+    m_cpuUpscaler.reset();
+    m_temporalUpscaler.reset();
+    m_cnnUpscaler.reset();
+    m_casSharpener.reset();
     
     m_device = nullptr;
     m_context = nullptr;
@@ -260,6 +492,15 @@ void D3D11Upscaler::Shutdown()
     m_outputHeight = 0;
 }
 
+void D3D11Upscaler::SetLinearLight(bool enabled)
+{
+    m_linearLight = enabled;
+    if (m_cpuUpscaler)
+    {
+        m_cpuUpscaler->SetLinearLight(enabled);
+    }
+}
+
 bool D3D11Upscaler::CreateComputeShaders()
 {
     // Try to load pre-compiled shaders first, fall back to runtime compilation
@@ -278,11 +519,29 @@ bool D3D11Upscaler::CreateComputeShaders()
         return false;
     }
 
+    // Linear-light variants, optional (the gamma shaders are used without them)
+    const D3D_SHADER_MACRO linearDefines[] = { { "LINEAR_LIGHT", "1" }, { nullptr, nullptr } };
+    if (!CompileShaderFromSource(s_bilinearShaderSource, "CSMain", m_bilinearLinearShader, linearDefines) ||
+        !CompileShaderFromSource(s_fsrShaderSource, "CSMain", m_fsrLinearShader, linearDefines) ||
+        !CreateSrgbTables())
+    {
+        Logger::Warning("D3D11Upscaler: Linear-light shaders unavailable");
+        m_bilinearLinearShader.Reset();
+        m_fsrLinearShader.Reset();
+    }
+
+    // Compile CAS sharpening shader
+    if (!CompileShaderFromSource(s_casShaderSource, "CSMain", m_casShader))
+    {
+        Logger::Error("D3D11Upscaler: Failed to compile CAS shader");
+        return false;
+    }
+
     Logger::Info("D3D11Upscaler: Compute shaders compiled successfully");
     return true;
 }
 
-bool D3D11Upscaler::CompileShaderFromSource(const char* source, const char* entryPoint, ComPtr<ID3D11ComputeShader>& shader)
+bool D3D11Upscaler::CompileShaderFromSource(const char* source, const char* entryPoint, ComPtr<ID3D11ComputeShader>& shader, const D3D_SHADER_MACRO* defines)
 {
     ComPtr<ID3DBlob> shaderBlob;
     ComPtr<ID3DBlob> errorBlob;
@@ -296,7 +555,7 @@ bool D3D11Upscaler::CompileShaderFromSource(const char* source, const char* entr
         source,
         strlen(source),
         nullptr,
-        nullptr,
+        defines,
         D3D_COMPILE_STANDARD_FILE_INCLUDE,
         entryPoint,
         "cs_5_0",
@@ -372,25 +631,104 @@ bool D3D11Upscaler::CreateConstantBuffer()
         return false;
     }
 
+    bufferDesc.ByteWidth = sizeof(SharpenConstants);
+    hr = m_device->CreateBuffer(&bufferDesc, nullptr, &m_sharpenConstantBuffer);
+    if (FAILED(hr))
+    {
+        Logger::Error("D3D11Upscaler: Failed to create sharpen constant buffer: 0x%08X", hr);
+        return false;
+    }
+
     return true;
 }
 
+bool D3D11Upscaler::CreateSrgbTables()
+{
+    // Same tables as the CPU kernels, on a 0..1 scale
+    const SrgbTables& tables = GetSrgbTables();
+    float toLinear[256];
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        toLinear[i] = tables.toLinear[i] / 255.0f;
+    }
+    std::vector<float> toSrgb(SrgbTables::LINEAR_STEPS);
+    for (uint32_t i = 0; i < SrgbTables::LINEAR_STEPS; i++)
+    {
+        toSrgb[i] = tables.toSrgb[i] / 255.0f;
+    }
+
+    return CreateTableBuffer(toLinear, 256, m_srgbToLinearSRV) &&
+           CreateTableBuffer(toSrgb.data(), SrgbTables::LINEAR_STEPS, m_linearToSrgbSRV);
+}
+
+bool D3D11Upscaler::CreateTableBuffer(const float* values, uint32_t count, ComPtr<ID3D11ShaderResourceView>& srv)
+{
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.ByteWidth = count * sizeof(float);
+    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = values;
+
+    ComPtr<ID3D11Buffer> buffer;
+    HRESULT hr = m_device->CreateBuffer(&bufferDesc, &initData, &buffer);
+    if (FAILED(hr))
+    {
+        Logger::Error("D3D11Upscaler: Failed to create table buffer: 0x%08X", hr);
+        return false;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.FirstElement = 0;
+    srvDesc.Buffer.NumElements = count;
+
+    hr = m_device->CreateShaderResourceView(buffer.Get(), &srvDesc, &srv);
+    if (FAILED(hr))
+    {
+        Logger::Error("D3D11Upscaler: Failed to create table SRV: 0x%08X", hr);
+        return false;
+    }
+    return true;
+}
+
+void D3D11Upscaler::SetMaxOutputSize(uint32_t width, uint32_t height)
+{
+    m_maxOutputWidth = width;
+    m_maxOutputHeight = height;
+}
+
 bool D3D11Upscaler::EnsureOutputTexture(uint32_t width, uint32_t height, DXGI_FORMAT format)
 {
-    // Check if we need to recreate the output texture
-    if (m_outputTexture && m_outputWidth == width && m_outputHeight == height && m_outputFormat == format)
+    // Any cached texture of the format that's big enough will do, only the used size changes
+    for (size_t i = 0; i < m_outputSurfaces.size(); i++)
     {
-        return true;
+        const OutputSurface& surface = m_outputSurfaces[i];
+        if (surface.format == format && surface.width >= width && surface.height >= height)
+        {
+            // The hit moves to the front, so read it from there
+            std::rotate(m_outputSurfaces.begin(), m_outputSurfaces.begin() + i, m_outputSurfaces.begin() + i + 1);
+            const OutputSurface& hit = m_outputSurfaces.front();
+            m_outputTexture = hit.texture;
+            m_outputUAV = hit.uav;
+            m_outputWidth = width;
+            m_outputHeight = height;
+            m_outputFormat = format;
+            return true;
+        }
     }
 
-    // Release old resources
-    m_outputUAV.Reset();
-    m_outputTexture.Reset();
+    // Create at the maximum output size so later factor changes fit
+    OutputSurface surface;
+    surface.width = max(width, m_maxOutputWidth);
+    surface.height = max(height, m_maxOutputHeight);
+    surface.format = format;
 
-    // Create new output texture
     D3D11_TEXTURE2D_DESC texDesc = {};
-    texDesc.Width = width;
-    texDesc.Height = height;
+    texDesc.Width = surface.width;
+    texDesc.Height = surface.height;
     texDesc.MipLevels = 1;
     texDesc.ArraySize = 1;
     texDesc.Format = format;
@@ -398,7 +736,7 @@ bool D3D11Upscaler::EnsureOutputTexture(uint32_t width, uint32_t height, DXGI_FO
     texDesc.Usage = D3D11_USAGE_DEFAULT;
     texDesc.BindFlags = D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
 
-    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &m_outputTexture);
+    HRESULT hr = m_device->CreateTexture2D(&texDesc, nullptr, &surface.texture);
     if (FAILED(hr))
     {
         Logger::Error("D3D11Upscaler: Failed to create output texture: 0x%08X", hr);
@@ -411,18 +749,28 @@ bool D3D11Upscaler::EnsureOutputTexture(uint32_t width, uint32_t height, DXGI_FO
     uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
     uavDesc.Texture2D.MipSlice = 0;
 
-    hr = m_device->CreateUnorderedAccessView(m_outputTexture.Get(), &uavDesc, &m_outputUAV);
+    hr = m_device->CreateUnorderedAccessView(surface.texture.Get(), &uavDesc, &surface.uav);
     if (FAILED(hr))
     {
         Logger::Error("D3D11Upscaler: Failed to create UAV: 0x%08X", hr);
         return false;
     }
+    m_resourceCreations += 2;
+
+    // Least recently used texture goes when the cache is full
+    m_outputSurfaces.insert(m_outputSurfaces.begin(), surface);
+    if (m_outputSurfaces.size() > OUTPUT_SURFACE_CACHE)
+    {
+        m_outputSurfaces.pop_back();
+    }
 
+    m_outputTexture = surface.texture;
+    m_outputUAV = surface.uav;
     m_outputWidth = width;
     m_outputHeight = height;
     m_outputFormat = format;
 
-    Logger::Info("D3D11Upscaler: Created output texture %ux%u", width, height);
+    Logger::Info("D3D11Upscaler: Created output texture %ux%u", surface.width, surface.height);
     return true;
 }
 
@@ -430,7 +778,8 @@ ID3D11Texture2D* D3D11Upscaler::Upscale(
     ID3D11Texture2D* inputTexture,
     uint32_t outputWidth,
     uint32_t outputHeight,
-    UpscaleMethod method)
+    UpscaleMethod method,
+    const D3D11_RECT* sourceRect)
 {
     if (!inputTexture || !m_device || !m_context)
     {
@@ -441,36 +790,59 @@ ID3D11Texture2D* D3D11Upscaler::Upscale(
     D3D11_TEXTURE2D_DESC inputDesc;
     inputTexture->GetDesc(&inputDesc);
 
+    // Source rect defaults to the whole texture
+    D3D11_RECT source = { 0, 0, (LONG)inputDesc.Width, (LONG)inputDesc.Height };
+    if (sourceRect)
+    {
+        source = *sourceRect;
+    }
+    bool fullTexture = source.left == 0 && source.top == 0 &&
+                       source.right == (LONG)inputDesc.Width && source.bottom == (LONG)inputDesc.Height;
+
     // If output size matches input, just return input (no upscaling needed)
-    if (inputDesc.Width == outputWidth && inputDesc.Height == outputHeight)
+    if (fullTexture && inputDesc.Width == outputWidth && inputDesc.Height == outputHeight)
     {
         return inputTexture;
     }
 
+    if (method == UpscaleMethod::EdgeDirected || method == UpscaleMethod::Temporal || method == UpscaleMethod::Neural)
+    {
+        // CPU kernels work on BGRA8, other capture formats are converted after readback.
+        // HDR captures keep their range: edge-directed has a half-float kernel, the others
+        // would clip to 8 bits so they use the shader path instead
+        PixelFormat pixelFormat;
+        if (IsHdrFormat(inputDesc.Format) && GetCpuPixelFormat(inputDesc.Format, pixelFormat))
+        {
+            if (method == UpscaleMethod::EdgeDirected)
+            {
+                if (!EnsureOutputTexture(outputWidth, outputHeight, inputDesc.Format))
+                {
+                    return nullptr;
+                }
+                return UpscaleHdrOnCpu(inputTexture, source, pixelFormat);
+            }
+        }
+        else if (GetCpuPixelFormat(inputDesc.Format, pixelFormat))
+        {
+            if (!EnsureOutputTexture(outputWidth, outputHeight, DXGI_FORMAT_B8G8R8A8_UNORM))
+            {
+                return nullptr;
+            }
+            return UpscaleOnCpu(inputTexture, source, method, pixelFormat);
+        }
+        // Unknown or HDR format, fall back to the shader path
+        method = UpscaleMethod::FSR;
+    }
+
     // Ensure output texture exists
     if (!EnsureOutputTexture(outputWidth, outputHeight, inputDesc.Format))
     {
         return nullptr;
     }
 
-    // Only recreate SRV if input texture changed
-    if (m_cachedInputTexture != inputTexture)
+    if (!EnsureInputSRV(inputTexture, inputDesc.Format))
     {
-        m_cachedInputSRV.Reset();
-        
-        D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Format = inputDesc.Format;
-        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = 1;
-        srvDesc.Texture2D.MostDetailedMip = 0;
-
-        HRESULT hr = m_device->CreateShaderResourceView(inputTexture, &srvDesc, &m_cachedInputSRV);
-        if (FAILED(hr))
-        {
-            Logger::Error("D3D11Upscaler: Failed to create input SRV: 0x%08X", hr);
-            return nullptr;
-        }
-        m_cachedInputTexture = inputTexture;
+        return nullptr;
     }
 
     // Update constant buffer
@@ -479,21 +851,35 @@ ID3D11Texture2D* D3D11Upscaler::Upscale(
     if (SUCCEEDED(hr))
     {
         UpscaleConstants* constants = static_cast<UpscaleConstants*>(mappedResource.pData);
-        constants->inputWidth = static_cast<float>(inputDesc.Width);
-        constants->inputHeight = static_cast<float>(inputDesc.Height);
+        constants->inputWidth = static_cast<float>(source.right - source.left);
+        constants->inputHeight = static_cast<float>(source.bottom - source.top);
         constants->outputWidth = static_cast<float>(outputWidth);
         constants->outputHeight = static_cast<float>(outputHeight);
         constants->sharpness = m_sharpness;
+        constants->inputOffsetX = static_cast<float>(source.left);
+        constants->inputOffsetY = static_cast<float>(source.top);
+        constants->textureWidth = static_cast<float>(inputDesc.Width);
+        constants->textureHeight = static_cast<float>(inputDesc.Height);
         m_context->Unmap(m_constantBuffer.Get(), 0);
     }
 
-    // Select shader
-    ID3D11ComputeShader* shader = (method == UpscaleMethod::FSR) ? m_fsrShader.Get() : m_bilinearShader.Get();
+    // Select shader (the sRGB tables only apply to 8-bit captures, scRGB is already linear)
+    bool linear = m_linearLight && !IsHdrFormat(inputDesc.Format) && m_fsrLinearShader && m_bilinearLinearShader;
+    ID3D11ComputeShader* shader;
+    if (method == UpscaleMethod::FSR)
+    {
+        shader = linear ? m_fsrLinearShader.Get() : m_fsrShader.Get();
+    }
+    else
+    {
+        shader = linear ? m_bilinearLinearShader.Get() : m_bilinearShader.Get();
+    }
 
     // Set compute shader state
+    ID3D11ShaderResourceView* srvs[3] = { m_cachedInputSRV.Get(), m_srgbToLinearSRV.Get(), m_linearToSrgbSRV.Get() };
     m_context->CSSetShader(shader, nullptr, 0);
     m_context->CSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
-    m_context->CSSetShaderResources(0, 1, m_cachedInputSRV.GetAddressOf());
+    m_context->CSSetShaderResources(0, linear ? 3 : 1, srvs);
     m_context->CSSetUnorderedAccessViews(0, 1, m_outputUAV.GetAddressOf(), nullptr);
     m_context->CSSetSamplers(0, 1, m_linearSampler.GetAddressOf());
 
@@ -503,11 +889,254 @@ ID3D11Texture2D* D3D11Upscaler::Upscale(
     m_context->Dispatch(threadGroupsX, threadGroupsY, 1);
 
     // Clear shader state
-    ID3D11ShaderResourceView* nullSRV = nullptr;
+    ID3D11ShaderResourceView* nullSRVs[3] = {};
     ID3D11UnorderedAccessView* nullUAV = nullptr;
-    m_context->CSSetShaderResources(0, 1, &nullSRV);
+    m_context->CSSetShaderResources(0, linear ? 3 : 1, nullSRVs);
     m_context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
     m_context->CSSetShader(nullptr, nullptr, 0);
 
     return m_outputTexture.Get();
 }
+
+bool D3D11Upscaler::EnsureInputSRV(ID3D11Texture2D* inputTexture, DXGI_FORMAT format)
+{
+    // Only recreate SRV if input texture changed
+    if (m_cachedInputTexture == inputTexture)
+    {
+        return true;
+    }
+
+    m_cachedInputSRV.Reset();
+    m_cachedInputTexture = nullptr;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = 1;
+    srvDesc.Texture2D.MostDetailedMip = 0;
+
+    HRESULT hr = m_device->CreateShaderResourceView(inputTexture, &srvDesc, &m_cachedInputSRV);
+    if (FAILED(hr))
+    {
+        Logger::Error("D3D11Upscaler: Failed to create input SRV: 0x%08X", hr);
+        return false;
+    }
+    m_resourceCreations++;
+    m_cachedInputTexture = inputTexture;
+    return true;
+}
+
+bool D3D11Upscaler::Sharpen(
+    ID3D11Texture2D* inputTexture,
+    const D3D11_RECT& source,
+    ID3D11Texture2D* target,
+    ID3D11UnorderedAccessView* targetUAV,
+    uint32_t targetX,
+    uint32_t targetY,
+    SharpenMode mode)
+{
+    if (!inputTexture || !target || !m_device || mode == SharpenMode::Off)
+    {
+        return false;
+    }
+
+    D3D11_TEXTURE2D_DESC inputDesc;
+    inputTexture->GetDesc(&inputDesc);
+
+    uint32_t width = source.right - source.left;
+    uint32_t height = source.bottom - source.top;
+
+    // CAS clamps to 0..1, which would clip FP16 highlights
+    if (inputDesc.Format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+    {
+        return false;
+    }
+
+    // Without a target UAV the GPU mode falls back to the CPU kernel
+    if (mode == SharpenMode::Gpu && targetUAV)
+    {
+        if (!EnsureInputSRV(inputTexture, inputDesc.Format))
+        {
+            return false;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        HRESULT hr = m_context->Map(m_sharpenConstantBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+        if (FAILED(hr))
+        {
+            return false;
+        }
+
+        SharpenConstants* constants = static_cast<SharpenConstants*>(mappedResource.pData);
+        constants->sourceX = source.left;
+        constants->sourceY = source.top;
+        constants->targetX = static_cast<int32_t>(targetX);
+        constants->targetY = static_cast<int32_t>(targetY);
+        constants->width = static_cast<int32_t>(width);
+        constants->height = static_cast<int32_t>(height);
+        constants->peak = -1.0f / (8.0f - 3.0f * m_sharpness);
+        constants->padding = 0.0f;
+        m_context->Unmap(m_sharpenConstantBuffer.Get(), 0);
+
+        m_context->CSSetShader(m_casShader.Get(), nullptr, 0);
+        m_context->CSSetConstantBuffers(0, 1, m_sharpenConstantBuffer.GetAddressOf());
+        m_context->CSSetShaderResources(0, 1, m_cachedInputSRV.GetAddressOf());
+        m_context->CSSetUnorderedAccessViews(0, 1, &targetUAV, nullptr);
+
+        m_context->Dispatch((width + 7) / 8, (height + 7) / 8, 1);
+
+        ID3D11ShaderResourceView* nullSRV = nullptr;
+        ID3D11UnorderedAccessView* nullUAV = nullptr;
+        m_context->CSSetShaderResources(0, 1, &nullSRV);
+        m_context->CSSetUnorderedAccessViews(0, 1, &nullUAV, nullptr);
+        m_context->CSSetShader(nullptr, nullptr, 0);
+        return true;
+    }
+
+    // CPU kernel only handles 8-bit BGRA
+    if (inputDesc.Format != DXGI_FORMAT_B8G8R8A8_UNORM)
+    {
+        return false;
+    }
+
+    MutableImageView frame;
+    if (!m_readback->MapWritable(inputTexture, frame))
+    {
+        return false;
+    }
+
+    MutableImageView region{ frame.Row(static_cast<uint32_t>(source.top)) + source.left * 4, width, height, frame.pitch };
+    m_casSharpener->Sharpen(region, m_sharpness);
+    m_readback->Unmap();
+
+    D3D11_BOX box = { (UINT)source.left, (UINT)source.top, 0, (UINT)source.right, (UINT)source.bottom, 1 };
+    m_context->CopySubresourceRegion(target, 0, targetX, targetY, 0, m_readback->GetStagingTexture(), 0, &box);
+    return true;
+}
+
+ID3D11Texture2D* D3D11Upscaler::UpscaleOnCpu(ID3D11Texture2D* inputTexture, const D3D11_RECT& source, UpscaleMethod method, PixelFormat format)
+{
+    ImageView frame;
+    if (!m_readback->Map(inputTexture, frame))
+    {
+        return nullptr;
+    }
+
+    const uint32_t sourceWidth = source.right - source.left;
+    const uint32_t sourceHeight = source.bottom - source.top;
+    ImageView src = frame.Crop(source.left, source.top, sourceWidth, sourceHeight);
+
+    // Intermediate frames come from the shared pool and go back to it on return
+    FramePool& pool = FramePool::Shared();
+    FrameHandle converted;
+    if (format != PixelFormat::Bgra8)
+    {
+        converted = pool.Acquire(sourceWidth, sourceHeight, PixelFormat::Bgra8);
+        if (!converted)
+        {
+            m_readback->Unmap();
+            return nullptr;
+        }
+
+        PlaneView raw{ frame.Row(source.top) + source.left * GetBytesPerPixel(format), frame.pitch };
+        ConvertToBgra(format, raw, converted.View());
+        src = converted.View();
+    }
+
+    // Pooled at the maximum output size like the output texture, so a factor change reuses the
+    // frame; the kernels get its used top-left part
+    FrameHandle output = pool.Acquire(max(m_outputWidth, m_maxOutputWidth), max(m_outputHeight, m_maxOutputHeight), PixelFormat::Bgra8);
+    if (!output)
+    {
+        m_readback->Unmap();
+        return nullptr;
+    }
+    MutableImageView dst{ output.Data(), m_outputWidth, m_outputHeight, output.GetPitch() };
+
+    switch (method)
+    {
+    case UpscaleMethod::EdgeDirected:
+        m_cpuUpscaler->EdgeDirected(src, dst);
+        break;
+    case UpscaleMethod::Temporal:
+        m_temporalUpscaler->Upscale(src, dst);
+        break;
+    case UpscaleMethod::Neural:
+        m_cnnUpscaler->Upscale(src, dst);
+        break;
+    default:
+        m_cpuUpscaler->Bilinear(src, dst);
+        break;
+    }
+
+    m_readback->Unmap();
+
+    UploadOutput(output.Data(), output.GetPitch());
+    return m_outputTexture.Get();
+}
+
+ID3D11Texture2D* D3D11Upscaler::UpscaleHdrOnCpu(ID3D11Texture2D* inputTexture, const D3D11_RECT& source, PixelFormat format)
+{
+    ImageView frame;
+    if (!m_readback->Map(inputTexture, frame))
+    {
+        return nullptr;
+    }
+
+    const uint32_t sourceWidth = source.right - source.left;
+    const uint32_t sourceHeight = source.bottom - source.top;
+    const uint8_t* origin = frame.Row(source.top) + source.left * GetBytesPerPixel(format);
+
+    // FP16 is filtered straight from the mapped readback, 10-bit is unpacked to half first
+    HalfImageView src{ reinterpret_cast<const uint16_t*>(origin), sourceWidth, sourceHeight, frame.pitch / 2 };
+    FramePool& pool = FramePool::Shared();
+    FrameHandle unpacked;
+    if (format == PixelFormat::Rgb10A2)
+    {
+        unpacked = pool.Acquire(sourceWidth, sourceHeight, PixelFormat::Rgba16F);
+        if (!unpacked)
+        {
+            m_readback->Unmap();
+            return nullptr;
+        }
+        Rgb10A2ToHalf(PlaneView{ origin, frame.pitch }, unpacked.HalfView());
+        src = unpacked.HalfView();
+    }
+
+    // At the maximum output size, as in UpscaleOnCpu()
+    const uint32_t poolWidth = max(m_outputWidth, m_maxOutputWidth);
+    const uint32_t poolHeight = max(m_outputHeight, m_maxOutputHeight);
+    FrameHandle output = pool.Acquire(poolWidth, poolHeight, PixelFormat::Rgba16F);
+    if (!output)
+    {
+        m_readback->Unmap();
+        return nullptr;
+    }
+    MutableHalfImageView dst{ reinterpret_cast<uint16_t*>(output.Data()), m_outputWidth, m_outputHeight, output.GetPitch() / 2 };
+    m_cpuUpscaler->EdgeDirected(src, dst);
+
+    m_readback->Unmap();
+
+    if (format == PixelFormat::Rgb10A2)
+    {
+        FrameHandle packed = pool.Acquire(poolWidth, poolHeight, PixelFormat::Rgb10A2);
+        if (!packed)
+        {
+            return nullptr;
+        }
+        HalfToRgb10A2(dst, packed.Plane());
+        UploadOutput(packed.Data(), packed.GetPitch());
+    }
+    else
+    {
+        UploadOutput(output.Data(), output.GetPitch());
+    }
+    return m_outputTexture.Get();
+}
+
+void D3D11Upscaler::UploadOutput(const uint8_t* data, size_t pitch)
+{
+    // Only the used part, the texture is usually larger
+    D3D11_BOX box = { 0, 0, 0, m_outputWidth, m_outputHeight, 1 };
+    m_context->UpdateSubresource(m_outputTexture.Get(), 0, &box, data, static_cast<UINT>(pitch), 0);
+}
@@ -2,18 +2,38 @@
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
+#include "CpuUpscaler.h"
+#include "TemporalUpscaler.h"
+#include "CnnUpscaler.h"
+#include "CasSharpener.h"
+#include "PixelConvert.h"
+#include "../Capture/FrameReadback.h"
 
 using Microsoft::WRL::ComPtr;
 
 enum class UpscaleMethod
 {
     Bilinear,
-    FSR  // FidelityFX Super Resolution inspired
+    FSR,          // FidelityFX Super Resolution inspired
+    EdgeDirected, // Directional interpolation for text/UI (CPU)
+    Temporal,     // Accumulates detail over frames using global motion (CPU)
+    Neural        // Small int8 convolutional network, falls back to bilinear without a model (CPU)
+};
+
+// Contrast adaptive sharpening when the frame is shown at native resolution
+enum class SharpenMode
+{
+    Off,
+    Gpu,  // Compute shader from the captured frame straight into the target
+    Cpu   // In place on the readback copy, then copied into the target
 };
 
 // D3D11-based upscaler for the overlay system
-// Supports bilinear and FSR-style edge-adaptive upscaling
+// Supports bilinear and FSR-style edge-adaptive upscaling on the GPU,
+// plus CPU methods that read the frame back and upload the result
 class D3D11Upscaler
 {
 public:
@@ -24,27 +44,61 @@ public:
     void Shutdown();
 
     // Upscale the input texture to the specified output size
-    // Returns the upscaled texture (owned by this class)
+    // If sourceRect is set only that part of the input is upscaled (e.g. to drop black bars)
+    // Returns the upscaled texture (owned by this class); it can be larger than the output
+    // size, the result is its top-left outputWidth x outputHeight
     ID3D11Texture2D* Upscale(
         ID3D11Texture2D* inputTexture,
         uint32_t outputWidth,
         uint32_t outputHeight,
-        UpscaleMethod method = UpscaleMethod::FSR
+        UpscaleMethod method = UpscaleMethod::FSR,
+        const D3D11_RECT* sourceRect = nullptr
+    );
+
+    // Sharpen the source rect of the input at native resolution into target at (targetX, targetY)
+    // Single pass with no intermediate texture; GPU mode without targetUAV runs on the CPU
+    // Returns false when nothing was written (e.g. non BGRA8 input on the CPU path)
+    bool Sharpen(
+        ID3D11Texture2D* inputTexture,
+        const D3D11_RECT& source,
+        ID3D11Texture2D* target,
+        ID3D11UnorderedAccessView* targetUAV,
+        uint32_t targetX,
+        uint32_t targetY,
+        SharpenMode mode
     );
 
     // Get the upscaled texture directly
     ID3D11Texture2D* GetOutputTexture() const { return m_outputTexture.Get(); }
 
-    // Set sharpness for FSR (0.0 = smooth, 1.0 = sharp)
+    // Largest output expected (the back buffer size); output textures are created at least
+    // this big so changing the upscale factor only changes the part that's used
+    void SetMaxOutputSize(uint32_t width, uint32_t height);
+
+    // Textures and views created since start (output surfaces, input SRVs)
+    uint64_t GetResourceCreations() const { return m_resourceCreations; }
+
+    // Set sharpness for FSR and CAS (0.0 = smooth, 1.0 = sharp)
     void SetSharpness(float sharpness) { m_sharpness = sharpness; }
     float GetSharpness() const { return m_sharpness; }
 
+    // Filter in linear light instead of on the sRGB-encoded values (bilinear, FSR and
+    // edge-directed; temporal and neural always work on the encoded values)
+    void SetLinearLight(bool enabled);
+    bool IsLinearLight() const { return m_linearLight; }
+
 private:
     bool CreateComputeShaders();
     bool CreateConstantBuffer();
     bool EnsureOutputTexture(uint32_t width, uint32_t height, DXGI_FORMAT format);
+    bool EnsureInputSRV(ID3D11Texture2D* inputTexture, DXGI_FORMAT format);
     bool LoadCompiledShader(const std::wstring& filename, ComPtr<ID3D11ComputeShader>& shader);
-    bool CompileShaderFromSource(const char* source, const char* entryPoint, ComPtr<ID3D11ComputeShader>& shader);
+    bool CompileShaderFromSource(const char* source, const char* entryPoint, ComPtr<ID3D11ComputeShader>& shader, const D3D_SHADER_MACRO* defines = nullptr);
+    bool CreateSrgbTables();
+    bool CreateTableBuffer(const float* values, uint32_t count, ComPtr<ID3D11ShaderResourceView>& srv);
+    ID3D11Texture2D* UpscaleOnCpu(ID3D11Texture2D* inputTexture, const D3D11_RECT& source, UpscaleMethod method, PixelFormat format);
+    ID3D11Texture2D* UpscaleHdrOnCpu(ID3D11Texture2D* inputTexture, const D3D11_RECT& source, PixelFormat format);
+    void UploadOutput(const uint8_t* data, size_t pitch);
 
 private:
     ID3D11Device* m_device = nullptr;
@@ -53,18 +107,41 @@ private:
     // Compute shaders
     ComPtr<ID3D11ComputeShader> m_bilinearShader;
     ComPtr<ID3D11ComputeShader> m_fsrShader;
+    ComPtr<ID3D11ComputeShader> m_bilinearLinearShader;
+    ComPtr<ID3D11ComputeShader> m_fsrLinearShader;
+    ComPtr<ID3D11ComputeShader> m_casShader;
+
+    // sRGB <-> linear tables for the linear-light shaders
+    ComPtr<ID3D11ShaderResourceView> m_srgbToLinearSRV;
+    ComPtr<ID3D11ShaderResourceView> m_linearToSrgbSRV;
 
     // Output texture and UAV
     ComPtr<ID3D11Texture2D> m_outputTexture;
     ComPtr<ID3D11UnorderedAccessView> m_outputUAV;
 
-    // Constant buffer
+    // Output textures kept for reuse, most recently used first (includes the current one)
+    struct OutputSurface
+    {
+        ComPtr<ID3D11Texture2D> texture;
+        ComPtr<ID3D11UnorderedAccessView> uav;
+        uint32_t width = 0;   // Allocated size
+        uint32_t height = 0;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    };
+    static const size_t OUTPUT_SURFACE_CACHE = 3;
+    std::vector<OutputSurface> m_outputSurfaces;
+    uint32_t m_maxOutputWidth = 0;
+    uint32_t m_maxOutputHeight = 0;
+    uint64_t m_resourceCreations = 0;
+
+    // Constant buffers
     ComPtr<ID3D11Buffer> m_constantBuffer;
+    ComPtr<ID3D11Buffer> m_sharpenConstantBuffer;
 
     // Sampler state for texture sampling
     ComPtr<ID3D11SamplerState> m_linearSampler;
 
-    // Current output dimensions
+    // Current output dimensions (the used part of the output texture)
     uint32_t m_outputWidth = 0;
     uint32_t m_outputHeight = 0;
     DXGI_FORMAT m_outputFormat = DXGI_FORMAT_UNKNOWN;
@@ -73,17 +150,42 @@ private:
     ComPtr<ID3D11ShaderResourceView> m_cachedInputSRV;
     ID3D11Texture2D* m_cachedInputTexture = nullptr;
 
+    // CPU upscaling path
+    std::unique_ptr<CpuUpscaler> m_cpuUpscaler;
+    std::unique_ptr<TemporalUpscaler> m_temporalUpscaler;
+    std::unique_ptr<CnnUpscaler> m_cnnUpscaler;
+    std::unique_ptr<CasSharpener> m_casSharpener;
+    std::unique_ptr<FrameReadback> m_readback;
+
     // Settings
     float m_sharpness = 0.5f;
+    bool m_linearLight = false;
 
     // Shader constant structure (must match HLSL)
     struct UpscaleConstants
     {
-        float inputWidth;
+        float inputWidth;    // Source rect size
         float inputHeight;
         float outputWidth;
         float outputHeight;
         float sharpness;
-        float padding[3];  // Align to 16 bytes
+        float inputOffsetX;  // Source rect top-left
+        float inputOffsetY;
+        float padding;
+        float textureWidth;  // Full input texture size
+        float textureHeight;
+        float padding2[2];   // Align to 16 bytes
+    };
+
+    struct SharpenConstants
+    {
+        int32_t sourceX;     // Source rect top-left in the input
+        int32_t sourceY;
+        int32_t targetX;     // Top-left in the target
+        int32_t targetY;
+        int32_t width;       // Rect size
+        int32_t height;
+        float peak;          // Neighbour weight at full contrast headroom
+        float padding;
     };
 };
@@ -0,0 +1,177 @@
+#include "DuplicateFrameDetector.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    // xxHash64 primes and round: a multiply, rotate and multiply per 8 bytes, so no change to the
+    // pixels cancels out the way it can in sums (+1/-2/+1 on three pixels leaves both a running
+    // sum and its sum unchanged)
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+    const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+    const uint64_t RGB_MASK = 0x00FFFFFF00FFFFFFull;
+
+    uint64_t RotateLeft(uint64_t value, uint32_t bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    uint64_t Round(uint64_t accumulator, uint64_t input)
+    {
+        return RotateLeft(accumulator + input * PRIME2, 31) * PRIME1;
+    }
+
+    // width x height pixels at row, alpha ignored; four independent accumulators take 8 bytes each
+    // in turn so the multiplies overlap
+    uint64_t HashTile(const uint8_t* row, size_t pitch, uint32_t width, uint32_t height)
+    {
+        uint64_t acc[4] = { PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1 };
+        for (uint32_t y = 0; y < height; y++, row += pitch)
+        {
+            uint32_t x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                uint64_t words[4];
+                memcpy(words, row + x * 4, sizeof(words));
+                acc[0] = Round(acc[0], words[0] & RGB_MASK);
+                acc[1] = Round(acc[1], words[1] & RGB_MASK);
+                acc[2] = Round(acc[2], words[2] & RGB_MASK);
+                acc[3] = Round(acc[3], words[3] & RGB_MASK);
+            }
+            for (; x < width; x++)
+            {
+                uint32_t pixel;
+                memcpy(&pixel, row + x * 4, 4);
+                acc[x & 3] = Round(acc[x & 3], pixel & 0x00FFFFFFu);
+            }
+        }
+
+        // Merge and avalanche as xxHash64 does
+        uint64_t hash = RotateLeft(acc[0], 1) + RotateLeft(acc[1], 7) + RotateLeft(acc[2], 12) + RotateLeft(acc[3], 18);
+        hash ^= hash >> 33;
+        hash *= PRIME2;
+        hash ^= hash >> 29;
+        hash *= PRIME3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
+
+DuplicateFrameDetector::DuplicateFrameDetector()
+    : m_pool(ThreadPool::Shared())
+{
+}
+
+void DuplicateFrameDetector::Reset()
+{
+    m_reference.clear();
+    m_width = 0;
+    m_height = 0;
+    m_lastFrameTime = 0.0;
+    m_previousFrameTime = 0.0;
+    m_stats.frameInterval = 0.0;
+}
+
+bool DuplicateFrameDetector::Update(const ImageView& frame, double timestamp)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    const uint32_t tilesX = (frame.width + TILE_WIDTH - 1) / TILE_WIDTH;
+    const uint32_t tilesY = (frame.height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+    m_tilesX = tilesX;
+    m_hashes.resize(static_cast<size_t>(tilesX) * tilesY);
+
+    // Every tile is hashed even when the answer is clear early: a new frame's hashes are the
+    // reference for the captures after it
+    m_pool.ParallelFor(tilesY, m_pool.SuggestGrain(tilesY), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t tileY = begin; tileY < end; tileY++)
+        {
+            HashTileRow(frame, tileY);
+        }
+    });
+
+    const bool sameSize = frame.width == m_width && frame.height == m_height && m_reference.size() == m_hashes.size();
+    m_stats.changedTiles = sameSize ? CountChangedTiles() : static_cast<uint32_t>(m_hashes.size());
+    const bool isNew = !sameSize || m_stats.changedTiles > m_changedTileLimit;
+    if (isNew)
+    {
+        const bool hadFrame = m_width != 0;
+        m_reference.swap(m_hashes);
+        m_width = frame.width;
+        m_height = frame.height;
+
+        if (hadFrame && timestamp > m_lastFrameTime)
+        {
+            const double interval = timestamp - m_lastFrameTime;
+            m_stats.frameInterval = m_stats.frameInterval == 0.0 ? interval : m_stats.frameInterval * 0.9 + interval * 0.1;
+        }
+        m_previousFrameTime = m_lastFrameTime;
+        m_lastFrameTime = timestamp;
+        m_stats.newFrames++;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    float elapsedMs = std::chrono::duration<float, std::milli>(end - start).count();
+    m_stats.checkMs = elapsedMs;
+    m_stats.checkMsAverage = (m_stats.captures == 0) ? elapsedMs : m_stats.checkMsAverage * 0.9f + elapsedMs * 0.1f;
+    m_stats.captures++;
+    return isNew;
+}
+
+void DuplicateFrameDetector::HashTileRow(const ImageView& frame, uint32_t tileY)
+{
+    const uint32_t y0 = tileY * TILE_HEIGHT;
+    const uint32_t height = std::min(TILE_HEIGHT, frame.height - y0);
+    uint64_t* hashes = m_hashes.data() + static_cast<size_t>(tileY) * m_tilesX;
+    for (uint32_t tileX = 0; tileX < m_tilesX; tileX++)
+    {
+        const uint32_t x0 = tileX * TILE_WIDTH;
+        hashes[tileX] = HashTile(frame.Row(y0) + x0 * 4, frame.pitch, std::min(TILE_WIDTH, frame.width - x0), height);
+    }
+}
+
+// Tiles whose hash differs from the reference, up to the first past the limit
+// Eight hashes are compared per step; a step where all match (every tile of a duplicate, most
+// of a near-duplicate) costs four compares and one movemask
+uint32_t DuplicateFrameDetector::CountChangedTiles() const
+{
+    const __m128i* a = reinterpret_cast<const __m128i*>(m_hashes.data());
+    const __m128i* b = reinterpret_cast<const __m128i*>(m_reference.data());
+    const size_t count = m_hashes.size();
+    uint32_t changed = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i equal[4];
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            equal[j] = _mm_cmpeq_epi32(_mm_loadu_si128(a + i / 2 + j), _mm_loadu_si128(b + i / 2 + j));
+        }
+        __m128i all = _mm_and_si128(_mm_and_si128(equal[0], equal[1]), _mm_and_si128(equal[2], equal[3]));
+        if (_mm_movemask_epi8(all) == 0xFFFF)
+        {
+            continue;
+        }
+
+        // A hash matches only if both of its 32-bit halves do
+        for (uint32_t j = 0; j < 4; j++)
+        {
+            const int mask = _mm_movemask_epi8(equal[j]);
+            changed += ((mask & 0x00FF) != 0x00FF ? 1 : 0) + ((mask & 0xFF00) != 0xFF00 ? 1 : 0);
+        }
+        if (changed > m_changedTileLimit)
+        {
+            return changed;
+        }
+    }
+    for (; i < count && changed <= m_changedTileLimit; i++)
+    {
+        changed += m_hashes[i] != m_reference[i] ? 1 : 0;
+    }
+    return changed;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "ImageView.h"
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+struct DuplicateFrameStats
+{
+    float checkMs = 0.0f;         // Hashing and comparing the last capture
+    float checkMsAverage = 0.0f;  // Smoothed
+    uint32_t changedTiles = 0;    // Tiles of the last capture unlike the last new frame (counting stops past the limit)
+    uint64_t captures = 0;        // Captures checked
+    uint64_t newFrames = 0;       // Captures tagged as new frames
+    double frameInterval = 0.0;   // Smoothed time between new frames in seconds, 0 until two were seen
+};
+
+// Tells new game frames from repeated captures of the same one
+// Desktop Duplication hands out a frame whenever anything on the desktop changes, so a game
+// running below the refresh rate arrives as runs of identical captures. Each capture is cut into
+// TILE_WIDTH x TILE_HEIGHT tiles and every tile gets a 64-bit hash of its colour channels
+// (xxHash64-style multiply-rotate rounds, tile rows in parallel), so only a real collision hides
+// a change. The hashes are compared with the last new frame's eight at a time (SSE2), stopping
+// as soon as more tiles differ than the limit allows. A duplicate keeps the last new frame's
+// hashes and time, so small changes can't pile up over a run of duplicates.
+class DuplicateFrameDetector
+{
+public:
+    static constexpr uint32_t TILE_WIDTH = 64;
+    static constexpr uint32_t TILE_HEIGHT = 16;
+
+    DuplicateFrameDetector();
+
+    // Tiles that may change while a capture still counts as a duplicate
+    // 0 by default: a game frame that only moves a cursor or a small sprite over a still scene
+    // changes a tile or two and must not be dropped. Raise it only when something outside the
+    // game (a blinking caret, a clock) shares the captured area
+    void SetChangedTileLimit(uint32_t tiles) { m_changedTileLimit = tiles; }
+    uint32_t GetChangedTileLimit() const { return m_changedTileLimit; }
+
+    // Checks a capture whose image was presented at timestamp (seconds, any steady clock); true
+    // for a new frame
+    // The first capture and any size change are new frames
+    bool Update(const ImageView& frame, double timestamp);
+    void Reset();
+
+    // Present times of the last new frame and of the one before it, 0 until seen
+    double GetLastFrameTime() const { return m_lastFrameTime; }
+    double GetPreviousFrameTime() const { return m_previousFrameTime; }
+
+    const DuplicateFrameStats& GetStats() const { return m_stats; }
+
+private:
+    void HashTileRow(const ImageView& frame, uint32_t tileY);
+    uint32_t CountChangedTiles() const;
+
+private:
+    ThreadPool& m_pool;
+    uint32_t m_changedTileLimit = 0;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_tilesX = 0;
+    std::vector<uint64_t> m_reference;  // Tile hashes of the last new frame, row by row
+    std::vector<uint64_t> m_hashes;     // Of the capture being checked
+    double m_lastFrameTime = 0.0;
+    double m_previousFrameTime = 0.0;
+    DuplicateFrameStats m_stats;
+};
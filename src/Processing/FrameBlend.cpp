@@ -0,0 +1,189 @@
+#include "FrameBlend.h"
+#include "../Utils/CpuFeatures.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Fixed16 holds channels as value * 128 and t in Q15, like the bilinear kernel
+    const int FIXED_SHIFT = 7;
+
+    // Scalar versions for the row tails, rounding the same way as the vector code
+    void BlendFloatScalar(const uint8_t* a, const uint8_t* b, float t, uint8_t* dst, uint32_t begin, uint32_t count)
+    {
+        for (uint32_t i = begin; i < count; i++)
+        {
+            float value = a[i] + (b[i] - a[i]) * t;
+            dst[i] = static_cast<uint8_t>(std::nearbyint(value));
+        }
+    }
+
+    void BlendFixedScalar(const uint8_t* a, const uint8_t* b, int16_t weight, uint8_t* dst, uint32_t begin, uint32_t count)
+    {
+        const int round = 1 << (FIXED_SHIFT - 1);
+        for (uint32_t i = begin; i < count; i++)
+        {
+            int from = a[i] << FIXED_SHIFT;
+            int delta = (b[i] - a[i]) * (1 << FIXED_SHIFT);
+            int value = from + ((delta * weight + 0x4000) >> 15);
+            dst[i] = static_cast<uint8_t>(std::min(std::max((value + round) >> FIXED_SHIFT, 0), 255));
+        }
+    }
+
+    // 16 channels per step in four float vectors
+    void BlendFloatSse2(const uint8_t* a, const uint8_t* b, float t, uint8_t* dst, uint32_t count)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 weight = _mm_set1_ps(t);
+        uint32_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i words[2][2] = {
+                { _mm_unpacklo_epi8(va, zero), _mm_unpackhi_epi8(va, zero) },
+                { _mm_unpacklo_epi8(vb, zero), _mm_unpackhi_epi8(vb, zero) },
+            };
+            __m128i result[4];
+            for (int k = 0; k < 4; k++)
+            {
+                __m128i wa = words[0][k >> 1];
+                __m128i wb = words[1][k >> 1];
+                __m128 fa = _mm_cvtepi32_ps((k & 1) ? _mm_unpackhi_epi16(wa, zero) : _mm_unpacklo_epi16(wa, zero));
+                __m128 fb = _mm_cvtepi32_ps((k & 1) ? _mm_unpackhi_epi16(wb, zero) : _mm_unpacklo_epi16(wb, zero));
+                result[k] = _mm_cvtps_epi32(_mm_add_ps(fa, _mm_mul_ps(_mm_sub_ps(fb, fa), weight)));
+            }
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(result[0], result[1]), _mm_packs_epi32(result[2], result[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+        }
+        BlendFloatScalar(a, b, t, dst, i, count);
+    }
+
+    // 32 channels per step; mul + add rather than FMA so both float kernels round the same
+    POTATO_TARGET_AVX2
+    void BlendFloatAVX2(const uint8_t* a, const uint8_t* b, float t, uint8_t* dst, uint32_t count)
+    {
+        const __m256 weight = _mm256_set1_ps(t);
+        uint32_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            __m256i result[4];
+            for (int k = 0; k < 4; k++)
+            {
+                __m256 fa = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i + k * 8))));
+                __m256 fb = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + i + k * 8))));
+                result[k] = _mm256_cvtps_epi32(_mm256_add_ps(fa, _mm256_mul_ps(_mm256_sub_ps(fb, fa), weight)));
+            }
+            // The packs work per 128-bit lane, leaving groups of 4 channels in the order
+            // 0 2 4 6 1 3 5 7
+            __m256i words0 = _mm256_packs_epi32(result[0], result[1]);
+            __m256i words1 = _mm256_packs_epi32(result[2], result[3]);
+            __m256i packed = _mm256_packus_epi16(words0, words1);
+            packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+        }
+        BlendFloatScalar(a, b, t, dst, i, count);
+    }
+
+    POTATO_TARGET_SSE41
+    inline __m128i BlendFixedSse41(__m128i a, __m128i b, __m128i weight, __m128i round)
+    {
+        __m128i from = _mm_slli_epi16(a, FIXED_SHIFT);
+        __m128i value = _mm_add_epi16(from, _mm_mulhrs_epi16(_mm_sub_epi16(_mm_slli_epi16(b, FIXED_SHIFT), from), weight));
+        return _mm_srai_epi16(_mm_add_epi16(value, round), FIXED_SHIFT);
+    }
+
+    // 16 channels per step in two 16-bit vectors
+    POTATO_TARGET_SSE41
+    void BlendFixedSse41(const uint8_t* a, const uint8_t* b, int16_t t, uint8_t* dst, uint32_t count)
+    {
+        const __m128i weight = _mm_set1_epi16(t);
+        const __m128i round = _mm_set1_epi16(1 << (FIXED_SHIFT - 1));
+        uint32_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            __m128i lo = BlendFixedSse41(_mm_cvtepu8_epi16(va), _mm_cvtepu8_epi16(vb), weight, round);
+            __m128i hi = BlendFixedSse41(_mm_cvtepu8_epi16(_mm_srli_si128(va, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(vb, 8)), weight, round);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+        BlendFixedScalar(a, b, t, dst, i, count);
+    }
+
+    POTATO_TARGET_AVX2
+    inline __m256i BlendFixedAVX2(__m256i a, __m256i b, __m256i weight, __m256i round)
+    {
+        __m256i from = _mm256_slli_epi16(a, FIXED_SHIFT);
+        __m256i value = _mm256_add_epi16(from, _mm256_mulhrs_epi16(_mm256_sub_epi16(_mm256_slli_epi16(b, FIXED_SHIFT), from), weight));
+        return _mm256_srai_epi16(_mm256_add_epi16(value, round), FIXED_SHIFT);
+    }
+
+    // 32 channels per step
+    POTATO_TARGET_AVX2
+    void BlendFixedAVX2(const uint8_t* a, const uint8_t* b, int16_t t, uint8_t* dst, uint32_t count)
+    {
+        const __m256i weight = _mm256_set1_epi16(t);
+        const __m256i round = _mm256_set1_epi16(1 << (FIXED_SHIFT - 1));
+        uint32_t i = 0;
+        for (; i + 32 <= count; i += 32)
+        {
+            __m256i lo = BlendFixedAVX2(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))),
+                                        _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))), weight, round);
+            __m256i hi = BlendFixedAVX2(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 16))),
+                                        _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + 16))), weight, round);
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), packed);
+        }
+        BlendFixedScalar(a, b, t, dst, i, count);
+    }
+}
+
+void BlendRow(const uint8_t* a, const uint8_t* b, float t, uint8_t* dst, uint32_t width, KernelPrecision precision)
+{
+    const CpuFeatures& cpu = GetCpuFeatures();
+    const uint32_t count = width * 4;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+
+    if (precision == KernelPrecision::Fixed16 && cpu.sse41)
+    {
+        int16_t weight = static_cast<int16_t>(std::min(std::lround(t * 32768.0f), 32767L));
+        if (cpu.avx2)
+        {
+            BlendFixedAVX2(a, b, weight, dst, count);
+        }
+        else
+        {
+            BlendFixedSse41(a, b, weight, dst, count);
+        }
+        return;
+    }
+
+    if (cpu.avx2)
+    {
+        BlendFloatAVX2(a, b, t, dst, count);
+    }
+    else
+    {
+        BlendFloatSse2(a, b, t, dst, count);
+    }
+}
+
+void BlendFrames(const ImageView& a, const ImageView& b, float t, const MutableImageView& dst, KernelPrecision precision)
+{
+    if (!a.data || !b.data || !dst.data)
+    {
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::Shared();
+    pool.ParallelFor(dst.height, pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            BlendRow(a.Row(y), b.Row(y), t, dst.Row(y), dst.width, precision);
+        }
+    });
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "ImageView.h"
+#include "PixelSimd.h"
+#include <cstdint>
+
+// Cross-fade of two BGRA8 frames, dst = a + (b - a) * t with t in 0..1 (all four channels)
+// The blend step of frame interpolation, and its fallback when motion can't be trusted.
+// Float widens to float lanes (SSE2/AVX2), Fixed16 lerps in 16-bit lanes (SSE4.1/AVX2).
+
+// One row, for callers already inside a parallel loop; dst may be a or b
+void BlendRow(const uint8_t* a, const uint8_t* b, float t, uint8_t* dst, uint32_t width, KernelPrecision precision);
+
+// Whole frames of the same size, rows split over the shared thread pool
+void BlendFrames(const ImageView& a, const ImageView& b, float t, const MutableImageView& dst,
+                 KernelPrecision precision = KernelPrecision::Float);
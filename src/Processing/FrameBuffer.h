@@ -0,0 +1,294 @@
+#pragma once
+#include "ImageView.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Owning CPU frame with a choice of memory layout
+// Captures and the kernels' ImageViews are interleaved BGRA rows. 2D stencil kernels (FSR taps,
+// block matching) can run on a planar or tiled copy instead when that suits their access
+// pattern better. Every plane row, and every tile, starts on a 64-byte boundary.
+
+const size_t FRAME_ALIGNMENT = 64;
+
+// Pixel formats: channel type and channels per pixel
+struct Bgra8Pixel
+{
+    using Channel = uint8_t;
+    static const uint32_t CHANNELS = 4;
+};
+
+struct Luma8Pixel
+{
+    using Channel = uint8_t;
+    static const uint32_t CHANNELS = 1;
+};
+
+// Elements rounded up to whole 64-byte lines
+template <typename Format>
+inline size_t AlignElements(size_t count)
+{
+    const size_t perLine = FRAME_ALIGNMENT / sizeof(typename Format::Channel);
+    return (count + perLine - 1) / perLine * perLine;
+}
+
+// Consecutive pixels of one row stored at a fixed step
+// Channel c of pixel i is data[i * step + c * channelStride]
+template <typename Channel>
+struct PixelSpan
+{
+    Channel* data;
+    uint32_t x;      // First pixel of the span
+    uint32_t count;
+    size_t step;
+    size_t channelStride;
+};
+
+// Layouts describe where a pixel lives; each has a Geometry per pixel format with
+// Set() (returns the elements needed), Offset() of a pixel's first channel, the pixel step
+// and channel stride, RunLength() of the contiguous pixels from x and the block size that
+// follows the storage order
+
+// BGRA BGRA ... rows, the layout of captures and ImageView
+struct InterleavedLayout
+{
+    static const char* Name() { return "interleaved"; }
+
+    template <typename Format>
+    struct Geometry
+    {
+        static const bool INTERLEAVED = true;
+        size_t stride = 0;  // Elements between rows
+        uint32_t width = 0;
+
+        size_t Set(uint32_t frameWidth, uint32_t frameHeight)
+        {
+            width = frameWidth;
+            stride = AlignElements<Format>(static_cast<size_t>(frameWidth) * Format::CHANNELS);
+            return stride * frameHeight;
+        }
+
+        size_t Offset(uint32_t x, uint32_t y) const { return y * stride + static_cast<size_t>(x) * Format::CHANNELS; }
+        size_t PixelStep() const { return Format::CHANNELS; }
+        size_t ChannelStride() const { return 1; }
+        uint32_t RunLength(uint32_t x) const { return width - x; }
+        uint32_t BlockWidth() const { return width; }
+        uint32_t BlockHeight() const { return 1; }
+    };
+};
+
+// One plane per channel (structure of arrays), a channel's horizontal neighbours are adjacent
+struct PlanarLayout
+{
+    static const char* Name() { return "planar"; }
+
+    template <typename Format>
+    struct Geometry
+    {
+        static const bool INTERLEAVED = Format::CHANNELS == 1;
+        size_t stride = 0;     // Elements between rows of a plane
+        size_t planeSize = 0;  // Elements per plane
+        uint32_t width = 0;
+
+        size_t Set(uint32_t frameWidth, uint32_t frameHeight)
+        {
+            width = frameWidth;
+            stride = AlignElements<Format>(frameWidth);
+            planeSize = stride * frameHeight;
+            return planeSize * Format::CHANNELS;
+        }
+
+        size_t Offset(uint32_t x, uint32_t y) const { return y * stride + x; }
+        size_t PixelStep() const { return 1; }
+        size_t ChannelStride() const { return planeSize; }
+        uint32_t RunLength(uint32_t x) const { return width - x; }
+        uint32_t BlockWidth() const { return width; }
+        uint32_t BlockHeight() const { return 1; }
+    };
+};
+
+// TILE x TILE pixel tiles stored one after another (row-major inside a tile, channels
+// interleaved), so a small 2D window touches a few cache lines instead of a line per row
+// Tiles hanging over the right and bottom edges are stored whole
+template <uint32_t TILE>
+struct TiledLayout
+{
+    static const char* Name() { return TILE == 8 ? "tiled 8x8" : TILE == 32 ? "tiled 32x32" : "tiled"; }
+
+    template <typename Format>
+    struct Geometry
+    {
+        static const bool INTERLEAVED = true;
+        size_t tileSize = 0;  // Elements per tile, whole 64-byte lines
+        uint32_t tilesPerRow = 0;
+
+        size_t Set(uint32_t frameWidth, uint32_t frameHeight)
+        {
+            tilesPerRow = (frameWidth + TILE - 1) / TILE;
+            tileSize = AlignElements<Format>(static_cast<size_t>(TILE) * TILE * Format::CHANNELS);
+            return tileSize * tilesPerRow * ((frameHeight + TILE - 1) / TILE);
+        }
+
+        size_t Offset(uint32_t x, uint32_t y) const
+        {
+            size_t tile = static_cast<size_t>(y / TILE) * tilesPerRow + x / TILE;
+            return tile * tileSize + ((y % TILE) * TILE + x % TILE) * Format::CHANNELS;
+        }
+
+        size_t PixelStep() const { return Format::CHANNELS; }
+        size_t ChannelStride() const { return 1; }
+        uint32_t RunLength(uint32_t x) const { return TILE - x % TILE; }
+        uint32_t BlockWidth() const { return TILE; }
+        uint32_t BlockHeight() const { return TILE; }
+    };
+};
+
+template <typename Format, typename Layout>
+class FrameBuffer
+{
+public:
+    using Channel = typename Format::Channel;
+    using Geometry = typename Layout::template Geometry<Format>;
+
+    FrameBuffer() = default;
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+    FrameBuffer(FrameBuffer&&) = default;
+    FrameBuffer& operator=(FrameBuffer&&) = default;
+
+    // Contents are undefined after a size change
+    void Allocate(uint32_t width, uint32_t height)
+    {
+        size_t size = m_geometry.Set(width, height);
+        const size_t slack = FRAME_ALIGNMENT / sizeof(Channel);
+        m_storage.resize(size + slack);
+
+        size_t misalignment = reinterpret_cast<uintptr_t>(m_storage.data()) % FRAME_ALIGNMENT;
+        m_alignment = misalignment ? (FRAME_ALIGNMENT - misalignment) / sizeof(Channel) : 0;
+        m_width = width;
+        m_height = height;
+    }
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+    const Geometry& GetGeometry() const { return m_geometry; }
+
+    // First channel of a pixel; the others are ChannelStride() apart
+    Channel* PixelAt(uint32_t x, uint32_t y) { return Data() + m_geometry.Offset(x, y); }
+    const Channel* PixelAt(uint32_t x, uint32_t y) const { return Data() + m_geometry.Offset(x, y); }
+    size_t ChannelStride() const { return m_geometry.ChannelStride(); }
+
+    Channel& At(uint32_t x, uint32_t y, uint32_t c) { return PixelAt(x, y)[c * ChannelStride()]; }
+    Channel At(uint32_t x, uint32_t y, uint32_t c) const { return PixelAt(x, y)[c * ChannelStride()]; }
+
+    // Row y as contiguous spans, left to right (one for row layouts, one per tile otherwise)
+    template <typename Fn>
+    void ForEachSpan(uint32_t y, Fn&& fn)
+    {
+        for (uint32_t x = 0; x < m_width;)
+        {
+            uint32_t count = std::min(m_geometry.RunLength(x), m_width - x);
+            fn(PixelSpan<Channel>{ PixelAt(x, y), x, count, m_geometry.PixelStep(), ChannelStride() });
+            x += count;
+        }
+    }
+
+    template <typename Fn>
+    void ForEachSpan(uint32_t y, Fn&& fn) const
+    {
+        for (uint32_t x = 0; x < m_width;)
+        {
+            uint32_t count = std::min(m_geometry.RunLength(x), m_width - x);
+            fn(PixelSpan<const Channel>{ PixelAt(x, y), x, count, m_geometry.PixelStep(), ChannelStride() });
+            x += count;
+        }
+    }
+
+    // The frame as rectangles in storage order (tiles, or single rows), fn(x, y, width, height)
+    // A kernel that works block by block then walks memory front to back
+    uint32_t GetBlockRows() const { return (m_height + m_geometry.BlockHeight() - 1) / m_geometry.BlockHeight(); }
+
+    template <typename Fn>
+    void ForEachBlock(uint32_t blockRow, Fn&& fn) const
+    {
+        const uint32_t blockWidth = m_geometry.BlockWidth();
+        const uint32_t y = blockRow * m_geometry.BlockHeight();
+        const uint32_t height = std::min(m_geometry.BlockHeight(), m_height - y);
+        for (uint32_t x = 0; x < m_width; x += blockWidth)
+        {
+            fn(x, y, std::min(blockWidth, m_width - x), height);
+        }
+    }
+
+    template <typename Fn>
+    void ForEachBlock(Fn&& fn) const
+    {
+        for (uint32_t row = 0; row < GetBlockRows(); row++)
+        {
+            ForEachBlock(row, fn);
+        }
+    }
+
+    // Conversion from and to interleaved images of the same format (BGRA8 ImageView);
+    // Load() sizes the frame to src
+    void Load(const ImageView& src)
+    {
+        Allocate(src.width, src.height);
+        for (uint32_t y = 0; y < m_height; y++)
+        {
+            const Channel* row = reinterpret_cast<const Channel*>(src.Row(y));
+            ForEachSpan(y, [&](const PixelSpan<Channel>& span)
+            {
+                CopySpan(row + static_cast<size_t>(span.x) * Format::CHANNELS, Format::CHANNELS, 1,
+                         span.data, span.step, span.channelStride, span.count);
+            });
+        }
+    }
+
+    void Store(const MutableImageView& dst) const
+    {
+        const uint32_t height = std::min(m_height, dst.height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            Channel* row = reinterpret_cast<Channel*>(dst.Row(y));
+            ForEachSpan(y, [&](const PixelSpan<const Channel>& span)
+            {
+                if (span.x < dst.width)
+                {
+                    CopySpan(span.data, span.step, span.channelStride, row + static_cast<size_t>(span.x) * Format::CHANNELS,
+                             Format::CHANNELS, 1, std::min(span.count, dst.width - span.x));
+                }
+            });
+        }
+    }
+
+private:
+    Channel* Data() { return m_storage.data() + m_alignment; }
+    const Channel* Data() const { return m_storage.data() + m_alignment; }
+
+    static void CopySpan(const Channel* src, size_t srcStep, size_t srcChannelStride,
+                         Channel* dst, size_t dstStep, size_t dstChannelStride, uint32_t count)
+    {
+        if (srcStep == dstStep && srcChannelStride == 1 && dstChannelStride == 1)
+        {
+            memcpy(dst, src, count * srcStep * sizeof(Channel));
+            return;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t c = 0; c < Format::CHANNELS; c++)
+            {
+                dst[i * dstStep + c * dstChannelStride] = src[i * srcStep + c * srcChannelStride];
+            }
+        }
+    }
+
+private:
+    std::vector<Channel> m_storage;  // Over-allocated by a line so Data() can be aligned
+    size_t m_alignment = 0;
+    Geometry m_geometry;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+};
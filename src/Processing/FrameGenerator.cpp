@@ -0,0 +1,1177 @@
+#include "FrameGenerator.h"
+#include "BlockSad.h"
+#include "FrameBlend.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    const uint32_t MAX_BLOCK_SIZE = 32;
+
+    // Static blocks: zero motion and at most STATIC_SAD luma levels (or STATIC_ERROR squared RGB
+    // levels) of difference per pixel, about what capture and compression noise leave
+    const uint32_t STATIC_SAD = 1;
+    const uint32_t STATIC_ERROR = 3;
+
+    // Extrapolation: marks a pixel no block landed on
+    const int16_t NO_VECTOR = -32768;
+
+    // Hierarchical search: the coarsest level is the first where the range is at most
+    // COARSE_RANGE pixels; finer levels refine by REFINE_RANGE around their best predictor
+    const uint32_t COARSE_RANGE = 4;
+    const int32_t REFINE_RANGE = 2;
+
+    // Cost of a pixel of distance from the predicted vector, in SAD units
+    const uint32_t MOTION_PENALTY = 4;
+
+    // Predictive search: a block is done once its cost is at most EARLY_EXIT_SAD per pixel.
+    // The hexagon walks at most MAX_PATTERN_STEPS steps
+    const uint32_t EARLY_EXIT_SAD = 1;
+    const uint32_t MAX_PATTERN_STEPS = 16;
+    const uint32_t MAX_TESTED = 64;
+    const int32_t HEXAGON[6][2] = { { -2, 0 }, { 2, 0 }, { -1, -2 }, { 1, -2 }, { -1, 2 }, { 1, 2 } };
+    const int32_t DIAMOND[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+    // Squared RGB difference of count pixels (a multiple of 4), alpha ignored
+    uint32_t RowError(const uint8_t* a, const uint8_t* b, uint32_t count)
+    {
+        const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sum = zero;
+        for (uint32_t x = 0; x < count; x += 4)
+        {
+            __m128i pa = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x * 4)), rgbMask);
+            __m128i pb = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x * 4)), rgbMask);
+            __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(pa, zero), _mm_unpacklo_epi8(pb, zero));
+            __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(pa, zero), _mm_unpackhi_epi8(pb, zero));
+            sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+        return static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+    }
+
+    uint32_t PixelError(const uint8_t* a, const uint8_t* b)
+    {
+        int32_t db = a[0] - b[0];
+        int32_t dg = a[1] - b[1];
+        int32_t dr = a[2] - b[2];
+        return static_cast<uint32_t>(db * db + dg * dg + dr * dr);
+    }
+
+    int32_t Clamp(int32_t value, int32_t low, int32_t high)
+    {
+        return value < low ? low : (value > high ? high : value);
+    }
+
+    // Whole pixels a vector moves over distance frames, rounded to nearest
+    int32_t Scaled(int16_t component, float distance)
+    {
+        return static_cast<int32_t>(std::floor(component * distance + 0.5f));
+    }
+
+    int32_t Length2(const MotionVector& vector)
+    {
+        return vector.x * vector.x + vector.y * vector.y;
+    }
+
+    // Error of the width x height block at (x0, y0) of current against previous moved by (dx, dy)
+    // Stops early once it reaches limit, the candidate can't win then
+    uint32_t BlockError(const ImageView& previous, const ImageView& current, uint32_t x0, uint32_t y0,
+                        uint32_t width, uint32_t height, int32_t dx, int32_t dy, uint32_t limit)
+    {
+        const int32_t px = static_cast<int32_t>(x0) + dx;
+        const int32_t py = static_cast<int32_t>(y0) + dy;
+        const bool inside = width % 4 == 0 && px >= 0 && py >= 0 &&
+                            px + static_cast<int32_t>(width) <= static_cast<int32_t>(previous.width) &&
+                            py + static_cast<int32_t>(height) <= static_cast<int32_t>(previous.height);
+
+        uint32_t error = 0;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* cur = current.Row(y0 + y) + x0 * 4;
+            if (inside)
+            {
+                error += RowError(cur, previous.Row(py + y) + px * 4, width);
+            }
+            else
+            {
+                // Off the previous frame: clamped texels, as a sampler would return
+                const uint8_t* prev = previous.Row(Clamp(py + static_cast<int32_t>(y), 0, previous.height - 1));
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    error += PixelError(cur + x * 4, prev + Clamp(px + static_cast<int32_t>(x), 0, previous.width - 1) * 4);
+                }
+            }
+
+            if (error >= limit)
+            {
+                break;
+            }
+        }
+        return error;
+    }
+
+    // Sum of absolute luma differences, same conventions as BlockError()
+    uint32_t LumaBlockSad(const LumaView& previous, const LumaView& current, uint32_t x0, uint32_t y0,
+                          uint32_t width, uint32_t height, int32_t dx, int32_t dy, uint32_t limit)
+    {
+        const int32_t px = static_cast<int32_t>(x0) + dx;
+        const int32_t py = static_cast<int32_t>(y0) + dy;
+        const bool inside = px >= 0 && py >= 0 &&
+                            px + static_cast<int32_t>(width) <= static_cast<int32_t>(previous.width) &&
+                            py + static_cast<int32_t>(height) <= static_cast<int32_t>(previous.height);
+        if (inside && width == height && (width == 8 || width == 16))
+        {
+            return BlockSad(current.Row(y0) + x0, current.pitch, previous.Row(py) + px, previous.pitch, width);
+        }
+
+        uint32_t sad = 0;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* cur = current.Row(y0 + y) + x0;
+            if (inside)
+            {
+                sad += RowSad(cur, previous.Row(py + y) + px, width);
+            }
+            else
+            {
+                const uint8_t* prev = previous.Row(Clamp(py + static_cast<int32_t>(y), 0, previous.height - 1));
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    sad += static_cast<uint32_t>(std::abs(cur[x] - prev[Clamp(px + static_cast<int32_t>(x), 0, previous.width - 1)]));
+                }
+            }
+
+            if (sad >= limit)
+            {
+                break;
+            }
+        }
+        return sad;
+    }
+}
+
+FrameGenerator::FrameGenerator()
+    : m_pool(ThreadPool::Shared())
+{
+}
+
+FrameGenerator::~FrameGenerator()
+{
+}
+
+void FrameGenerator::SetBlockSize(uint32_t blockSize)
+{
+    blockSize = std::min(std::max(blockSize, 4u), MAX_BLOCK_SIZE);
+    m_blockSize = blockSize / 4 * 4;
+}
+
+void FrameGenerator::Generate(const ImageView& previous, const ImageView& current, const MutableImageView& dst, float t)
+{
+    if (RepeatOnCut(previous, current, &dst, &t, 1))
+    {
+        return;
+    }
+    EstimateMotion(previous, current);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Interpolate(previous, current, dst, t);
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.interpolateMs = std::chrono::duration<float, std::milli>(end - start).count();
+    m_stats.frames++;
+    m_generationMs = m_stats.estimateMs + m_stats.interpolateMs;
+}
+
+void FrameGenerator::Generate(const ImageView& previous, const ImageView& current, const MutableImageView* dst, uint32_t count)
+{
+    count = std::min(count, MAX_GENERATED_FRAMES);
+    float t[MAX_GENERATED_FRAMES];
+    for (uint32_t k = 0; k < count; k++)
+    {
+        t[k] = static_cast<float>(k + 1) / (count + 1);
+    }
+
+    if (RepeatOnCut(previous, current, dst, t, count))
+    {
+        return;
+    }
+    EstimateMotion(previous, current);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Interpolate(previous, current, dst, t, count);
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.interpolateMs = std::chrono::duration<float, std::milli>(end - start).count();
+    m_stats.frames += count;
+    m_generationMs = m_stats.estimateMs + m_stats.interpolateMs;
+}
+
+// Checks the pair for a scene cut and, if it is one, fills dst with the source frame nearest to
+// each t. Returns true if dst was written
+bool FrameGenerator::RepeatOnCut(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t,
+                                 uint32_t count)
+{
+    m_stats.sceneCut = false;
+    if (!m_cutDetection)
+    {
+        m_stats.cutDetectMs = 0.0f;
+        return false;
+    }
+
+    m_lastCut = m_cutDetector.Compare(previous, current);
+    m_stats.cutDetectMs = m_lastCut.detectMs;
+    if (!m_lastCut.cut)
+    {
+        return false;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    RepeatFrames(previous, current, dst, t, count);
+    auto end = std::chrono::high_resolution_clock::now();
+    const float repeatMs = std::chrono::duration<float, std::milli>(end - start).count();
+
+    // The last field belongs to the old shot, it mustn't seed the next search
+    m_previousField = MotionField();
+    m_pairValid = false;
+    m_stats.sceneCut = true;
+    m_stats.cuts++;
+    m_stats.frames += count;
+    m_stats.cutSavedMs += std::max(0.0f, m_generationMs - repeatMs);
+    return true;
+}
+
+// dst[k] = the source frame nearer to t[k]
+void FrameGenerator::RepeatFrames(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t,
+                                  uint32_t count)
+{
+    for (uint32_t k = 0; k < count; k++)
+    {
+        // A capture size change is a cut too; only a source of dst's size can be copied
+        const bool previousFits = previous.width == dst[k].width && previous.height == dst[k].height;
+        const bool currentFits = current.width == dst[k].width && current.height == dst[k].height;
+        if (!previousFits && !currentFits)
+        {
+            continue;
+        }
+        const ImageView& source = (t[k] < 0.5f && previousFits) || !currentFits ? previous : current;
+        const size_t rowBytes = static_cast<size_t>(dst[k].width) * 4;
+        m_pool.ParallelFor(dst[k].height, m_pool.SuggestGrain(dst[k].height), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t y = begin; y < end; y++)
+            {
+                memcpy(dst[k].Row(y), source.Row(y), rowBytes);
+            }
+        });
+    }
+}
+
+void FrameGenerator::GenerateAt(const ImageView& previous, double previousTime, const ImageView& current, double currentTime,
+                                double outputTime, const MutableImageView& dst)
+{
+    const double span = currentTime - previousTime;
+    const float t = span > 0.0 ? static_cast<float>(std::min(std::max((outputTime - previousTime) / span, 0.0), 1.0)) : 1.0f;
+
+    if (!m_pairValid || m_pairTimes[0] != previousTime || m_pairTimes[1] != currentTime)
+    {
+        Generate(previous, current, dst, t);
+        m_pairTimes[0] = previousTime;
+        m_pairTimes[1] = currentTime;
+        m_pairValid = true;
+        m_pairIsCut = m_stats.sceneCut;
+        return;
+    }
+
+    m_stats.reusedEstimates++;
+    m_stats.frames++;
+    if (m_pairIsCut)
+    {
+        RepeatFrames(previous, current, &dst, &t, 1);
+        return;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Interpolate(previous, current, dst, t);
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.interpolateMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void FrameGenerator::EstimateMotion(const ImageView& previous, const ImageView& current)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    m_pairValid = false;
+
+    if (m_search != MotionSearch::Exhaustive)
+    {
+        m_previousPyramid.Build(previous);
+        m_currentPyramid.Build(current);
+        auto built = std::chrono::high_resolution_clock::now();
+
+        EstimateMotion(m_previousPyramid, m_currentPyramid);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        m_stats.pyramidMs = std::chrono::duration<float, std::milli>(built - start).count();
+        m_stats.estimateMs = std::chrono::duration<float, std::milli>(end - start).count();
+        return;
+    }
+    m_stats.pyramidMs = 0.0f;
+
+    m_field.blockSize = m_blockSize;
+    m_field.blocksX = (current.width + m_blockSize - 1) / m_blockSize;
+    m_field.blocksY = (current.height + m_blockSize - 1) / m_blockSize;
+    m_field.vectors.resize(static_cast<size_t>(m_field.blocksX) * m_field.blocksY);
+    m_staticBlocks.assign(m_staticBypass ? m_field.vectors.size() : 0, 0);
+
+    // One block row per chunk, rows cost about the same
+    m_pool.ParallelFor(m_field.blocksY, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t blockY = begin; blockY < end; blockY++)
+        {
+            MatchBlockRow(previous, current, blockY);
+        }
+    });
+    CountStaticBlocks();
+
+    const float side = static_cast<float>(2 * m_searchRange + 1);
+    m_stats.candidatesPerBlock = side * side;
+    m_previousField = m_field;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.estimateMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void FrameGenerator::EstimateMotion(const LumaPyramid& previous, const LumaPyramid& current)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    m_pairValid = false;
+    m_candidates.store(0, std::memory_order_relaxed);
+
+    if (m_search == MotionSearch::Predictive)
+    {
+        SearchPredictive(previous, current);
+    }
+    else if (m_search == MotionSearch::DenseFlow)
+    {
+        m_opticalFlow.SetMaxMotion(m_searchRange);
+        m_opticalFlow.Compute(previous, current);
+        SampleFlowField(current.GetWidth(), current.GetHeight());
+    }
+    else
+    {
+        uint32_t coarsest = 0;
+        const uint32_t levels = std::min(previous.GetLevelCount(), current.GetLevelCount());
+        while (coarsest + 1 < levels && (m_searchRange >> coarsest) > COARSE_RANGE)
+        {
+            coarsest++;
+        }
+
+        for (uint32_t level = coarsest + 1; level-- > 0;)
+        {
+            SearchLevel(previous, current, level, coarsest);
+        }
+    }
+    MarkStaticBlocks(previous.GetLevel(0), current.GetLevel(0));
+
+    m_stats.candidatesPerBlock = static_cast<float>(m_candidates.load(std::memory_order_relaxed)) / m_field.vectors.size();
+    m_previousField = m_field;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.estimateMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void FrameGenerator::SearchLevel(const LumaPyramid& previous, const LumaPyramid& current, uint32_t level, uint32_t coarsest)
+{
+    const LumaView& previousLevel = previous.GetLevel(level);
+    const LumaView& currentLevel = current.GetLevel(level);
+
+    MotionField& field = LevelField(level);
+    field.blockSize = m_blockSize;
+    field.blocksX = (currentLevel.width + m_blockSize - 1) / m_blockSize;
+    field.blocksY = (currentLevel.height + m_blockSize - 1) / m_blockSize;
+    field.vectors.resize(static_cast<size_t>(field.blocksX) * field.blocksY);
+
+    m_pool.ParallelFor(field.blocksY, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t blockY = begin; blockY < end; blockY++)
+        {
+            SearchLevelRow(previousLevel, currentLevel, level, coarsest, blockY);
+        }
+    });
+}
+
+void FrameGenerator::SearchLevelRow(const LumaView& previous, const LumaView& current, uint32_t level, uint32_t coarsest, uint32_t blockY)
+{
+    MotionField& field = LevelField(level);
+    const uint32_t y0 = blockY * m_blockSize;
+    const uint32_t height = std::min(m_blockSize, current.height - y0);
+    const int32_t coarseRange = static_cast<int32_t>((m_searchRange + (1u << level) - 1) >> level);
+    MotionVector left;
+    uint64_t candidates = 0;
+
+    for (uint32_t blockX = 0; blockX < field.blocksX; blockX++)
+    {
+        const uint32_t x0 = blockX * m_blockSize;
+        const uint32_t width = std::min(m_blockSize, current.width - x0);
+
+        // Cost is the SAD plus a penalty per pixel of distance from the prediction (the block
+        // to the left at the coarsest level, the parent below), so flat and repeating blocks,
+        // which match well almost anywhere, follow their neighbours
+        int32_t predictedX = 0;
+        int32_t predictedY = 0;
+        int32_t bestX = 0;
+        int32_t bestY = 0;
+        uint32_t bestCost = UINT32_MAX;
+        auto penaltyOf = [&](int32_t dx, int32_t dy)
+        {
+            return MOTION_PENALTY * static_cast<uint32_t>(std::abs(dx - predictedX) + std::abs(dy - predictedY));
+        };
+        auto takeIfBetter = [&](int32_t dx, int32_t dy, uint32_t cost)
+        {
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestX = dx;
+                bestY = dy;
+            }
+        };
+        auto tryCandidate = [&](int32_t dx, int32_t dy)
+        {
+            uint32_t penalty = penaltyOf(dx, dy);
+            if (penalty < bestCost)
+            {
+                takeIfBetter(dx, dy, LumaBlockSad(previous, current, x0, y0, width, height, dx, dy, bestCost - penalty) + penalty);
+                candidates++;
+            }
+        };
+
+        int32_t centerX = 0;
+        int32_t centerY = 0;
+        int32_t range = coarseRange;
+        if (level < coarsest)
+        {
+            // The parent block and its neighbours on this block's side (vectors doubled), the
+            // block to the left and zero
+            const MotionField& parent = LevelField(level + 1);
+            const uint32_t parentX = std::min(blockX / 2, parent.blocksX - 1);
+            const uint32_t parentY = std::min(blockY / 2, parent.blocksY - 1);
+            const uint32_t sideX = (blockX & 1) ? std::min(parentX + 1, parent.blocksX - 1) : (parentX ? parentX - 1 : 0);
+            const uint32_t sideY = (blockY & 1) ? std::min(parentY + 1, parent.blocksY - 1) : (parentY ? parentY - 1 : 0);
+            const MotionVector predictors[3] = { parent.At(parentX, parentY), parent.At(sideX, parentY), parent.At(parentX, sideY) };
+            predictedX = predictors[0].x * 2;
+            predictedY = predictors[0].y * 2;
+            for (const MotionVector& predictor : predictors)
+            {
+                tryCandidate(predictor.x * 2, predictor.y * 2);
+            }
+            tryCandidate(left.x, left.y);
+            tryCandidate(0, 0);
+            centerX = bestX;
+            centerY = bestY;
+            range = REFINE_RANGE;
+        }
+        else
+        {
+            predictedX = left.x;
+            predictedY = left.y;
+            tryCandidate(predictedX, predictedY);
+        }
+
+        // Rows of the window go eight offsets at a time while the block is square and they,
+        // plus the kernel's overread, stay inside the frame
+        const bool batched = width == height && (width == 8 || width == 16);
+        for (int32_t dy = centerY - range; dy <= centerY + range; dy++)
+        {
+            const int32_t py = static_cast<int32_t>(y0) + dy;
+            const bool rowInside = py >= 0 && py + static_cast<int32_t>(height) <= static_cast<int32_t>(previous.height);
+            for (int32_t dx = centerX - range; dx <= centerX + range; dx += 8)
+            {
+                const int32_t count = std::min(8, centerX + range - dx + 1);
+                const int32_t px = static_cast<int32_t>(x0) + dx;
+                if (batched && rowInside && count > 1 && px >= 0 && px + static_cast<int32_t>(width) + 8 <= static_cast<int32_t>(previous.width))
+                {
+                    uint32_t sads[8];
+                    BlockSadX8(current.Row(y0) + x0, current.pitch, previous.Row(py) + px, previous.pitch, width, sads);
+                    for (int32_t i = 0; i < count; i++)
+                    {
+                        takeIfBetter(dx + i, dy, sads[i] + penaltyOf(dx + i, dy));
+                    }
+                    candidates += static_cast<uint64_t>(count);
+                }
+                else
+                {
+                    for (int32_t i = 0; i < count; i++)
+                    {
+                        tryCandidate(dx + i, dy);
+                    }
+                }
+            }
+        }
+        left = { static_cast<int16_t>(bestX), static_cast<int16_t>(bestY) };
+        field.vectors[static_cast<size_t>(blockY) * field.blocksX + blockX] = left;
+    }
+    m_candidates.fetch_add(candidates, std::memory_order_relaxed);
+}
+
+void FrameGenerator::SearchPredictive(const LumaPyramid& previousPyramid, const LumaPyramid& currentPyramid)
+{
+    const LumaView& previous = previousPyramid.GetLevel(0);
+    const LumaView& current = currentPyramid.GetLevel(0);
+    m_globalMotion = EstimateGlobalMotion(previousPyramid, currentPyramid);
+
+    m_field.blockSize = m_blockSize;
+    m_field.blocksX = (current.width + m_blockSize - 1) / m_blockSize;
+    m_field.blocksY = (current.height + m_blockSize - 1) / m_blockSize;
+    m_field.vectors.resize(static_cast<size_t>(m_field.blocksX) * m_field.blocksY);
+
+    // The last field can seed this one if it has the same block grid
+    const bool temporal = m_previousField.blockSize == m_field.blockSize &&
+                          m_previousField.blocksX == m_field.blocksX && m_previousField.blocksY == m_field.blocksY;
+
+    m_pool.ParallelFor(m_field.blocksY, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t blockY = begin; blockY < end; blockY++)
+        {
+            SearchPredictiveRow(previous, current, blockY, temporal);
+        }
+    });
+}
+
+void FrameGenerator::SearchPredictiveRow(const LumaView& previous, const LumaView& current, uint32_t blockY, bool temporal)
+{
+    const int32_t range = static_cast<int32_t>(m_searchRange);
+    const uint32_t y0 = blockY * m_blockSize;
+    const uint32_t height = std::min(m_blockSize, current.height - y0);
+    MotionVector left;
+    uint64_t candidates = 0;
+
+    for (uint32_t blockX = 0; blockX < m_field.blocksX; blockX++)
+    {
+        const uint32_t x0 = blockX * m_blockSize;
+        const uint32_t width = std::min(m_blockSize, current.width - x0);
+        const uint32_t goodEnough = EARLY_EXIT_SAD * width * height;
+
+        // Seeds, most likely first: the co-located vector of the last field and its right and
+        // lower neighbours (the blocks this frame hasn't reached yet), the block to the left,
+        // this frame's global motion and zero. Costs carry the hierarchical search's penalty,
+        // measured from the first seed
+        MotionVector seeds[6];
+        uint32_t seedCount = 0;
+        if (temporal)
+        {
+            seeds[seedCount++] = m_previousField.At(blockX, blockY);
+            seeds[seedCount++] = m_previousField.At(std::min(blockX + 1, m_field.blocksX - 1), blockY);
+            seeds[seedCount++] = m_previousField.At(blockX, std::min(blockY + 1, m_field.blocksY - 1));
+        }
+        seeds[seedCount++] = left;
+        seeds[seedCount++] = m_globalMotion;
+        seeds[seedCount++] = MotionVector();
+
+        const int32_t predictedX = seeds[0].x;
+        const int32_t predictedY = seeds[0].y;
+        int32_t bestX = 0;
+        int32_t bestY = 0;
+        uint32_t bestCost = UINT32_MAX;
+
+        // Offsets already scored for this block; the patterns overlap
+        MotionVector tested[MAX_TESTED];
+        uint32_t testedCount = 0;
+        auto tryCandidate = [&](int32_t dx, int32_t dy)
+        {
+            if (dx < -range || dx > range || dy < -range || dy > range)
+            {
+                return;
+            }
+            for (uint32_t i = 0; i < testedCount; i++)
+            {
+                if (tested[i].x == dx && tested[i].y == dy)
+                {
+                    return;
+                }
+            }
+            if (testedCount < MAX_TESTED)
+            {
+                tested[testedCount++] = { static_cast<int16_t>(dx), static_cast<int16_t>(dy) };
+            }
+
+            uint32_t penalty = MOTION_PENALTY * static_cast<uint32_t>(std::abs(dx - predictedX) + std::abs(dy - predictedY));
+            if (penalty >= bestCost)
+            {
+                return;
+            }
+            uint32_t cost = LumaBlockSad(previous, current, x0, y0, width, height, dx, dy, bestCost - penalty) + penalty;
+            candidates++;
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestX = dx;
+                bestY = dy;
+            }
+        };
+
+        for (uint32_t i = 0; i < seedCount && bestCost > goodEnough; i++)
+        {
+            tryCandidate(seeds[i].x, seeds[i].y);
+        }
+
+        // Large hexagon steps while the best moves, then one small diamond around it
+        for (uint32_t step = 0; step < MAX_PATTERN_STEPS && bestCost > goodEnough; step++)
+        {
+            const int32_t centerX = bestX;
+            const int32_t centerY = bestY;
+            for (const auto& offset : HEXAGON)
+            {
+                tryCandidate(centerX + offset[0], centerY + offset[1]);
+            }
+            if (bestX == centerX && bestY == centerY)
+            {
+                break;
+            }
+        }
+        if (bestCost > goodEnough)
+        {
+            const int32_t centerX = bestX;
+            const int32_t centerY = bestY;
+            for (const auto& offset : DIAMOND)
+            {
+                tryCandidate(centerX + offset[0], centerY + offset[1]);
+            }
+        }
+
+        left = { static_cast<int16_t>(bestX), static_cast<int16_t>(bestY) };
+        m_field.vectors[static_cast<size_t>(blockY) * m_field.blocksX + blockX] = left;
+    }
+    m_candidates.fetch_add(candidates, std::memory_order_relaxed);
+}
+
+// Block field for callers that want one: the flow at each block's centre, rounded
+void FrameGenerator::SampleFlowField(uint32_t width, uint32_t height)
+{
+    m_field.blockSize = m_blockSize;
+    m_field.blocksX = (width + m_blockSize - 1) / m_blockSize;
+    m_field.blocksY = (height + m_blockSize - 1) / m_blockSize;
+    m_field.vectors.resize(static_cast<size_t>(m_field.blocksX) * m_field.blocksY);
+
+    const FlowField& flow = m_opticalFlow.GetFlow();
+    const float half = m_blockSize * 0.5f - 0.5f;
+    for (uint32_t blockY = 0; blockY < m_field.blocksY; blockY++)
+    {
+        for (uint32_t blockX = 0; blockX < m_field.blocksX; blockX++)
+        {
+            MotionVector& motion = m_field.vectors[static_cast<size_t>(blockY) * m_field.blocksX + blockX];
+            if (flow.IsEmpty())
+            {
+                motion = MotionVector();
+                continue;
+            }
+            float dx;
+            float dy;
+            flow.Sample(blockX * m_blockSize + half, blockY * m_blockSize + half, dx, dy);
+            motion.x = static_cast<int16_t>(std::lround(dx));
+            motion.y = static_cast<int16_t>(std::lround(dy));
+        }
+    }
+}
+
+MotionVector FrameGenerator::EstimateGlobalMotion(const LumaPyramid& previous, const LumaPyramid& current) const
+{
+    // Whole-frame SAD: every offset within the range at the level where it's a few pixels, then
+    // REFINE_RANGE either way at each finer level down to half resolution. A strip as wide as
+    // the largest offset is left out around the frame so every offset compares the same pixels
+    const uint32_t levels = std::min(previous.GetLevelCount(), current.GetLevelCount());
+    uint32_t coarsest = 0;
+    while (coarsest + 1 < levels && (m_searchRange >> coarsest) > COARSE_RANGE)
+    {
+        coarsest++;
+    }
+    const uint32_t finest = coarsest > 0 ? 1 : 0;
+
+    int32_t bestX = 0;
+    int32_t bestY = 0;
+    for (uint32_t level = coarsest + 1; level-- > finest;)
+    {
+        int32_t range = static_cast<int32_t>((m_searchRange + (1u << level) - 1) >> level);
+        if (level < coarsest)
+        {
+            bestX *= 2;
+            bestY *= 2;
+            range = REFINE_RANGE;
+        }
+
+        const LumaView& prev = previous.GetLevel(level);
+        const LumaView& cur = current.GetLevel(level);
+        const int32_t centerX = bestX;
+        const int32_t centerY = bestY;
+        const uint32_t margin = static_cast<uint32_t>(std::max(std::abs(centerX), std::abs(centerY)) + range);
+        if (cur.width <= 2 * margin || cur.height <= 2 * margin)
+        {
+            continue;
+        }
+
+        uint64_t bestSad = UINT64_MAX;
+        for (int32_t dy = centerY - range; dy <= centerY + range; dy++)
+        {
+            for (int32_t dx = centerX - range; dx <= centerX + range; dx++)
+            {
+                uint64_t sad = 0;
+                for (uint32_t y = margin; y < cur.height - margin && sad < bestSad; y++)
+                {
+                    sad += RowSad(cur.Row(y) + margin, prev.Row(y + dy) + margin + dx, cur.width - 2 * margin);
+                }
+                if (sad < bestSad)
+                {
+                    bestSad = sad;
+                    bestX = dx;
+                    bestY = dy;
+                }
+            }
+        }
+    }
+
+    MotionVector global;
+    global.x = static_cast<int16_t>(bestX * (1 << finest));
+    global.y = static_cast<int16_t>(bestY * (1 << finest));
+    return global;
+}
+
+void FrameGenerator::MatchBlockRow(const ImageView& previous, const ImageView& current, uint32_t blockY)
+{
+    const int32_t range = static_cast<int32_t>(m_searchRange);
+    const uint32_t y0 = blockY * m_blockSize;
+    const uint32_t height = std::min(m_blockSize, current.height - y0);
+
+    for (uint32_t blockX = 0; blockX < m_field.blocksX; blockX++)
+    {
+        const uint32_t x0 = blockX * m_blockSize;
+        const uint32_t width = std::min(m_blockSize, current.width - x0);
+
+        // Same scan order as the shader, the first of equal errors wins
+        MotionVector best;
+        uint32_t bestError = UINT32_MAX;
+        for (int32_t dy = -range; dy <= range; dy++)
+        {
+            for (int32_t dx = -range; dx <= range; dx++)
+            {
+                uint32_t error = BlockError(previous, current, x0, y0, width, height, dx, dy, bestError);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best.x = static_cast<int16_t>(dx);
+                    best.y = static_cast<int16_t>(dy);
+                }
+            }
+        }
+        const size_t index = static_cast<size_t>(blockY) * m_field.blocksX + blockX;
+        m_field.vectors[index] = best;
+
+        // The zero offset's error is complete when it wins, the scan only stops losing candidates
+        if (!m_staticBlocks.empty() && best.x == 0 && best.y == 0 && bestError <= STATIC_ERROR * width * height)
+        {
+            m_staticBlocks[index] = 1;
+        }
+    }
+}
+
+// Static mask of the pyramid searches: zero vector blocks checked on full resolution luma
+void FrameGenerator::MarkStaticBlocks(const LumaView& previous, const LumaView& current)
+{
+    m_staticBlocks.assign(m_staticBypass ? m_field.vectors.size() : 0, 0);
+    if (m_staticBlocks.empty() || previous.width != current.width || previous.height != current.height)
+    {
+        CountStaticBlocks();
+        return;
+    }
+
+    m_pool.ParallelFor(m_field.blocksY, m_pool.SuggestGrain(m_field.blocksY), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t blockY = begin; blockY < end; blockY++)
+        {
+            const uint32_t y0 = blockY * m_blockSize;
+            const uint32_t height = std::min(m_blockSize, current.height - y0);
+            for (uint32_t blockX = 0; blockX < m_field.blocksX; blockX++)
+            {
+                const size_t index = static_cast<size_t>(blockY) * m_field.blocksX + blockX;
+                const MotionVector& motion = m_field.vectors[index];
+                if (motion.x != 0 || motion.y != 0)
+                {
+                    continue;
+                }
+                const uint32_t x0 = blockX * m_blockSize;
+                const uint32_t width = std::min(m_blockSize, current.width - x0);
+                const uint32_t limit = STATIC_SAD * width * height + 1;
+                m_staticBlocks[index] = LumaBlockSad(previous, current, x0, y0, width, height, 0, 0, limit) < limit ? 1 : 0;
+            }
+        }
+    });
+    CountStaticBlocks();
+}
+
+void FrameGenerator::CountStaticBlocks()
+{
+    const size_t count = std::count(m_staticBlocks.begin(), m_staticBlocks.end(), static_cast<uint8_t>(1));
+    m_stats.staticRatio = m_field.vectors.empty() ? 0.0f : static_cast<float>(count) / m_field.vectors.size();
+}
+
+void FrameGenerator::Interpolate(const ImageView& previous, const ImageView& current, const MutableImageView& dst, float t) const
+{
+    Interpolate(previous, current, &dst, &t, 1);
+}
+
+void FrameGenerator::Interpolate(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t,
+                                 uint32_t count) const
+{
+    count = std::min(count, MAX_GENERATED_FRAMES);
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Only frames of one size can be fetched from; nothing is written otherwise
+    bool sameSize = previous.width == current.width && previous.height == current.height;
+    for (uint32_t k = 0; k < count; k++)
+    {
+        sameSize = sameSize && dst[k].width == current.width && dst[k].height == current.height;
+    }
+    if (!sameSize)
+    {
+        return;
+    }
+
+    // Without a field for this frame size (no estimate yet, or a size change) cross-fade instead
+    const bool matches = m_field.blockSize != 0 && m_field.blocksX == (current.width + m_field.blockSize - 1) / m_field.blockSize &&
+                         m_field.blocksY == (current.height + m_field.blockSize - 1) / m_field.blockSize;
+    if (!matches)
+    {
+        for (uint32_t k = 0; k < count; k++)
+        {
+            BlendFrames(previous, current, t[k], dst[k]);
+        }
+        return;
+    }
+
+    // Per-pixel fetches only if the flow was computed for frames of this size
+    const FlowField& flow = m_opticalFlow.GetFlow();
+    const bool dense = m_search == MotionSearch::DenseFlow && !flow.IsEmpty() &&
+                       flow.width == current.width >> flow.level && flow.height == current.height >> flow.level;
+
+    // Every frame of the batch is written row by row in the same pass, while the source rows
+    // around y are still in cache
+    const uint32_t height = dst[0].height;
+    m_pool.ParallelFor(height, m_pool.SuggestGrain(height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            if (dense)
+            {
+                InterpolateFlowRow(previous, current, dst, t, count, y);
+            }
+            else
+            {
+                InterpolateRow(previous, current, dst, t, count, y);
+            }
+        }
+    });
+}
+
+void FrameGenerator::InterpolateRow(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t,
+                                    uint32_t count, uint32_t y) const
+{
+    const int32_t width = static_cast<int32_t>(current.width);
+    const int32_t maxX = width - 1;
+    const int32_t maxY = static_cast<int32_t>(current.height) - 1;
+    const uint32_t blockY = y / m_field.blockSize;
+
+    const uint8_t* staticBlocks = m_staticBlocks.empty() ? nullptr : m_staticBlocks.data() + static_cast<size_t>(blockY) * m_field.blocksX;
+
+    uint8_t prevPixels[MAX_BLOCK_SIZE * 4];
+    uint8_t curPixels[MAX_BLOCK_SIZE * 4];
+
+    // Neighbouring blocks with the same vector blend as one run (the whole row in a pan)
+    for (uint32_t blockX = 0; blockX < m_field.blocksX;)
+    {
+        const MotionVector& motion = m_field.At(blockX, blockY);
+        const uint8_t still = staticBlocks ? staticBlocks[blockX] : 0;
+        uint32_t runEnd = blockX + 1;
+        while (runEnd < m_field.blocksX && m_field.At(runEnd, blockY).x == motion.x && m_field.At(runEnd, blockY).y == motion.y &&
+               (staticBlocks ? staticBlocks[runEnd] : 0) == still)
+        {
+            runEnd++;
+        }
+        const int32_t x0 = static_cast<int32_t>(blockX * m_field.blockSize);
+        const int32_t run = std::min(static_cast<int32_t>(runEnd * m_field.blockSize), width) - x0;
+        blockX = runEnd;
+
+        if (still)
+        {
+            // Both frames agree here, every intermediate is the current frame
+            for (uint32_t k = 0; k < count; k++)
+            {
+                memcpy(dst[k].Row(y) + x0 * 4, current.Row(y) + x0 * 4, static_cast<size_t>(run) * 4);
+            }
+            continue;
+        }
+
+        for (uint32_t k = 0; k < count; k++)
+        {
+            // The pixel at time t lies on its block's vector: moved by motion * t in the previous
+            // frame and by motion * t - motion in the current one (nearest texel, so the two
+            // offsets always span exactly the vector)
+            const float time = t[k];
+            const int32_t prevX = static_cast<int32_t>(std::floor(motion.x * time + 0.5f));
+            const int32_t prevY = static_cast<int32_t>(std::floor(motion.y * time + 0.5f));
+            const int32_t curX = prevX - motion.x;
+            const int32_t curY = prevY - motion.y;
+            const uint8_t* prevRow = previous.Row(Clamp(static_cast<int32_t>(y) + prevY, 0, maxY));
+            const uint8_t* curRow = current.Row(Clamp(static_cast<int32_t>(y) + curY, 0, maxY));
+            uint8_t* out = dst[k].Row(y);
+
+            if (x0 + std::min(prevX, curX) >= 0 && x0 + run + std::max(prevX, curX) <= width)
+            {
+                BlendRow(prevRow + (x0 + prevX) * 4, curRow + (x0 + curX) * 4, time, out + x0 * 4, static_cast<uint32_t>(run),
+                         KernelPrecision::Float);
+                continue;
+            }
+
+            // The run crosses the frame edge, clamp per pixel
+            for (int32_t begin = x0; begin < x0 + run; begin += MAX_BLOCK_SIZE)
+            {
+                const int32_t segment = std::min(static_cast<int32_t>(MAX_BLOCK_SIZE), x0 + run - begin);
+                for (int32_t i = 0; i < segment; i++)
+                {
+                    memcpy(prevPixels + i * 4, prevRow + Clamp(begin + i + prevX, 0, maxX) * 4, 4);
+                    memcpy(curPixels + i * 4, curRow + Clamp(begin + i + curX, 0, maxX) * 4, 4);
+                }
+                BlendRow(prevPixels, curPixels, time, out + begin * 4, static_cast<uint32_t>(segment), KernelPrecision::Float);
+            }
+        }
+    }
+}
+
+void FrameGenerator::InterpolateFlowRow(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t,
+                                        uint32_t count, uint32_t y) const
+{
+    const FlowField& flow = m_opticalFlow.GetFlow();
+    const int32_t width = static_cast<int32_t>(current.width);
+    const int32_t maxX = width - 1;
+    const int32_t maxY = static_cast<int32_t>(current.height) - 1;
+
+    float flowX[MAX_BLOCK_SIZE];
+    float flowY[MAX_BLOCK_SIZE];
+    uint8_t prevPixels[MAX_BLOCK_SIZE * 4];
+    uint8_t curPixels[MAX_BLOCK_SIZE * 4];
+
+    // Runs of static blocks are copied as in InterpolateRow(); in between, the same blend with
+    // each pixel's own vector (nearest texel, rounded), gathered MAX_BLOCK_SIZE pixels at a time,
+    // the flow sampled once for all frames
+    const uint32_t blockY = y / m_field.blockSize;
+    const bool masked = !m_staticBlocks.empty() && blockY < m_field.blocksY;
+    int32_t x0 = 0;
+    while (x0 < width)
+    {
+        int32_t runEnd = width;
+        if (masked)
+        {
+            const uint8_t* staticBlocks = m_staticBlocks.data() + static_cast<size_t>(blockY) * m_field.blocksX;
+            uint32_t blockX = static_cast<uint32_t>(x0) / m_field.blockSize;
+            const uint8_t still = staticBlocks[blockX];
+            while (blockX < m_field.blocksX && staticBlocks[blockX] == still)
+            {
+                blockX++;
+            }
+            runEnd = std::min(static_cast<int32_t>(blockX * m_field.blockSize), width);
+            if (still)
+            {
+                for (uint32_t k = 0; k < count; k++)
+                {
+                    memcpy(dst[k].Row(y) + x0 * 4, current.Row(y) + x0 * 4, static_cast<size_t>(runEnd - x0) * 4);
+                }
+                x0 = runEnd;
+                continue;
+            }
+        }
+
+        const int32_t segment = std::min(static_cast<int32_t>(MAX_BLOCK_SIZE), runEnd - x0);
+        for (int32_t i = 0; i < segment; i++)
+        {
+            flow.Sample(static_cast<float>(x0 + i), static_cast<float>(y), flowX[i], flowY[i]);
+        }
+
+        for (uint32_t k = 0; k < count; k++)
+        {
+            const float time = t[k];
+            for (int32_t i = 0; i < segment; i++)
+            {
+                const int32_t prevX = Clamp(x0 + i + static_cast<int32_t>(std::floor(flowX[i] * time + 0.5f)), 0, maxX);
+                const int32_t prevY = Clamp(static_cast<int32_t>(y) + static_cast<int32_t>(std::floor(flowY[i] * time + 0.5f)), 0, maxY);
+                const int32_t curX = Clamp(x0 + i + static_cast<int32_t>(std::floor(-flowX[i] * (1.0f - time) + 0.5f)), 0, maxX);
+                const int32_t curY = Clamp(static_cast<int32_t>(y) + static_cast<int32_t>(std::floor(-flowY[i] * (1.0f - time) + 0.5f)), 0, maxY);
+                memcpy(prevPixels + i * 4, previous.Row(prevY) + prevX * 4, 4);
+                memcpy(curPixels + i * 4, current.Row(curY) + curX * 4, 4);
+            }
+            BlendRow(prevPixels, curPixels, time, dst[k].Row(y) + x0 * 4, static_cast<uint32_t>(segment), KernelPrecision::Float);
+        }
+        x0 += segment;
+    }
+}
+
+void FrameGenerator::Extrapolate(const ImageView& previous, const ImageView& current, const MutableImageView& dst)
+{
+    // Across a cut the prediction is the current frame
+    const float t = 1.0f;
+    if (RepeatOnCut(previous, current, &dst, &t, 1))
+    {
+        return;
+    }
+    EstimateMotion(previous, current);
+    ExtrapolateFrame(current, dst, m_predictionDistance);
+    m_stats.frames++;
+    m_generationMs = m_stats.estimateMs + m_stats.extrapolateMs;
+}
+
+void FrameGenerator::ExtrapolateFrame(const ImageView& current, const MutableImageView& dst, float distance)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Without a field for this frame size there is nothing to move, repeat the frame
+    const bool matches = m_field.blockSize != 0 && m_field.blocksX == (current.width + m_field.blockSize - 1) / m_field.blockSize &&
+                         m_field.blocksY == (current.height + m_field.blockSize - 1) / m_field.blockSize;
+    if (!matches)
+    {
+        for (uint32_t y = 0; y < dst.height; y++)
+        {
+            memcpy(dst.Row(y), current.Row(y), static_cast<size_t>(current.width) * 4);
+        }
+        m_stats.holeRatio = 0.0f;
+        m_stats.extrapolateMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return;
+    }
+
+    // Rows a block can land away from its own, which bounds the source rows each output row checks
+    int32_t reach = 0;
+    for (const MotionVector& vector : m_field.vectors)
+    {
+        reach = std::max(reach, std::abs(Scaled(vector.y, distance)));
+    }
+
+    m_landed.resize(static_cast<size_t>(current.width) * current.height);
+    std::atomic<uint64_t> holes{ 0 };
+    m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        uint64_t count = 0;
+        for (uint32_t y = begin; y < end; y++)
+        {
+            count += ExtrapolateRow(current, dst.Row(y), y, distance, reach);
+        }
+        holes.fetch_add(count, std::memory_order_relaxed);
+    });
+
+    m_stats.holeRatio = static_cast<float>(holes.load(std::memory_order_relaxed)) / m_landed.size();
+    m_stats.extrapolateMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+uint32_t FrameGenerator::ExtrapolateRow(const ImageView& current, uint8_t* dst, uint32_t y, float distance, int32_t reach)
+{
+    const int32_t width = static_cast<int32_t>(current.width);
+    const int32_t height = static_cast<int32_t>(current.height);
+    const int32_t blockSize = static_cast<int32_t>(m_field.blockSize);
+    MotionVector* landed = &m_landed[static_cast<size_t>(y) * current.width];
+    for (int32_t x = 0; x < width; x++)
+    {
+        landed[x].x = NO_VECTOR;
+    }
+
+    // Forward warp: the pixel at p of the current frame lands at p - vector * distance. Only the
+    // block rows within reach can land on row y
+    const int32_t firstBlockY = std::max(static_cast<int32_t>(y) - reach, 0) / blockSize;
+    const int32_t lastBlockY = std::min(static_cast<int32_t>(y) + reach, height - 1) / blockSize;
+    for (int32_t blockY = firstBlockY; blockY <= lastBlockY; blockY++)
+    {
+        for (uint32_t blockX = 0; blockX < m_field.blocksX; blockX++)
+        {
+            const MotionVector& vector = m_field.At(blockX, static_cast<uint32_t>(blockY));
+            const int32_t sourceY = static_cast<int32_t>(y) + Scaled(vector.y, distance);
+            if (sourceY < blockY * blockSize || sourceY >= std::min((blockY + 1) * blockSize, height))
+            {
+                continue;
+            }
+
+            const int32_t shift = Scaled(vector.x, distance);
+            const int32_t sourceX = static_cast<int32_t>(blockX) * blockSize;
+            const int32_t begin = std::max(sourceX - shift, 0);
+            const int32_t end = std::min(std::min(sourceX + blockSize, width) - shift, width);
+            const int32_t length = Length2(vector);
+            for (int32_t x = begin; x < end; x++)
+            {
+                if (landed[x].x == NO_VECTOR || Length2(landed[x]) < length)
+                {
+                    landed[x] = vector;
+                }
+            }
+        }
+    }
+
+    // Holes are what the foreground uncovered: take the slower of the nearest vectors either side
+    uint32_t holes = 0;
+    for (int32_t x = 0; x < width;)
+    {
+        if (landed[x].x != NO_VECTOR)
+        {
+            x++;
+            continue;
+        }
+        int32_t end = x;
+        while (end < width && landed[end].x == NO_VECTOR)
+        {
+            end++;
+        }
+
+        MotionVector fill;
+        const bool hasLeft = x > 0;
+        const bool hasRight = end < width;
+        if (hasLeft && hasRight)
+        {
+            fill = Length2(landed[x - 1]) <= Length2(landed[end]) ? landed[x - 1] : landed[end];
+        }
+        else if (hasLeft || hasRight)
+        {
+            fill = hasLeft ? landed[x - 1] : landed[end];
+        }
+        for (int32_t i = x; i < end; i++)
+        {
+            landed[i] = fill;
+        }
+        holes += static_cast<uint32_t>(end - x);
+        x = end;
+    }
+
+    // Backward fetch along the landed vectors, a run of equal vectors at a time
+    const int32_t maxX = width - 1;
+    for (int32_t x = 0; x < width;)
+    {
+        const MotionVector vector = landed[x];
+        int32_t end = x + 1;
+        while (end < width && landed[end].x == vector.x && landed[end].y == vector.y)
+        {
+            end++;
+        }
+
+        const int32_t shift = Scaled(vector.x, distance);
+        const uint8_t* row = current.Row(Clamp(static_cast<int32_t>(y) + Scaled(vector.y, distance), 0, height - 1));
+        if (x + shift >= 0 && end + shift <= width)
+        {
+            memcpy(dst + x * 4, row + (x + shift) * 4, static_cast<size_t>(end - x) * 4);
+        }
+        else
+        {
+            for (int32_t i = x; i < end; i++)
+            {
+                memcpy(dst + i * 4, row + Clamp(i + shift, 0, maxX) * 4, 4);
+            }
+        }
+        x = end;
+    }
+    return holes;
+}
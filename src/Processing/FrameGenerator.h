@@ -0,0 +1,217 @@
+#pragma once
+#include "AnalysisPyramid.h"
+#include "ImageView.h"
+#include "OpticalFlow.h"
+#include "SceneCutDetector.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Per-block motion, in pixels: the block's content was at (x, y) + offset in the previous frame
+struct MotionVector
+{
+    int16_t x = 0;
+    int16_t y = 0;
+};
+
+// One vector per blockSize x blockSize block of the current frame, row by row
+struct MotionField
+{
+    std::vector<MotionVector> vectors;
+    uint32_t blocksX = 0;
+    uint32_t blocksY = 0;
+    uint32_t blockSize = 0;
+
+    const MotionVector& At(uint32_t blockX, uint32_t blockY) const { return vectors[blockY * blocksX + blockX]; }
+};
+
+enum class MotionSearch
+{
+    Exhaustive,    // Every offset within the range, full resolution RGB (the shader's search)
+    Hierarchical,  // Coarse-to-fine over the luma pyramid
+    Predictive,    // Seeded from neighbouring and last-frame vectors, then a short pattern search
+    DenseFlow      // Per-pixel optical flow (DenseOpticalFlow); the block field is sampled from it
+};
+
+struct FrameGeneratorStats
+{
+    float pyramidMs = 0.0f;           // Luma pyramids of both frames (hierarchical and predictive search)
+    float estimateMs = 0.0f;          // Motion estimation of the last frame, pyramids included
+    float candidatesPerBlock = 0.0f;  // Offsets scored per full resolution block, all levels counted (0 for dense flow)
+    float interpolateMs = 0.0f;       // Motion-compensated blend of the last frame (or batch of frames)
+    float extrapolateMs = 0.0f;       // Forward warp and hole filling of the last predicted frame
+    float holeRatio = 0.0f;           // Share of the last predicted frame no block landed on
+    float staticRatio = 0.0f;         // Share of the last estimate's blocks copied rather than blended
+    float cutDetectMs = 0.0f;         // Scene cut check of the last source pair
+    float cutSavedMs = 0.0f;          // Estimation and blending skipped at cuts, all cuts so far
+    bool sceneCut = false;            // The last source pair was a cut and its frames were repeated
+    uint64_t cuts = 0;                // Source pairs treated as cuts
+    uint64_t reusedEstimates = 0;     // GenerateAt() calls served by an earlier call's estimate
+    uint64_t frames = 0;              // Frames generated
+};
+
+// Generates frames between two BGRA8 captures on the CPU
+// Port of MotionEstimation.hlsl and FrameInterpolation.hlsl: exhaustive block matching on the
+// squared RGB difference, then each output pixel fetches both frames along its block's vector
+// (nearest texel, like the shader's integer loads) and blends them. Candidates that reach outside
+// the previous frame read clamped texels rather than being skipped, which let off-frame offsets
+// win at the borders. Block rows are matched in parallel on the shared thread pool.
+// The hierarchical search instead matches luma blocks at the coarsest pyramid level that brings
+// the range down to a few pixels, then at each finer level tries the doubled vectors of the parent
+// block and its two nearest neighbours, the block to the left and zero, and refines the best by
+// two pixels. Costs carry a small penalty for straying from the prediction. The candidates per
+// block stay about the same whatever the range, so large pans cost no more than small ones.
+// The predictive search scores a handful of seed vectors (the last field around the block, the
+// block to the left, the frame's global motion, zero) on full resolution luma, walks a hexagon
+// from the best one and finishes with a small diamond, stopping as soon as a block matches within
+// one level per pixel. Global motion is a whole-frame SAD search on the coarse pyramid levels.
+// Dense flow gives every pixel its own vector, so moving edges don't carry their block's motion
+// into the background; interpolation then fetches along the per-pixel flow.
+// For 3x and 4x output one motion estimate serves every intermediate frame, and a single pass
+// over the rows writes all of them, so each row's source pixels (and per-pixel flow) are fetched
+// once for the whole batch.
+// Blocks whose best vector is zero and that barely differ between the two frames (HUDs, menus,
+// a still background) are marked static; interpolation copies them straight from the current
+// frame and only warps and blends the rest.
+// Generate() and Extrapolate() first check the two frames for a scene cut; across a cut there is
+// no motion to find, so every output frame repeats the nearer source frame and motion estimation
+// is skipped.
+// Extrapolation predicts a frame past the current one instead, so it can be shown before the
+// next capture arrives rather than holding the current one back. Each block of the current frame
+// is pushed on along its vector (forward warp, the larger vector winning where blocks land on the
+// same pixel, as the foreground usually moves more), pixels no block reaches are filled with the
+// vector of the nearer-to-static of their row neighbours, and every pixel then copies the current
+// frame from where its vector says it came from.
+class FrameGenerator
+{
+public:
+    // Intermediate frames per source pair, for up to 4x output
+    static constexpr uint32_t MAX_GENERATED_FRAMES = 3;
+
+    FrameGenerator();
+    ~FrameGenerator();
+
+    // 4 to 32, a multiple of 4 (8 and 16 are the usual choices)
+    void SetBlockSize(uint32_t blockSize);
+    uint32_t GetBlockSize() const { return m_blockSize; }
+
+    // Largest offset tried in each direction, in pixels
+    void SetSearchRange(uint32_t searchRange) { m_searchRange = searchRange; }
+    uint32_t GetSearchRange() const { return m_searchRange; }
+
+    void SetMotionSearch(MotionSearch search) { m_search = search; }
+    MotionSearch GetMotionSearch() const { return m_search; }
+
+    // Copy static blocks instead of blending them (on by default); applies from the next estimate
+    void SetStaticBypass(bool enabled) { m_staticBypass = enabled; }
+    bool GetStaticBypass() const { return m_staticBypass; }
+
+    // Repeat frames across scene cuts (on by default); the threshold is the detector's
+    void SetSceneCutDetection(bool enabled) { m_cutDetection = enabled; }
+    bool GetSceneCutDetection() const { return m_cutDetection; }
+    void SetSceneCutThreshold(float threshold) { m_cutDetector.SetThreshold(threshold); }
+
+    // Detector figures of the last source pair checked
+    const SceneCutResult& GetLastSceneCut() const { return m_lastCut; }
+
+    // Frame at time t between previous (0) and current (1); all three the same size
+    void Generate(const ImageView& previous, const ImageView& current, const MutableImageView& dst, float t = 0.5f);
+
+    // count frames (output multiplier - 1, at most MAX_GENERATED_FRAMES) at t = k / (count + 1),
+    // k = 1..count, into dst[0..count)
+    void Generate(const ImageView& previous, const ImageView& current, const MutableImageView* dst, uint32_t count);
+
+    // Frame at outputTime between source frames presented at previousTime and currentTime, in
+    // seconds. The times should be those FrameAnalysis keeps for two new frames, with repeated
+    // captures dropped, so the spacing is the game's frame time rather than the capture rate.
+    // Further calls for the same two source frames (the refreshes between them) reuse the motion
+    // estimate of the first
+    void GenerateAt(const ImageView& previous, double previousTime, const ImageView& current, double currentTime,
+                    double outputTime, const MutableImageView& dst);
+
+    // The two steps of Generate()
+    void EstimateMotion(const ImageView& previous, const ImageView& current);
+
+    // Hierarchical, predictive or dense flow search on pyramids the caller already has (e.g. from
+    // FrameAnalysis); Exhaustive needs the frames, the hierarchical search runs instead
+    void EstimateMotion(const LumaPyramid& previous, const LumaPyramid& current);
+
+    // Frames of one size; without a motion field for that size (nothing estimated yet, or the
+    // size changed since) the output is a cross-fade
+    void Interpolate(const ImageView& previous, const ImageView& current, const MutableImageView& dst, float t) const;
+
+    // dst[k] at time t[k], k < count (at most MAX_GENERATED_FRAMES), in one pass
+    void Interpolate(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t, uint32_t count) const;
+
+    // Extrapolation: how far past the current frame to predict, in source frame intervals
+    // (0.5 = the half way slot of 2x output, 1 = the next capture itself)
+    void SetPredictionDistance(float distance) { m_predictionDistance = distance; }
+    float GetPredictionDistance() const { return m_predictionDistance; }
+
+    // Frame GetPredictionDistance() after current, from the motion between previous and current
+    void Extrapolate(const ImageView& previous, const ImageView& current, const MutableImageView& dst);
+
+    // The warp step of Extrapolate(), on the field of the last estimate
+    void ExtrapolateFrame(const ImageView& current, const MutableImageView& dst, float distance);
+
+    const MotionField& GetMotionField() const { return m_field; }
+
+    // Whole-frame motion found by the last predictive search, same convention as the field
+    MotionVector GetGlobalMotion() const { return m_globalMotion; }
+
+    // Per-pixel flow of the last DenseFlow estimate
+    const DenseOpticalFlow& GetOpticalFlow() const { return m_opticalFlow; }
+    const FrameGeneratorStats& GetStats() const { return m_stats; }
+
+private:
+    void MatchBlockRow(const ImageView& previous, const ImageView& current, uint32_t blockY);
+    void SearchLevel(const LumaPyramid& previous, const LumaPyramid& current, uint32_t level, uint32_t coarsest);
+    void SearchLevelRow(const LumaView& previous, const LumaView& current, uint32_t level, uint32_t coarsest, uint32_t blockY);
+    MotionField& LevelField(uint32_t level) { return level == 0 ? m_field : m_levelFields[level]; }
+    void SearchPredictive(const LumaPyramid& previous, const LumaPyramid& current);
+    void SearchPredictiveRow(const LumaView& previous, const LumaView& current, uint32_t blockY, bool temporal);
+    void SampleFlowField(uint32_t width, uint32_t height);
+    void MarkStaticBlocks(const LumaView& previous, const LumaView& current);
+    void CountStaticBlocks();
+    MotionVector EstimateGlobalMotion(const LumaPyramid& previous, const LumaPyramid& current) const;
+    bool RepeatOnCut(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t, uint32_t count);
+    void RepeatFrames(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t, uint32_t count);
+    void InterpolateRow(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t,
+                        uint32_t count, uint32_t y) const;
+    void InterpolateFlowRow(const ImageView& previous, const ImageView& current, const MutableImageView* dst, const float* t,
+                            uint32_t count, uint32_t y) const;
+    uint32_t ExtrapolateRow(const ImageView& current, uint8_t* dst, uint32_t y, float distance, int32_t reach);
+
+private:
+    ThreadPool& m_pool;
+    uint32_t m_blockSize = 8;
+    uint32_t m_searchRange = 8;
+    MotionSearch m_search = MotionSearch::Exhaustive;
+    bool m_staticBypass = true;
+    bool m_cutDetection = true;
+    float m_predictionDistance = 0.5f;
+    MotionField m_field;
+    MotionField m_previousField;  // Last estimate, seeds the predictive search
+    MotionVector m_globalMotion;
+    std::vector<uint8_t> m_staticBlocks;  // 1 per static block of m_field; empty with the bypass off
+    std::atomic<uint64_t> m_candidates{ 0 };
+    DenseOpticalFlow m_opticalFlow;
+    SceneCutDetector m_cutDetector;
+    SceneCutResult m_lastCut;
+    float m_generationMs = 0.0f;  // Estimate and warp of the last pair that wasn't a cut
+
+    // GenerateAt(): source times of the pair the current field (or cut) belongs to
+    double m_pairTimes[2] = { 0.0, 0.0 };
+    bool m_pairValid = false;
+    bool m_pairIsCut = false;
+    std::vector<MotionVector> m_landed;  // Extrapolation: vector that reached each pixel, row by row
+
+    // Hierarchical search: per-level fields (level 0 is m_field) and the pyramids built by
+    // EstimateMotion() from frames
+    MotionField m_levelFields[LumaPyramid::MAX_LEVELS];
+    LumaPyramid m_previousPyramid;
+    LumaPyramid m_currentPyramid;
+    FrameGeneratorStats m_stats;
+};
@@ -0,0 +1,272 @@
+#include "FramePool.h"
+#include "../Utils/AllocationCounter.h"
+#include "../Utils/Logger.h"
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+    const size_t PITCH_ALIGNMENT = 64;
+    const size_t SMALL_PAGE_SIZE = 4096;
+
+    size_t RoundUp(size_t value, size_t multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    // Large page size, or 0 when they can't be used
+    size_t QueryLargePages()
+    {
+#if defined(_WIN32)
+        // MEM_LARGE_PAGES fails unless SeLockMemoryPrivilege is enabled on the process token,
+        // which only works if the user holds "Lock pages in memory"
+        size_t pageSize = GetLargePageMinimum();
+        if (pageSize == 0)
+        {
+            return 0;
+        }
+
+        HANDLE token = nullptr;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+        {
+            return 0;
+        }
+
+        TOKEN_PRIVILEGES privileges = {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        bool enabled = LookupPrivilegeValue(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+            AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+            GetLastError() == ERROR_SUCCESS;
+        CloseHandle(token);
+        return enabled ? pageSize : 0;
+#elif defined(MADV_HUGEPAGE)
+        return 2u << 20;
+#else
+        return 0;
+#endif
+    }
+
+    uint8_t* AllocatePages(size_t bytes, size_t largePageSize, bool& largePages)
+    {
+        const bool wantLarge = largePageSize != 0 && bytes % largePageSize == 0;
+        largePages = false;
+#if defined(_WIN32)
+        if (wantLarge)
+        {
+            void* memory = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (memory)
+            {
+                largePages = true;
+                return static_cast<uint8_t*>(memory);
+            }
+            // Physical memory too fragmented for contiguous large pages, use small ones
+        }
+        return static_cast<uint8_t*>(VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+        void* memory = nullptr;
+        if (posix_memalign(&memory, wantLarge ? largePageSize : SMALL_PAGE_SIZE, bytes) != 0)
+        {
+            return nullptr;
+        }
+#if defined(MADV_HUGEPAGE)
+        largePages = wantLarge && madvise(memory, bytes, MADV_HUGEPAGE) == 0;
+#endif
+        return static_cast<uint8_t*>(memory);
+#endif
+    }
+
+    void FreePages(uint8_t* data)
+    {
+#if defined(_WIN32)
+        VirtualFree(data, 0, MEM_RELEASE);
+#else
+        free(data);
+#endif
+    }
+}
+
+FrameHandle::FrameHandle(PooledFrame* frame)
+    : m_frame(frame)
+{
+}
+
+FrameHandle::FrameHandle(const FrameHandle& other)
+    : m_frame(other.m_frame)
+{
+    if (m_frame)
+    {
+        m_frame->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept
+    : m_frame(other.m_frame)
+{
+    other.m_frame = nullptr;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle other) noexcept
+{
+    PooledFrame* previous = m_frame;
+    m_frame = other.m_frame;
+    other.m_frame = previous;
+    return *this;
+}
+
+FrameHandle::~FrameHandle()
+{
+    Reset();
+}
+
+void FrameHandle::Reset()
+{
+    if (m_frame && m_frame->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        m_frame->pool->Release(m_frame);
+    }
+    m_frame = nullptr;
+}
+
+FramePool::FramePool()
+{
+    m_largePageSize = QueryLargePages();
+    if (m_largePageSize)
+    {
+        Logger::Info("Frame pool: large pages available (%zu KB)", m_largePageSize >> 10);
+    }
+    else
+    {
+        Logger::Info("Frame pool: large pages unavailable, using 4 KB pages");
+    }
+}
+
+FramePool::~FramePool()
+{
+    Trim();
+    if (m_stats.framesInUse)
+    {
+        Logger::Warning("Frame pool: %u frames still in use at shutdown", m_stats.framesInUse);
+    }
+}
+
+FramePool& FramePool::Shared()
+{
+    static FramePool pool;
+    return pool;
+}
+
+FrameHandle FramePool::Acquire(uint32_t width, uint32_t height, PixelFormat format)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = m_idle.size(); i-- > 0;)
+        {
+            PooledFrame* frame = m_idle[i];
+            if (frame->width == width && frame->height == height && frame->format == format)
+            {
+                m_idle.erase(m_idle.begin() + i);
+                m_stats.hits++;
+                m_stats.idleBytes -= frame->allocated;
+                m_stats.framesInUse++;
+                frame->references.store(1, std::memory_order_relaxed);
+                return FrameHandle(frame);
+            }
+        }
+    }
+
+    // Allocate outside the lock, a large frame can take a while to commit
+    PooledFrame* frame = Allocate(width, height, format);
+    if (!frame)
+    {
+        Logger::Error("Frame pool: failed to allocate %ux%u frame", width, height);
+        return FrameHandle();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.misses++;
+    m_stats.residentBytes += frame->allocated;
+    m_stats.largePageBytes += frame->largePages ? frame->allocated : 0;
+    m_stats.framesInUse++;
+    frame->references.store(1, std::memory_order_relaxed);
+    return FrameHandle(frame);
+}
+
+void FramePool::Release(PooledFrame* frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.framesInUse--;
+    m_stats.idleBytes += frame->allocated;
+    m_idle.push_back(frame);
+    TrimIdle(m_idleBudget);
+}
+
+void FramePool::SetIdleBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idleBudget = bytes;
+    TrimIdle(m_idleBudget);
+}
+
+void FramePool::Trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TrimIdle(0);
+}
+
+void FramePool::TrimIdle(size_t budget)
+{
+    size_t freed = 0;
+    while (freed < m_idle.size() && m_stats.idleBytes > budget)
+    {
+        PooledFrame* frame = m_idle[freed++];
+        m_stats.idleBytes -= frame->allocated;
+        m_stats.residentBytes -= frame->allocated;
+        m_stats.largePageBytes -= frame->largePages ? frame->allocated : 0;
+        Free(frame);
+    }
+    m_idle.erase(m_idle.begin(), m_idle.begin() + freed);
+}
+
+FramePoolStats FramePool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+PooledFrame* FramePool::Allocate(uint32_t width, uint32_t height, PixelFormat format)
+{
+    size_t pitch = RoundUp(static_cast<size_t>(width) * GetBytesPerPixel(format), PITCH_ALIGNMENT);
+    size_t bytes = pitch * (height ? height : 1);
+    bytes = (m_largePageSize && bytes >= m_largePageSize) ? RoundUp(bytes, m_largePageSize) : RoundUp(bytes, SMALL_PAGE_SIZE);
+
+    bool largePages = false;
+    uint8_t* data = AllocatePages(bytes, m_largePageSize, largePages);
+    if (!data)
+    {
+        return nullptr;
+    }
+    CountHeapAllocation();
+
+    PooledFrame* frame = new PooledFrame();
+    frame->data = data;
+    frame->pitch = pitch;
+    frame->allocated = bytes;
+    frame->width = width;
+    frame->height = height;
+    frame->format = format;
+    frame->largePages = largePages;
+    frame->pool = this;
+    return frame;
+}
+
+void FramePool::Free(PooledFrame* frame)
+{
+    FreePages(frame->data);
+    delete frame;
+}
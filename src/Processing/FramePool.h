@@ -0,0 +1,115 @@
+#pragma once
+#include "ImageView.h"
+#include "PixelConvert.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Recycled CPU frame memory for the readback and CPU upscale paths
+// Frames are keyed by (width, height, format) and handed out as ref-counted FrameHandles.
+// When the last handle goes away the frame goes back to the pool instead of the heap, so a
+// steady stream of frames doesn't allocate and a resize pays for each new size once.
+// Frames of 2 MB and up use large pages where the OS allows it: MEM_LARGE_PAGES needs the
+// "Lock pages in memory" privilege on Windows, elsewhere the range is madvise()d for
+// transparent huge pages.
+
+class FramePool;
+
+struct FramePoolStats
+{
+    uint64_t hits = 0;          // Acquire() served by an idle frame
+    uint64_t misses = 0;        // Acquire() that allocated
+    size_t residentBytes = 0;   // Frames in use plus idle ones
+    size_t idleBytes = 0;
+    size_t largePageBytes = 0;  // Part of residentBytes on large pages
+    uint32_t framesInUse = 0;
+};
+
+// One allocation owned by the pool, only reached through FrameHandle
+struct PooledFrame
+{
+    uint8_t* data = nullptr;
+    size_t pitch = 0;       // Bytes, a multiple of 64
+    size_t allocated = 0;   // Bytes reserved, rounded to the page size
+    uint32_t width = 0;
+    uint32_t height = 0;
+    PixelFormat format = PixelFormat::Bgra8;
+    bool largePages = false;
+    std::atomic<uint32_t> references{ 0 };
+    FramePool* pool = nullptr;
+};
+
+// Shared reference to a pooled frame, copies share the same pixels
+class FrameHandle
+{
+public:
+    FrameHandle() = default;
+    FrameHandle(const FrameHandle& other);
+    FrameHandle(FrameHandle&& other) noexcept;
+    FrameHandle& operator=(FrameHandle other) noexcept;
+    ~FrameHandle();
+
+    explicit operator bool() const { return m_frame != nullptr; }
+    void Reset();
+
+    uint8_t* Data() const { return m_frame->data; }
+    size_t GetPitch() const { return m_frame->pitch; }
+    uint32_t GetWidth() const { return m_frame->width; }
+    uint32_t GetHeight() const { return m_frame->height; }
+    PixelFormat GetFormat() const { return m_frame->format; }
+
+    // View() is for the 4-byte formats, HalfView() for Rgba16F
+    MutableImageView View() const { return MutableImageView{ m_frame->data, m_frame->width, m_frame->height, m_frame->pitch }; }
+    MutablePlaneView Plane() const { return MutablePlaneView{ m_frame->data, m_frame->pitch }; }
+    MutableHalfImageView HalfView() const
+    {
+        return MutableHalfImageView{ reinterpret_cast<uint16_t*>(m_frame->data), m_frame->width, m_frame->height, m_frame->pitch / 2 };
+    }
+
+private:
+    friend class FramePool;
+    explicit FrameHandle(PooledFrame* frame);
+
+private:
+    PooledFrame* m_frame = nullptr;
+};
+
+class FramePool
+{
+public:
+    FramePool();
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Pool shared by all processing stages
+    static FramePool& Shared();
+
+    // Contents are whatever the frame held last; returns an empty handle if allocation fails
+    FrameHandle Acquire(uint32_t width, uint32_t height, PixelFormat format);
+
+    // Idle frames beyond this many bytes are freed, least recently released first
+    void SetIdleBudget(size_t bytes);
+    // Frees every idle frame
+    void Trim();
+
+    FramePoolStats GetStats() const;
+
+private:
+    friend class FrameHandle;
+    void Release(PooledFrame* frame);
+
+    PooledFrame* Allocate(uint32_t width, uint32_t height, PixelFormat format);
+    void Free(PooledFrame* frame);
+    void TrimIdle(size_t budget);  // m_mutex held
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<PooledFrame*> m_idle;  // Most recently released last
+    FramePoolStats m_stats;
+    size_t m_idleBudget = 256ull << 20;
+    size_t m_largePageSize = 0;        // 0 when large pages can't be used
+};
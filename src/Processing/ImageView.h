@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Non-owning views of a CPU-side 8-bit BGRA image (e.g. a mapped staging texture)
+// pitch is the distance between rows in bytes and may be larger than width * 4
+struct ImageView
+{
+    const uint8_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    const uint8_t* Row(uint32_t y) const { return data + y * pitch; }
+
+    ImageView Crop(uint32_t x, uint32_t y, uint32_t cropWidth, uint32_t cropHeight) const
+    {
+        return ImageView{ data + y * pitch + x * 4, cropWidth, cropHeight, pitch };
+    }
+};
+
+struct MutableImageView
+{
+    uint8_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    uint8_t* Row(uint32_t y) const { return data + y * pitch; }
+    operator ImageView() const { return ImageView{ data, width, height, pitch }; }
+};
+
+// RGBA16F image (an HDR capture); pitch is in elements (4 per pixel)
+struct HalfImageView
+{
+    const uint16_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    const uint16_t* Row(uint32_t y) const { return data + y * pitch; }
+};
+
+struct MutableHalfImageView
+{
+    uint16_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    uint16_t* Row(uint32_t y) const { return data + y * pitch; }
+    operator HalfImageView() const { return HalfImageView{ data, width, height, pitch }; }
+};
+
+// 8-bit single channel plane (luma); pitch in bytes
+struct LumaView
+{
+    const uint8_t* data = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t pitch = 0;
+
+    const uint8_t* Row(uint32_t y) const { return data + y * pitch; }
+};
@@ -0,0 +1,283 @@
+#include "LetterboxDetector.h"
+#include "../Utils/CpuFeatures.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    // Bars must leave at least this fraction of the frame as picture, otherwise the
+    // frame is treated as a black/fade frame and the current rect is kept
+    const uint32_t MIN_CONTENT_DIVISOR = 4;
+
+    // Rows sampled when measuring pillarbox width
+    const uint32_t COLUMN_SAMPLE_ROWS = 16;
+
+    // Allowed edge jitter (pixels) before two scans are considered different
+    const uint32_t EDGE_TOLERANCE = 2;
+
+    const uint8_t s_bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+    // Index of the first/last set bit of a 4-pixel mask (mask != 0)
+    inline uint32_t LowestBit4(uint32_t mask)
+    {
+        return (mask & 1u) ? 0 : (mask & 2u) ? 1 : (mask & 4u) ? 2 : 3;
+    }
+
+    inline uint32_t HighestBit4(uint32_t mask)
+    {
+        return (mask & 8u) ? 3 : (mask & 4u) ? 2 : (mask & 2u) ? 1 : 0;
+    }
+
+    // Bit i set = pixel i has a colour channel above the threshold (alpha ignored)
+    inline uint32_t BrightMask4(const uint8_t* pixels, __m128i threshold, __m128i colorMask)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        __m128i above = _mm_and_si128(_mm_subs_epu8(v, threshold), colorMask);
+        __m128i black = _mm_cmpeq_epi32(above, _mm_setzero_si128());
+        return ~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(black))) & 0xFu;
+    }
+
+    POTATO_TARGET_AVX2
+    uint32_t CountBrightAVX2(const uint8_t* row, uint32_t width, uint8_t thresholdValue)
+    {
+        __m256i threshold = _mm256_set1_epi8(static_cast<char>(thresholdValue));
+        __m256i colorMask = _mm256_set1_epi32(0x00FFFFFF);
+        __m256i zero = _mm256_setzero_si256();
+        __m256i count = _mm256_setzero_si256();
+
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x * 4));
+            __m256i above = _mm256_and_si256(_mm256_subs_epu8(v, threshold), colorMask);
+            // cmpeq gives -1 for black pixels, so count black and flip at the end
+            count = _mm256_sub_epi32(count, _mm256_cmpeq_epi32(above, zero));
+        }
+
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), count);
+        uint32_t black = 0;
+        for (int i = 0; i < 8; i++) black += lanes[i];
+        uint32_t bright = x - black;
+
+        for (; x < width; x++)
+        {
+            const uint8_t* p = row + x * 4;
+            if (p[0] > thresholdValue || p[1] > thresholdValue || p[2] > thresholdValue) bright++;
+        }
+        return bright;
+    }
+}
+
+LetterboxDetector::LetterboxDetector()
+{
+}
+
+void LetterboxDetector::Reset()
+{
+    m_activeRect = ActiveRect{ 0, 0, m_frameWidth, m_frameHeight };
+    m_candidateRect = m_activeRect;
+    m_candidateScans = 0;
+    m_stats = LetterboxStats{};
+}
+
+bool LetterboxDetector::IsBright(const uint8_t* pixel) const
+{
+    return pixel[0] > m_blackThreshold || pixel[1] > m_blackThreshold || pixel[2] > m_blackThreshold;
+}
+
+uint32_t LetterboxDetector::CountBrightPixels(const uint8_t* row, uint32_t width) const
+{
+    if (GetCpuFeatures().avx2)
+    {
+        return CountBrightAVX2(row, width, m_blackThreshold);
+    }
+
+    __m128i threshold = _mm_set1_epi8(static_cast<char>(m_blackThreshold));
+    __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+
+    uint32_t bright = 0;
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        bright += s_bitCount[BrightMask4(row + x * 4, threshold, colorMask)];
+    }
+    for (; x < width; x++)
+    {
+        if (IsBright(row + x * 4)) bright++;
+    }
+    return bright;
+}
+
+uint32_t LetterboxDetector::FindFirstBright(const uint8_t* row, uint32_t width) const
+{
+    __m128i threshold = _mm_set1_epi8(static_cast<char>(m_blackThreshold));
+    __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        uint32_t mask = BrightMask4(row + x * 4, threshold, colorMask);
+        if (mask) return x + LowestBit4(mask);
+    }
+    for (; x < width; x++)
+    {
+        if (IsBright(row + x * 4)) return x;
+    }
+    return width;
+}
+
+uint32_t LetterboxDetector::FindLastBright(const uint8_t* row, uint32_t width) const
+{
+    __m128i threshold = _mm_set1_epi8(static_cast<char>(m_blackThreshold));
+    __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+
+    uint32_t x = width;
+    for (; x >= 4; x -= 4)
+    {
+        uint32_t mask = BrightMask4(row + (x - 4) * 4, threshold, colorMask);
+        if (mask) return x - 4 + HighestBit4(mask);
+    }
+    while (x > 0)
+    {
+        x--;
+        if (IsBright(row + x * 4)) return x;
+    }
+    return 0;
+}
+
+ActiveRect LetterboxDetector::Scan(const ImageView& frame) const
+{
+    const uint32_t width = frame.width;
+    const uint32_t height = frame.height;
+
+    // A handful of stray pixels (noise, a logo) shouldn't stop a row from being a bar
+    const uint32_t rowTolerance = width >> 7;
+    const uint32_t maxBarHeight = (height - height / MIN_CONTENT_DIVISOR) / 2;
+    const uint32_t maxBarWidth = (width - width / MIN_CONTENT_DIVISOR) / 2;
+
+    ActiveRect rect{ 0, 0, width, height };
+
+    while (rect.top < maxBarHeight && CountBrightPixels(frame.Row(rect.top), width) <= rowTolerance)
+    {
+        rect.top++;
+    }
+    while (height - rect.bottom < maxBarHeight && CountBrightPixels(frame.Row(rect.bottom - 1), width) <= rowTolerance)
+    {
+        rect.bottom--;
+    }
+    if (rect.top >= maxBarHeight || height - rect.bottom >= maxBarHeight)
+    {
+        // Nothing but black - no usable measurement
+        return ActiveRect{};
+    }
+
+    uint32_t left = width;
+    uint32_t right = 0;
+    uint32_t contentHeight = rect.Height();
+    for (uint32_t i = 0; i < COLUMN_SAMPLE_ROWS; i++)
+    {
+        uint32_t y = rect.top + (contentHeight * (2 * i + 1)) / (2 * COLUMN_SAMPLE_ROWS);
+        const uint8_t* row = frame.Row(y);
+
+        left = std::min(left, FindFirstBright(row, std::min(left, width)));
+        if (left == 0 && right == width) break;
+
+        uint32_t last = FindLastBright(row, width);
+        if (last >= right && IsBright(row + last * 4)) right = last + 1;
+    }
+
+    if (left >= maxBarWidth || width - right >= maxBarWidth || right <= left)
+    {
+        // Sampled rows were dark - keep the full width rather than guess
+        left = 0;
+        right = width;
+    }
+
+    rect.left = left;
+    rect.right = right;
+    return rect;
+}
+
+bool LetterboxDetector::IsSimilar(const ActiveRect& a, const ActiveRect& b) const
+{
+    auto close = [](uint32_t x, uint32_t y) { return (x > y ? x - y : y - x) <= EDGE_TOLERANCE; };
+    return close(a.left, b.left) && close(a.top, b.top) && close(a.right, b.right) && close(a.bottom, b.bottom);
+}
+
+bool LetterboxDetector::Update(const ImageView& frame)
+{
+    if (!frame.data || frame.width == 0 || frame.height == 0)
+    {
+        return false;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    bool changed = false;
+    if (frame.width != m_frameWidth || frame.height != m_frameHeight)
+    {
+        m_frameWidth = frame.width;
+        m_frameHeight = frame.height;
+        Reset();
+        changed = true;
+    }
+
+    ActiveRect found = Scan(frame);
+    bool measured = found.right > found.left && found.bottom > found.top;
+
+    if (measured)
+    {
+        bool grows = found.left < m_activeRect.left || found.top < m_activeRect.top ||
+                     found.right > m_activeRect.right || found.bottom > m_activeRect.bottom;
+
+        if (grows)
+        {
+            // Content appeared inside a bar - never crop picture, expand right away
+            m_activeRect.left = std::min(m_activeRect.left, found.left);
+            m_activeRect.top = std::min(m_activeRect.top, found.top);
+            m_activeRect.right = std::max(m_activeRect.right, found.right);
+            m_activeRect.bottom = std::max(m_activeRect.bottom, found.bottom);
+            m_candidateScans = 0;
+            changed = true;
+        }
+        else if (!IsSimilar(found, m_activeRect))
+        {
+            if (m_candidateScans > 0 && IsSimilar(found, m_candidateRect))
+            {
+                m_candidateScans++;
+            }
+            else
+            {
+                m_candidateRect = found;
+                m_candidateScans = 1;
+            }
+
+            if (m_candidateScans >= m_hysteresisScans)
+            {
+                m_activeRect = m_candidateRect;
+                m_candidateScans = 0;
+                changed = true;
+            }
+        }
+        else
+        {
+            m_candidateScans = 0;
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    float elapsedMs = std::chrono::duration<float, std::milli>(end - start).count();
+
+    m_stats.detectMs = elapsedMs;
+    m_stats.detectMsAverage = (m_stats.scans == 0) ? elapsedMs : m_stats.detectMsAverage * 0.9f + elapsedMs * 0.1f;
+    m_stats.scans++;
+    m_stats.barTop = m_activeRect.top;
+    m_stats.barBottom = m_frameHeight - m_activeRect.bottom;
+    m_stats.barLeft = m_activeRect.left;
+    m_stats.barRight = m_frameWidth - m_activeRect.right;
+    m_stats.barsFound = m_stats.barTop || m_stats.barBottom || m_stats.barLeft || m_stats.barRight;
+
+    return changed;
+}
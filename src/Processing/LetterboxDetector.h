@@ -0,0 +1,74 @@
+#pragma once
+#include "ImageView.h"
+#include <cstdint>
+
+// Active picture area inside a captured frame (right/bottom are exclusive)
+struct ActiveRect
+{
+    uint32_t left = 0;
+    uint32_t top = 0;
+    uint32_t right = 0;
+    uint32_t bottom = 0;
+
+    uint32_t Width() const { return right - left; }
+    uint32_t Height() const { return bottom - top; }
+};
+
+struct LetterboxStats
+{
+    float detectMs = 0.0f;         // Cost of the last scan
+    float detectMsAverage = 0.0f;  // Smoothed scan cost
+    uint32_t barTop = 0;
+    uint32_t barBottom = 0;
+    uint32_t barLeft = 0;
+    uint32_t barRight = 0;
+    uint32_t scans = 0;
+    bool barsFound = false;
+};
+
+// Finds black letterbox (top/bottom) and pillarbox (left/right) bars in BGRA frames
+// Rows are scanned inwards from the top and bottom edges, then a set of sampled rows is
+// scanned inwards from the left and right to find the pillarbox width.
+// Results are filtered across frames: the rect grows immediately when content appears
+// in a bar, but only shrinks after the smaller rect has been seen for several scans,
+// so dark scenes don't get cropped.
+class LetterboxDetector
+{
+public:
+    LetterboxDetector();
+
+    // Scan a frame and update the committed active rect
+    // Returns true if the committed rect changed
+    bool Update(const ImageView& frame);
+
+    void Reset();
+
+    const ActiveRect& GetActiveRect() const { return m_activeRect; }
+    const LetterboxStats& GetStats() const { return m_stats; }
+
+    // Max channel value still considered black (compression noise sits a bit above 0)
+    void SetBlackThreshold(uint8_t threshold) { m_blackThreshold = threshold; }
+
+    // Number of consecutive agreeing scans needed before the rect shrinks
+    void SetHysteresisScans(uint32_t scans) { m_hysteresisScans = scans; }
+
+private:
+    ActiveRect Scan(const ImageView& frame) const;
+    uint32_t CountBrightPixels(const uint8_t* row, uint32_t width) const;
+    uint32_t FindFirstBright(const uint8_t* row, uint32_t width) const;
+    uint32_t FindLastBright(const uint8_t* row, uint32_t width) const;
+    bool IsBright(const uint8_t* pixel) const;
+    bool IsSimilar(const ActiveRect& a, const ActiveRect& b) const;
+
+private:
+    ActiveRect m_activeRect;
+    ActiveRect m_candidateRect;
+    uint32_t m_candidateScans = 0;
+    uint32_t m_frameWidth = 0;
+    uint32_t m_frameHeight = 0;
+
+    uint8_t m_blackThreshold = 24;
+    uint32_t m_hysteresisScans = 4;
+
+    LetterboxStats m_stats;
+};
@@ -0,0 +1,622 @@
+#include "OpticalFlow.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // Lucas-Kanade only converges within a pixel or so, so the search starts at the level where
+    // the largest motion is at most COARSE_MOTION pixels
+    const uint32_t COARSE_MOTION = 1;
+
+    // Inverse search: steps per patch, and the update (in pixels, squared) that counts as converged
+    const uint32_t SEARCH_ITERATIONS = 8;
+    const float CONVERGED_STEP = 0.01f * 0.01f;
+
+    // Patches with less texture than this (Hessian determinant) keep their initial flow
+    const float MIN_DETERMINANT = 1.0f;
+
+    // Refinement: Jacobi iterations per level (even, so the result ends in the level's field).
+    // The data term is normalised by |gradient|^2 + DATA_NORMALISATION, so strong edges don't
+    // outvote the smoothness term, which has weight SMOOTHNESS
+    const uint32_t REFINE_ITERATIONS = 6;
+    const float SMOOTHNESS = 10.0f;
+    const float DATA_NORMALISATION = 30.0f;
+
+    const uint32_t PATCH_SIZE = DenseOpticalFlow::PATCH_SIZE;
+    const uint32_t PATCH_STRIDE = DenseOpticalFlow::PATCH_STRIDE;
+    const uint32_t PATCH_PIXELS = PATCH_SIZE * PATCH_SIZE;
+
+    float Clamp(float value, float low, float high)
+    {
+        return value < low ? low : (value > high ? high : value);
+    }
+
+    // Bilinear, coordinates clamped to the image
+    float SampleLuma(const LumaView& image, float x, float y)
+    {
+        x = Clamp(x, 0.0f, static_cast<float>(image.width - 1));
+        y = Clamp(y, 0.0f, static_cast<float>(image.height - 1));
+        const uint32_t x0 = static_cast<uint32_t>(x);
+        const uint32_t y0 = static_cast<uint32_t>(y);
+        const uint32_t x1 = std::min(x0 + 1, image.width - 1);
+        const uint32_t y1 = std::min(y0 + 1, image.height - 1);
+        const float fx = x - x0;
+        const float fy = y - y0;
+        const uint8_t* row0 = image.Row(y0);
+        const uint8_t* row1 = image.Row(y1);
+        float top = row0[x0] + (row0[x1] - row0[x0]) * fx;
+        float bottom = row1[x0] + (row1[x1] - row1[x0]) * fx;
+        return top + (bottom - top) * fy;
+    }
+
+    uint8_t LumaAt(const LumaView& image, int32_t x, int32_t y)
+    {
+        x = std::min(std::max(x, 0), static_cast<int32_t>(image.width) - 1);
+        y = std::min(std::max(y, 0), static_cast<int32_t>(image.height) - 1);
+        return image.Row(y)[x];
+    }
+
+    // Central differences, clamped at the borders
+    void Gradient(const LumaView& image, int32_t x, int32_t y, float& gx, float& gy)
+    {
+        gx = 0.5f * (LumaAt(image, x + 1, y) - LumaAt(image, x - 1, y));
+        gy = 0.5f * (LumaAt(image, x, y + 1) - LumaAt(image, x, y - 1));
+    }
+
+    // Eight luma pixels as two vectors of floats
+    void LoadLuma8(const uint8_t* pixels, __m128& low, __m128& high)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels)), zero);
+        low = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+        high = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+    }
+
+    // Eight bilinear samples between rows row0 and row0 + pitch, starting at row0 + (fx, fy);
+    // reads nine pixels of each row
+    void Sample8(const uint8_t* row0, size_t pitch, __m128 fx, __m128 fy, __m128& low, __m128& high)
+    {
+        __m128 a0;
+        __m128 a1;
+        __m128 b0;
+        __m128 b1;
+        __m128 c0;
+        __m128 c1;
+        __m128 d0;
+        __m128 d1;
+        LoadLuma8(row0, a0, a1);
+        LoadLuma8(row0 + 1, b0, b1);
+        LoadLuma8(row0 + pitch, c0, c1);
+        LoadLuma8(row0 + pitch + 1, d0, d1);
+        __m128 top0 = _mm_add_ps(a0, _mm_mul_ps(_mm_sub_ps(b0, a0), fx));
+        __m128 top1 = _mm_add_ps(a1, _mm_mul_ps(_mm_sub_ps(b1, a1), fx));
+        __m128 bottom0 = _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(d0, c0), fx));
+        __m128 bottom1 = _mm_add_ps(c1, _mm_mul_ps(_mm_sub_ps(d1, c1), fx));
+        low = _mm_add_ps(top0, _mm_mul_ps(_mm_sub_ps(bottom0, top0), fy));
+        high = _mm_add_ps(top1, _mm_mul_ps(_mm_sub_ps(bottom1, top1), fy));
+    }
+
+    float HorizontalSum(__m128 v)
+    {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+        return _mm_cvtss_f32(v);
+    }
+
+    // Flow of a level at level coordinates (x, y), bilinear, clamped
+    void SampleFlow(const FlowField& flow, float x, float y, float& dx, float& dy)
+    {
+        x = Clamp(x, 0.0f, static_cast<float>(flow.width - 1));
+        y = Clamp(y, 0.0f, static_cast<float>(flow.height - 1));
+        const uint32_t x0 = static_cast<uint32_t>(x);
+        const uint32_t y0 = static_cast<uint32_t>(y);
+        const uint32_t x1 = std::min(x0 + 1, flow.width - 1);
+        const uint32_t y1 = std::min(y0 + 1, flow.height - 1);
+        const float fx = x - x0;
+        const float fy = y - y0;
+        const float* a = &flow.vectors[(static_cast<size_t>(y0) * flow.width + x0) * 2];
+        const float* b = &flow.vectors[(static_cast<size_t>(y0) * flow.width + x1) * 2];
+        const float* c = &flow.vectors[(static_cast<size_t>(y1) * flow.width + x0) * 2];
+        const float* d = &flow.vectors[(static_cast<size_t>(y1) * flow.width + x1) * 2];
+        for (int i = 0; i < 2; i++)
+        {
+            float top = a[i] + (b[i] - a[i]) * fx;
+            float bottom = c[i] + (d[i] - c[i]) * fx;
+            (i == 0 ? dx : dy) = top + (bottom - top) * fy;
+        }
+    }
+
+    // Patches starting at i * PATCH_STRIDE cover p when p - PATCH_SIZE < i * PATCH_STRIDE <= p;
+    // pixels past the last patch belong to the last one
+    void PatchRange(uint32_t p, uint32_t count, uint32_t& low, uint32_t& high)
+    {
+        high = std::min(p / PATCH_STRIDE, count - 1);
+        low = p + PATCH_STRIDE >= PATCH_SIZE ? (p + PATCH_STRIDE - PATCH_SIZE) / PATCH_STRIDE : 0;
+        low = std::min(low, high);
+    }
+
+    float Milliseconds(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+}
+
+void FlowField::Sample(float x, float y, float& dx, float& dy) const
+{
+    // Pixel centres of level n sit at (p + 0.5) / 2^n - 0.5
+    const float scale = static_cast<float>(1u << level);
+    SampleFlow(*this, (x + 0.5f) / scale - 0.5f, (y + 0.5f) / scale - 0.5f, dx, dy);
+    dx *= scale;
+    dy *= scale;
+}
+
+DenseOpticalFlow::DenseOpticalFlow()
+    : m_pool(ThreadPool::Shared())
+{
+}
+
+void DenseOpticalFlow::Compute(const LumaPyramid& previous, const LumaPyramid& current)
+{
+    m_stats = OpticalFlowStats();
+    const uint32_t levels = std::min(previous.GetLevelCount(), current.GetLevelCount());
+
+    // Levels smaller than a patch have no patches; level 0 can be, the pyramid only limits the
+    // levels below it
+    auto fits = [&](uint32_t level)
+    {
+        const LumaView& a = previous.GetLevel(level);
+        const LumaView& b = current.GetLevel(level);
+        return std::min(a.width, b.width) >= PATCH_SIZE && std::min(a.height, b.height) >= PATCH_SIZE;
+    };
+    uint32_t finest = levels > 0 ? std::min(m_finestLevel, levels - 1) : 0;
+    while (finest > 0 && !fits(finest))
+    {
+        finest--;
+    }
+    if (levels == 0 || !fits(finest))
+    {
+        // No flow, FrameGenerator falls back to block vectors
+        m_flow[m_result].vectors.clear();
+        return;
+    }
+
+    uint32_t coarsest = finest;
+    while (coarsest + 1 < levels && fits(coarsest + 1) && (m_maxMotion >> coarsest) > COARSE_MOTION)
+    {
+        coarsest++;
+    }
+
+    const FlowField* coarser = nullptr;
+    for (uint32_t level = coarsest + 1; level-- > finest;)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        LumaView prev;
+        LumaView cur;
+        Smooth(previous.GetLevel(level), m_smoothed[0], prev);
+        Smooth(current.GetLevel(level), m_smoothed[1], cur);
+        m_stats.smoothMs += Milliseconds(start);
+
+        const uint32_t patchesX = (cur.width - PATCH_SIZE) / PATCH_STRIDE + 1;
+        const uint32_t patchesY = (cur.height - PATCH_SIZE) / PATCH_STRIDE + 1;
+        m_patchFlow.resize(static_cast<size_t>(patchesX) * patchesY * 2);
+
+        // Patches within a row run left to right, each can start from its left neighbour
+        start = std::chrono::high_resolution_clock::now();
+        std::atomic<uint32_t> reverted{ 0 };
+        m_pool.ParallelFor(patchesY, 1, [&](uint32_t begin, uint32_t end)
+        {
+            uint32_t count = 0;
+            for (uint32_t patchY = begin; patchY < end; patchY++)
+            {
+                SearchPatchRow(prev, cur, coarser, patchY, patchesX, count);
+            }
+            reverted.fetch_add(count, std::memory_order_relaxed);
+        });
+        m_stats.searchMs += Milliseconds(start);
+        m_stats.patches += patchesX * patchesY;
+        m_stats.revertedPatches += reverted.load(std::memory_order_relaxed);
+
+        FlowField& flow = m_flow[level & 1];
+        flow.width = cur.width;
+        flow.height = cur.height;
+        flow.level = level;
+        flow.vectors.resize(static_cast<size_t>(cur.width) * cur.height * 2);
+        m_terms.resize(static_cast<size_t>(cur.width) * cur.height * 4);
+
+        start = std::chrono::high_resolution_clock::now();
+        m_pool.ParallelFor(cur.height, m_pool.SuggestGrain(cur.height), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t y = begin; y < end; y++)
+            {
+                DensifyRow(prev, cur, flow, patchesX, patchesY, y);
+            }
+        });
+        m_stats.densifyMs += Milliseconds(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        Refine(prev, cur, flow);
+        m_stats.refineMs += Milliseconds(start);
+
+        coarser = &flow;
+    }
+    m_result = finest & 1;
+}
+
+void DenseOpticalFlow::SearchPatchRow(const LumaView& previous, const LumaView& current, const FlowField* coarser, uint32_t patchY,
+                                      uint32_t patchesX, uint32_t& reverted)
+{
+    const int32_t py = static_cast<int32_t>(patchY * PATCH_STRIDE);
+    const int32_t lastX = static_cast<int32_t>(previous.width - PATCH_SIZE);
+    const int32_t lastY = static_cast<int32_t>(previous.height - PATCH_SIZE);
+    alignas(16) float templ[PATCH_PIXELS];
+    alignas(16) float gx[PATCH_PIXELS];
+    alignas(16) float gy[PATCH_PIXELS];
+
+    for (uint32_t patchX = 0; patchX < patchesX; patchX++)
+    {
+        const int32_t px = static_cast<int32_t>(patchX * PATCH_STRIDE);
+
+        // Template and its gradients (inverse compositional: fixed for all steps)
+        const bool interior = px > 0 && py > 0 && px < lastX && py < lastY;
+        float hxx = 0.0f;
+        float hxy = 0.0f;
+        float hyy = 0.0f;
+        for (uint32_t y = 0; y < PATCH_SIZE; y++)
+        {
+            const uint8_t* row = current.Row(py + y) + px;
+            const uint8_t* above = row - current.pitch;
+            const uint8_t* below = row + current.pitch;
+            for (uint32_t x = 0; x < PATCH_SIZE; x++)
+            {
+                const uint32_t i = y * PATCH_SIZE + x;
+                templ[i] = row[x];
+                if (interior)
+                {
+                    gx[i] = 0.5f * (row[x + 1] - (row - 1)[x]);
+                    gy[i] = 0.5f * (below[x] - above[x]);
+                }
+                else
+                {
+                    Gradient(current, px + x, py + y, gx[i], gy[i]);
+                }
+                hxx += gx[i] * gx[i];
+                hxy += gx[i] * gy[i];
+                hyy += gy[i] * gy[i];
+            }
+        }
+        const float determinant = hxx * hyy - hxy * hxy;
+
+        // Squared error of the patch warped by (ux, uy), and the steepest descent sums
+        auto warp = [&](float ux, float uy, float& bx, float& by)
+        {
+            const float sx = px + ux;
+            const float sy = py + uy;
+            const int32_t ix = static_cast<int32_t>(std::floor(sx));
+            const int32_t iy = static_cast<int32_t>(std::floor(sy));
+            if (ix < 0 || iy < 0 || ix >= lastX || iy >= lastY)
+            {
+                float error = 0.0f;
+                bx = 0.0f;
+                by = 0.0f;
+                for (uint32_t i = 0; i < PATCH_PIXELS; i++)
+                {
+                    const float e = SampleLuma(previous, sx + i % PATCH_SIZE, sy + i / PATCH_SIZE) - templ[i];
+                    bx += gx[i] * e;
+                    by += gy[i] * e;
+                    error += e * e;
+                }
+                return error;
+            }
+
+            const __m128 fx = _mm_set1_ps(sx - ix);
+            const __m128 fy = _mm_set1_ps(sy - iy);
+            __m128 sumX = _mm_setzero_ps();
+            __m128 sumY = _mm_setzero_ps();
+            __m128 sumE = _mm_setzero_ps();
+            for (uint32_t y = 0; y < PATCH_SIZE; y++)
+            {
+                __m128 low;
+                __m128 high;
+                Sample8(previous.Row(iy + y) + ix, previous.pitch, fx, fy, low, high);
+                const uint32_t i = y * PATCH_SIZE;
+                __m128 e0 = _mm_sub_ps(low, _mm_load_ps(templ + i));
+                __m128 e1 = _mm_sub_ps(high, _mm_load_ps(templ + i + 4));
+                sumX = _mm_add_ps(sumX, _mm_add_ps(_mm_mul_ps(_mm_load_ps(gx + i), e0), _mm_mul_ps(_mm_load_ps(gx + i + 4), e1)));
+                sumY = _mm_add_ps(sumY, _mm_add_ps(_mm_mul_ps(_mm_load_ps(gy + i), e0), _mm_mul_ps(_mm_load_ps(gy + i + 4), e1)));
+                sumE = _mm_add_ps(sumE, _mm_add_ps(_mm_mul_ps(e0, e0), _mm_mul_ps(e1, e1)));
+            }
+            bx = HorizontalSum(sumX);
+            by = HorizontalSum(sumY);
+            return HorizontalSum(sumE);
+        };
+
+        // Start from the coarser level's flow at the patch centre, doubled, or from the patch to
+        // the left if that fits better
+        float initX = 0.0f;
+        float initY = 0.0f;
+        if (coarser)
+        {
+            const float centre = (PATCH_SIZE - 1) * 0.5f;
+            SampleFlow(*coarser, (px + centre + 0.5f) * 0.5f - 0.5f, (py + centre + 0.5f) * 0.5f - 0.5f, initX, initY);
+            initX *= 2.0f;
+            initY *= 2.0f;
+        }
+        float bx;
+        float by;
+        float startError = warp(initX, initY, bx, by);
+        if (patchX > 0)
+        {
+            const float* left = &m_patchFlow[(static_cast<size_t>(patchY) * patchesX + patchX - 1) * 2];
+            float leftBx;
+            float leftBy;
+            const float leftError = warp(left[0], left[1], leftBx, leftBy);
+            if (leftError < startError)
+            {
+                initX = left[0];
+                initY = left[1];
+                startError = leftError;
+                bx = leftBx;
+                by = leftBy;
+            }
+        }
+
+        float ux = initX;
+        float uy = initY;
+        if (determinant >= MIN_DETERMINANT)
+        {
+            for (uint32_t step = 0; step < SEARCH_ITERATIONS; step++)
+            {
+                if (step > 0)
+                {
+                    warp(ux, uy, bx, by);
+                }
+                const float dx = (hyy * bx - hxy * by) / determinant;
+                const float dy = (hxx * by - hxy * bx) / determinant;
+                ux -= dx;
+                uy -= dy;
+                if (dx * dx + dy * dy < CONVERGED_STEP)
+                {
+                    break;
+                }
+            }
+
+            // Keep the search only if it improved the match and stayed within a patch
+            const float moved = std::max(std::fabs(ux - initX), std::fabs(uy - initY));
+            if (moved > PATCH_SIZE || !(warp(ux, uy, bx, by) < startError))
+            {
+                ux = initX;
+                uy = initY;
+                reverted++;
+            }
+        }
+
+        float* out = &m_patchFlow[(static_cast<size_t>(patchY) * patchesX + patchX) * 2];
+        out[0] = ux;
+        out[1] = uy;
+    }
+}
+
+void DenseOpticalFlow::DensifyRow(const LumaView& previous, const LumaView& current, FlowField& flow, uint32_t patchesX, uint32_t patchesY, uint32_t y)
+{
+    const uint32_t width = current.width;
+    const uint8_t* row = current.Row(y);
+    float* out = &flow.vectors[static_cast<size_t>(y) * width * 2];
+    float* weights = &m_terms[static_cast<size_t>(y) * width];
+    std::fill(out, out + width * 2, 0.0f);
+    std::fill(weights, weights + width, 0.0f);
+
+    // Each patch covering the row adds its flow to its pixels, weighted by 1 / max(1, |error|)
+    // of the pixel moved by that flow; the last patch of a row also takes the pixels past it
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    uint32_t lowY;
+    uint32_t highY;
+    PatchRange(y, patchesY, lowY, highY);
+    for (uint32_t patchY = lowY; patchY <= highY; patchY++)
+    {
+        for (uint32_t patchX = 0; patchX < patchesX; patchX++)
+        {
+            const float* patch = &m_patchFlow[(static_cast<size_t>(patchY) * patchesX + patchX) * 2];
+            const uint32_t x0 = patchX * PATCH_STRIDE;
+            const uint32_t count = patchX + 1 < patchesX ? PATCH_SIZE : width - x0;
+            const float sx = x0 + patch[0];
+            const float sy = y + patch[1];
+            const int32_t ix = static_cast<int32_t>(std::floor(sx));
+            const int32_t iy = static_cast<int32_t>(std::floor(sy));
+
+            if (count == PATCH_SIZE && ix >= 0 && iy >= 0 && ix + static_cast<int32_t>(PATCH_SIZE) < static_cast<int32_t>(width) &&
+                iy + 1 < static_cast<int32_t>(previous.height))
+            {
+                __m128 sampleLow;
+                __m128 sampleHigh;
+                __m128 curLow;
+                __m128 curHigh;
+                Sample8(previous.Row(iy) + ix, previous.pitch, _mm_set1_ps(sx - ix), _mm_set1_ps(sy - iy), sampleLow, sampleHigh);
+                LoadLuma8(row + x0, curLow, curHigh);
+                __m128 w0 = _mm_div_ps(one, _mm_max_ps(one, _mm_and_ps(_mm_sub_ps(sampleLow, curLow), absMask)));
+                __m128 w1 = _mm_div_ps(one, _mm_max_ps(one, _mm_and_ps(_mm_sub_ps(sampleHigh, curHigh), absMask)));
+                _mm_storeu_ps(weights + x0, _mm_add_ps(_mm_loadu_ps(weights + x0), w0));
+                _mm_storeu_ps(weights + x0 + 4, _mm_add_ps(_mm_loadu_ps(weights + x0 + 4), w1));
+
+                // Weighted flow, interleaved x, y like the output
+                const __m128 flowX = _mm_set1_ps(patch[0]);
+                const __m128 flowY = _mm_set1_ps(patch[1]);
+                float* o = out + x0 * 2;
+                __m128 wx0 = _mm_mul_ps(w0, flowX);
+                __m128 wy0 = _mm_mul_ps(w0, flowY);
+                __m128 wx1 = _mm_mul_ps(w1, flowX);
+                __m128 wy1 = _mm_mul_ps(w1, flowY);
+                _mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_unpacklo_ps(wx0, wy0)));
+                _mm_storeu_ps(o + 4, _mm_add_ps(_mm_loadu_ps(o + 4), _mm_unpackhi_ps(wx0, wy0)));
+                _mm_storeu_ps(o + 8, _mm_add_ps(_mm_loadu_ps(o + 8), _mm_unpacklo_ps(wx1, wy1)));
+                _mm_storeu_ps(o + 12, _mm_add_ps(_mm_loadu_ps(o + 12), _mm_unpackhi_ps(wx1, wy1)));
+                continue;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                const float error = std::fabs(SampleLuma(previous, sx + i, sy) - row[x0 + i]);
+                const float weight = 1.0f / std::max(1.0f, error);
+                weights[x0 + i] += weight;
+                out[(x0 + i) * 2] += patch[0] * weight;
+                out[(x0 + i) * 2 + 1] += patch[1] * weight;
+            }
+        }
+    }
+
+    for (uint32_t x = 0; x < width; x++)
+    {
+        const float scale = 1.0f / weights[x];
+        out[x * 2] *= scale;
+        out[x * 2 + 1] *= scale;
+    }
+}
+
+void DenseOpticalFlow::Refine(const LumaView& previous, const LumaView& current, FlowField& flow)
+{
+    const uint32_t width = flow.width;
+    const uint32_t height = flow.height;
+    const size_t pixels = static_cast<size_t>(width) * height;
+    m_terms.resize(pixels * 4);
+    m_scratch.resize(pixels * 2);
+    const uint32_t grain = m_pool.SuggestGrain(height);
+
+    // Data term linearised at the densified flow w0: I1(p + w) - I0(p) ~ g . w + c. Stored per
+    // pixel as gx, gy, c and the normalised denominator of the update below
+    m_pool.ParallelFor(height, grain, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint8_t* row = current.Row(y);
+            float* terms = &m_terms[static_cast<size_t>(y) * width * 4];
+            const float* w = &flow.vectors[static_cast<size_t>(y) * width * 2];
+            const bool interiorRow = y > 0 && y + 1 < height;
+            const uint8_t* above = row - current.pitch;
+            const uint8_t* below = row + current.pitch;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                float gx;
+                float gy;
+                if (interiorRow && x > 0 && x + 1 < width)
+                {
+                    gx = 0.5f * (row[x + 1] - (row - 1)[x]);
+                    gy = 0.5f * (below[x] - above[x]);
+                }
+                else
+                {
+                    Gradient(current, static_cast<int32_t>(x), static_cast<int32_t>(y), gx, gy);
+                }
+                const float difference = SampleLuma(previous, x + w[x * 2], y + w[x * 2 + 1]) - row[x];
+                const float g2 = gx * gx + gy * gy;
+                terms[x * 4] = gx;
+                terms[x * 4 + 1] = gy;
+                terms[x * 4 + 2] = difference - gx * w[x * 2] - gy * w[x * 2 + 1];
+                terms[x * 4 + 3] = 1.0f / (SMOOTHNESS * (g2 + DATA_NORMALISATION) + g2);
+            }
+        }
+    });
+
+    // Jacobi: each pixel moves from its neighbours' mean w' towards satisfying the data term,
+    // w = w' - g (g . w' + c) / (SMOOTHNESS (|g|^2 + DATA_NORMALISATION) + |g|^2)
+    // Two pixels per vector inside the row, the end pixels clamp their neighbours
+    float* buffers[2] = { flow.vectors.data(), m_scratch.data() };
+    for (uint32_t iteration = 0; iteration < REFINE_ITERATIONS; iteration++)
+    {
+        const float* src = buffers[iteration & 1];
+        float* dst = buffers[(iteration & 1) ^ 1];
+        m_pool.ParallelFor(height, grain, [&](uint32_t begin, uint32_t end)
+        {
+            const __m128 quarter = _mm_set1_ps(0.25f);
+            for (uint32_t y = begin; y < end; y++)
+            {
+                const float* up = src + static_cast<size_t>(y > 0 ? y - 1 : y) * width * 2;
+                const float* row = src + static_cast<size_t>(y) * width * 2;
+                const float* down = src + static_cast<size_t>(y + 1 < height ? y + 1 : y) * width * 2;
+                float* out = dst + static_cast<size_t>(y) * width * 2;
+                const float* terms = &m_terms[static_cast<size_t>(y) * width * 4];
+
+                auto update = [&](uint32_t x)
+                {
+                    const uint32_t left = x > 0 ? x - 1 : x;
+                    const uint32_t right = x + 1 < width ? x + 1 : x;
+                    const float meanX = 0.25f * (row[left * 2] + row[right * 2] + up[x * 2] + down[x * 2]);
+                    const float meanY = 0.25f * (row[left * 2 + 1] + row[right * 2 + 1] + up[x * 2 + 1] + down[x * 2 + 1]);
+                    const float* t = terms + x * 4;
+                    const float step = (t[2] + t[0] * meanX + t[1] * meanY) * t[3];
+                    out[x * 2] = meanX - t[0] * step;
+                    out[x * 2 + 1] = meanY - t[1] * step;
+                };
+
+                update(0);
+                uint32_t x = 1;
+                for (; x + 2 < width; x += 2)
+                {
+                    __m128 mean = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row + x * 2 - 2), _mm_loadu_ps(row + x * 2 + 2)),
+                                             _mm_add_ps(_mm_loadu_ps(up + x * 2), _mm_loadu_ps(down + x * 2)));
+                    mean = _mm_mul_ps(mean, quarter);
+                    __m128 t0 = _mm_loadu_ps(terms + x * 4);
+                    __m128 t1 = _mm_loadu_ps(terms + x * 4 + 4);
+                    __m128 g = _mm_movelh_ps(t0, t1);           // gx0 gy0 gx1 gy1
+                    __m128 constants = _mm_movehl_ps(t1, t0);   // c0 d0 c1 d1
+                    __m128 dot = _mm_mul_ps(g, mean);
+                    dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+                    __m128 step = _mm_mul_ps(_mm_add_ps(_mm_shuffle_ps(constants, constants, _MM_SHUFFLE(2, 2, 0, 0)), dot),
+                                             _mm_shuffle_ps(constants, constants, _MM_SHUFFLE(3, 3, 1, 1)));
+                    _mm_storeu_ps(out + x * 2, _mm_sub_ps(mean, _mm_mul_ps(g, step)));
+                }
+                for (; x < width; x++)
+                {
+                    update(x);
+                }
+            }
+        });
+    }
+}
+
+void DenseOpticalFlow::Smooth(const LumaView& src, std::vector<uint8_t>& storage, LumaView& dst)
+{
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+    storage.resize(static_cast<size_t>(width) * height);
+    m_smoothRows.resize(static_cast<size_t>(width) * height);
+    const uint32_t grain = m_pool.SuggestGrain(height);
+
+    // [1 2 1] across, then down, edges clamped
+    m_pool.ParallelFor(height, grain, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint8_t* row = src.Row(y);
+            uint16_t* out = &m_smoothRows[static_cast<size_t>(y) * width];
+            out[0] = static_cast<uint16_t>(3 * row[0] + row[1]);
+            for (uint32_t x = 1; x + 1 < width; x++)
+            {
+                out[x] = static_cast<uint16_t>(row[x - 1] + 2 * row[x] + row[x + 1]);
+            }
+            out[width - 1] = static_cast<uint16_t>(row[width - 2] + 3 * row[width - 1]);
+        }
+    });
+    m_pool.ParallelFor(height, grain, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint16_t* up = &m_smoothRows[static_cast<size_t>(y > 0 ? y - 1 : y) * width];
+            const uint16_t* row = &m_smoothRows[static_cast<size_t>(y) * width];
+            const uint16_t* down = &m_smoothRows[static_cast<size_t>(y + 1 < height ? y + 1 : y) * width];
+            uint8_t* out = &storage[static_cast<size_t>(y) * width];
+            for (uint32_t x = 0; x < width; x++)
+            {
+                out[x] = static_cast<uint8_t>((up[x] + 2 * row[x] + down[x] + 8) >> 4);
+            }
+        }
+    });
+
+    dst.data = storage.data();
+    dst.width = width;
+    dst.height = height;
+    dst.pitch = width;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "AnalysisPyramid.h"
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Per-pixel motion computed at one pyramid level, in that level's pixels
+// Same direction as MotionVector: the content at p in the current frame was at p + flow(p) in
+// the previous frame.
+struct FlowField
+{
+    std::vector<float> vectors;  // x, y interleaved, row by row
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t level = 0;          // Full resolution motion is 2^level times larger
+
+    bool IsEmpty() const { return vectors.empty() || width == 0; }
+
+    // Full resolution motion at full resolution pixel (x, y), bilinear between flow samples
+    void Sample(float x, float y, float& dx, float& dy) const;
+};
+
+struct OpticalFlowStats
+{
+    float smoothMs = 0.0f;   // Pre-filter of both frames, all levels
+    float searchMs = 0.0f;   // Patch inverse search, all levels
+    float densifyMs = 0.0f;  // Patch flow to per-pixel flow, all levels
+    float refineMs = 0.0f;   // Variational refinement, all levels
+    uint32_t patches = 0;    // Patches searched over all levels
+    uint32_t revertedPatches = 0;  // Patches whose search didn't improve on the starting flow
+};
+
+// Dense inverse search optical flow (after Kroeger et al., "Fast Optical Flow using Dense
+// Inverse Search") on the luma pyramid
+// At each level, from the coarsest down to the finest computed one:
+// 0. Both frames get a 3x3 binomial blur: the 2x2 box pyramid aliases fine detail such as text,
+//    and the gradient steps below need smooth images.
+// 1. Overlapping 8x8 patches of the current frame (4 pixel stride) start from the flow of the
+//    level above, or from the patch to their left if it matches better, and run a few inverse
+//    compositional Lucas-Kanade steps against the previous frame. The template gradients and
+//    Hessian are computed once per patch, so each step is one bilinear warp (SSE2) and a 2x2
+//    solve. Patches that end no better than they started keep the starting flow.
+// 2. Densification: each pixel averages the flow of the patches covering it, weighted by how
+//    well each one explains that pixel (1 / max(1, |photometric error|)).
+// 3. Variational refinement: a few Jacobi iterations of a linearised brightness-constancy term,
+//    normalised by the gradient strength, against quadratic smoothness (Horn-Schunck), which
+//    fills in flat areas and smooths patch seams.
+// The finest level defaults to quarter resolution; the flow is sampled bilinearly above that.
+class DenseOpticalFlow
+{
+public:
+    static const uint32_t PATCH_SIZE = 8;
+    static const uint32_t PATCH_STRIDE = 4;
+
+    DenseOpticalFlow();
+
+    // Finest pyramid level computed (0 = full resolution)
+    void SetFinestLevel(uint32_t level) { m_finestLevel = level; }
+    uint32_t GetFinestLevel() const { return m_finestLevel; }
+
+    // Largest motion to expect, in full resolution pixels; picks the coarsest level
+    void SetMaxMotion(uint32_t pixels) { m_maxMotion = pixels; }
+
+    // Pyramids of the same frame size
+    void Compute(const LumaPyramid& previous, const LumaPyramid& current);
+
+    const FlowField& GetFlow() const { return m_flow[m_result]; }
+    const OpticalFlowStats& GetStats() const { return m_stats; }
+
+private:
+    void SearchPatchRow(const LumaView& previous, const LumaView& current, const FlowField* coarser, uint32_t patchY,
+                        uint32_t patchesX, uint32_t& reverted);
+    void DensifyRow(const LumaView& previous, const LumaView& current, FlowField& flow, uint32_t patchesX, uint32_t patchesY, uint32_t y);
+    void Refine(const LumaView& previous, const LumaView& current, FlowField& flow);
+    void Smooth(const LumaView& src, std::vector<uint8_t>& storage, LumaView& dst);
+
+private:
+    ThreadPool& m_pool;
+    uint32_t m_finestLevel = 2;
+    uint32_t m_maxMotion = 32;
+
+    std::vector<uint8_t> m_smoothed[2];  // Current level of the previous and current frame, blurred
+    std::vector<uint16_t> m_smoothRows;  // Horizontal pass of the blur
+    std::vector<float> m_patchFlow;  // Current level's patches, x, y interleaved
+    FlowField m_flow[2];             // Alternating by level; the finer one starts from the coarser
+    uint32_t m_result = 0;
+    std::vector<float> m_terms;      // Densification weights, then the refinement's per-pixel terms
+    std::vector<float> m_scratch;    // Refinement: the other Jacobi buffer
+    OpticalFlowStats m_stats;
+};
@@ -0,0 +1,824 @@
+#include "PixelConvert.h"
+#include "../Utils/CpuFeatures.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Channel weights in BGRA order with 8 fractional bits, bias includes the rounding
+    const int16_t FULL_LUMA_WEIGHTS[3] = { 29, 150, 77 };  // Same as PixelLuma()
+    const int32_t FULL_LUMA_BIAS = 128;
+    const int16_t VIDEO_LUMA_WEIGHTS[3] = { 25, 129, 66 }; // BT.601 limited range
+    const int32_t VIDEO_LUMA_BIAS = 128 + (16 << 8);
+
+    // Chroma is computed from the sum of a 2x2 block, hence 10 fractional bits
+    const int16_t CHROMA_U_WEIGHTS[3] = { 112, -74, -38 };
+    const int16_t CHROMA_V_WEIGHTS[3] = { -18, -94, 112 };
+    const int32_t CHROMA_BIAS = 512 + (128 << 10);
+
+    inline uint8_t WeightedLuma(const uint8_t* pixel, const int16_t (&weights)[3], int32_t bias)
+    {
+        return static_cast<uint8_t>((pixel[0] * weights[0] + pixel[1] * weights[1] + pixel[2] * weights[2] + bias) >> 8);
+    }
+
+    inline uint8_t WeightedChroma(const int32_t (&sum)[3], const int16_t (&weights)[3])
+    {
+        return static_cast<uint8_t>((sum[0] * weights[0] + sum[1] * weights[1] + sum[2] * weights[2] + CHROMA_BIAS) >> 10);
+    }
+
+    inline __m128i LoadBytes(const uint8_t* p)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    inline void StoreBytes(uint8_t* p, __m128i v)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    }
+
+    inline __m128i WeightVector(const int16_t (&weights)[3])
+    {
+        return _mm_setr_epi16(weights[0], weights[1], weights[2], 0, weights[0], weights[1], weights[2], 0);
+    }
+
+    // madd leaves (b*wb + g*wg, r*wr) per pixel, add the two halves of 4 pixels
+    inline __m128i PairSums(__m128i lo, __m128i hi)
+    {
+        __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+        return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+    }
+
+    inline __m128i SwapRedBlueSse2(__m128i v)
+    {
+        const __m128i greenAlpha = _mm_set1_epi32(static_cast<int32_t>(0xFF00FF00u));
+        __m128i redBlue = _mm_andnot_si128(greenAlpha, v);
+        __m128i swapped = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+        return _mm_or_si128(_mm_and_si128(v, greenAlpha), swapped);
+    }
+
+    // --- BGRA8 <-> RGBA8 ---
+
+    uint32_t SwapRedBlueSse2(const uint8_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        for (; x + 4 <= width; x += 4)
+        {
+            StoreBytes(dst + x * 4, SwapRedBlueSse2(LoadBytes(src + x * 4)));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_SSE41 uint32_t SwapRedBlueSsse3(const uint8_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for (; x + 4 <= width; x += 4)
+        {
+            StoreBytes(dst + x * 4, _mm_shuffle_epi8(LoadBytes(src + x * 4), shuffle));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t SwapRedBlueAvx2(const uint8_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for (; x + 8 <= width; x += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_shuffle_epi8(v, shuffle));
+        }
+        return x;
+    }
+
+    // --- BGRA8 -> 8-bit luma ---
+
+    uint32_t WeightedLumaSse2(const uint8_t* src, uint8_t* dst, uint32_t x, uint32_t width, const int16_t (&weights)[3], int32_t bias)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i w = WeightVector(weights);
+        const __m128i round = _mm_set1_epi32(bias);
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i sums[4];
+            for (int i = 0; i < 4; i++)
+            {
+                __m128i pixels = LoadBytes(src + (x + i * 4) * 4);
+                __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), w);
+                __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), w);
+                sums[i] = _mm_srai_epi32(_mm_add_epi32(PairSums(lo, hi), round), 8);
+            }
+            __m128i lo = _mm_packs_epi32(sums[0], sums[1]);
+            __m128i hi = _mm_packs_epi32(sums[2], sums[3]);
+            StoreBytes(dst + x, _mm_packus_epi16(lo, hi));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t WeightedLumaAvx2(const uint8_t* src, uint8_t* dst, uint32_t x, uint32_t width, const int16_t (&weights)[3], int32_t bias)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i w = _mm256_broadcastsi128_si256(WeightVector(weights));
+        const __m256i round = _mm256_set1_epi32(bias);
+        // packs/packus work per 128-bit lane, this puts the 4-pixel groups back in order
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        for (; x + 32 <= width; x += 32)
+        {
+            __m256i sums[4];
+            for (int i = 0; i < 4; i++)
+            {
+                __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + (x + i * 8) * 4));
+                __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(pixels, zero), w);
+                __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(pixels, zero), w);
+                __m256 even = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+                __m256 odd = _mm256_shuffle_ps(_mm256_castsi256_ps(lo), _mm256_castsi256_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+                __m256i sum = _mm256_add_epi32(_mm256_castps_si256(even), _mm256_castps_si256(odd));
+                sums[i] = _mm256_srai_epi32(_mm256_add_epi32(sum, round), 8);
+            }
+            __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(sums[0], sums[1]), _mm256_packs_epi32(sums[2], sums[3]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_permutevar8x32_epi32(packed, order));
+        }
+        return x;
+    }
+
+    void WeightedLumaRow(const uint8_t* src, uint8_t* dst, uint32_t width, const int16_t (&weights)[3], int32_t bias)
+    {
+        uint32_t x = 0;
+        if (GetCpuFeatures().avx2)
+        {
+            x = WeightedLumaAvx2(src, dst, x, width, weights, bias);
+        }
+        x = WeightedLumaSse2(src, dst, x, width, weights, bias);
+        for (; x < width; x++)
+        {
+            dst[x] = WeightedLuma(src + x * 4, weights, bias);
+        }
+    }
+
+    // --- BGRA8 -> subsampled chroma ---
+
+    // One chroma row from two BGRA rows; interleaved is NV12 (u points at the UV plane)
+    template <bool Interleaved>
+    void ChromaRow(const uint8_t* row0, const uint8_t* row1, uint32_t width, uint8_t* u, uint8_t* v)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wu = WeightVector(CHROMA_U_WEIGHTS);
+        const __m128i wv = WeightVector(CHROMA_V_WEIGHTS);
+        const __m128i bias = _mm_set1_epi32(CHROMA_BIAS);
+
+        // 8 pixels of both rows -> 4 chroma samples
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i blocks[2];
+            for (int i = 0; i < 2; i++)
+            {
+                __m128i a = LoadBytes(row0 + (x + i * 4) * 4);
+                __m128i b = LoadBytes(row1 + (x + i * 4) * 4);
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                // Pixels 0+1 and 2+3 of the group
+                blocks[i] = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+            }
+
+            __m128i cu = PairSums(_mm_madd_epi16(blocks[0], wu), _mm_madd_epi16(blocks[1], wu));
+            __m128i cv = PairSums(_mm_madd_epi16(blocks[0], wv), _mm_madd_epi16(blocks[1], wv));
+            cu = _mm_srai_epi32(_mm_add_epi32(cu, bias), 10);
+            cv = _mm_srai_epi32(_mm_add_epi32(cv, bias), 10);
+
+            if (Interleaved)
+            {
+                __m128i uv = _mm_or_si128(cu, _mm_slli_epi32(cv, 16));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x), _mm_packus_epi16(uv, uv));
+            }
+            else
+            {
+                __m128i packed = _mm_packus_epi16(_mm_packs_epi32(cu, cv), zero);
+                int32_t uBytes = _mm_cvtsi128_si32(packed);
+                int32_t vBytes = _mm_cvtsi128_si32(_mm_srli_si128(packed, 4));
+                memcpy(u + x / 2, &uBytes, sizeof(uBytes));
+                memcpy(v + x / 2, &vBytes, sizeof(vBytes));
+            }
+        }
+
+        for (uint32_t cx = x / 2; cx < (width + 1) / 2; cx++)
+        {
+            const uint8_t* p0 = row0 + cx * 8;
+            const uint8_t* p1 = row1 + cx * 8;
+            size_t next = (cx * 2 + 1 < width) ? 4 : 0;
+            int32_t sum[3];
+            for (int c = 0; c < 3; c++)
+            {
+                sum[c] = p0[c] + p0[next + c] + p1[c] + p1[next + c];
+            }
+            if (Interleaved)
+            {
+                u[cx * 2] = WeightedChroma(sum, CHROMA_U_WEIGHTS);
+                u[cx * 2 + 1] = WeightedChroma(sum, CHROMA_V_WEIGHTS);
+            }
+            else
+            {
+                u[cx] = WeightedChroma(sum, CHROMA_U_WEIGHTS);
+                v[cx] = WeightedChroma(sum, CHROMA_V_WEIGHTS);
+            }
+        }
+    }
+
+    template <bool Interleaved>
+    void ConvertVideo(const ImageView& src, const MutablePlaneView& luma, const MutablePlaneView& u, const MutablePlaneView& v)
+    {
+        ThreadPool& pool = ThreadPool::Shared();
+        const uint32_t chromaHeight = (src.height + 1) / 2;
+        pool.ParallelFor(chromaHeight, pool.SuggestGrain(chromaHeight), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t cy = begin; cy < end; cy++)
+            {
+                uint32_t y0 = cy * 2;
+                uint32_t y1 = std::min(y0 + 1, src.height - 1);
+                WeightedLumaRow(src.Row(y0), luma.Row(y0), src.width, VIDEO_LUMA_WEIGHTS, VIDEO_LUMA_BIAS);
+                if (y1 != y0)
+                {
+                    WeightedLumaRow(src.Row(y1), luma.Row(y1), src.width, VIDEO_LUMA_WEIGHTS, VIDEO_LUMA_BIAS);
+                }
+                ChromaRow<Interleaved>(src.Row(y0), src.Row(y1), src.width, u.Row(cy), Interleaved ? nullptr : v.Row(cy));
+            }
+        });
+    }
+
+    // --- 8-bit <-> FP16 ---
+
+    // 8-bit value / 255 as FP16, computed the same way as the F16C path
+    struct HalfTable
+    {
+        uint16_t values[256];
+
+        HalfTable()
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                values[i] = FloatToHalf(static_cast<float>(i) * (1.0f / 255.0f));
+            }
+        }
+    };
+
+    const HalfTable& GetHalfTable()
+    {
+        static const HalfTable table;
+        return table;
+    }
+
+    inline uint8_t HalfToByte(uint16_t half)
+    {
+        float value = HalfToFloat(half);
+        // NaN fails both comparisons and ends up as 0
+        value = (value > 0.0f) ? std::min(value, 1.0f) : 0.0f;
+        return static_cast<uint8_t>(_mm_cvtss_si32(_mm_set_ss(value * 255.0f)));
+    }
+
+    POTATO_TARGET_AVX2 uint32_t BgraToHalfF16c(const uint8_t* src, uint16_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m128i toRgba = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i pixels = _mm_shuffle_epi8(LoadBytes(src + x * 4), toRgba);
+            __m256 lo = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(pixels)), scale);
+            __m256 hi = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(pixels, 8))), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm256_cvtps_ph(lo, _MM_FROUND_TO_NEAREST_INT));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4 + 8), _mm256_cvtps_ph(hi, _MM_FROUND_TO_NEAREST_INT));
+        }
+        return x;
+    }
+
+    // 4 halves in the low 16 bits of each lane to floats (branch-free version of HalfToFloat)
+    inline __m128 HalfToFloatSse2(__m128i half)
+    {
+        const __m128i expMantissaMask = _mm_set1_epi32(0x7FFF);
+        __m128i expMantissa = _mm_and_si128(half, expMantissaMask);
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(half, expMantissa), 16);
+        __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), _mm_set1_ps(0x1p112f));
+        __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMantissa, _mm_set1_epi32(0x7BFF)), _mm_set1_epi32(255 << 23));
+        return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan)));
+    }
+
+    // max(NaN, 0) returns 0, so NaN ends up black like in HalfToByte()
+    inline __m128i FloatsToBytesSse2(__m128 value)
+    {
+        value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(255.0f)));
+    }
+
+    uint32_t HalfToBgraSse2(const uint16_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i a = LoadBytes(reinterpret_cast<const uint8_t*>(src + x * 4));
+            __m128i b = LoadBytes(reinterpret_cast<const uint8_t*>(src + x * 4 + 8));
+            __m128i p0 = FloatsToBytesSse2(HalfToFloatSse2(_mm_unpacklo_epi16(a, zero)));
+            __m128i p1 = FloatsToBytesSse2(HalfToFloatSse2(_mm_unpackhi_epi16(a, zero)));
+            __m128i p2 = FloatsToBytesSse2(HalfToFloatSse2(_mm_unpacklo_epi16(b, zero)));
+            __m128i p3 = FloatsToBytesSse2(HalfToFloatSse2(_mm_unpackhi_epi16(b, zero)));
+            __m128i rgba = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+            StoreBytes(dst + x * 4, SwapRedBlueSse2(rgba));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t HalfToBgraF16c(const uint16_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        const __m256i toBgra = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for (; x + 8 <= width; x += 8)
+        {
+            // Two pixels per vector
+            __m256i values[4];
+            for (int i = 0; i < 4; i++)
+            {
+                __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (x + i * 2) * 4));
+                __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_cvtph_ps(half), _mm256_setzero_ps()), one);
+                values[i] = _mm256_cvtps_epi32(_mm256_mul_ps(value, scale));
+            }
+            __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(values[0], values[1]), _mm256_packs_epi32(values[2], values[3]));
+            packed = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(packed, order), toBgra);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), packed);
+        }
+        return x;
+    }
+
+    // --- 10:10:10:2 -> BGRA8 ---
+
+    uint32_t Rgb10A2ToBgraSse2(const uint8_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+        const __m128 scale = _mm_set1_ps(255.0f / 1023.0f);
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i v = LoadBytes(src + x * 4);
+            __m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask)), scale));
+            __m128i g = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 10), mask)), scale));
+            __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 20), mask)), scale));
+            __m128i a = _mm_madd_epi16(_mm_srli_epi32(v, 30), _mm_set1_epi32(85));
+            __m128i bgra = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(a, 24)));
+            StoreBytes(dst + x * 4, bgra);
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t Rgb10A2ToBgraAvx2(const uint8_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m256i mask = _mm256_set1_epi32(0x3FF);
+        const __m256 scale = _mm256_set1_ps(255.0f / 1023.0f);
+        for (; x + 8 <= width; x += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+            __m256i r = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(v, mask)), scale));
+            __m256i g = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 10), mask)), scale));
+            __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 20), mask)), scale));
+            __m256i a = _mm256_mullo_epi32(_mm256_srli_epi32(v, 30), _mm256_set1_epi32(85));
+            __m256i bgra = _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), _mm256_slli_epi32(a, 24)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), bgra);
+        }
+        return x;
+    }
+
+    inline uint8_t TenBitToByte(uint32_t value)
+    {
+        return static_cast<uint8_t>((value * 255 + 511) / 1023);
+    }
+
+    // --- 10:10:10:2 <-> RGBA16F ---
+
+    uint32_t Rgb10A2ToHalfSse2(const uint8_t* src, uint16_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+        const __m128 scale = _mm_set1_ps(1.0f / 1023.0f);
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i v = LoadBytes(src + x * 4);
+            __m128i r = FloatToHalfSse2(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask)), scale));
+            __m128i g = FloatToHalfSse2(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 10), mask)), scale));
+            __m128i b = FloatToHalfSse2(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 20), mask)), scale));
+            __m128i a = FloatToHalfSse2(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 30)), _mm_set1_ps(1.0f / 3.0f)));
+            __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+            __m128i ba = _mm_or_si128(b, _mm_slli_epi32(a, 16));
+            StoreBytes(reinterpret_cast<uint8_t*>(dst + x * 4), _mm_unpacklo_epi32(rg, ba));
+            StoreBytes(reinterpret_cast<uint8_t*>(dst + x * 4 + 8), _mm_unpackhi_epi32(rg, ba));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t Rgb10A2ToHalfF16c(const uint8_t* src, uint16_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m256i mask = _mm256_set1_epi32(0x3FF);
+        const __m256 scale = _mm256_set1_ps(1.0f / 1023.0f);
+        for (; x + 8 <= width; x += 8)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+            __m128i r = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(v, mask)), scale), _MM_FROUND_TO_NEAREST_INT);
+            __m128i g = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 10), mask)), scale), _MM_FROUND_TO_NEAREST_INT);
+            __m128i b = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 20), mask)), scale), _MM_FROUND_TO_NEAREST_INT);
+            __m128i a = _mm256_cvtps_ph(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 30)), _mm256_set1_ps(1.0f / 3.0f)), _MM_FROUND_TO_NEAREST_INT);
+            __m128i rg0 = _mm_unpacklo_epi16(r, g);
+            __m128i rg1 = _mm_unpackhi_epi16(r, g);
+            __m128i ba0 = _mm_unpacklo_epi16(b, a);
+            __m128i ba1 = _mm_unpackhi_epi16(b, a);
+            uint8_t* out = reinterpret_cast<uint8_t*>(dst + x * 4);
+            StoreBytes(out, _mm_unpacklo_epi32(rg0, ba0));
+            StoreBytes(out + 16, _mm_unpackhi_epi32(rg0, ba0));
+            StoreBytes(out + 32, _mm_unpacklo_epi32(rg1, ba1));
+            StoreBytes(out + 48, _mm_unpackhi_epi32(rg1, ba1));
+        }
+        return x;
+    }
+
+    // Four RGBA float pixels (0..1) to 10:10:10:2, NaN ends up 0 like in HalfToByte()
+    inline __m128i PackTenBit(__m128 p0, __m128 p1, __m128 p2, __m128 p3)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        p0 = _mm_min_ps(_mm_max_ps(p0, _mm_setzero_ps()), one);
+        p1 = _mm_min_ps(_mm_max_ps(p1, _mm_setzero_ps()), one);
+        p2 = _mm_min_ps(_mm_max_ps(p2, _mm_setzero_ps()), one);
+        p3 = _mm_min_ps(_mm_max_ps(p3, _mm_setzero_ps()), one);
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+        const __m128 scale = _mm_set1_ps(1023.0f);
+        __m128i r = _mm_cvtps_epi32(_mm_mul_ps(p0, scale));
+        __m128i g = _mm_cvtps_epi32(_mm_mul_ps(p1, scale));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(p2, scale));
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(p3, _mm_set1_ps(3.0f)));
+        return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 10)), _mm_or_si128(_mm_slli_epi32(b, 20), _mm_slli_epi32(a, 30)));
+    }
+
+    uint32_t HalfToRgb10A2Sse2(const uint16_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i a = LoadBytes(reinterpret_cast<const uint8_t*>(src + x * 4));
+            __m128i b = LoadBytes(reinterpret_cast<const uint8_t*>(src + x * 4 + 8));
+            StoreBytes(dst + x * 4, PackTenBit(
+                HalfToFloatSse2(_mm_unpacklo_epi16(a, zero)), HalfToFloatSse2(_mm_unpackhi_epi16(a, zero)),
+                HalfToFloatSse2(_mm_unpacklo_epi16(b, zero)), HalfToFloatSse2(_mm_unpackhi_epi16(b, zero))));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t HalfToRgb10A2F16c(const uint16_t* src, uint8_t* dst, uint32_t x, uint32_t width)
+    {
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i a = LoadBytes(reinterpret_cast<const uint8_t*>(src + x * 4));
+            __m128i b = LoadBytes(reinterpret_cast<const uint8_t*>(src + x * 4 + 8));
+            StoreBytes(dst + x * 4, PackTenBit(
+                _mm_cvtph_ps(a), _mm_cvtph_ps(_mm_srli_si128(a, 8)),
+                _mm_cvtph_ps(b), _mm_cvtph_ps(_mm_srli_si128(b, 8))));
+        }
+        return x;
+    }
+
+    inline uint32_t HalfToTenBit(uint16_t half, float scale)
+    {
+        float value = HalfToFloat(half);
+        value = (value > 0.0f) ? std::min(value, 1.0f) : 0.0f;
+        return static_cast<uint32_t>(_mm_cvtss_si32(_mm_set_ss(value * scale)));
+    }
+
+    // --- RGBA16F <-> BGRA float (CPU kernel layout) ---
+
+    uint32_t HalfToBgraFloatSse2(const uint16_t* src, float* dst, uint32_t x, uint32_t width)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 scale = _mm_set1_ps(255.0f);
+        for (; x + 2 <= width; x += 2)
+        {
+            __m128i half = LoadBytes(reinterpret_cast<const uint8_t*>(src + x * 4));
+            __m128 p0 = HalfToFloatSse2(_mm_unpacklo_epi16(half, zero));
+            __m128 p1 = HalfToFloatSse2(_mm_unpackhi_epi16(half, zero));
+            _mm_storeu_ps(dst + x * 4, _mm_mul_ps(_mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 0, 1, 2)), scale));
+            _mm_storeu_ps(dst + x * 4 + 4, _mm_mul_ps(_mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 0, 1, 2)), scale));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t HalfToBgraFloatF16c(const uint16_t* src, float* dst, uint32_t x, uint32_t width)
+    {
+        const __m256 scale = _mm256_set1_ps(255.0f);
+        for (; x + 4 <= width; x += 4)
+        {
+            __m256 p01 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4)));
+            __m256 p23 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4 + 8)));
+            _mm256_storeu_ps(dst + x * 4, _mm256_mul_ps(_mm256_permute_ps(p01, _MM_SHUFFLE(3, 0, 1, 2)), scale));
+            _mm256_storeu_ps(dst + x * 4 + 8, _mm256_mul_ps(_mm256_permute_ps(p23, _MM_SHUFFLE(3, 0, 1, 2)), scale));
+        }
+        return x;
+    }
+
+    POTATO_TARGET_AVX2 uint32_t FloatToHalfF16c(const float* src, uint16_t* dst, uint32_t x, uint32_t width)
+    {
+        const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+        for (; x + 4 <= width; x += 4)
+        {
+            __m256 p01 = _mm256_mul_ps(_mm256_permute_ps(_mm256_loadu_ps(src + x * 4), _MM_SHUFFLE(3, 0, 1, 2)), scale);
+            __m256 p23 = _mm256_mul_ps(_mm256_permute_ps(_mm256_loadu_ps(src + x * 4 + 8), _MM_SHUFFLE(3, 0, 1, 2)), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm256_cvtps_ph(p01, _MM_FROUND_TO_NEAREST_INT));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4 + 8), _mm256_cvtps_ph(p23, _MM_FROUND_TO_NEAREST_INT));
+        }
+        return x;
+    }
+
+    template <typename Fn>
+    void ForEachRow(uint32_t height, Fn&& fn)
+    {
+        ThreadPool& pool = ThreadPool::Shared();
+        pool.ParallelFor(height, pool.SuggestGrain(height), [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t y = begin; y < end; y++)
+            {
+                fn(y);
+            }
+        });
+    }
+}
+
+uint32_t GetBytesPerPixel(PixelFormat format)
+{
+    return (format == PixelFormat::Rgba16F) ? 8 : 4;
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= (143u << 23))
+    {
+        half = (bits > (255u << 23)) ? 0x7E00u : 0x7C00u;  // NaN, overflow to Inf
+    }
+    else if (bits < (113u << 23))
+    {
+        // Denormal: let the FPU round by adding a magic value
+        const uint32_t magicBits = 126u << 23;
+        float magic;
+        memcpy(&magic, &magicBits, sizeof(magic));
+        float shifted;
+        memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += magic;
+        memcpy(&half, &shifted, sizeof(half));
+        half -= magicBits;
+    }
+    else
+    {
+        uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu + mantissaOdd;
+        half = bits >> 13;
+    }
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float HalfToFloat(uint16_t half)
+{
+    // Shift into float position and rebias with a multiply, which also handles denormals
+    uint32_t expMantissa = half & 0x7FFFu;
+    uint32_t bits = expMantissa << 13;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    value *= 0x1p112f;
+    memcpy(&bits, &value, sizeof(bits));
+    if (expMantissa > 0x7BFFu)
+    {
+        bits |= 255u << 23;  // Inf/NaN
+    }
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void SwapRedBlueRow(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    uint32_t x = 0;
+    if (features.avx2)
+    {
+        x = SwapRedBlueAvx2(src, dst, x, width);
+    }
+    x = features.sse41 ? SwapRedBlueSsse3(src, dst, x, width) : SwapRedBlueSse2(src, dst, x, width);
+    for (; x < width; x++)
+    {
+        uint8_t red = src[x * 4 + 2];
+        dst[x * 4 + 2] = src[x * 4];
+        dst[x * 4 + 1] = src[x * 4 + 1];
+        dst[x * 4 + 3] = src[x * 4 + 3];
+        dst[x * 4] = red;
+    }
+}
+
+void BgraToLumaRow(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    WeightedLumaRow(src, dst, width, FULL_LUMA_WEIGHTS, FULL_LUMA_BIAS);
+}
+
+void BgraToHalfRow(const uint8_t* src, uint16_t* dst, uint32_t width)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    uint32_t x = 0;
+    if (features.avx2 && features.f16c)
+    {
+        x = BgraToHalfF16c(src, dst, x, width);
+    }
+    const HalfTable& table = GetHalfTable();
+    for (; x < width; x++)
+    {
+        dst[x * 4] = table.values[src[x * 4 + 2]];
+        dst[x * 4 + 1] = table.values[src[x * 4 + 1]];
+        dst[x * 4 + 2] = table.values[src[x * 4]];
+        dst[x * 4 + 3] = table.values[src[x * 4 + 3]];
+    }
+}
+
+void HalfToBgraRow(const uint16_t* src, uint8_t* dst, uint32_t width)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    uint32_t x = 0;
+    if (features.avx2 && features.f16c)
+    {
+        x = HalfToBgraF16c(src, dst, x, width);
+    }
+    x = HalfToBgraSse2(src, dst, x, width);
+    for (; x < width; x++)
+    {
+        dst[x * 4] = HalfToByte(src[x * 4 + 2]);
+        dst[x * 4 + 1] = HalfToByte(src[x * 4 + 1]);
+        dst[x * 4 + 2] = HalfToByte(src[x * 4]);
+        dst[x * 4 + 3] = HalfToByte(src[x * 4 + 3]);
+    }
+}
+
+void Rgb10A2ToBgraRow(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    uint32_t x = 0;
+    if (GetCpuFeatures().avx2)
+    {
+        x = Rgb10A2ToBgraAvx2(src, dst, x, width);
+    }
+    x = Rgb10A2ToBgraSse2(src, dst, x, width);
+    for (; x < width; x++)
+    {
+        uint32_t v;
+        memcpy(&v, src + x * 4, sizeof(v));
+        dst[x * 4] = TenBitToByte((v >> 20) & 0x3FF);
+        dst[x * 4 + 1] = TenBitToByte((v >> 10) & 0x3FF);
+        dst[x * 4 + 2] = TenBitToByte(v & 0x3FF);
+        dst[x * 4 + 3] = static_cast<uint8_t>((v >> 30) * 85);
+    }
+}
+
+void Rgb10A2ToHalfRow(const uint8_t* src, uint16_t* dst, uint32_t width)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    uint32_t x = 0;
+    if (features.avx2 && features.f16c)
+    {
+        x = Rgb10A2ToHalfF16c(src, dst, x, width);
+    }
+    x = Rgb10A2ToHalfSse2(src, dst, x, width);
+    for (; x < width; x++)
+    {
+        uint32_t v;
+        memcpy(&v, src + x * 4, sizeof(v));
+        dst[x * 4] = FloatToHalf(static_cast<float>(v & 0x3FF) * (1.0f / 1023.0f));
+        dst[x * 4 + 1] = FloatToHalf(static_cast<float>((v >> 10) & 0x3FF) * (1.0f / 1023.0f));
+        dst[x * 4 + 2] = FloatToHalf(static_cast<float>((v >> 20) & 0x3FF) * (1.0f / 1023.0f));
+        dst[x * 4 + 3] = FloatToHalf(static_cast<float>(v >> 30) * (1.0f / 3.0f));
+    }
+}
+
+void HalfToRgb10A2Row(const uint16_t* src, uint8_t* dst, uint32_t width)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    uint32_t x = 0;
+    x = (features.avx2 && features.f16c) ? HalfToRgb10A2F16c(src, dst, x, width) : HalfToRgb10A2Sse2(src, dst, x, width);
+    for (; x < width; x++)
+    {
+        const uint16_t* pixel = src + x * 4;
+        uint32_t v = HalfToTenBit(pixel[0], 1023.0f) | (HalfToTenBit(pixel[1], 1023.0f) << 10) |
+                     (HalfToTenBit(pixel[2], 1023.0f) << 20) | (HalfToTenBit(pixel[3], 3.0f) << 30);
+        memcpy(dst + x * 4, &v, sizeof(v));
+    }
+}
+
+void HalfToFloatRow(const uint16_t* src, float* dst, uint32_t width)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    uint32_t x = 0;
+    if (features.avx2 && features.f16c)
+    {
+        x = HalfToBgraFloatF16c(src, dst, x, width);
+    }
+    x = HalfToBgraFloatSse2(src, dst, x, width);
+    for (; x < width; x++)
+    {
+        dst[x * 4] = HalfToFloat(src[x * 4 + 2]) * 255.0f;
+        dst[x * 4 + 1] = HalfToFloat(src[x * 4 + 1]) * 255.0f;
+        dst[x * 4 + 2] = HalfToFloat(src[x * 4]) * 255.0f;
+        dst[x * 4 + 3] = HalfToFloat(src[x * 4 + 3]) * 255.0f;
+    }
+}
+
+void FloatToHalfRow(const float* src, uint16_t* dst, uint32_t width)
+{
+    const CpuFeatures& features = GetCpuFeatures();
+    uint32_t x = 0;
+    if (features.avx2 && features.f16c)
+    {
+        x = FloatToHalfF16c(src, dst, x, width);
+    }
+    for (; x < width; x++)
+    {
+        StorePixelHalf(dst + x * 4, _mm_loadu_ps(src + x * 4));
+    }
+}
+
+void ConvertToBgra(PixelFormat format, const PlaneView& src, const MutableImageView& dst)
+{
+    const size_t rowBytes = static_cast<size_t>(dst.width) * 4;
+    ForEachRow(dst.height, [&](uint32_t y)
+    {
+        const uint8_t* in = src.Row(y);
+        uint8_t* out = dst.Row(y);
+        switch (format)
+        {
+        case PixelFormat::Rgba8:
+            SwapRedBlueRow(in, out, dst.width);
+            break;
+        case PixelFormat::Rgb10A2:
+            Rgb10A2ToBgraRow(in, out, dst.width);
+            break;
+        case PixelFormat::Rgba16F:
+            HalfToBgraRow(reinterpret_cast<const uint16_t*>(in), out, dst.width);
+            break;
+        default:
+            memcpy(out, in, rowBytes);
+            break;
+        }
+    });
+}
+
+void BgraToRgba(const ImageView& src, const MutablePlaneView& dst)
+{
+    ForEachRow(src.height, [&](uint32_t y)
+    {
+        SwapRedBlueRow(src.Row(y), dst.Row(y), src.width);
+    });
+}
+
+void BgraToLuma(const ImageView& src, const MutablePlaneView& luma)
+{
+    ForEachRow(src.height, [&](uint32_t y)
+    {
+        BgraToLumaRow(src.Row(y), luma.Row(y), src.width);
+    });
+}
+
+void BgraToHalf(const ImageView& src, const MutablePlaneView& dst)
+{
+    ForEachRow(src.height, [&](uint32_t y)
+    {
+        BgraToHalfRow(src.Row(y), reinterpret_cast<uint16_t*>(dst.Row(y)), src.width);
+    });
+}
+
+void Rgb10A2ToHalf(const PlaneView& src, const MutableHalfImageView& dst)
+{
+    ForEachRow(dst.height, [&](uint32_t y)
+    {
+        Rgb10A2ToHalfRow(src.Row(y), dst.Row(y), dst.width);
+    });
+}
+
+void HalfToRgb10A2(const HalfImageView& src, const MutablePlaneView& dst)
+{
+    ForEachRow(src.height, [&](uint32_t y)
+    {
+        HalfToRgb10A2Row(src.Row(y), dst.Row(y), src.width);
+    });
+}
+
+void BgraToNv12(const ImageView& src, const MutablePlaneView& luma, const MutablePlaneView& chroma)
+{
+    ConvertVideo<true>(src, luma, chroma, MutablePlaneView{});
+}
+
+void BgraToI420(const ImageView& src, const MutablePlaneView& luma, const MutablePlaneView& u, const MutablePlaneView& v)
+{
+    ConvertVideo<false>(src, luma, u, v);
+}
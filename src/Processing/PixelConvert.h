@@ -0,0 +1,105 @@
+#pragma once
+#include "ImageView.h"
+#include "PixelSimd.h"
+#include <cstddef>
+#include <cstdint>
+
+// Pixel format conversions for frames crossing format boundaries (capture and readback
+// formats, luma planes, video encoder layouts)
+// Row functions are for callers already inside a parallel loop; the whole-image versions
+// split the rows over the shared thread pool. SSE2 baseline, SSSE3/AVX2/F16C when available.
+
+// Raw plane of a format ImageView doesn't describe; pitch is in bytes
+struct PlaneView
+{
+    const uint8_t* data = nullptr;
+    size_t pitch = 0;
+
+    const uint8_t* Row(uint32_t y) const { return data + y * pitch; }
+};
+
+struct MutablePlaneView
+{
+    uint8_t* data = nullptr;
+    size_t pitch = 0;
+
+    uint8_t* Row(uint32_t y) const { return data + y * pitch; }
+    operator PlaneView() const { return PlaneView{ data, pitch }; }
+};
+
+// Source formats that can be converted to BGRA8 (DXGI layouts)
+enum class PixelFormat
+{
+    Bgra8,    // B8G8R8A8_UNORM
+    Rgba8,    // R8G8B8A8_UNORM
+    Rgb10A2,  // R10G10B10A2_UNORM
+    Rgba16F   // R16G16B16A16_FLOAT, clamped to 0..1
+};
+
+uint32_t GetBytesPerPixel(PixelFormat format);
+
+// Scalar FP16 conversions (round to nearest even, like F16C)
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t half);
+
+// Rows, width in pixels
+void SwapRedBlueRow(const uint8_t* src, uint8_t* dst, uint32_t width);    // BGRA8 <-> RGBA8, src may be dst
+void BgraToLumaRow(const uint8_t* src, uint8_t* dst, uint32_t width);     // Full range, same as PixelLuma()
+void BgraToHalfRow(const uint8_t* src, uint16_t* dst, uint32_t width);    // -> RGBA16F 0..1
+void HalfToBgraRow(const uint16_t* src, uint8_t* dst, uint32_t width);    // RGBA16F -> BGRA8
+void Rgb10A2ToBgraRow(const uint8_t* src, uint8_t* dst, uint32_t width);  // R10G10B10A2 -> BGRA8
+void Rgb10A2ToHalfRow(const uint8_t* src, uint16_t* dst, uint32_t width);  // R10G10B10A2 -> RGBA16F 0..1
+void HalfToRgb10A2Row(const uint16_t* src, uint8_t* dst, uint32_t width);  // RGBA16F -> R10G10B10A2, clamped
+void HalfToFloatRow(const uint16_t* src, float* dst, uint32_t width);      // RGBA16F -> BGRA floats, 1.0 = 255
+void FloatToHalfRow(const float* src, uint16_t* dst, uint32_t width);      // BGRA floats -> RGBA16F, like StorePixelHalf()
+
+// Whole images, sized by the BGRA8 side
+void ConvertToBgra(PixelFormat format, const PlaneView& src, const MutableImageView& dst);
+void BgraToRgba(const ImageView& src, const MutablePlaneView& dst);
+void BgraToLuma(const ImageView& src, const MutablePlaneView& luma);
+void BgraToHalf(const ImageView& src, const MutablePlaneView& dst);
+void Rgb10A2ToHalf(const PlaneView& src, const MutableHalfImageView& dst);
+void HalfToRgb10A2(const HalfImageView& src, const MutablePlaneView& dst);
+
+// Video layouts, BT.601 limited range with chroma averaged over 2x2 pixels
+// Odd sizes repeat the last column/row; chroma planes are (width + 1) / 2 x (height + 1) / 2
+void BgraToNv12(const ImageView& src, const MutablePlaneView& luma, const MutablePlaneView& chroma);
+void BgraToI420(const ImageView& src, const MutablePlaneView& luma, const MutablePlaneView& u, const MutablePlaneView& v);
+
+// 4 floats to halves in the low 16 bits of each lane, rounding like FloatToHalf()
+inline __m128i FloatToHalfSse2(__m128 value)
+{
+    const __m128i signMask = _mm_set1_epi32(static_cast<int32_t>(0x80000000u));
+    __m128i bits = _mm_castps_si128(value);
+    __m128i sign = _mm_and_si128(bits, signMask);
+    __m128i absBits = _mm_xor_si128(bits, sign);
+
+    // Normal results: rebias the exponent and round the dropped mantissa bits to even
+    __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(absBits, 13), _mm_set1_epi32(1));
+    __m128i normal = _mm_add_epi32(absBits, _mm_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu)));
+    normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), 13);
+
+    // Denormal results: let the FPU round by adding a magic value
+    const __m128i magic = _mm_set1_epi32(126 << 23);
+    __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(absBits), _mm_castsi128_ps(magic))), magic);
+
+    // Overflow to Inf, NaN stays NaN
+    __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(value, value));
+    __m128i special = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(isNan, _mm_set1_epi32(0x200)));
+
+    __m128i isDenormal = _mm_cmpgt_epi32(_mm_set1_epi32(113 << 23), absBits);
+    __m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32(143 << 23), absBits);
+    __m128i half = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+    half = _mm_or_si128(_mm_and_si128(isRegular, half), _mm_andnot_si128(isRegular, special));
+    return _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+}
+
+// A BGRA float pixel on the 0..255 scale to RGBA16F, HDR values above 255 are kept
+inline void StorePixelHalf(uint16_t* pixel, __m128 value)
+{
+    __m128 rgba = _mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 0, 1, 2));
+    __m128i half = FloatToHalfSse2(_mm_mul_ps(rgba, _mm_set1_ps(1.0f / 255.0f)));
+    // Sign extend so the pack doesn't saturate negative values
+    half = _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(pixel), _mm_packs_epi32(half, half));
+}
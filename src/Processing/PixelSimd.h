@@ -0,0 +1,48 @@
+#pragma once
+#include <emmintrin.h>
+#include <cstdint>
+#include <cstring>
+
+// Small SSE2 helpers shared by the CPU pixel kernels
+// A BGRA8 pixel is processed as one __m128 holding its four channels as floats
+
+inline __m128 LoadPixel(const uint8_t* pixel)
+{
+    int32_t packed;
+    memcpy(&packed, pixel, sizeof(packed));
+    __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+    v = _mm_unpacklo_epi16(v, zero);
+    return _mm_cvtepi32_ps(v);
+}
+
+// Rounds and saturates to 0..255
+inline void StorePixel(uint8_t* pixel, __m128 value)
+{
+    __m128i v = _mm_cvtps_epi32(value);
+    v = _mm_packs_epi32(v, v);
+    v = _mm_packus_epi16(v, v);
+    int32_t packed = _mm_cvtsi128_si32(v);
+    memcpy(pixel, &packed, sizeof(packed));
+}
+
+inline void CopyPixel(uint8_t* dst, const uint8_t* src)
+{
+    memcpy(dst, src, 4);
+}
+
+// BT.601 luma of a BGRA8 pixel, same weights as GetLuminance() in the shaders
+inline uint8_t PixelLuma(const uint8_t* pixel)
+{
+    return static_cast<uint8_t>((pixel[0] * 29 + pixel[1] * 150 + pixel[2] * 77 + 128) >> 8);
+}
+
+// Arithmetic of the kernels that come in two variants: Float widens each channel to a float
+// lane, Fixed16 keeps channels in 16-bit lanes with rounding shifts (twice the channels per
+// instruction) and stays within 1 LSB of Float. Fixed16 falls back to Float on CPUs without
+// the instructions it needs
+enum class KernelPrecision
+{
+    Float,
+    Fixed16
+};
@@ -0,0 +1,197 @@
+#include "SceneCutDetector.h"
+#include "PixelConvert.h"
+#include "../Utils/ThreadPool.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    // Pixels converted at a time, so a row needs no heap buffer whatever the frame width; the
+    // byte counters of CountBins() take at most 255 vectors
+    const uint32_t SEGMENT = 1024;
+
+    // Largest correlation of a cut: above it the picture is the same one, brighter or darker
+    const float MAX_CORRELATION = 0.5f;
+
+    // Luma sums of one frame pair's samples
+    struct PairSums
+    {
+        uint64_t a = 0;
+        uint64_t b = 0;
+        uint64_t aa = 0;
+        uint64_t bb = 0;
+        uint64_t ab = 0;
+    };
+
+    uint64_t SumLanes32(__m128i sum)
+    {
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sum);
+        return static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    // Sums, squares and products of two luma rows (SSE2); 32-bit lanes are safe for a SEGMENT
+    void AccumulateSums(const uint8_t* a, const uint8_t* b, uint32_t width, PairSums& sums)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sumA = zero;
+        __m128i sumB = zero;
+        __m128i sumAA = zero;
+        __m128i sumBB = zero;
+        __m128i sumAB = zero;
+        uint32_t x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+            sumA = _mm_add_epi64(sumA, _mm_sad_epu8(va, zero));
+            sumB = _mm_add_epi64(sumB, _mm_sad_epu8(vb, zero));
+            __m128i aLow = _mm_unpacklo_epi8(va, zero);
+            __m128i aHigh = _mm_unpackhi_epi8(va, zero);
+            __m128i bLow = _mm_unpacklo_epi8(vb, zero);
+            __m128i bHigh = _mm_unpackhi_epi8(vb, zero);
+            sumAA = _mm_add_epi32(sumAA, _mm_add_epi32(_mm_madd_epi16(aLow, aLow), _mm_madd_epi16(aHigh, aHigh)));
+            sumBB = _mm_add_epi32(sumBB, _mm_add_epi32(_mm_madd_epi16(bLow, bLow), _mm_madd_epi16(bHigh, bHigh)));
+            sumAB = _mm_add_epi32(sumAB, _mm_add_epi32(_mm_madd_epi16(aLow, bLow), _mm_madd_epi16(aHigh, bHigh)));
+        }
+
+        sums.a += static_cast<uint64_t>(_mm_cvtsi128_si32(sumA)) + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_unpackhi_epi64(sumA, sumA)));
+        sums.b += static_cast<uint64_t>(_mm_cvtsi128_si32(sumB)) + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_unpackhi_epi64(sumB, sumB)));
+        sums.aa += SumLanes32(sumAA);
+        sums.bb += SumLanes32(sumBB);
+        sums.ab += SumLanes32(sumAB);
+        for (; x < width; x++)
+        {
+            sums.a += a[x];
+            sums.b += b[x];
+            sums.aa += a[x] * a[x];
+            sums.bb += b[x] * b[x];
+            sums.ab += a[x] * b[x];
+        }
+    }
+
+    // counts[b] += pixels whose luma is in bin b (luma / 16)
+    void CountBins(const uint8_t* luma, uint32_t width, uint32_t* counts)
+    {
+        const __m128i lowNibble = _mm_set1_epi8(0x0F);
+        const __m128i zero = _mm_setzero_si128();
+        __m128i bins[SceneCutDetector::HISTOGRAM_BINS];
+        for (uint32_t b = 0; b < SceneCutDetector::HISTOGRAM_BINS; b++)
+        {
+            bins[b] = zero;
+        }
+
+        uint32_t x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma + x));
+            __m128i bin = _mm_and_si128(_mm_srli_epi16(v, 4), lowNibble);
+            for (uint32_t b = 0; b < SceneCutDetector::HISTOGRAM_BINS; b++)
+            {
+                // cmpeq gives -1 per matching byte
+                bins[b] = _mm_sub_epi8(bins[b], _mm_cmpeq_epi8(bin, _mm_set1_epi8(static_cast<char>(b))));
+            }
+        }
+
+        for (uint32_t b = 0; b < SceneCutDetector::HISTOGRAM_BINS; b++)
+        {
+            __m128i sum = _mm_sad_epu8(bins[b], zero);
+            sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+            counts[b] += static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+        }
+        for (; x < width; x++)
+        {
+            counts[luma[x] >> 4]++;
+        }
+    }
+}
+
+SceneCutDetector::SceneCutDetector()
+    : m_pool(ThreadPool::Shared())
+{
+}
+
+SceneCutResult SceneCutDetector::Compare(const ImageView& previous, const ImageView& current) const
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    SceneCutResult result;
+    if (previous.width != current.width || previous.height != current.height || current.width == 0 || current.height == 0)
+    {
+        result.histogramDistance = 1.0f;
+        result.cut = true;
+        return result;
+    }
+
+    const uint32_t rows = (current.height + ROW_STEP - 1) / ROW_STEP;
+    std::atomic<uint64_t> histograms[2][HISTOGRAM_BINS];
+    std::atomic<uint64_t> pairSums[5];
+    for (auto& sum : pairSums)
+    {
+        sum.store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t b = 0; b < HISTOGRAM_BINS; b++)
+    {
+        histograms[0][b].store(0, std::memory_order_relaxed);
+        histograms[1][b].store(0, std::memory_order_relaxed);
+    }
+
+    m_pool.ParallelFor(rows, m_pool.SuggestGrain(rows), [&](uint32_t begin, uint32_t end)
+    {
+        alignas(16) uint8_t luma[2][SEGMENT];
+        uint32_t counts[2][HISTOGRAM_BINS] = {};
+        PairSums chunkSums;
+        for (uint32_t row = begin; row < end; row++)
+        {
+            const uint32_t y = row * ROW_STEP;
+            for (uint32_t x0 = 0; x0 < current.width; x0 += SEGMENT)
+            {
+                const uint32_t width = std::min(SEGMENT, current.width - x0);
+                BgraToLumaRow(previous.Row(y) + x0 * 4, luma[0], width);
+                BgraToLumaRow(current.Row(y) + x0 * 4, luma[1], width);
+                CountBins(luma[0], width, counts[0]);
+                CountBins(luma[1], width, counts[1]);
+                AccumulateSums(luma[0], luma[1], width, chunkSums);
+            }
+        }
+
+        for (uint32_t b = 0; b < HISTOGRAM_BINS; b++)
+        {
+            histograms[0][b].fetch_add(counts[0][b], std::memory_order_relaxed);
+            histograms[1][b].fetch_add(counts[1][b], std::memory_order_relaxed);
+        }
+        pairSums[0].fetch_add(chunkSums.a, std::memory_order_relaxed);
+        pairSums[1].fetch_add(chunkSums.b, std::memory_order_relaxed);
+        pairSums[2].fetch_add(chunkSums.aa, std::memory_order_relaxed);
+        pairSums[3].fetch_add(chunkSums.bb, std::memory_order_relaxed);
+        pairSums[4].fetch_add(chunkSums.ab, std::memory_order_relaxed);
+    });
+
+    // Half the L1 distance of the histograms is the share of pixels that changed bin
+    const double samples = static_cast<double>(rows) * current.width;
+    uint64_t moved = 0;
+    for (uint32_t b = 0; b < HISTOGRAM_BINS; b++)
+    {
+        const int64_t a = static_cast<int64_t>(histograms[0][b].load(std::memory_order_relaxed));
+        const int64_t c = static_cast<int64_t>(histograms[1][b].load(std::memory_order_relaxed));
+        moved += static_cast<uint64_t>(std::llabs(a - c));
+    }
+    result.histogramDistance = static_cast<float>(moved / (2.0 * samples));
+
+    // Pearson correlation of the samples; a flat frame correlates with nothing
+    const double sumA = static_cast<double>(pairSums[0].load(std::memory_order_relaxed));
+    const double sumB = static_cast<double>(pairSums[1].load(std::memory_order_relaxed));
+    const double varianceA = samples * pairSums[2].load(std::memory_order_relaxed) - sumA * sumA;
+    const double varianceB = samples * pairSums[3].load(std::memory_order_relaxed) - sumB * sumB;
+    const double covariance = samples * pairSums[4].load(std::memory_order_relaxed) - sumA * sumB;
+    const double flat = samples * samples;
+    result.correlation = varianceA > flat && varianceB > flat ? static_cast<float>(covariance / std::sqrt(varianceA * varianceB)) : 0.0f;
+    result.cut = result.histogramDistance >= m_threshold && result.correlation <= MAX_CORRELATION;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    result.detectMs = std::chrono::duration<float, std::milli>(end - start).count();
+    return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "ImageView.h"
+#include <cstdint>
+
+class ThreadPool;
+
+struct SceneCutResult
+{
+    float histogramDistance = 0.0f;  // Share of the sampled pixels that would have to change luma bin, 0-1
+    float correlation = 0.0f;        // Of the sampled pixels' luma, -1 to 1 (0 if either frame is flat)
+    float detectMs = 0.0f;
+    bool cut = false;
+};
+
+// Tells whether two consecutive BGRA8 captures belong to different shots (a camera cut, a
+// loading screen), where interpolating between them only produces a cross-fade of unrelated
+// pictures
+// Every ROW_STEP-th row of both frames is converted to luma (SSE2), counted into a
+// HISTOGRAM_BINS bin histogram, and the two frames' samples are correlated pixel by pixel
+// (psadbw and pmaddwd sums). Bins are counted with a byte compare per bin on 16 pixels at a time
+// rather than a scatter per pixel. Motion barely changes a histogram, so a large histogram change
+// decides; a high correlation overrules it when the picture stayed put and only got brighter or
+// darker (a fade step, a flash). Cuts between shots of the same tonal range are not caught and
+// get interpolated as usual.
+class SceneCutDetector
+{
+public:
+    static const uint32_t ROW_STEP = 8;
+    static const uint32_t HISTOGRAM_BINS = 16;
+
+    SceneCutDetector();
+
+    // Histogram distance from which two frames are a cut (0-1)
+    void SetThreshold(float threshold) { m_threshold = threshold; }
+    float GetThreshold() const { return m_threshold; }
+
+    // Frames of the same size; different sizes always count as a cut
+    SceneCutResult Compare(const ImageView& previous, const ImageView& current) const;
+
+private:
+    ThreadPool& m_pool;
+    float m_threshold = 0.4f;
+};
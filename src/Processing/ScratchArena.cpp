@@ -0,0 +1,135 @@
+#include "ScratchArena.h"
+#include "../Utils/AllocationCounter.h"
+#include "../Utils/Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+namespace
+{
+    // Buffers grow to a quarter above their peak, in whole 64 KB steps
+    const size_t GROWTH_STEP = 64 * 1024;
+
+    uint8_t* AllocateBlock(size_t bytes)
+    {
+        return static_cast<uint8_t*>(::operator new(bytes, std::align_val_t(ScratchArena::ALIGNMENT)));
+    }
+
+    void FreeBlock(uint8_t* block)
+    {
+        ::operator delete(block, std::align_val_t(ScratchArena::ALIGNMENT));
+    }
+}
+
+ScratchArena::~ScratchArena()
+{
+    for (Buffer& buffer : m_buffers)
+    {
+        for (uint8_t* block : buffer.overflow)
+        {
+            FreeBlock(block);
+        }
+        if (buffer.memory)
+        {
+            FreeBlock(buffer.memory);
+        }
+    }
+}
+
+ScratchArena& ScratchArena::Shared()
+{
+    static ScratchArena arena;
+    return arena;
+}
+
+void ScratchArena::BeginFrame(uint64_t frameIndex, uint64_t shapeKey)
+{
+    m_current = static_cast<uint32_t>(frameIndex & 1);
+    Buffer& buffer = m_buffers[m_current];
+    buffer.peak = std::max(buffer.peak, buffer.offset.load(std::memory_order_relaxed));
+    Regrow(buffer);
+    buffer.offset.store(0, std::memory_order_relaxed);
+    m_inFrame = true;
+
+    if (shapeKey != m_shapeKey)
+    {
+        m_shapeKey = shapeKey;
+        m_shapeFrames = 0;
+    }
+    m_shapeFrames++;
+    m_heapAllocationsAtBegin = GetHeapAllocationCount();
+    m_overflowsAtBegin = m_overflowBlocks.load(std::memory_order_relaxed);
+}
+
+void ScratchArena::EndFrame()
+{
+    Buffer& buffer = m_buffers[m_current];
+    buffer.peak = std::max(buffer.peak, buffer.offset.load(std::memory_order_relaxed));
+    m_inFrame = false;
+
+#if defined(POTATO_SCRATCH_CHECKS)
+    uint64_t allocations = GetHeapAllocationCount() - m_heapAllocationsAtBegin;
+    uint32_t overflows = m_overflowBlocks.load(std::memory_order_relaxed) - m_overflowsAtBegin;
+    if (m_shapeFrames > WARMUP_FRAMES && (allocations || overflows))
+    {
+        Logger::Error("ScratchArena: frame made %llu heap allocations and %u arena overflows",
+            static_cast<unsigned long long>(allocations), overflows);
+        assert(!"Heap allocation inside a processing frame");
+    }
+#endif
+}
+
+void* ScratchArena::Allocate(size_t bytes)
+{
+    Buffer& buffer = m_buffers[m_current];
+    const size_t size = (std::max<size_t>(bytes, 1) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    size_t offset = buffer.offset.fetch_add(size, std::memory_order_relaxed);
+    if (offset + size <= buffer.capacity)
+    {
+        return buffer.memory + offset;
+    }
+
+    // Out of room until the buffer is regrown, the block lives until then
+    uint8_t* block = AllocateBlock(size);
+    std::lock_guard<std::mutex> lock(m_overflowMutex);
+    buffer.overflow.push_back(block);
+    m_overflowBlocks.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+size_t ScratchArena::GetCapacity() const
+{
+    return m_buffers[0].capacity + m_buffers[1].capacity;
+}
+
+void ScratchArena::Rewind(size_t mark)
+{
+    Buffer& buffer = m_buffers[m_current];
+    buffer.peak = std::max(buffer.peak, buffer.offset.load(std::memory_order_relaxed));
+    buffer.offset.store(mark, std::memory_order_relaxed);
+
+    // Outside frames the outermost scope closing is the point where nothing is in use
+    if (mark == 0 && !m_inFrame)
+    {
+        Regrow(buffer);
+    }
+}
+
+void ScratchArena::Regrow(Buffer& buffer)
+{
+    for (uint8_t* block : buffer.overflow)
+    {
+        FreeBlock(block);
+    }
+    buffer.overflow.clear();
+
+    if (buffer.peak > buffer.capacity)
+    {
+        if (buffer.memory)
+        {
+            FreeBlock(buffer.memory);
+        }
+        buffer.capacity = (buffer.peak + buffer.peak / 4 + GROWTH_STEP - 1) / GROWTH_STEP * GROWTH_STEP;
+        buffer.memory = AllocateBlock(buffer.capacity);
+    }
+}
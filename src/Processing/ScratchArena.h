@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Bump allocator for per-frame temporaries of the processing stages (line buffers, profiles,
+// cost arrays, pyramids)
+// Two buffers alternate by frame index: frame N allocates from buffer N % 2, so whatever frame
+// N - 1 allocated stays valid until frame N + 1 begins. Scratch that dies within a call goes
+// through a ScratchScope, which rewinds the arena when it closes (and works outside frames,
+// e.g. in the benchmark).
+// A buffer that runs out hands out separate blocks for the rest of the frame and is regrown
+// to its peak at the start of its next frame, so after the first frames of a new size nothing
+// is allocated.
+// Frames and scopes are opened from one thread; Allocate() may be called from pool workers.
+// Building with POTATO_SCRATCH_CHECKS counts heap allocations on every thread (operator new,
+// malloc where the runtime allows, frame pool pages; see AllocationCounter.h) and asserts there
+// are none between BeginFrame() and EndFrame() once a frame shape has warmed up.
+class ScratchArena
+{
+public:
+    static const size_t ALIGNMENT = 64;
+
+    // Frames after a shape change that may still allocate while buffers and stages grow
+    static const uint32_t WARMUP_FRAMES = 2;
+
+    ScratchArena() = default;
+    ~ScratchArena();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // Arena shared by all processing stages
+    static ScratchArena& Shared();
+
+    // shapeKey identifies the processing setup (sizes, formats, method); the allocation check
+    // restarts its warm-up when it changes
+    void BeginFrame(uint64_t frameIndex, uint64_t shapeKey = 0);
+    void EndFrame();
+
+    // ALIGNMENT aligned, uninitialised
+    void* Allocate(size_t bytes);
+
+    template <typename T>
+    T* Allocate(size_t count)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T)));
+    }
+
+    size_t GetCapacity() const;
+    uint32_t GetOverflowBlocks() const { return m_overflowBlocks; }  // Since start
+
+private:
+    friend class ScratchScope;
+
+    struct Buffer
+    {
+        uint8_t* memory = nullptr;
+        size_t capacity = 0;
+        std::atomic<size_t> offset{ 0 };  // Keeps counting past capacity to measure the peak
+        size_t peak = 0;
+        std::vector<uint8_t*> overflow;
+    };
+
+    size_t Mark() const { return m_buffers[m_current].offset.load(std::memory_order_relaxed); }
+    void Rewind(size_t mark);
+    void Regrow(Buffer& buffer);
+
+private:
+    Buffer m_buffers[2];
+    uint32_t m_current = 0;
+    bool m_inFrame = false;
+    std::mutex m_overflowMutex;
+    std::atomic<uint32_t> m_overflowBlocks{ 0 };
+
+    // Allocation check
+    uint64_t m_shapeKey = 0;
+    uint32_t m_shapeFrames = 0;
+    uint64_t m_heapAllocationsAtBegin = 0;
+    uint32_t m_overflowsAtBegin = 0;
+};
+
+// Scratch that's dead once the scope closes; the arena is rewound to where it was
+class ScratchScope
+{
+public:
+    explicit ScratchScope(ScratchArena& arena = ScratchArena::Shared())
+        : m_arena(arena), m_mark(arena.Mark())
+    {
+    }
+
+    ~ScratchScope() { m_arena.Rewind(m_mark); }
+
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    template <typename T>
+    T* Allocate(size_t count)
+    {
+        return m_arena.Allocate<T>(count);
+    }
+
+private:
+    ScratchArena& m_arena;
+    size_t m_mark;
+};
@@ -0,0 +1,546 @@
+#include "TemporalUpscaler.h"
+#include "PixelSimd.h"
+#include "ScratchArena.h"
+#include "../Utils/ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    // History is stored as colour * HISTORY_SCALE in 16-bit lanes so slow
+    // accumulation doesn't stall on 8-bit rounding
+    const float HISTORY_SCALE = 128.0f;
+
+    // Spread of the Gaussian used to weight current-frame samples (input pixels)
+    // Output pixels sitting on an input sample get weight ~1, pixels between samples less
+    const float SAMPLE_SIGMA = 0.3f;
+
+    // History weight is divided by (1 + clamp distance * HISTORY_REJECTION) so pixels
+    // that had to be clamped hard (disocclusion, wrong motion) refresh quickly
+    const float HISTORY_REJECTION = 0.125f;
+
+    // Largest global motion searched for, in input pixels
+    const int MAX_MOTION = 48;
+
+    const uint32_t INVALID_HISTORY = 0xFFFFFFFF;
+
+    // Line buffers are processed in segments so the scratch lives on the stack
+    const uint32_t SEGMENT = 256;
+
+    inline float SampleWeight(float distance)
+    {
+        return std::exp(-distance * distance / (2.0f * SAMPLE_SIGMA * SAMPLE_SIGMA));
+    }
+
+    inline __m128 LoadHistory(const uint16_t* texel)
+    {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(texel));
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()));
+    }
+
+    // Values stay below 32768 (255 * 128, weight * 128), so a signed pack is enough
+    inline void StoreHistory(uint16_t* texel, __m128 value)
+    {
+        __m128i v = _mm_cvtps_epi32(value);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(texel), _mm_packs_epi32(v, v));
+    }
+
+    // Cubic convolution weights (a = -0.5) for taps at -1, 0, 1, 2 around fraction t
+    void CatmullRomWeights(float t, float (&weights)[4])
+    {
+        float t2 = t * t;
+        float t3 = t2 * t;
+        weights[0] = -0.5f * t3 + t2 - 0.5f * t;
+        weights[1] = 1.5f * t3 - 2.5f * t2 + 1.0f;
+        weights[2] = -1.5f * t3 + 2.0f * t2 + 0.5f * t;
+        weights[3] = 0.5f * t3 - 0.5f * t2;
+    }
+
+    inline float HorizontalSum3(__m128 v)
+    {
+        __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+        return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(v, y), z));
+    }
+
+    // Mean absolute difference between cur[i] and prev[i - shift] over their overlap
+    float ProfileCost(const float* cur, const float* prev, int length, int shift)
+    {
+        int begin = std::max(0, shift);
+        int end = std::min(length, length + shift);
+        float sum = 0.0f;
+        for (int i = begin; i < end; i++)
+        {
+            sum += std::fabs(cur[i] - prev[i - shift]);
+        }
+        return sum / std::max(1, end - begin);
+    }
+
+    // Mean-removed profile smoothed with a 5-tap binomial filter
+    // Thin text and lines alias heavily in the raw projections, which makes the
+    // matching cost too rugged for sub-pixel refinement
+    void PrepareProfile(const std::vector<int32_t>& profile, float* out)
+    {
+        const int length = static_cast<int>(profile.size());
+        double mean = 0.0;
+        for (int32_t value : profile)
+        {
+            mean += value;
+        }
+        mean /= length;
+
+        for (int i = 0; i < length; i++)
+        {
+            float sum = 6.0f * profile[i];
+            sum += 4.0f * (profile[std::max(i - 1, 0)] + profile[std::min(i + 1, length - 1)]);
+            sum += profile[std::max(i - 2, 0)] + profile[std::min(i + 2, length - 1)];
+            out[i] = static_cast<float>(sum / 16.0f - mean);
+        }
+    }
+
+    // Refine an integer shift with 1D Lucas-Kanade steps on the linearly interpolated profile
+    float RefineShift(const float* cur, const float* prev, int length, int shift)
+    {
+        float offset = 0.0f;
+        for (int iteration = 0; iteration < 3; iteration++)
+        {
+            float position = shift + offset;
+            float numerator = 0.0f;
+            float denominator = 0.0f;
+            for (int i = 0; i < length; i++)
+            {
+                float p = i - position;
+                if (p < 1.0f || p >= length - 2)
+                {
+                    continue;
+                }
+                int p0 = static_cast<int>(p);
+                float f = p - p0;
+                float value = prev[p0] + (prev[p0 + 1] - prev[p0]) * f;
+                float gradient = 0.5f * ((prev[p0 + 1] - prev[p0 - 1]) * (1.0f - f) + (prev[p0 + 2] - prev[p0]) * f);
+                numerator += (cur[i] - value) * gradient;
+                denominator += gradient * gradient;
+            }
+            if (denominator < 1e-3f)
+            {
+                break;
+            }
+            // cur[i] ~ prev(i - position) - delta * prev'(i - position)
+            offset = std::min(1.0f, std::max(-1.0f, offset - numerator / denominator));
+        }
+        return shift + offset;
+    }
+
+    // Global shift of the content between two luma projections (current = previous moved by +shift)
+    float MatchProfiles(const std::vector<int32_t>& current, const std::vector<int32_t>& previous)
+    {
+        const int length = static_cast<int>(current.size());
+        if (length < 16 || previous.size() != current.size())
+        {
+            return 0.0f;
+        }
+
+        ScratchScope scratch;
+        float* cur = scratch.Allocate<float>(length);
+        float* prev = scratch.Allocate<float>(length);
+        PrepareProfile(current, cur);
+        PrepareProfile(previous, prev);
+
+        const int range = std::min(MAX_MOTION, length / 4);
+        int best = 0;
+        float bestCost = ProfileCost(cur, prev, length, 0);
+        const float zeroCost = bestCost;
+        for (int shift = -range; shift <= range; shift++)
+        {
+            float cost = ProfileCost(cur, prev, length, shift);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                best = shift;
+            }
+        }
+
+        // Prefer no motion unless another shift is clearly better (flat content, noise)
+        if (zeroCost <= bestCost * 1.05f + 1e-3f)
+        {
+            best = 0;
+        }
+
+        return RefineShift(cur, prev, length, best);
+    }
+}
+
+TemporalUpscaler::TemporalUpscaler()
+    : m_pool(ThreadPool::Shared())
+{
+}
+
+TemporalUpscaler::~TemporalUpscaler()
+{
+}
+
+void TemporalUpscaler::Reset()
+{
+    m_hasHistory = false;
+    m_previousRowProfile.clear();
+    m_previousColumnProfile.clear();
+    m_motionX = 0.0f;
+    m_motionY = 0.0f;
+    m_gridOffsetX = 0.0f;
+    m_gridOffsetY = 0.0f;
+}
+
+void TemporalUpscaler::Upscale(const ImageView& src, const MutableImageView& dst)
+{
+    if (!src.data || !dst.data || src.width == 0 || src.height == 0 || dst.width == 0 || dst.height == 0)
+    {
+        return;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (src.width != m_inputWidth || src.height != m_inputHeight ||
+        dst.width != m_outputWidth || dst.height != m_outputHeight)
+    {
+        m_inputWidth = src.width;
+        m_inputHeight = src.height;
+        m_outputWidth = dst.width;
+        m_outputHeight = dst.height;
+
+        size_t historySize = static_cast<size_t>(dst.width) * dst.height * 4;
+        m_history[0].assign(historySize, 0);
+        m_history[1].assign(historySize, 0);
+        m_neighbourMin.resize(static_cast<size_t>(src.width) * src.height * 4);
+        m_neighbourMax.resize(static_cast<size_t>(src.width) * src.height * 4);
+        Reset();
+    }
+
+    EstimateMotion(src);
+    BuildNeighbourhood(src);
+
+    // The history grid is anchored to the content: it only ever moves by whole pixels,
+    // so accumulated detail is never resampled. The sub-pixel remainder is tracked in
+    // m_gridOffset and applied once when resolving to the output.
+    const float gridX = m_gridOffsetX + m_motionX * dst.width / src.width;
+    const float gridY = m_gridOffsetY + m_motionY * dst.height / src.height;
+    m_historyShiftX = static_cast<int>(std::floor(gridX + 0.5f));
+    m_historyShiftY = static_cast<int>(std::floor(gridY + 0.5f));
+    m_gridOffsetX = gridX - m_historyShiftX;
+    m_gridOffsetY = gridY - m_historyShiftY;
+
+    // Column taps: where each history column lands in the current input
+    const float invScaleX = static_cast<float>(src.width) / dst.width;
+    m_columns.resize(dst.width);
+    for (uint32_t x = 0; x < dst.width; x++)
+    {
+        ColumnTaps& taps = m_columns[x];
+
+        float srcX = std::min(std::max((x + m_gridOffsetX + 0.5f) * invScaleX - 0.5f, 0.0f), static_cast<float>(src.width - 1));
+        uint32_t x0 = static_cast<uint32_t>(srcX);
+        uint32_t x1 = std::min(x0 + 1, src.width - 1);
+        float fx = srcX - x0;
+        taps.input0 = x0 * 4;
+        taps.input1 = x1 * 4;
+        taps.weight0 = SampleWeight(fx);
+        taps.weight1 = x1 != x0 ? SampleWeight(1.0f - fx) : 0.0f;
+        taps.nearest = (fx < 0.5f ? x0 : x1) * 4;
+
+        int historyX = static_cast<int>(x) - m_historyShiftX;
+        taps.history = historyX >= 0 && historyX < static_cast<int>(dst.width) ? historyX * 4 : INVALID_HISTORY;
+    }
+
+    m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        AccumulateRows(src, begin, end);
+    });
+
+    m_historyIndex ^= 1;
+    m_hasHistory = true;
+
+    m_pool.ParallelFor(dst.height, m_pool.SuggestGrain(dst.height), [&](uint32_t begin, uint32_t end)
+    {
+        ResolveRows(dst, begin, end);
+    });
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.upscaleMs = std::chrono::duration<float, std::milli>(end - start).count();
+    m_stats.motionX = m_motionX;
+    m_stats.motionY = m_motionY;
+    m_stats.frames++;
+}
+
+void TemporalUpscaler::BuildProfiles(const ImageView& src, std::vector<int32_t>& rows, std::vector<int32_t>& columns)
+{
+    rows.assign(src.height, 0);
+    columns.assign(src.width, 0);
+
+    // Every other pixel along each projection is plenty for a global estimate
+    m_pool.ParallelFor(src.height, m_pool.SuggestGrain(src.height), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint8_t* row = src.Row(y);
+            int32_t sum = 0;
+            for (uint32_t x = 0; x < src.width; x += 2)
+            {
+                sum += PixelLuma(row + x * 4);
+            }
+            rows[y] = sum;
+        }
+    });
+
+    m_pool.ParallelFor(src.width, std::max(64u, m_pool.SuggestGrain(src.width)), [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = 0; y < src.height; y += 2)
+        {
+            const uint8_t* row = src.Row(y);
+            for (uint32_t x = begin; x < end; x++)
+            {
+                columns[x] += PixelLuma(row + x * 4);
+            }
+        }
+    });
+}
+
+void TemporalUpscaler::EstimateMotion(const ImageView& src)
+{
+    BuildProfiles(src, m_rowProfile, m_columnProfile);
+
+    if (m_hasHistory)
+    {
+        m_motionX = MatchProfiles(m_columnProfile, m_previousColumnProfile);
+        m_motionY = MatchProfiles(m_rowProfile, m_previousRowProfile);
+    }
+    else
+    {
+        m_motionX = 0.0f;
+        m_motionY = 0.0f;
+    }
+
+    m_previousRowProfile.swap(m_rowProfile);
+    m_previousColumnProfile.swap(m_columnProfile);
+}
+
+void TemporalUpscaler::BuildNeighbourhood(const ImageView& src)
+{
+    const uint32_t width = src.width;
+    const uint32_t height = src.height;
+
+    m_pool.ParallelFor(height, m_pool.SuggestGrain(height), [&](uint32_t begin, uint32_t end)
+    {
+        // Vertical min/max for columns x0 - 1 .. x0 + count, edges replicated
+        uint8_t columnMin[(SEGMENT + 2) * 4 + 16];
+        uint8_t columnMax[(SEGMENT + 2) * 4 + 16];
+
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint8_t* above = src.Row(y > 0 ? y - 1 : 0);
+            const uint8_t* centre = src.Row(y);
+            const uint8_t* below = src.Row(std::min(y + 1, height - 1));
+            uint8_t* outMin = &m_neighbourMin[static_cast<size_t>(y) * width * 4];
+            uint8_t* outMax = &m_neighbourMax[static_cast<size_t>(y) * width * 4];
+
+            for (uint32_t x0 = 0; x0 < width; x0 += SEGMENT)
+            {
+                const uint32_t count = std::min(SEGMENT, width - x0);
+                const uint32_t first = x0 > 0 ? x0 - 1 : 0;
+                const uint32_t last = std::min(x0 + count + 1, width);
+                const uint32_t bytes = (last - first) * 4;
+                const uint32_t base = (first + 1 - x0) * 4;  // Scratch slot of column 'first'
+
+                uint32_t i = 0;
+                for (; i + 16 <= bytes; i += 16)
+                {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(above + first * 4 + i));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(centre + first * 4 + i));
+                    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + first * 4 + i));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(columnMin + base + i), _mm_min_epu8(_mm_min_epu8(a, b), c));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(columnMax + base + i), _mm_max_epu8(_mm_max_epu8(a, b), c));
+                }
+                for (; i < bytes; i++)
+                {
+                    uint8_t a = above[first * 4 + i];
+                    uint8_t b = centre[first * 4 + i];
+                    uint8_t c = below[first * 4 + i];
+                    columnMin[base + i] = std::min(std::min(a, b), c);
+                    columnMax[base + i] = std::max(std::max(a, b), c);
+                }
+
+                // Replicate the image edge into the halo slots
+                if (x0 == 0)
+                {
+                    memcpy(columnMin, columnMin + 4, 4);
+                    memcpy(columnMax, columnMax + 4, 4);
+                }
+                if (x0 + count == width)
+                {
+                    memcpy(columnMin + (count + 1) * 4, columnMin + count * 4, 4);
+                    memcpy(columnMax + (count + 1) * 4, columnMax + count * 4, 4);
+                }
+
+                // Horizontal min/max of three neighbouring columns
+                const uint32_t outBytes = count * 4;
+                i = 0;
+                for (; i + 16 <= outBytes; i += 16)
+                {
+                    __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnMin + i));
+                    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnMin + i + 4));
+                    __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnMin + i + 8));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(outMin + x0 * 4 + i), _mm_min_epu8(_mm_min_epu8(l, c), r));
+                    l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnMax + i));
+                    c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnMax + i + 4));
+                    r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columnMax + i + 8));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(outMax + x0 * 4 + i), _mm_max_epu8(_mm_max_epu8(l, c), r));
+                }
+                for (; i < outBytes; i++)
+                {
+                    outMin[x0 * 4 + i] = std::min(std::min(columnMin[i], columnMin[i + 4]), columnMin[i + 8]);
+                    outMax[x0 * 4 + i] = std::max(std::max(columnMax[i], columnMax[i + 4]), columnMax[i + 8]);
+                }
+            }
+        }
+    });
+}
+
+void TemporalUpscaler::AccumulateRows(const ImageView& src, uint32_t begin, uint32_t end)
+{
+    const float invScaleY = static_cast<float>(src.height) / m_outputHeight;
+    const size_t historyPitch = static_cast<size_t>(m_outputWidth) * 4;
+    const uint16_t* history = m_history[m_historyIndex].data();
+    uint16_t* nextHistory = m_history[m_historyIndex ^ 1].data();
+    const ColumnTaps* columns = m_columns.data();
+
+    const __m128 historyScale = _mm_set1_ps(HISTORY_SCALE);
+    const __m128 invHistoryScale = _mm_set1_ps(1.0f / HISTORY_SCALE);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 colourMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 alphaMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+    for (uint32_t y = begin; y < end; y++)
+    {
+        float srcY = std::min(std::max((y + m_gridOffsetY + 0.5f) * invScaleY - 0.5f, 0.0f), static_cast<float>(src.height - 1));
+        uint32_t y0 = static_cast<uint32_t>(srcY);
+        uint32_t y1 = std::min(y0 + 1, src.height - 1);
+        float fy = srcY - y0;
+        float weightY0 = SampleWeight(fy);
+        float weightY1 = y1 != y0 ? SampleWeight(1.0f - fy) : 0.0f;
+        uint32_t nearestY = fy < 0.5f ? y0 : y1;
+
+        const uint8_t* row0 = src.Row(y0);
+        const uint8_t* row1 = src.Row(y1);
+        const uint8_t* rowMin = &m_neighbourMin[static_cast<size_t>(nearestY) * src.width * 4];
+        const uint8_t* rowMax = &m_neighbourMax[static_cast<size_t>(nearestY) * src.width * 4];
+
+        int historyY = static_cast<int>(y) - m_historyShiftY;
+        const uint16_t* historyRow = m_hasHistory && historyY >= 0 && historyY < static_cast<int>(m_outputHeight)
+            ? history + historyY * historyPitch : nullptr;
+        uint16_t* outHistory = nextHistory + y * historyPitch;
+
+        for (uint32_t x = 0; x < m_outputWidth; x++)
+        {
+            const ColumnTaps& taps = columns[x];
+
+            // Current frame: Gaussian-weighted 2x2 reconstruction at this history pixel
+            float w00 = taps.weight0 * weightY0;
+            float w01 = taps.weight1 * weightY0;
+            float w10 = taps.weight0 * weightY1;
+            float w11 = taps.weight1 * weightY1;
+            float currentWeight = w00 + w01 + w10 + w11;
+            __m128 current = _mm_mul_ps(LoadPixel(row0 + taps.input0), _mm_set1_ps(w00));
+            current = _mm_add_ps(current, _mm_mul_ps(LoadPixel(row0 + taps.input1), _mm_set1_ps(w01)));
+            current = _mm_add_ps(current, _mm_mul_ps(LoadPixel(row1 + taps.input0), _mm_set1_ps(w10)));
+            current = _mm_add_ps(current, _mm_mul_ps(LoadPixel(row1 + taps.input1), _mm_set1_ps(w11)));
+            current = _mm_mul_ps(current, _mm_set1_ps(1.0f / currentWeight));
+
+            __m128 result = current;
+            float totalWeight = currentWeight;
+
+            if (historyRow && taps.history != INVALID_HISTORY)
+            {
+                // The accumulated weight travels in the alpha lane
+                __m128 previous = _mm_mul_ps(LoadHistory(historyRow + taps.history), invHistoryScale);
+                float historyWeight = _mm_cvtss_f32(_mm_shuffle_ps(previous, previous, _MM_SHUFFLE(3, 3, 3, 3)));
+
+                // Clamp to the current neighbourhood (alpha comes from the current frame)
+                previous = _mm_or_ps(_mm_and_ps(previous, colourMask), _mm_and_ps(current, alphaMask));
+                __m128 clamped = _mm_min_ps(_mm_max_ps(previous, LoadPixel(rowMin + taps.nearest)), LoadPixel(rowMax + taps.nearest));
+                float clampDistance = HorizontalSum3(_mm_and_ps(_mm_sub_ps(clamped, previous), absMask));
+                historyWeight /= 1.0f + clampDistance * HISTORY_REJECTION;
+
+                totalWeight = historyWeight + currentWeight;
+                result = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(historyWeight)), _mm_mul_ps(current, _mm_set1_ps(currentWeight))),
+                                    _mm_set1_ps(1.0f / totalWeight));
+            }
+
+            __m128 weight = _mm_set1_ps(std::min(totalWeight, m_maxHistoryWeight));
+            __m128 stored = _mm_or_ps(_mm_and_ps(result, colourMask), _mm_and_ps(weight, alphaMask));
+            StoreHistory(outHistory + x * 4, _mm_mul_ps(stored, historyScale));
+        }
+    }
+}
+
+void TemporalUpscaler::ResolveRows(const MutableImageView& dst, uint32_t begin, uint32_t end)
+{
+    // Output pixel x sits at history position x - m_gridOffset
+    // Separable Catmull-Rom: vertical taps into a line buffer, then horizontal taps
+    const int width = static_cast<int>(m_outputWidth);
+    const int height = static_cast<int>(m_outputHeight);
+    const size_t historyPitch = static_cast<size_t>(m_outputWidth) * 4;
+    const uint16_t* history = m_history[m_historyIndex].data();
+
+    const float positionX = -m_gridOffsetX;
+    const float positionY = -m_gridOffsetY;
+    const int baseX = static_cast<int>(std::floor(positionX));
+    const int baseY = static_cast<int>(std::floor(positionY));
+    float weightsX[4];
+    float weightsY[4];
+    CatmullRomWeights(positionX - baseX, weightsX);
+    CatmullRomWeights(positionY - baseY, weightsY);
+
+    const __m128 invHistoryScale = _mm_set1_ps(1.0f / HISTORY_SCALE);
+    const __m128 colourMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 opaque = _mm_castsi128_ps(_mm_set_epi32(0x437F0000, 0, 0, 0));  // 255.0f in alpha
+    const __m128 wx0 = _mm_set1_ps(weightsX[0]);
+    const __m128 wx1 = _mm_set1_ps(weightsX[1]);
+    const __m128 wx2 = _mm_set1_ps(weightsX[2]);
+    const __m128 wx3 = _mm_set1_ps(weightsX[3]);
+
+    __m128 line[SEGMENT + 3];
+
+    for (uint32_t y = begin; y < end; y++)
+    {
+        const uint16_t* rows[4];
+        for (int i = 0; i < 4; i++)
+        {
+            int row = std::min(std::max(static_cast<int>(y) + baseY - 1 + i, 0), height - 1);
+            rows[i] = history + row * historyPitch;
+        }
+        uint8_t* out = dst.Row(y);
+
+        for (uint32_t x0 = 0; x0 < m_outputWidth; x0 += SEGMENT)
+        {
+            const uint32_t count = std::min(SEGMENT, m_outputWidth - x0);
+
+            for (uint32_t k = 0; k < count + 3; k++)
+            {
+                int column = std::min(std::max(static_cast<int>(x0 + k) + baseX - 1, 0), width - 1) * 4;
+                __m128 sum = _mm_mul_ps(LoadHistory(rows[0] + column), _mm_set1_ps(weightsY[0]));
+                sum = _mm_add_ps(sum, _mm_mul_ps(LoadHistory(rows[1] + column), _mm_set1_ps(weightsY[1])));
+                sum = _mm_add_ps(sum, _mm_mul_ps(LoadHistory(rows[2] + column), _mm_set1_ps(weightsY[2])));
+                sum = _mm_add_ps(sum, _mm_mul_ps(LoadHistory(rows[3] + column), _mm_set1_ps(weightsY[3])));
+                line[k] = sum;
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+            {
+                __m128 value = _mm_mul_ps(line[i], wx0);
+                value = _mm_add_ps(value, _mm_mul_ps(line[i + 1], wx1));
+                value = _mm_add_ps(value, _mm_mul_ps(line[i + 2], wx2));
+                value = _mm_add_ps(value, _mm_mul_ps(line[i + 3], wx3));
+                value = _mm_or_ps(_mm_and_ps(_mm_mul_ps(value, invHistoryScale), colourMask), opaque);
+                StorePixel(out + (x0 + i) * 4, value);
+            }
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "ImageView.h"
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+struct TemporalStats
+{
+    float motionX = 0.0f;  // Estimated global motion of the last frame (input pixels)
+    float motionY = 0.0f;
+    float upscaleMs = 0.0f;
+    uint32_t frames = 0;
+};
+
+// Temporal accumulation upscaler (CPU reference implementation)
+// Keeps a history buffer at output resolution. Each frame the history is reprojected by
+// the estimated global motion, clamped to the current frame's 3x3 neighbourhood and merged
+// with a cheap 2x2 Gaussian reconstruction of the current frame, weighted by how close each
+// history pixel is to a real input sample. The history grid follows the content in whole
+// pixels so accumulated detail is never resampled; sub-pixel motion lands new samples at
+// new positions and a single Catmull-Rom resolve aligns the result with the output.
+class TemporalUpscaler
+{
+public:
+    TemporalUpscaler();
+    ~TemporalUpscaler();
+
+    // Upscale src into dst, accumulating into the history
+    // History is reset automatically when the input or output size changes
+    void Upscale(const ImageView& src, const MutableImageView& dst);
+
+    // Drop the history (scene change, capture restart)
+    void Reset();
+
+    // Upper bound on the accumulated history weight (higher = smoother, slower to react)
+    void SetMaxHistoryWeight(float weight) { m_maxHistoryWeight = weight; }
+
+    const TemporalStats& GetStats() const { return m_stats; }
+
+private:
+    struct ColumnTaps
+    {
+        uint32_t input0;    // Byte offsets of the two nearest input columns
+        uint32_t input1;
+        float weight0;      // Gaussian weights of those columns
+        float weight1;
+        uint32_t nearest;   // Byte offset of the nearest input column
+        uint32_t history;   // Element offset of the shifted history column, or INVALID_HISTORY
+    };
+
+    void EstimateMotion(const ImageView& src);
+    void BuildProfiles(const ImageView& src, std::vector<int32_t>& rows, std::vector<int32_t>& columns);
+    void BuildNeighbourhood(const ImageView& src);
+    void AccumulateRows(const ImageView& src, uint32_t begin, uint32_t end);
+    void ResolveRows(const MutableImageView& dst, uint32_t begin, uint32_t end);
+
+private:
+    ThreadPool& m_pool;
+
+    uint32_t m_inputWidth = 0;
+    uint32_t m_inputHeight = 0;
+    uint32_t m_outputWidth = 0;
+    uint32_t m_outputHeight = 0;
+    bool m_hasHistory = false;
+
+    // Ping-ponged history: 4 x uint16 per pixel, colour * 128 in BGR, weight * 128 in A
+    std::vector<uint16_t> m_history[2];
+    int m_historyIndex = 0;
+
+    // 3x3 min/max of the current input, used to clamp reprojected history
+    std::vector<uint8_t> m_neighbourMin;
+    std::vector<uint8_t> m_neighbourMax;
+
+    // Luma projections for global motion estimation
+    std::vector<int32_t> m_rowProfile;
+    std::vector<int32_t> m_columnProfile;
+    std::vector<int32_t> m_previousRowProfile;
+    std::vector<int32_t> m_previousColumnProfile;
+    float m_motionX = 0.0f;
+    float m_motionY = 0.0f;
+
+    std::vector<ColumnTaps> m_columns;
+
+    // History reprojection: whole-pixel shift this frame, and the sub-pixel offset of the
+    // history grid relative to the output grid (-0.5..0.5 output pixels)
+    int m_historyShiftX = 0;
+    int m_historyShiftY = 0;
+    float m_gridOffsetX = 0.0f;
+    float m_gridOffsetY = 0.0f;
+
+    float m_maxHistoryWeight = 8.0f;
+
+    TemporalStats m_stats;
+};
@@ -1,4 +1,5 @@
 #include "ImGuiLayer.h"
+#include "../Utils/AllocationCounter.h"
 #include "../Utils/Logger.h"
 #include <imgui.h>
 #include <backends/imgui_impl_win32.h>
@@ -22,6 +23,13 @@ bool ImGuiLayer::Initialize(HWND hwnd, D3D12Context* context)
 
     // Setup ImGui context
     IMGUI_CHECKVERSION();
+    if (IsHeapAllocationCountEnabled())
+    {
+        // ImGui's own growth (window lists, draw buffers) shows up in the per-frame allocation
+        // count; must be set before the context exists
+        ImGui::SetAllocatorFunctions([](size_t size, void*) { return CountedMalloc(size); },
+                                     [](void* memory, void*) { CountedFree(memory); });
+    }
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
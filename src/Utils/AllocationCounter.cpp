@@ -0,0 +1,198 @@
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(POTATO_SCRATCH_CHECKS)
+#if defined(_MSC_VER)
+#include <crtdbg.h>
+#include <malloc.h>
+#endif
+
+// Where the malloc family is visible: glibc lets the program replace malloc, calloc, realloc and
+// free around its own entry points; the debug CRT calls an allocation hook, for _aligned_malloc
+// too. Elsewhere only operator new and CountHeapAllocation() are counted
+#if defined(__GLIBC__)
+#define POTATO_MALLOC_WRAPPERS
+#elif defined(_MSC_VER) && defined(_DEBUG)
+#define POTATO_MALLOC_HOOK
+#endif
+
+static std::atomic<uint64_t> s_heapAllocations{ 0 };
+
+void CountHeapAllocation()
+{
+    s_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t GetHeapAllocationCount()
+{
+    return s_heapAllocations.load(std::memory_order_relaxed);
+}
+
+#if defined(POTATO_MALLOC_WRAPPERS)
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* memory, size_t size);
+    void __libc_free(void* memory);
+
+    void* malloc(size_t size)
+    {
+        CountHeapAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        CountHeapAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* memory, size_t size)
+    {
+        CountHeapAllocation();
+        return __libc_realloc(memory, size);
+    }
+
+    void free(void* memory)
+    {
+        __libc_free(memory);
+    }
+}
+#elif defined(POTATO_MALLOC_HOOK)
+namespace
+{
+    int CountingAllocHook(int type, void*, size_t, int, long, const unsigned char*, int)
+    {
+        if (type == _HOOK_ALLOC || type == _HOOK_REALLOC)
+        {
+            CountHeapAllocation();
+        }
+        return TRUE;
+    }
+
+    // Installed before main(); allocations of earlier static initializers aren't counted
+    const _CRT_ALLOC_HOOK s_previousHook = _CrtSetAllocHook(CountingAllocHook);
+}
+#endif
+
+void* CountedMalloc(size_t size)
+{
+#if !defined(POTATO_MALLOC_WRAPPERS) && !defined(POTATO_MALLOC_HOOK)
+    CountHeapAllocation();
+#endif
+    return std::malloc(size ? size : 1);
+}
+
+void CountedFree(void* memory)
+{
+    std::free(memory);
+}
+
+namespace
+{
+    // posix_memalign isn't wrapped; the debug CRT hook sees _aligned_malloc
+    void* AllocateAlignedCounted(size_t size, std::align_val_t alignment)
+    {
+#if !defined(POTATO_MALLOC_HOOK)
+        CountHeapAllocation();
+#endif
+#if defined(_MSC_VER)
+        return _aligned_malloc(size ? size : 1, static_cast<size_t>(alignment));
+#else
+        void* memory = nullptr;
+        const size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+        return posix_memalign(&memory, align, size ? size : 1) == 0 ? memory : nullptr;
+#endif
+    }
+
+    void FreeAligned(void* memory)
+    {
+#if defined(_MSC_VER)
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+void* operator new(size_t size)
+{
+    if (void* memory = CountedMalloc(size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedMalloc(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    if (void* memory = AllocateAlignedCounted(size, alignment))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return AllocateAlignedCounted(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    FreeAligned(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+    FreeAligned(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    FreeAligned(memory);
+}
+#else
+void CountHeapAllocation()
+{
+}
+
+void* CountedMalloc(size_t size)
+{
+    return std::malloc(size ? size : 1);
+}
+
+void CountedFree(void* memory)
+{
+    std::free(memory);
+}
+
+uint64_t GetHeapAllocationCount()
+{
+    return 0;
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocations since start, on every thread
+// Only counted in builds with POTATO_SCRATCH_CHECKS, which replace every form of operator new
+// (plain, nothrow, aligned) and count malloc, calloc and realloc where the runtime allows it:
+// glibc, and the MSVC debug CRT through its allocation hook. With the release CRT, malloc calls
+// from outside operator new aren't seen. Otherwise the count stays 0.
+uint64_t GetHeapAllocationCount();
+
+// For allocations that bypass the heap functions (pages from VirtualAlloc, posix_memalign)
+void CountHeapAllocation();
+
+// malloc and free for allocator hooks of libraries (ImGui); counted once, whether or not the
+// runtime's malloc is
+void* CountedMalloc(size_t size);
+void CountedFree(void* memory);
+
+constexpr bool IsHeapAllocationCountEnabled()
+{
+#if defined(POTATO_SCRATCH_CHECKS)
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,67 @@
+#include "CpuFeatures.h"
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void QueryCpuid(int leaf, int subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<uint32_t>(info[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t QueryXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+static CpuFeatures DetectCpuFeatures()
+{
+    CpuFeatures features;
+    uint32_t regs[4];
+
+    QueryCpuid(0, 0, regs);
+    uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1) return features;
+
+    QueryCpuid(1, 0, regs);
+    features.sse41 = (regs[2] & (1u << 19)) != 0;
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+    bool fma = (regs[2] & (1u << 12)) != 0;
+    bool f16c = (regs[2] & (1u << 29)) != 0;
+
+    // The OS must save YMM state or AVX instructions fault
+    bool ymmEnabled = osxsave && avx && (QueryXcr0() & 0x6) == 0x6;
+    if (!ymmEnabled || maxLeaf < 7) return features;
+
+    QueryCpuid(7, 0, regs);
+    features.avx2 = (regs[1] & (1u << 5)) != 0;
+    features.fma = fma;
+    features.f16c = f16c;
+
+    QueryCpuid(7, 1, regs);
+    features.avxVnni = features.avx2 && (regs[0] & (1u << 4)) != 0;
+
+    return features;
+}
+
+const CpuFeatures& GetCpuFeatures()
+{
+    static const CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+// Runtime CPU feature detection for the SIMD kernels
+// x64 always has SSE2, everything above that is checked once at startup
+struct CpuFeatures
+{
+    bool sse41 = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool f16c = false;
+    bool avxVnni = false;
+};
+
+const CpuFeatures& GetCpuFeatures();
+
+// MSVC lets any intrinsic be used in any function, GCC/Clang need the target enabled
+// per function so AVX2 code can live next to the SSE2 baseline in one translation unit
+#if defined(_MSC_VER) && !defined(__clang__)
+#define POTATO_TARGET_SSE41
+#define POTATO_TARGET_AVX2
+#else
+#define POTATO_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define POTATO_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#endif
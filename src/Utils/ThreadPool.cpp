@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+#include "Logger.h"
+#include <algorithm>
+
+// Set while a thread is executing pool work, so nested ParallelFor calls don't deadlock
+static thread_local bool t_insideJob = false;
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_workers.reserve(threadCount - 1);
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+
+    Logger::Info("Thread pool started with %u threads", threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+uint32_t ThreadPool::SuggestGrain(uint32_t count) const
+{
+    uint32_t chunks = GetThreadCount() * 4;
+    return std::max(1u, (count + chunks - 1) / chunks);
+}
+
+void ThreadPool::Run(uint32_t count, uint32_t grain, JobFn fn, void* context)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grain = std::max(1u, grain);
+    if (m_workers.empty() || count <= grain || t_insideJob)
+    {
+        fn(context, 0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitLock(m_submitMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobFn = fn;
+        m_jobContext = context;
+        m_jobCount = count;
+        m_jobGrain = grain;
+        m_nextIndex.store(0, std::memory_order_relaxed);
+        m_busyWorkers = static_cast<uint32_t>(m_workers.size());
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    t_insideJob = true;
+    ExecuteChunks();
+    t_insideJob = false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_jobFn = nullptr;
+    m_jobContext = nullptr;
+}
+
+void ThreadPool::ExecuteChunks()
+{
+    for (;;)
+    {
+        uint32_t begin = m_nextIndex.fetch_add(m_jobGrain, std::memory_order_relaxed);
+        if (begin >= m_jobCount)
+        {
+            break;
+        }
+        uint32_t end = std::min(begin + m_jobGrain, m_jobCount);
+        m_jobFn(m_jobContext, begin, end);
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    uint64_t seenGeneration = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop)
+            {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+
+        t_insideJob = true;
+        ExecuteChunks();
+        t_insideJob = false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busyWorkers == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+}
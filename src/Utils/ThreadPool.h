@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads for the CPU processing kernels
+// ParallelFor splits [0, count) into chunks that workers pull from a shared counter;
+// the calling thread works too and the call returns once every chunk is done.
+// Jobs are passed as a function pointer + context so dispatching never allocates.
+class ThreadPool
+{
+public:
+    // threadCount = total threads including the caller, 0 = one per hardware thread
+    explicit ThreadPool(uint32_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Pool shared by all processing stages
+    static ThreadPool& Shared();
+
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()) + 1; }
+
+    // Calls fn(begin, end) for chunks of at most grain items covering [0, count)
+    // Nested calls from inside a job run serially on the calling thread
+    template <typename Fn>
+    void ParallelFor(uint32_t count, uint32_t grain, Fn&& fn)
+    {
+        using FnType = typename std::remove_reference<Fn>::type;
+        Run(count, grain, &Invoke<FnType>, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+    // Grain that gives each thread a few chunks for load balancing
+    uint32_t SuggestGrain(uint32_t count) const;
+
+private:
+    using JobFn = void (*)(void* context, uint32_t begin, uint32_t end);
+
+    template <typename FnType>
+    static void Invoke(void* context, uint32_t begin, uint32_t end)
+    {
+        (*static_cast<FnType*>(context))(begin, end);
+    }
+
+    void Run(uint32_t count, uint32_t grain, JobFn fn, void* context);
+    void WorkerLoop();
+    void ExecuteChunks();
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_submitMutex;  // One job at a time
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    // Current job (written under m_mutex before m_generation changes)
+    JobFn m_jobFn = nullptr;
+    void* m_jobContext = nullptr;
+    uint32_t m_jobCount = 0;
+    uint32_t m_jobGrain = 1;
+    std::atomic<uint32_t> m_nextIndex{ 0 };
+    uint32_t m_busyWorkers = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+};
@@ -1,13 +1,37 @@
 #include "Application.h"
+#include "Benchmark/BenchmarkSuite.h"
 #include "Utils/Logger.h"
 #include <Windows.h>
+#include <cstring>
 #include <exception>
 
-int main()
+int main(int argc, char** argv)
 {
     HINSTANCE hInstance = GetModuleHandle(nullptr);
     
     Logger::Init();
+
+    // Headless mode: PotatoPatch --benchmark [--replay file.ppr]
+    bool benchmark = false;
+    BenchmarkOptions benchmarkOptions;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--benchmark") == 0)
+        {
+            benchmark = true;
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            benchmarkOptions.replayPath = argv[++i];
+        }
+    }
+
+    if (benchmark)
+    {
+        BenchmarkSuite suite(benchmarkOptions);
+        return suite.Run();
+    }
+
     Logger::Info("Starting PotatoPatch...");
 
     try